@@ -0,0 +1,263 @@
+#include "src/benchmark.h"
+#include <nitrogl/samplers/color_sampler.h>
+#include <nitrogl/path.h>
+#include <nitrogl/tessellation_pool.h>
+#include <nitrogl/hit_testing.h>
+#include <nitrogl/math.h>
+
+using namespace nitrogl;
+using path_t = nitrogl::path<dynamic_array>;
+using fixed_path_t = nitrogl::fixed_path<>;
+
+// a flower outline of count quadratic petals, like the outlines of glyphs
+static path_t flower(int count, float cx, float cy, float radius) {
+    path_t path{};
+    count = count < 3 ? 3 : count;
+    for (int ix = 0; ix <= count; ++ix) {
+        const float a = 2.0f*math::pi<float>()*float(ix)/float(count);
+        const vec2f on{cx + radius*0.7f*math::cos(a), cy + radius*0.7f*math::sin(a)};
+        if(ix==0) { path.moveTo(on); continue; }
+        const float c = a - math::pi<float>()/float(count);
+        path.quadraticCurveTo({cx + radius*math::cos(c), cy + radius*math::sin(c)}, on);
+    }
+    path.closePath();
+    return path;
+}
+
+// a star polygon (or a regular polygon if not concave), with count vertices in its outline
+static std::vector<vec2f> star(int count, float cx, float cy, float radius, bool concave=true) {
+    std::vector<vec2f> points;
+    count = count < 3 ? 3 : count;
+    for (int ix = 0; ix < count; ++ix) {
+        const float a = 2.0f*math::pi<float>()*float(ix)/float(count);
+        const float r = (concave && ix%2) ? radius*0.6f : radius;
+        points.push_back({cx + r*math::cos(a), cy + r*math::sin(a)});
+    }
+    return points;
+}
+
+static float * bi_cubic(float s) {
+    static float mesh[4 * 4 * 2];
+    for (int v = 0; v < 4; ++v) {
+        for (int u = 0; u < 4; ++u) {
+            const float wave = (u==1 || u==2) && (v==1 || v==2) ? s*0.1f : 0.0f;
+            mesh[(v*4 + u)*2 + 0] = s*float(u)/3.0f + wave;
+            mesh[(v*4 + u)*2 + 1] = s*float(v)/3.0f - wave;
+        }
+    }
+    return mesh;
+}
+
+// general polygons and paths are tessellated on the CPU in O(n^2), so they are capped
+static constexpr int max_tessellated_vertices = 1024;
+// paths of a tessellate_all batch
+static constexpr int tessellated_batch = 16;
+// hit testing scene of grid x grid stars, about 100k triangles
+static constexpr int hit_test_grid = 16;
+static constexpr int hit_test_star = 96;
+
+/**
+ * tessellated geometry: polygons, path fills, path strokes and bezier patches.
+ * Primitives are the amount of vertices of the outline, or the amount of patch samples.
+ */
+
+int main(int argc, char ** argv) {
+    benchmark_suite suite("draw_paths", argc, argv);
+    color_sampler color{1.0f, 0.0f, 0.0f, 0.5f};
+    const dynamic_array<int> no_dash{};
+    dynamic_array<int> dash{};
+    dash.push_back(12); dash.push_back(6);
+    tessellation_pool single_thread(1);
+
+    for (int size : suite.canvas_sizes()) {
+        auto target = gl_texture::empty(size, size, GL_RGBA, true);
+        canvas canva(target);
+        canva.clear(1.0f, 1.0f, 1.0f, 1.0f);
+        // multisampled anti-aliasing, resolved after every draw
+        auto target_ms = gl_texture::empty(size, size, GL_RGBA, true);
+        canvas canva_ms(target_ms);
+        canva_ms.clear(1.0f, 1.0f, 1.0f, 1.0f);
+        canva_ms.enableMultisampling(4);
+        const float s = float(size);
+
+        for (int count : suite.primitive_counts()) {
+            const auto points = star(count, s*0.5f, s*0.5f, s*0.45f);
+            const auto convex = star(count, s*0.5f, s*0.5f, s*0.45f, false);
+            suite.run("drawPolygon/convex", canva, int(convex.size()), [&]() {
+                canva.drawPolygon<polygons::CONVEX>(color, convex.data(), canvas::index(convex.size()));
+            });
+            suite.run("drawPolygon/convex/msaa4", canva_ms, int(convex.size()), [&]() {
+                canva_ms.drawPolygon<polygons::CONVEX>(color, convex.data(), canvas::index(convex.size()));
+                canva_ms.flush();
+            });
+            canva.enableEdgeAntialiasing(true);
+            suite.run("drawPolygon/convex/edge_aa", canva, int(convex.size()), [&]() {
+                canva.drawPolygon<polygons::CONVEX>(color, convex.data(), canvas::index(convex.size()));
+            });
+            canva.enableEdgeAntialiasing(false);
+            // patch samples grid of about count samples
+            const unsigned samples = unsigned(math::sqrt(float(count))) + 1;
+            suite.run("drawBezierPatch", canva, int(samples*samples), [&]() {
+                canva.drawBezierPatch<microtess::patch_type::BI_CUBIC>(color, bi_cubic(s), samples, samples);
+            });
+            canva.updateBezierPatchMode(bezier_patch_mode::gpu);
+            suite.run("drawBezierPatch/gpu", canva, int(samples*samples), [&]() {
+                canva.drawBezierPatch<microtess::patch_type::BI_CUBIC>(color, bi_cubic(s), samples, samples);
+            });
+            canva.updateBezierPatchMode(bezier_patch_mode::tessellate);
+            // strokes expanded on the GPU are linear in the vertices
+            suite.run("drawPolyline", canva, int(points.size()), [&]() {
+                canva.drawPolyline(color, points.data(), canvas::index(points.size()), 8.0f,
+                                   microtess::stroke_cap::round, microtess::stroke_line_join::round,
+                                   4, true);
+            });
+            if(count > max_tessellated_vertices) continue;
+            suite.run("drawPolygon/simple", canva, int(points.size()), [&]() {
+                canva.drawPolygon<polygons::SIMPLE>(color, points.data(), canvas::index(points.size()));
+            });
+            suite.run("drawPolygon/complex", canva, int(points.size()), [&]() {
+                canva.drawPolygon<polygons::COMPLEX>(color, points.data(), canvas::index(points.size()));
+            });
+            path_t path{};
+            path.linesTo(points).closePath();
+            suite.run("drawPathFill", canva, int(points.size()), [&]() {
+                canva.drawPathFill(color, path, microtess::fill_rule::non_zero,
+                                   microtess::tess_quality::better);
+            });
+            canva.enableEdgeAntialiasing(true);
+            suite.run("drawPathFill/edge_aa", canva, int(points.size()), [&]() {
+                canva.drawPathFill(color, path, microtess::fill_rule::non_zero,
+                                   microtess::tess_quality::better);
+            });
+            canva.enableEdgeAntialiasing(false);
+            // curved outline, flattened into the tessellation or filled by the curves themselves
+            auto curved = flower(count, s*0.5f, s*0.5f, s*0.45f);
+            suite.run("drawPathFill/curved", canva, count, [&]() {
+                curved.invalidate();
+                canva.drawPathFill(color, curved, microtess::fill_rule::non_zero,
+                                   microtess::tess_quality::better);
+            });
+            canva.updatePathFillMode(path_fill_mode::curves);
+            suite.run("drawPathFill/curved/curves", canva, count, [&]() {
+                curved.invalidate();
+                canva.drawPathFill(color, curved, microtess::fill_rule::non_zero,
+                                   microtess::tess_quality::better);
+            });
+            canva.updatePathFillMode(path_fill_mode::tessellate);
+            suite.run("drawPathStroke", canva, int(points.size()), [&]() {
+                canva.drawPathStroke(color, path, 8.0f, microtess::stroke_cap::round,
+                                     microtess::stroke_line_join::round, 4, no_dash, 0);
+            });
+            // tessellation on every draw, of the float path and of the same outline in fixed point
+            fixed_path_t fixed{};
+            for (const auto & point : points)
+                fixed.lineTo({fixed_number<>(point.x), fixed_number<>(point.y)});
+            fixed.closePath();
+            suite.run("drawPathFill/retessellate", canva, int(points.size()), [&]() {
+                path.invalidate();
+                canva.drawPathFill(color, path, microtess::fill_rule::non_zero,
+                                   microtess::tess_quality::better);
+            });
+            suite.run("drawPathFill/retessellate/fixed", canva, int(points.size()), [&]() {
+                fixed.invalidate();
+                canva.drawPathFill(color, fixed, microtess::fill_rule::non_zero,
+                                   microtess::tess_quality::better);
+            });
+            suite.run("drawPathStroke/retessellate", canva, int(points.size()), [&]() {
+                path.invalidate();
+                canva.drawPathStroke(color, path, 8.0f, microtess::stroke_cap::round,
+                                     microtess::stroke_line_join::round, 4, no_dash, 0);
+            });
+            suite.run("drawPathStroke/retessellate/fixed", canva, int(points.size()), [&]() {
+                fixed.invalidate();
+                canva.drawPathStroke(color, fixed, 8.0f, microtess::stroke_cap::round,
+                                     microtess::stroke_line_join::round, 4, no_dash, 0);
+            });
+            canva.updatePathStrokeMode(path_stroke_mode::gpu);
+            suite.run("drawPathStroke/gpu", canva, int(points.size()), [&]() {
+                canva.drawPathStroke(color, path, 8.0f, microtess::stroke_cap::round,
+                                     microtess::stroke_line_join::round, 4, no_dash, 0);
+            });
+            // marching ants, the offset changes on every draw
+            int ants = 0;
+            suite.run("drawPathStroke/gpu/dashed", canva, int(points.size()), [&]() {
+                canva.drawPathStroke(color, path, 8.0f, microtess::stroke_cap::butt,
+                                     microtess::stroke_line_join::round, 4, dash, ants++);
+            });
+            canva.updatePathStrokeMode(path_stroke_mode::tessellate);
+            suite.run("drawPathStroke/dashed", canva, int(points.size()), [&]() {
+                canva.drawPathStroke(color, path, 8.0f, microtess::stroke_cap::butt,
+                                     microtess::stroke_line_join::round, 4, dash, ants++);
+            });
+            // batch tessellation of independent paths, nothing is drawn
+            std::vector<path_t> batch(tessellated_batch);
+            for (auto & item : batch) item.linesTo(points).closePath();
+            const auto tessellate_batch = [&](tessellation_pool & pool) {
+                for (auto & item : batch) item.invalidate();
+                tessellate_all(batch.data(), unsigned(batch.size()), tessellate_options{}, pool);
+            };
+            suite.run("tessellate_all/single_thread", canva, int(points.size())*tessellated_batch,
+                      [&]() { tessellate_batch(single_thread); });
+            suite.run("tessellate_all", canva, int(points.size())*tessellated_batch,
+                      [&]() { tessellate_batch(tessellation_pool::shared()); });
+        }
+        // hit testing, against testing every triangle. nothing is drawn
+        if(suite.wants("hit_test")) {
+            const float cell = s/float(hit_test_grid);
+            std::vector<path_t> paths(hit_test_grid*hit_test_grid);
+            hit_test_scene<path_t> scene;
+            for (unsigned ix = 0; ix < paths.size(); ++ix) {
+                const auto outline = star(hit_test_star, cell*(float(ix%hit_test_grid) + 0.5f),
+                                          cell*(float(ix/hit_test_grid) + 0.5f), cell*0.7f);
+                paths[ix].linesTo(outline).closePath();
+                scene.add(paths[ix], tessellate_options{});
+            }
+            scene.update();
+            struct indexed_triangle { triangles_bvh<>::triangle_t triangle; int index; };
+            std::vector<indexed_triangle> all;
+            for (unsigned ix = 0; ix < paths.size(); ++ix) {
+                const auto & fill = paths[ix].buffers_fill();
+                triangles::iterate_triangles(fill.output_indices.data(), fill.output_indices.size(),
+                             triangles::microtess_indices_type_to_nitrogl(fill.output_indices_type),
+                             [&](triangles::index, triangles::index a, triangles::index b,
+                                 triangles::index c, triangles::index, triangles::index, triangles::index) {
+                    const auto & v = fill.output_vertices;
+                    all.push_back({{v[a], v[b], v[c]}, int(ix)});
+                });
+            }
+            unsigned seed = 1;
+            const auto next_point = [&]() {
+                seed = seed*1664525u + 1013904223u;
+                return vec2f{s*float(seed>>16)/65535.0f, s*float(seed & 0xffff)/65535.0f};
+            };
+            volatile int hit = 0;
+            suite.run("hit_test/pick", canva, int(all.size()), [&]() {
+                hit = scene.pick(next_point());
+            });
+            suite.run("hit_test/pick/brute_force", canva, int(all.size()), [&]() {
+                const auto point = next_point();
+                int top = -1;
+                for (const auto & item : all)
+                    if(item.index > top && triangles_bvh<>::contains(item.triangle, point))
+                        top = item.index;
+                hit = top;
+            });
+            suite.run("hit_test/query", canva, int(all.size()), [&]() {
+                const auto point = next_point();
+                int count = 0;
+                scene.query(rectf{point.x, point.y, point.x + cell*2, point.y + cell*2},
+                            [&](unsigned) { ++count; });
+                hit = count;
+            });
+            // a path changes every update, the scene is refitted
+            unsigned changed = 0;
+            suite.run("hit_test/update", canva, int(all.size()), [&]() {
+                paths[(changed++)%paths.size()].invalidate();
+                hit = int(scene.update());
+            });
+        }
+        target.del();
+        target_ms.del();
+    }
+    return suite.finish();
+}
@@ -0,0 +1,83 @@
+#include "src/benchmark.h"
+#include <nitrogl/samplers/color_sampler.h>
+#include <nitrogl/samplers/texture_sampler.h>
+#include <nitrogl/math.h>
+
+using namespace nitrogl;
+
+/**
+ * rect, quadrilateral, mask, triangles, interleaved triangles and lines
+ */
+int main(int argc, char ** argv) {
+    benchmark_suite suite("draw_primitives", argc, argv);
+    color_sampler color{1.0f, 0.0f, 0.0f, 0.5f};
+    auto image = gl_texture(64, 64, GL_RGBA, true);
+    {
+        std::vector<unsigned char> texels(64*64*4, 255);
+        image.uploadImage(GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+    }
+    texture_sampler texture{image};
+
+    for (int size : suite.canvas_sizes()) {
+        auto target = gl_texture::empty(size, size, GL_RGBA, true);
+        canvas canva(target);
+        canva.clear(1.0f, 1.0f, 1.0f, 1.0f);
+        const float s = float(size);
+
+        suite.run("drawRect", canva, 1, [&]() {
+            canva.drawRect(color, s*0.25f, s*0.25f, s*0.75f, s*0.75f);
+        });
+        suite.run("drawRect/texture", canva, 1, [&]() {
+            canva.drawRect(texture, s*0.25f, s*0.25f, s*0.75f, s*0.75f);
+        });
+        suite.run("drawRect/full_canvas", canva, 1, [&]() {
+            canva.drawRect(color, 0.0f, 0.0f, s, s);
+        });
+        suite.run("drawQuadrilateral", canva, 1, [&]() {
+            canva.drawQuadrilateral(texture, s*0.1f, s*0.1f, s*0.9f, s*0.2f,
+                                    s*0.7f, s*0.9f, s*0.3f, s*0.8f);
+        });
+        suite.run("drawMask", canva, 1, [&]() {
+            canva.drawMask(texture, channels::channel::alpha_channel, 0.0f, 0.0f, s, s);
+        });
+
+        for (int count : suite.primitive_counts()) {
+            // a grid of independent triangles covering the canvas
+            const int cols = int(math::sqrt(float(count))) + 1;
+            const float cell = s/float(cols);
+            std::vector<vec2f> vertices; std::vector<canvas::index> indices;
+            std::vector<float> xyuv;
+            for (int ix = 0; ix < count; ++ix) {
+                const float x = cell*float(ix%cols), y = cell*float(ix/cols);
+                const auto base = canvas::index(vertices.size());
+                vertices.push_back({x, y});
+                vertices.push_back({x + cell, y});
+                vertices.push_back({x, y + cell});
+                indices.push_back(base); indices.push_back(base+1); indices.push_back(base+2);
+                const float xyuv_tri[12] = { x, y, 0.0f, 0.0f, x + cell, y, 1.0f, 0.0f,
+                                             x, y + cell, 0.0f, 1.0f };
+                xyuv.insert(xyuv.end(), xyuv_tri, xyuv_tri + 12);
+            }
+            suite.run("drawTriangles", canva, count, [&]() {
+                canva.drawTriangles(color, triangles::indices::TRIANGLES,
+                                    vertices.data(), canvas::index(vertices.size()),
+                                    indices.data(), canvas::index(indices.size()));
+            });
+            suite.run("drawInterleavedTriangles", canva, count, [&]() {
+                canva.drawInterleavedTriangles(texture, triangles::indices::TRIANGLES,
+                                               xyuv.data(), canvas::index(xyuv.size()),
+                                               indices.data(), canvas::index(indices.size()));
+            });
+            // a zig-zag poly-line of count segments
+            std::vector<vec2f> points;
+            for (int ix = 0; ix <= count; ++ix)
+                points.push_back({s*float(ix)/float(count), (ix%2) ? s*0.9f : s*0.1f});
+            suite.run("drawLines", canva, count, [&]() {
+                canva.drawLines(color, points.data(), unsigned(points.size()));
+            });
+        }
+        target.del();
+    }
+    image.del();
+    return suite.finish();
+}
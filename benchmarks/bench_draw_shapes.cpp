@@ -0,0 +1,64 @@
+#include "src/benchmark.h"
+#include <nitrogl/samplers/color_sampler.h>
+#include <nitrogl/math.h>
+#include <vector>
+
+using namespace nitrogl;
+
+/**
+ * analytic shapes: circle, arc, pie and rounded rect, single and batched (instanced)
+ */
+int main(int argc, char ** argv) {
+    benchmark_suite suite("draw_shapes", argc, argv);
+    color_sampler fill{1.0f, 0.0f, 0.0f, 1.0f};
+    color_sampler stroke{0.0f, 0.0f, 1.0f, 1.0f};
+    const float from = math::deg_to_rad(0.0f), to = math::deg_to_rad(270.0f);
+
+    for (int size : suite.canvas_sizes()) {
+        auto target = gl_texture::empty(size, size, GL_RGBA, true);
+        canvas canva(target);
+        canva.clear(1.0f, 1.0f, 1.0f, 1.0f);
+        const float s = float(size), c = s*0.5f, r = s*0.3f;
+
+        suite.run("drawCircle", canva, 1, [&]() {
+            canva.drawCircle(fill, stroke, c, c, r, 4.0f);
+        });
+        suite.run("drawArc", canva, 1, [&]() {
+            canva.drawArc(fill, stroke, c, c, r, from, to, r*0.5f, 4.0f);
+        });
+        suite.run("drawPie", canva, 1, [&]() {
+            canva.drawPie(fill, stroke, c, c, r, from, to, 4.0f);
+        });
+        suite.run("drawRoundedRect", canva, 1, [&]() {
+            canva.drawRoundedRect(fill, stroke, s*0.2f, s*0.2f, s*0.8f, s*0.8f, s*0.1f, 4.0f);
+        });
+        // batches of small shapes on a grid, one call vs. a call per shape
+        for (int count : suite.primitive_counts()) {
+            std::vector<circle_instance> circles;
+            std::vector<rounded_rect_instance> rects;
+            int side = int(math::sqrt(float(count)));
+            if(side*side < count) ++side;
+            const float cell = s/float(side), cr = cell*0.4f;
+            for (int ix = 0; ix < count; ++ix) {
+                const float x = float(ix%side)*cell, y = float(ix/side)*cell;
+                const color_t tint{float(ix%7)/6.0f, 1.0f, 1.0f, 1.0f}, white{1.0f, 1.0f, 1.0f, 1.0f};
+                circles.push_back({x+cell*0.5f, y+cell*0.5f, cr, 1.0f, tint, white,
+                                   mat3f::identity()});
+                rects.push_back({x, y, x+cell*0.9f, y+cell*0.9f, cell*0.1f, 1.0f, tint, white,
+                                 mat3f::identity()});
+            }
+            suite.run("drawCircles", canva, count, [&]() {
+                canva.drawCircles(fill, stroke, circles.data(), canvas::index(count));
+            });
+            suite.run("drawCircle/loop", canva, count, [&]() {
+                for (const auto & i : circles)
+                    canva.drawCircle(fill, stroke, i.x, i.y, i.radius, i.stroke);
+            });
+            suite.run("drawRoundedRects", canva, count, [&]() {
+                canva.drawRoundedRects(fill, stroke, rects.data(), canvas::index(count));
+            });
+        }
+        target.del();
+    }
+    return suite.finish();
+}
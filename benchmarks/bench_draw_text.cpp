@@ -0,0 +1,54 @@
+#include "src/benchmark.h"
+#include <nitrogl/math.h>
+#include <string>
+
+using namespace nitrogl;
+
+// a synthetic mono-space font of 8x8 glyphs, for printable ascii, in a 16x6 grid
+static text::bitmap_font<128> mono_font() {
+    auto bitmap = gl_texture(128, 48, GL_RGBA, true);
+    std::vector<unsigned char> texels(128*48*4);
+    for (size_t ix = 0; ix < texels.size(); ix+=4) {
+        const int x = int(ix/4)%128, y = int(ix/4)/128;
+        const unsigned char v = ((x%8)>0 && (x%8)<7 && (y%8)>0 && (y%8)<7) ? 255 : 0;
+        texels[ix] = texels[ix+1] = texels[ix+2] = texels[ix+3] = v;
+    }
+    bitmap.uploadImage(GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+    text::bitmap_font<128> font(nitrogl::traits::move(bitmap));
+    font.nativeSize = 8; font.lineHeight = 10; font.baseline = 8;
+    font.width = 128; font.height = 48;
+    for (int id = 32; id < 128; ++id) {
+        const int cell = id - 32;
+        font.addChar(id, (cell%16)*8, (cell/16)*8, 8, 8, 0, 0, 8);
+    }
+    font.glyphs_count = 128 - 32 + 1;
+    return font;
+}
+
+/**
+ * bitmap text, primitives are the amount of characters
+ */
+int main(int argc, char ** argv) {
+    benchmark_suite suite("draw_text", argc, argv);
+    auto font = mono_font();
+    text::text_format format;
+    format.wordWrap = text::wordWrap::break_word;
+
+    for (int size : suite.canvas_sizes()) {
+        auto target = gl_texture::empty(size, size, GL_RGBA, true);
+        canvas canva(target);
+        canva.clear(0.0f, 0.0f, 0.0f, 1.0f);
+
+        for (int count : suite.primitive_counts()) {
+            // text beyond the canvas area is laid out and then clipped
+            if(count > 4096) continue;
+            std::string text;
+            for (int ix = 0; ix < count; ++ix) text.push_back(char(33 + ix%94));
+            suite.run("drawText", canva, count, [&]() {
+                canva.drawText(text.c_str(), font, {1.0f, 1.0f, 1.0f, 1.0f}, format, 0, 0, size, size);
+            });
+        }
+        target.del();
+    }
+    return suite.finish();
+}
@@ -0,0 +1,195 @@
+#include "src/headless.h"
+#include <nitrogl/canvas.h>
+#include <nitrogl/samplers/color_sampler.h>
+#include <nitrogl/math.h>
+#include <cstring>
+#include <vector>
+
+using namespace nitrogl;
+
+/**
+ * equivalence check of hardware blending (see nitrogl::hardware_blending): every composition of
+ * the capability table is drawn twice, hardware blended and through the shader path, over opaque
+ * and translucent backdrops, with opaque and translucent sources, and with geometry that covers
+ * pixels partially (edge antialiasing, curves, dashes and shapes). The pixels must be the same,
+ * up to rounding. Prints the failing cases, exits with 1 if any.
+ *
+ * Command line:
+ *   --verbose    print every case
+ */
+
+struct composition_t { blend_mode_t blend_mode; compositor_t compositor; const char * name; };
+struct backdrop_t { float r, g, b, a; const char * name; };
+struct source_t { float r, g, b, a, opacity; const char * name; };
+
+static constexpr int size = 64;
+// rounding of the shader path and of the blending units may differ by a step
+static constexpr int tolerance = 2;
+
+static const composition_t compositions[] = {
+        { blend_modes::Normal(), porter_duff::SourceOver(), "Normal/SourceOver" },
+        { blend_modes::Normal(), porter_duff::Clear(), "Normal/Clear" },
+        { blend_modes::Normal(), porter_duff::Copy(), "Normal/Copy" },
+        { blend_modes::Normal(), porter_duff::Source(), "Normal/Source" },
+        { blend_modes::Normal(), porter_duff::Destination(), "Normal/Destination" },
+        { blend_modes::Normal(), porter_duff::SourceIn(), "Normal/SourceIn" },
+        { blend_modes::Normal(), porter_duff::SourceOut(), "Normal/SourceOut" },
+        { blend_modes::Normal(), porter_duff::SourceAtop(), "Normal/SourceAtop" },
+        { blend_modes::Normal(), porter_duff::DestinationOver(), "Normal/DestinationOver" },
+        { blend_modes::Normal(), porter_duff::DestinationIn(), "Normal/DestinationIn" },
+        { blend_modes::Normal(), porter_duff::DestinationOut(), "Normal/DestinationOut" },
+        { blend_modes::Normal(), porter_duff::DestinationAtop(), "Normal/DestinationAtop" },
+        { blend_modes::Normal(), porter_duff::XOR(), "Normal/XOR" },
+        { blend_modes::Normal(), porter_duff::Lighter(), "Normal/Lighter" },
+        { blend_modes::Screen(), porter_duff::SourceOver(), "Screen/SourceOver" },
+        { blend_modes::Exclusion(), porter_duff::SourceOver(), "Exclusion/SourceOver" },
+        { blend_modes::Multiply(), porter_duff::SourceOver(), "Multiply/SourceOver" },
+        { blend_modes::Darken(), porter_duff::SourceOver(), "Darken/SourceOver" },
+        { blend_modes::Lighten(), porter_duff::SourceOver(), "Lighten/SourceOver" },
+        { blend_modes::LinearDodge(), porter_duff::SourceOver(), "LinearDodge/SourceOver" },
+};
+
+// pre-multiplied
+static const backdrop_t backdrops[] = {
+        { 0.2f, 0.6f, 0.9f, 1.0f, "opaque backdrop" },
+        { 0.1f, 0.3f, 0.2f, 0.5f, "translucent backdrop" },
+};
+
+static const source_t sources[] = {
+        { 0.9f, 0.3f, 0.1f, 1.0f, 1.0f, "opaque source" },
+        { 0.9f, 0.3f, 0.1f, 0.6f, 1.0f, "translucent source" },
+        { 0.9f, 0.3f, 0.1f, 1.0f, 0.5f, "half opacity" },
+};
+
+static const char * const geometries[] = {
+        "rects", "polygon/edge_aa", "path/curves", "stroke/gpu/dashed", "circle",
+};
+
+// two overlapping draws, so the second one blends over the first
+static void draw(canvas & canva, int geometry, sampler_t & sampler, float opacity) {
+    const float s = float(size);
+    switch (geometry) {
+        case 0:
+            canva.drawRect(sampler, s*0.1f, s*0.1f, s*0.6f, s*0.6f, opacity);
+            canva.drawRect(sampler, s*0.3f, s*0.3f, s*0.9f, s*0.9f, opacity);
+            break;
+        case 1: {
+            canva.enableEdgeAntialiasing(true);
+            for (int pass = 0; pass < 2; ++pass) {
+                std::vector<vec2f> star;
+                for (int ix = 0; ix < 10; ++ix) {
+                    const float a = 2.0f*math::pi<float>()*float(ix)/10.0f + 0.3f*float(pass);
+                    const float r = (ix%2 ? 0.2f : 0.4f)*s;
+                    star.push_back({s*0.5f + r*math::cos(a), s*0.5f + r*math::sin(a)});
+                }
+                canva.drawPolygon<polygons::SIMPLE>(sampler, star.data(), canvas::index(star.size()),
+                                    mat3f::identity(), mat3f::identity(), opacity);
+            }
+            canva.enableEdgeAntialiasing(false);
+            break;
+        }
+        case 2: {
+            canva.updatePathFillMode(path_fill_mode::curves);
+            for (int pass = 0; pass < 2; ++pass) {
+                const float o = s*0.2f*float(pass);
+                path<> p;
+                p.moveTo({s*0.1f + o, s*0.5f});
+                p.quadraticCurveTo({s*0.1f + o, s*0.1f}, {s*0.5f + o, s*0.1f});
+                p.cubicBezierCurveTo({s*0.7f + o, s*0.3f}, {s*0.3f + o, s*0.6f}, {s*0.7f + o, s*0.8f});
+                p.closePath();
+                canva.drawPathFill(sampler, p, microtess::fill_rule::non_zero,
+                                   microtess::tess_quality::better, mat3f::identity(),
+                                   mat3f::identity(), opacity);
+            }
+            canva.updatePathFillMode(path_fill_mode::tessellate);
+            break;
+        }
+        case 3: {
+            // pieces of a stroke that overlap at joins take different arc lengths, so they may
+            // cover a pixel differently by dashes. The shader path keeps the last of them, and
+            // the hardware path the first (stencil), so the dashed lines have no joins
+            canva.updatePathStrokeMode(path_stroke_mode::gpu);
+            dynamic_array<int> dash{};
+            dash.push_back(7); dash.push_back(4);
+            for (int pass = 0; pass < 2; ++pass) {
+                path<> p;
+                p.moveTo({s*0.1f, s*(0.2f + 0.5f*float(pass))}).lineTo({s*0.9f, s*(0.6f - 0.3f*float(pass))});
+                canva.drawPathStroke(sampler, p, 6.0f, microtess::stroke_cap::round,
+                                     microtess::stroke_line_join::round, 4, dash, 0,
+                                     mat3f::identity(), mat3f::identity(), opacity);
+            }
+            canva.updatePathStrokeMode(path_stroke_mode::tessellate);
+            break;
+        }
+        case 4:
+            canva.drawCircle(sampler, sampler, s*0.4f, s*0.4f, s*0.3f, 0.0f, opacity);
+            canva.drawCircle(sampler, sampler, s*0.6f, s*0.6f, s*0.3f, 0.0f, opacity);
+            break;
+        default: break;
+    }
+}
+
+static std::vector<unsigned char> render(bool hardware, const composition_t & composition,
+                                         const backdrop_t & backdrop, const source_t & source,
+                                         int geometry) {
+    auto target = gl_texture::empty(size, size, GL_RGBA, true);
+    {
+        canvas canva(target);
+        canva.enableHardwareBlending(hardware);
+        canva.clear(backdrop.r, backdrop.g, backdrop.b, backdrop.a);
+        canva.update_composition(composition.blend_mode, composition.compositor);
+        color_sampler color{source.r, source.g, source.b, source.a};
+        draw(canva, geometry, color, source.opacity);
+        canva.flush();
+    }
+    std::vector<unsigned char> pixels(size*size*4);
+    fbo_t fbo;
+    fbo.attachTexture(target);
+    fbo.bind();
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    fbo_t::unbind();
+    gl_state::get().invalidate();
+    return pixels;
+}
+
+int main(int argc, char ** argv) {
+    bool verbose = false;
+    for (int ix = 1; ix < argc; ++ix)
+        if(!strcmp(argv[ix], "--verbose")) verbose = true;
+    headless_context context;
+    context.create();
+    fprintf(stderr, "nitro{gl} hardware blending check on %s | %s | %s\n",
+            headless_context::platform(), (const char *)glGetString(GL_VERSION),
+            (const char *)glGetString(GL_RENDERER));
+
+    int cases = 0, failures = 0;
+    for (const auto & composition : compositions) {
+        for (const auto & backdrop : backdrops) {
+            for (const auto & source : sources) {
+                for (int geometry = 0; geometry < int(sizeof(geometries)/sizeof(geometries[0])); ++geometry) {
+                    const auto hardware = render(true, composition, backdrop, source, geometry);
+                    const auto shader = render(false, composition, backdrop, source, geometry);
+                    int max_difference = 0, pixels = 0;
+                    for (int ix = 0; ix < size*size; ++ix) {
+                        int difference = 0;
+                        for (int c = 0; c < 4; ++c) {
+                            const int d = abs(int(hardware[ix*4 + c]) - int(shader[ix*4 + c]));
+                            difference = d > difference ? d : difference;
+                        }
+                        if(difference > tolerance) ++pixels;
+                        max_difference = difference > max_difference ? difference : max_difference;
+                    }
+                    const bool failed = pixels!=0;
+                    ++cases; failures += failed ? 1 : 0;
+                    if(failed || verbose)
+                        printf(" - %s %-24s %-20s %-18s %-18s | max difference %3d, pixels %4d\n",
+                               failed ? "FAIL" : "ok  ", composition.name, backdrop.name,
+                               source.name, geometries[geometry], max_difference, pixels);
+                }
+            }
+        }
+    }
+    printf("%d cases, %d failed\n", cases, failures);
+    context.destroy();
+    return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "src/headless.h"
+#include <nitrogl/ogl/texture_stream.h>
+#include <nitrogl/ogl/pixels_readback.h>
+#include <nitrogl/ogl/fbo.h>
+#include <cstring>
+#include <vector>
+
+using namespace nitrogl;
+
+/**
+ * round trip check of pixel streaming: frames are streamed into a texture (see
+ * nitrogl::texture_stream), by push() and by map()/submit(), and read back asynchronously (see
+ * nitrogl::pixels_readback), as is and pre-multiplied. More frames than the rings hold are in
+ * flight, so both wait for their buffers. Every frame must be delivered, in order, with its
+ * pixels. Prints the failing cases, exits with 1 if any.
+ *
+ * Command line:
+ *   --verbose    print every case
+ */
+
+// odd sizes, so rows of RGB frames are padded
+static constexpr int width = 61, height = 37;
+static constexpr int frames = 8;
+
+struct format_t { GLenum format; int channels; const char * name; };
+static const format_t formats[] = {
+        { GL_RGBA, 4, "RGBA" },
+        { GL_RGB, 3, "RGB" },
+};
+
+static unsigned char value(int frame, int x, int y, int c) {
+    return (unsigned char)((frame*37 + x*5 + y*11 + c*67) & 255);
+}
+
+struct delivery_t { int frame; pixels_alpha alpha; int pixels; };
+
+int main(int argc, char ** argv) {
+    bool verbose = false;
+    for (int ix = 1; ix < argc; ++ix)
+        if(!strcmp(argv[ix], "--verbose")) verbose = true;
+    headless_context context;
+    context.create();
+    fprintf(stderr, "nitro{gl} pixel streams check on %s | %s | %s\n",
+            headless_context::platform(), (const char *)glGetString(GL_VERSION),
+            (const char *)glGetString(GL_RENDERER));
+
+    int cases = 0, failures = 0;
+    for (const auto & f : formats) {
+        auto texture = gl_texture::empty(width, height, GL_RGBA, false);
+        fbo_t fbo;
+        fbo.attachTexture(texture);
+        std::vector<delivery_t> deliveries;
+        {
+            texture_stream<> stream(texture, f.format, GL_UNSIGNED_BYTE, 4);
+            pixels_readback<> readback;
+            const auto row_bytes = stream.rowBytes();
+            std::vector<unsigned char> frame(size_t(stream.frameBytes()));
+            for (int n = 0; n < frames; ++n) {
+                // rows of frames go from the bottom of the texture up
+                for (int y = 0; y < height; ++y)
+                    for (int x = 0; x < width; ++x)
+                        for (int c = 0; c < f.channels; ++c)
+                            frame[(height - 1 - y)*row_bytes + x*f.channels + c] = value(n, x, y, c);
+                if(n%2) {
+                    auto * memory = stream.map();
+                    if(memory) {
+                        memcpy(memory, frame.data(), frame.size());
+                        stream.submit();
+                    }
+                } else stream.push(frame.data());
+                const auto alpha = n%3==2 ? pixels_alpha::premultiply : pixels_alpha::as_is;
+                readback.read(fbo, height, rect_i(0, 0, width, height), alpha,
+                              [&deliveries, &f, n, alpha](const rect_i & r,
+                                                          const unsigned char * pixels,
+                                                          int stride) {
+                    int wrong = 0;
+                    for (int y = 0; y < r.height(); ++y) {
+                        for (int x = 0; x < r.width(); ++x) {
+                            const auto * p = pixels + y*stride + x*4;
+                            const int a = f.channels==4 ? value(n, x, y, 3) : 255;
+                            bool ok = p[3]==a;
+                            for (int c = 0; c < 3; ++c) {
+                                int expected = value(n, x, y, c);
+                                if(alpha==pixels_alpha::premultiply) expected = expected*a/255;
+                                ok = ok && abs(int(p[c]) - expected) <= 1;
+                            }
+                            wrong += ok ? 0 : 1;
+                        }
+                    }
+                    deliveries.push_back({n, alpha, wrong});
+                });
+                readback.poll();
+            }
+            readback.poll(true);
+        }
+        fbo_t::unbind();
+        texture.del();
+        gl_state::get().invalidate();
+        for (int n = 0; n < frames; ++n) {
+            const bool delivered = n < int(deliveries.size()) && deliveries[n].frame==n;
+            const int pixels = delivered ? deliveries[n].pixels : width*height;
+            const bool failed = pixels!=0;
+            ++cases; failures += failed ? 1 : 0;
+            if(failed || verbose)
+                printf(" - %s %-4s frame %d %-11s | %s, wrong pixels %4d\n",
+                       failed ? "FAIL" : "ok  ", f.name, n,
+                       n%3==2 ? "premultiply" : "as is",
+                       delivered ? "delivered" : "missing", pixels);
+        }
+    }
+    printf("%d cases, %d failed\n", cases, failures);
+    context.destroy();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+#include "src/headless.h"
+#include <nitrogl/tiled_canvas.h>
+#include <nitrogl/samplers/color_sampler.h>
+#include <nitrogl/math.h>
+#include <cstring>
+#include <vector>
+
+using namespace nitrogl;
+
+/**
+ * equivalence check of tiled rendering (see nitrogl::tiled_canvas): the same draws are rendered
+ * into a canvas directly, and recorded into a tiled canvas, with tiles that do not divide the
+ * canvas, and rendered into pixels and into a texture. The pixels must be the same, up to
+ * rounding. Prints the failing cases, exits with 1 if any.
+ *
+ * Command line:
+ *   --verbose    print every case
+ */
+
+static constexpr int width = 200, height = 150;
+// rounding of partially covered pixels may differ by a step
+static constexpr int tolerance = 2;
+
+struct samplers_t {
+    color_sampler red{0.9f, 0.2f, 0.1f, 1.0f};
+    color_sampler blue{0.1f, 0.3f, 0.8f, 0.7f};
+};
+
+// draws of the case, in canvas coordinates, over tile seams
+static void draw(canvas & canva, samplers_t & s, int command) {
+    switch (command) {
+        case 0:
+            canva.drawRect(s.red, 10.5f, 20.25f, 150.0f, 90.0f);
+            break;
+        case 1:
+            canva.update_composition(blend_modes::Multiply(), porter_duff::SourceOver());
+            canva.drawCircle(s.blue, s.red, 100.0f, 75.0f, 60.0f, 3.0f);
+            break;
+        case 2: {
+            canva.enableEdgeAntialiasing(true);
+            std::vector<vec2f> star;
+            for (int ix = 0; ix < 10; ++ix) {
+                const float a = 2.0f*math::pi<float>()*float(ix)/10.0f;
+                const float r = ix%2 ? 25.0f : 55.0f;
+                star.push_back({130.0f + r*math::cos(a), 70.0f + r*math::sin(a)});
+            }
+            canva.drawPolygon<polygons::SIMPLE>(s.blue, star.data(), canvas::index(star.size()));
+            canva.enableEdgeAntialiasing(false);
+            break;
+        }
+        case 3:
+            canva.drawRoundedRect(s.red, s.blue, 60.0f, 100.0f, 190.0f, 145.0f, 12.0f, 2.0f);
+            break;
+        default: break;
+    }
+}
+static constexpr int commands = 4;
+
+// top to bottom RGBA8 rows of a texture
+static std::vector<unsigned char> read(const gl_texture & texture) {
+    std::vector<unsigned char> pixels(width*height*4), rows(width*height*4);
+    fbo_t fbo;
+    fbo.attachTexture(texture);
+    fbo.bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    fbo_t::unbind();
+    gl_state::get().invalidate();
+    for (int y = 0; y < height; ++y)
+        memcpy(&rows[y*width*4], &pixels[(height - 1 - y)*width*4], width*4);
+    return rows;
+}
+
+static std::vector<unsigned char> render_direct(samplers_t & s) {
+    auto target = gl_texture::empty(width, height, GL_RGBA, true);
+    {
+        canvas canva(target);
+        canva.clear(0.0f, 0.0f, 0.0f, 0.0f);
+        for (int command = 0; command < commands; ++command) {
+            canva.update_composition(blend_modes::Normal(), porter_duff::SourceOver());
+            draw(canva, s, command);
+        }
+        canva.flush();
+    }
+    auto pixels = read(target);
+    target.del();
+    return pixels;
+}
+
+static void record(tiled_canvas<> & tiled, samplers_t & s) {
+    tiled.clear({0.0f, 0.0f, 0.0f, 0.0f});
+    for (int command = 0; command < commands; ++command)
+        tiled.record([&s, command](canvas & canva) { draw(canva, s, command); });
+}
+
+static std::vector<unsigned char> render_tiled_pixels(samplers_t & s, unsigned tile_size) {
+    std::vector<unsigned char> pixels(width*height*4);
+    tiled_canvas<> tiled(width, height, tile_size);
+    record(tiled, s);
+    tiled.renderToPixels([&](const rect_i & region, const unsigned char * p) {
+        for (int y = 0; y < region.height(); ++y)
+            memcpy(&pixels[((region.top + y)*width + region.left)*4],
+                   p + y*region.width()*4, size_t(region.width())*4);
+    });
+    return pixels;
+}
+
+static std::vector<unsigned char> render_tiled_texture(samplers_t & s, unsigned tile_size) {
+    auto target = gl_texture::empty(width, height, GL_RGBA, true);
+    {
+        tiled_canvas<> tiled(width, height, tile_size);
+        record(tiled, s);
+        tiled.renderToTexture(target);
+    }
+    auto pixels = read(target);
+    target.del();
+    return pixels;
+}
+
+int main(int argc, char ** argv) {
+    bool verbose = false;
+    for (int ix = 1; ix < argc; ++ix)
+        if(!strcmp(argv[ix], "--verbose")) verbose = true;
+    headless_context context;
+    context.create();
+    fprintf(stderr, "nitro{gl} tiled canvas check on %s | %s | %s\n",
+            headless_context::platform(), (const char *)glGetString(GL_VERSION),
+            (const char *)glGetString(GL_RENDERER));
+
+    int cases = 0, failures = 0;
+    {
+        samplers_t s;
+        const auto direct = render_direct(s);
+        const unsigned tile_sizes[] = { 64, 97, 256 };
+        for (unsigned tile_size : tile_sizes) {
+            for (int output = 0; output < 2; ++output) {
+                const auto tiled = output ? render_tiled_texture(s, tile_size) :
+                                            render_tiled_pixels(s, tile_size);
+                int max_difference = 0, pixels = 0;
+                for (int ix = 0; ix < width*height; ++ix) {
+                    int difference = 0;
+                    for (int c = 0; c < 4; ++c) {
+                        const int d = abs(int(direct[ix*4 + c]) - int(tiled[ix*4 + c]));
+                        difference = d > difference ? d : difference;
+                    }
+                    if(difference > tolerance) ++pixels;
+                    max_difference = difference > max_difference ? difference : max_difference;
+                }
+                const bool failed = pixels!=0;
+                ++cases; failures += failed ? 1 : 0;
+                if(failed || verbose)
+                    printf(" - %s tiles %3u %-16s | max difference %3d, pixels %4d\n",
+                           failed ? "FAIL" : "ok  ", tile_size,
+                           output ? "renderToTexture" : "renderToPixels", max_difference, pixels);
+            }
+        }
+    }
+    printf("%d cases, %d failed\n", cases, failures);
+    context.destroy();
+    return failures ? 1 : 0;
+}
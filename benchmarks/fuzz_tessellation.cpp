@@ -0,0 +1,239 @@
+#include <nitrogl/path.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Failure rates of path fill tessellation on degenerate input, float paths against fixed point
+ * paths (nitrogl::fixed_path). Every case is a set of closed contours on an integer lattice,
+ * so duplicate vertices, collinear runs, shared edges and exact intersections happen often.
+ * It is tessellated with the non-zero rule in a child process, and classified:
+ * - ok: a grid of samples off the lattice is covered by the triangles exactly where the
+ *   winding number of the contours is not zero
+ * - wrong: some samples are covered where they should not, or the other way around
+ * - crash: the tessellation terminated the process
+ * - hang: the tessellation did not finish in time
+ * Both number types see the same contours, scaled into the range of the fixed point numbers.
+ * POSIX only (fork).
+ *
+ * Command line:
+ *   --cases <count>       cases of every family (default 200)
+ *   --timeout <seconds>   time of a case, before it counts as a hang (default 5)
+ *   --out <file>          write JSON to file as well
+ *
+ * JSON: { "suite", "cases", "results": [ { "family", "number", "ok", "wrong", "crash", "hang" } ] }
+ * Speed of the tessellation is measured by bench_draw_paths (drawPathFill/retessellate).
+ */
+
+using contour_t = std::vector<std::pair<int, int>>;
+using contours_t = std::vector<contour_t>;
+using fixed_t = nitrogl::fixed_number<>;
+
+enum outcome { ok, wrong, crash, hang, outcomes };
+static const char * const outcome_names[] = { "ok", "wrong", "crash", "hang" };
+
+// samples of the coverage test, per axis
+static constexpr int samples = 32;
+
+struct random_t {
+    unsigned state;
+    explicit random_t(unsigned seed) : state(seed*2654435761u + 7u) {}
+    unsigned next() { state = state*1664525u + 1013904223u; return state>>8; }
+    int below(int count) { return int(next()%unsigned(count)); }
+};
+
+struct family_t {
+    const char * name;
+    int lattice; // coordinates are in [0, lattice)
+    float scale; // of the lattice into path coordinates
+    contours_t (*make)(random_t & random, int lattice);
+};
+
+// random self intersecting contours, with repeated vertices on coarse lattices
+static contours_t random_contours(random_t & random, int lattice) {
+    contours_t contours;
+    const int count = 1 + random.below(3);
+    for (int ix = 0; ix < count; ++ix) {
+        contour_t contour;
+        const int vertices = 3 + random.below(9);
+        for (int jx = 0; jx < vertices; ++jx) {
+            contour.push_back({random.below(lattice), random.below(lattice)});
+            if(lattice <= 8 && random.below(4)==0) contour.push_back(contour.back());
+        }
+        contours.push_back(contour);
+    }
+    return contours;
+}
+
+// star shaped outlines snapped to the lattice: collinear runs, duplicates and spikes
+static contours_t snapped_star(random_t & random, int lattice) {
+    contour_t contour;
+    const int vertices = 8 + random.below(40);
+    const double center = lattice/2.0;
+    for (int ix = 0; ix < vertices; ++ix) {
+        const double a = 6.283185307179586*ix/vertices;
+        const double r = center*(0.25 + random.below(600)/800.0);
+        contour.push_back({int(center + r*cos(a) + 0.5), int(center + r*sin(a) + 0.5)});
+    }
+    return contours_t{contour};
+}
+
+// axis aligned squares, that share edges and corners
+static contours_t touching_squares(random_t & random, int lattice) {
+    contours_t contours;
+    const int count = 2 + random.below(6);
+    for (int ix = 0; ix < count; ++ix) {
+        const int x = random.below(lattice*3/4), y = random.below(lattice*3/4);
+        const int w = 1 + random.below(lattice/4), h = 1 + random.below(lattice/4);
+        contours.push_back({{x, y}, {x + w, y}, {x + w, y + h}, {x, y + h}});
+    }
+    return contours;
+}
+
+// thin triangles, their middle vertex is a few lattice steps off the line of the others
+static contours_t slivers(random_t & random, int lattice) {
+    contours_t contours;
+    const int count = 1 + random.below(4);
+    for (int ix = 0; ix < count; ++ix) {
+        const int x = random.below(lattice), y = random.below(lattice);
+        const int dx = random.below(lattice) - x, dy = random.below(lattice) - y;
+        const int off = 1 + random.below(3);
+        contours.push_back({{x, y}, {x + dx/2, y + dy/2 + off}, {x + dx, y + dy}});
+    }
+    return contours;
+}
+
+static const family_t families[] = {
+        { "random/lattice 8", 8, 32.0f, random_contours },
+        { "random/lattice 64", 64, 4.0f, random_contours },
+        { "random/lattice 4096", 4096, 0.25f, random_contours },
+        { "snapped stars", 16, 16.0f, snapped_star },
+        { "touching squares", 16, 16.0f, touching_squares },
+        { "slivers", 4096, 0.25f, slivers },
+};
+
+static int winding(const contours_t & contours, double x, double y) {
+    int w = 0;
+    for (const auto & c : contours) {
+        for (size_t ix = 0; ix < c.size(); ++ix) {
+            const auto & a = c[ix], & b = c[(ix + 1)%c.size()];
+            const double cross = double(b.first - a.first)*(y - a.second) -
+                                 (x - a.first)*double(b.second - a.second);
+            if(a.second <= y) { if(b.second > y && cross > 0) ++w; }
+            else { if(b.second <= y && cross < 0) --w; }
+        }
+    }
+    return w;
+}
+
+// tessellate and test the coverage, returns ok or wrong
+template<typename number>
+static outcome tessellate(const contours_t & contours, const family_t & family) {
+    microtess::path<number, dynamic_array, nitrogl::std_rebind_allocator<>> path;
+    for (const auto & c : contours) {
+        for (size_t ix = 0; ix < c.size(); ++ix) {
+            const microtess::vec2<number> v{number(float(c[ix].first)*family.scale),
+                                            number(float(c[ix].second)*family.scale)};
+            if(ix==0) path.moveTo(v); else path.lineTo(v);
+        }
+        path.closePath();
+    }
+    const auto & buffers = path.tessellateFill(microtess::fill_rule::non_zero,
+                                               microtess::tess_quality::better, false, false);
+    const auto & v = buffers.output_vertices;
+    const auto & indices = buffers.output_indices;
+    const double step = double(family.lattice)/samples;
+    for (int sy = 0; sy < samples; ++sy) {
+        for (int sx = 0; sx < samples; ++sx) {
+            // off the lattice, so samples are never on edges
+            const double x = (sx + 0.3137)*step, y = (sy + 0.5791)*step;
+            const double X = x*family.scale, Y = y*family.scale;
+            bool covered = false;
+            for (unsigned ix = 0; ix + 2 < indices.size() && !covered; ix += 3) {
+                const auto & a = v[indices[ix]], & b = v[indices[ix + 1]], & c = v[indices[ix + 2]];
+                const double ax = float(a.x), ay = float(a.y), bx = float(b.x), by = float(b.y);
+                const double cx = float(c.x), cy = float(c.y);
+                const double d1 = (bx - ax)*(Y - ay) - (by - ay)*(X - ax);
+                const double d2 = (cx - bx)*(Y - by) - (cy - by)*(X - bx);
+                const double d3 = (ax - cx)*(Y - cy) - (ay - cy)*(X - cx);
+                if(d1==0 && d2==0 && d3==0) continue;
+                covered = !((d1 < 0 || d2 < 0 || d3 < 0) && (d1 > 0 || d2 > 0 || d3 > 0));
+            }
+            if(covered != (winding(contours, x, y)!=0)) return wrong;
+        }
+    }
+    return ok;
+}
+
+// run a case in a child process, so crashes and hangs are outcomes as well
+template<typename number>
+static outcome run_case(const contours_t & contours, const family_t & family, unsigned timeout) {
+    const pid_t pid = fork();
+    if(pid==0) {
+        alarm(timeout);
+        _exit(int(tessellate<number>(contours, family)));
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if(WIFEXITED(status)) return WEXITSTATUS(status)==0 ? ok : wrong;
+    return WTERMSIG(status)==SIGALRM ? hang : crash;
+}
+
+struct tally_t {
+    int counts[outcomes] = {};
+};
+
+int main(int argc, char ** argv) {
+    int cases = 200;
+    unsigned timeout = 5;
+    std::string out;
+    for (int ix = 1; ix < argc; ++ix) {
+        if(!strcmp(argv[ix], "--cases") && ix + 1 < argc) cases = atoi(argv[++ix]);
+        else if(!strcmp(argv[ix], "--timeout") && ix + 1 < argc) timeout = unsigned(atoi(argv[++ix]));
+        else if(!strcmp(argv[ix], "--out") && ix + 1 < argc) out = argv[++ix];
+    }
+    fprintf(stderr, "nitro{gl} tessellation fuzz, %d cases per family, non-zero fill\n", cases);
+
+    const unsigned count = sizeof(families)/sizeof(families[0]);
+    std::vector<tally_t> tallies(2*count);
+    for (unsigned f = 0; f < count; ++f) {
+        const auto & family = families[f];
+        auto & t_float = tallies[2*f], & t_fixed = tallies[2*f + 1];
+        for (int ix = 0; ix < cases; ++ix) {
+            random_t random{unsigned(ix)};
+            const auto contours = family.make(random, family.lattice);
+            t_float.counts[run_case<float>(contours, family, timeout)]++;
+            t_fixed.counts[run_case<fixed_t>(contours, family, timeout)]++;
+        }
+        for (int n = 0; n < 2; ++n) {
+            const auto & t = tallies[2*f + n];
+            printf(" - %-20s %-6s |", family.name, n ? "fixed" : "float");
+            for (int o = 0; o < outcomes; ++o)
+                printf(" %s %5.1f%%", outcome_names[o], 100.0*t.counts[o]/cases);
+            printf("\n");
+        }
+    }
+
+    if(!out.empty()) {
+        FILE * f = fopen(out.c_str(), "w");
+        if(!f) { fprintf(stderr, " - ERROR: could not open %s\n", out.c_str()); return 1; }
+        fprintf(f, "{\n  \"suite\": \"fuzz_tessellation\",\n  \"cases\": %d,\n  \"results\": [", cases);
+        for (unsigned ix = 0; ix < tallies.size(); ++ix) {
+            const auto & t = tallies[ix];
+            fprintf(f, "%s\n    { \"family\": \"%s\", \"number\": \"%s\"", ix ? "," : "",
+                    families[ix/2].name, ix%2 ? "fixed" : "float");
+            for (int o = 0; o < outcomes; ++o)
+                fprintf(f, ", \"%s\": %d", outcome_names[o], t.counts[o]);
+            fprintf(f, " }");
+        }
+        fprintf(f, "\n  ]\n}\n");
+        fclose(f);
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,211 @@
+#pragma once
+
+/**
+ * Minimal benchmark runner for canvas draw calls on a headless context.
+ *
+ * Every case is a (draw entry point, canvas size, primitives count) triple, and is measured in
+ * two phases:
+ * 1. throughput: the draw is repeated until the minimal time has passed, CPU time of every call
+ *    is taken, and the GPU is drained at the end, so draws/sec includes GPU work
+ * 2. GPU time: a few more calls, each one wrapped with a GL_TIME_ELAPSED query. Note, that
+ *    software rasterizers may defer rasterization past the query, prefer draws/sec there
+ *
+ * Results are written as JSON, so they can be tracked over releases:
+ * { "suite", "platform", "gl_version", "gl_renderer", "nitrogl_version",
+ *   "results": [ { "name", "canvas": [w, h], "primitives", "iterations", "draws_per_sec",
+ *                  "cpu_ns_per_call": { "mean", "median", "min" },
+ *                  "gpu_ns_per_call": { "mean", "median", "min" } } ] }
+ *
+ * Command line:
+ *   --out <file>          write JSON to file instead of stdout
+ *   --filter <substring>  run only cases whose name contains substring
+ *   --min-time <seconds>  minimal time of the throughput phase of every case (default 0.25)
+ *   --quick               single, small canvas size and short runs, for smoke tests
+ */
+
+#include "headless.h"
+#include <nitrogl/canvas.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef NITROGL_BENCH_VERSION
+#define NITROGL_BENCH_VERSION "unknown"
+#endif
+
+class benchmark_suite {
+public:
+    struct stats_t {
+        double mean=0, median=0, min=0;
+    };
+    struct result_t {
+        std::string name;
+        int width=0, height=0;
+        int primitives=0;
+        long iterations=0;
+        double draws_per_sec=0;
+        stats_t cpu_ns, gpu_ns;
+    };
+
+private:
+    static constexpr int gpu_samples = 32;
+    using clock = std::chrono::steady_clock;
+
+    headless_context _context;
+    std::string _suite, _out, _filter;
+    double _min_time;
+    bool _quick;
+    std::vector<result_t> _results;
+    GLuint _queries[gpu_samples];
+
+    static stats_t stats_of(std::vector<double> & samples) {
+        stats_t s;
+        if(samples.empty()) return s;
+        std::sort(samples.begin(), samples.end());
+        double sum=0; for (double v : samples) sum+=v;
+        s.mean = sum/double(samples.size());
+        s.median = samples[samples.size()/2];
+        s.min = samples.front();
+        return s;
+    }
+
+    static void write_escaped(FILE * f, const char * str) {
+        fputc('"', f);
+        for (; *str; ++str) {
+            if(*str=='"' || *str=='\\') fputc('\\', f);
+            fputc(*str, f);
+        }
+        fputc('"', f);
+    }
+
+    static void write_stats(FILE * f, const char * name, const stats_t & s) {
+        fprintf(f, "\"%s\": { \"mean\": %.1f, \"median\": %.1f, \"min\": %.1f }", name, s.mean, s.median, s.min);
+    }
+
+public:
+    benchmark_suite(const char * suite, int argc, char ** argv) :
+            _suite(suite), _min_time(0.25), _quick(false), _queries() {
+        for (int ix = 1; ix < argc; ++ix) {
+            const bool has_value = ix+1 < argc;
+            if(!strcmp(argv[ix], "--out") && has_value) _out = argv[++ix];
+            else if(!strcmp(argv[ix], "--filter") && has_value) _filter = argv[++ix];
+            else if(!strcmp(argv[ix], "--min-time") && has_value) _min_time = atof(argv[++ix]);
+            else if(!strcmp(argv[ix], "--quick")) _quick = true;
+            else {
+                fprintf(stderr, "usage: %s [--out file] [--filter name] [--min-time seconds] [--quick]\n", argv[0]);
+                exit(1);
+            }
+        }
+        if(_quick) _min_time = 0.02;
+        _context.create();
+        glGenQueries(gpu_samples, _queries);
+        fprintf(stderr, "nitro{gl} benchmark [%s] on %s | %s | %s\n", suite, headless_context::platform(),
+                glGetString(GL_VERSION), glGetString(GL_RENDERER));
+    }
+    benchmark_suite(const benchmark_suite &)=delete;
+    benchmark_suite & operator=(const benchmark_suite &)=delete;
+    ~benchmark_suite() {
+        glDeleteQueries(gpu_samples, _queries);
+        _context.destroy();
+    }
+
+    /**
+     * canvas sizes (square) every case is run with
+     */
+    std::vector<int> canvas_sizes() const {
+        if(_quick) return { 128 };
+        return { 256, 512, 1024 };
+    }
+
+    /**
+     * primitives counts, for draws that take many primitives in a single call
+     */
+    std::vector<int> primitive_counts() const {
+        if(_quick) return { 1, 64 };
+        return { 1, 64, 1024, 16384 };
+    }
+
+    bool wants(const char * name) const {
+        return _filter.empty() || strstr(name, _filter.c_str());
+    }
+
+    /**
+     * measure a draw call
+     * @param name entry point name, with a variant suffix if needed
+     * @param canvas the canvas the draw renders into
+     * @param primitives amount of primitives drawn by a single call
+     * @param draw callable, that issues a single draw
+     */
+    template<class draw_callback>
+    void run(const char * name, const nitrogl::canvas & canvas, int primitives, const draw_callback & draw) {
+        if(!wants(name)) return;
+        result_t r;
+        r.name = name; r.primitives = primitives;
+        r.width = int(canvas.width()); r.height = int(canvas.height());
+        // warm up: shader compilation, buffers allocation and pools
+        for (int ix = 0; ix < 3; ++ix) draw();
+        glFinish();
+        // phase 1: throughput and CPU time
+        std::vector<double> cpu;
+        const auto start = clock::now();
+        const auto min_duration = std::chrono::duration<double>(_min_time);
+        do {
+            const auto before = clock::now();
+            draw();
+            const auto after = clock::now();
+            cpu.push_back(std::chrono::duration<double, std::nano>(after - before).count());
+        } while (clock::now() - start < min_duration);
+        glFinish();
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+        r.iterations = long(cpu.size());
+        r.draws_per_sec = double(cpu.size())/seconds;
+        r.cpu_ns = stats_of(cpu);
+        // phase 2: GPU time, each call is wrapped by a query, results are read at the end
+        for (int ix = 0; ix < gpu_samples; ++ix) {
+            glBeginQuery(GL_TIME_ELAPSED, _queries[ix]);
+            draw();
+            glEndQuery(GL_TIME_ELAPSED);
+        }
+        std::vector<double> gpu;
+        for (int ix = 0; ix < gpu_samples; ++ix) {
+            GLuint64 elapsed=0;
+            glGetQueryObjectui64v(_queries[ix], GL_QUERY_RESULT, &elapsed);
+            gpu.push_back(double(elapsed));
+        }
+        r.gpu_ns = stats_of(gpu);
+        fprintf(stderr, " - %-32s %5dx%-5d prims %6d | %10.1f draws/sec | cpu %10.1f ns | gpu %10.1f ns\n",
+                name, r.width, r.height, primitives, r.draws_per_sec, r.cpu_ns.median, r.gpu_ns.median);
+        _results.push_back(r);
+    }
+
+    /**
+     * write the JSON report
+     * @return process exit code
+     */
+    int finish() const {
+        FILE * f = _out.empty() ? stdout : fopen(_out.c_str(), "w");
+        if(!f) { fprintf(stderr, " - ERROR: could not open %s\n", _out.c_str()); return 1; }
+        fprintf(f, "{\n  \"suite\": "); write_escaped(f, _suite.c_str());
+        fprintf(f, ",\n  \"platform\": "); write_escaped(f, headless_context::platform());
+        fprintf(f, ",\n  \"gl_version\": "); write_escaped(f, (const char *)glGetString(GL_VERSION));
+        fprintf(f, ",\n  \"gl_renderer\": "); write_escaped(f, (const char *)glGetString(GL_RENDERER));
+        fprintf(f, ",\n  \"nitrogl_version\": "); write_escaped(f, NITROGL_BENCH_VERSION);
+        fprintf(f, ",\n  \"results\": [");
+        for (size_t ix = 0; ix < _results.size(); ++ix) {
+            const auto & r = _results[ix];
+            fprintf(f, "%s\n    { \"name\": ", ix ? "," : "");
+            write_escaped(f, r.name.c_str());
+            fprintf(f, ", \"canvas\": [%d, %d], \"primitives\": %d, \"iterations\": %ld, \"draws_per_sec\": %.2f, ",
+                    r.width, r.height, r.primitives, r.iterations, r.draws_per_sec);
+            write_stats(f, "cpu_ns_per_call", r.cpu_ns);
+            fprintf(f, ", ");
+            write_stats(f, "gpu_ns_per_call", r.gpu_ns);
+            fprintf(f, " }");
+        }
+        fprintf(f, "\n  ]\n}\n");
+        if(f!=stdout) fclose(f);
+        return 0;
+    }
+};
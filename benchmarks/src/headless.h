@@ -0,0 +1,103 @@
+#pragma once
+
+/**
+ * Headless OpenGL context for benchmarks, no window and no display.
+ * - default: EGL with the EGL_MESA_platform_surfaceless platform (llvmpipe, or any
+ *   mesa driver available on the machine)
+ * - NITROGL_BENCH_OSMESA: OSMesa off-screen context
+ * Rendering is done into canvases backed by textures, so no default framebuffer is needed.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#define NITROGL_USE_STD_MATH
+// GL 3.3 core is the baseline, GL_TIME_ELAPSED queries are core since 3.3
+#ifndef NITROGL_OPENGL_MAJOR_VERSION
+#define NITROGL_OPENGL_MAJOR_VERSION 3
+#define NITROGL_OPENGL_MINOR_VERSION 3
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef NITROGL_BENCH_OSMESA
+#include <GL/osmesa.h>
+#include <GL/glext.h>
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+
+struct headless_context {
+#ifdef NITROGL_BENCH_OSMESA
+    OSMesaContext context = nullptr;
+    unsigned char pixels[4*4*4] = {};
+#else
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+#endif
+
+    static void fail(const char * what) {
+        fprintf(stderr, " - ERROR: %s\n", what);
+        exit(1);
+    }
+
+    void create() {
+#ifdef NITROGL_BENCH_OSMESA
+        const int attributes[] = { OSMESA_FORMAT, OSMESA_RGBA, OSMESA_DEPTH_BITS, 0,
+                                   OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+                                   OSMESA_CONTEXT_MAJOR_VERSION, NITROGL_OPENGL_MAJOR_VERSION,
+                                   OSMESA_CONTEXT_MINOR_VERSION, NITROGL_OPENGL_MINOR_VERSION, 0 };
+        context = OSMesaCreateContextAttribs(attributes, nullptr);
+        if(!context) fail("OSMesa context could not be created");
+        // OSMesa needs a color buffer to be current, all rendering goes to fbos anyway
+        if(!OSMesaMakeCurrent(context, pixels, GL_UNSIGNED_BYTE, 4, 4))
+            fail("OSMesa context could not be made current");
+#else
+        auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+                eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if(!get_platform_display) fail("eglGetPlatformDisplayEXT is not supported");
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        EGLint major, minor;
+        if(display==EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+            fail("EGL surfaceless display could not be initialized");
+        if(!eglBindAPI(EGL_OPENGL_API)) fail("EGL could not bind the OpenGL api");
+        const EGLint config_attributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLConfig config; EGLint configs_count=0;
+        eglChooseConfig(display, config_attributes, &config, 1, &configs_count);
+        const EGLint context_attributes[] = {
+                EGL_CONTEXT_MAJOR_VERSION, NITROGL_OPENGL_MAJOR_VERSION,
+                EGL_CONTEXT_MINOR_VERSION, NITROGL_OPENGL_MINOR_VERSION,
+                EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                EGL_NONE };
+        // surfaceless contexts do not need a config (EGL_KHR_no_config_context)
+        context = eglCreateContext(display, configs_count ? config : EGLConfig(nullptr),
+                                   EGL_NO_CONTEXT, context_attributes);
+        if(context==EGL_NO_CONTEXT) fail("EGL context could not be created");
+        if(!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+            fail("EGL context could not be made current");
+#endif
+    }
+
+    void destroy() {
+#ifdef NITROGL_BENCH_OSMESA
+        if(context) OSMesaDestroyContext(context);
+        context=nullptr;
+#else
+        if(display==EGL_NO_DISPLAY) return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if(context!=EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        eglTerminate(display);
+        display=EGL_NO_DISPLAY; context=EGL_NO_CONTEXT;
+#endif
+    }
+
+    static const char * platform() {
+#ifdef NITROGL_BENCH_OSMESA
+        return "osmesa";
+#else
+        return "egl-surfaceless";
+#endif
+    }
+};
@@ -12,11 +12,24 @@
 
 #include "../ogl/shader_program.h"
 #include "../math/mat4.h"
+#include "../math/vertex2.h"
+#include "../samplers/sampler.h"
+
+// entries of dash patterns of strokes, that are expanded on the GPU. Odd patterns count
+// twice, longer patterns are tessellated
+#ifndef NITROGL_STROKE_DASHES
+#define NITROGL_STROKE_DASHES 64
+#endif
+#define NITROGL_STRINGIFY_(x) #x
+#define NITROGL_STRINGIFY(x) NITROGL_STRINGIFY_(x)
 
 namespace nitrogl {
 
     class main_shader_program : public shader_program {
     public:
+        // vertex shader of a program: triangles, instanced quads, instanced stroke segments,
+        // bezier patches, triangles with edge antialiasing or triangles of curves fills
+        enum class vertex_kind { triangles, instanced, stroke, patch, edge_aa, curve };
 
         constexpr static const char * const glsl_version = "#version 410 core\n";
         constexpr static const char * const shader_compat = R"foo(
@@ -24,6 +37,7 @@ namespace nitrogl {
 #if __VERSION__>=130
 
 #define TEXTURE_2D texture
+#define TEXTURE_2D_LOD textureLod
 #define ATTRIBUTE in
 #define SHADER_IN in
 #define SHADER_OUT out
@@ -32,6 +46,8 @@ namespace nitrogl {
 #else
 
 #define TEXTURE_2D texture2D
+// explicit lod is not available in fragment shaders, fallback to implicit
+#define TEXTURE_2D_LOD(s, uv, lod) texture2D(s, uv)
 #define ATTRIBUTE attribute
 #define SHADER_IN varying
 #define SHADER_OUT varying
@@ -74,8 +90,306 @@ void main()
 )foo";
 
 
+        // vertex shader of instanced draws: a unit quad is stretched on the bounding box of
+        // every instance, and the per instance inputs of the shape and tints are passed flat
+        static constexpr const char * const vert_instanced = R"foo(
+// uniforms
+uniform mat4 mat_model;
+uniform mat4 mat_view;
+uniform mat4 mat_proj;
+uniform mat3 mat_transform_uvs;
+
+// ATTRIBUTE = in vertex attributes
+ATTRIBUTE vec2 VS_pos; // corner of the unit quad
+ATTRIBUTE vec2 VS_uvs_sampler; // uv of the corner
+// per instance attributes
+ATTRIBUTE vec4 VS_instance_rect; // left, top, right, bottom
+ATTRIBUTE vec3 VS_instance_transform_0; // rows of the instance transform
+ATTRIBUTE vec3 VS_instance_transform_1;
+ATTRIBUTE vec3 VS_instance_transform_2;
+ATTRIBUTE vec4 VS_instance_inputs_0; // inputs of the shape sampler
+ATTRIBUTE vec4 VS_instance_inputs_1;
+ATTRIBUTE vec4 VS_instance_inputs_2;
+ATTRIBUTE vec4 VS_instance_tint_0; // fill tint
+ATTRIBUTE vec4 VS_instance_tint_1; // stroke tint
+
+// SHADER_OUT = out/varying
+SHADER_OUT vec3 PS_uvs_sampler;
+flat SHADER_OUT vec4 PS_instance_inputs_0;
+flat SHADER_OUT vec4 PS_instance_inputs_1;
+flat SHADER_OUT vec4 PS_instance_inputs_2;
+flat SHADER_OUT vec4 PS_instance_tint_0;
+flat SHADER_OUT vec4 PS_instance_tint_1;
+
+void main()
+{
+    vec3 pos = vec3(mix(VS_instance_rect.xy, VS_instance_rect.zw, VS_pos), 1.0);
+    pos = vec3(dot(VS_instance_transform_0, pos), dot(VS_instance_transform_1, pos),
+               dot(VS_instance_transform_2, pos));
+    PS_uvs_sampler = vec3((mat_transform_uvs * vec3(VS_uvs_sampler, 1.0)).st, 1.0);
+    PS_instance_inputs_0 = VS_instance_inputs_0;
+    PS_instance_inputs_1 = VS_instance_inputs_1;
+    PS_instance_inputs_2 = VS_instance_inputs_2;
+    PS_instance_tint_0 = VS_instance_tint_0;
+    PS_instance_tint_1 = VS_instance_tint_1;
+    gl_Position = mat_proj * mat_view * mat_model * vec4(pos, 1.0);
+}
+
+)foo";
+
+        // vertex shader of stroked polylines: every instance is a segment, that is expanded
+        // into a quad and a fan at its end, the join with the next segment, or a cap if the
+        // next point equals the end. Start caps are end caps of reversed segments, that lead
+        // open polylines. Uvs are of the bounding box, as missing uvs
+        static constexpr const char * const vert_stroke = R"foo(
+// uniforms
+uniform mat4 mat_model;
+uniform mat4 mat_view;
+uniform mat4 mat_proj;
+uniform mat3 mat_transform_uvs;
+uniform vec4 bbox;
+uniform vec4 stroke; // half width, miter limit, line join, cap
+uniform int stroke_fan; // triangles per fan
+
+// per instance attributes, four consecutive points of the polyline
+ATTRIBUTE vec2 VS_stroke_0; // point before the segment
+ATTRIBUTE vec2 VS_stroke_1; // start of the segment
+ATTRIBUTE vec2 VS_stroke_2; // end of the segment
+ATTRIBUTE vec2 VS_stroke_3; // point after the segment
+ATTRIBUTE vec2 VS_stroke_length; // arc lengths at the start and the end of the segment
+
+// SHADER_OUT = out/varying
+SHADER_OUT vec3 PS_uvs_sampler;
+SHADER_OUT vec2 PS_stroke_dash; // arc length and offset from the center line
+
+// values of microtess::stroke_line_join and microtess::stroke_cap
+#define JOIN_MITER 1
+#define JOIN_MITER_CLIP 2
+#define JOIN_ROUND 3
+#define JOIN_BEVEL 4
+#define CAP_ROUND 1
+#define CAP_SQUARE 2
+
+vec2 rotate(vec2 v, float angle) {
+    float c = cos(angle), s = sin(angle);
+    return vec2(c*v.x - s*v.y, s*v.x + c*v.y);
+}
+
+// rim of a cap, from the left offset n, around the forward offset d, to the right
+vec2 cap_rim(int cap, vec2 n, vec2 d, int i, out int count) {
+    if(cap==CAP_SQUARE) {
+        count = 3;
+        return i==0 ? n : (i==1 ? n + d : (i==2 ? d - n : -n));
+    }
+    count = cap==CAP_ROUND ? stroke_fan : 0;
+    return rotate(n, -3.14159265*float(i)/float(stroke_fan));
+}
+
+// rim of a join on the outer side of the turn, from the offset o0 at the end of the
+// segment to the offset o1 at the start of the next one. d0, d1 are their directions
+vec2 join_rim(int join, vec2 o0, vec2 o1, vec2 d0, vec2 d1, float side, int i, out int count) {
+    float hw = stroke.x, limit = stroke.y*stroke.x;
+    if(join==JOIN_ROUND) {
+        count = stroke_fan;
+        float angle = acos(clamp(dot(o0, o1)/(hw*hw), -1.0, 1.0));
+        return rotate(o0, side*angle*float(i)/float(stroke_fan));
+    }
+    if(join!=JOIN_MITER && join!=JOIN_MITER_CLIP && join!=JOIN_BEVEL) {
+        count = 0;
+        return o0;
+    }
+    vec2 m = o0 + o1;
+    float length_m = length(m);
+    m = length_m > hw*1e-4 ? m/length_m : d0;
+    // cosine of half of the angle between the offsets, the miter is at hw/cos_half
+    float cos_half = dot(o0, m)/hw;
+    if(join!=JOIN_BEVEL && cos_half*limit >= hw) {
+        count = 2;
+        return i==0 ? o0 : (i==1 ? m*(hw/cos_half) : o1);
+    }
+    if(join==JOIN_MITER_CLIP) {
+        // the sides of the segments, clipped at the miter limit
+        count = 3;
+        if(i==1) return o0 + d0*(limit - dot(o0, m))/dot(d0, m);
+        if(i==2) return o1 + d1*(limit - dot(o1, m))/dot(d1, m);
+        return i==0 ? o0 : o1;
+    }
+    // bevel, or a miter over the limit
+    count = 1;
+    return i==0 ? o0 : o1;
+}
+
+void main()
+{
+    float hw = stroke.x;
+    int join = int(stroke.z), cap = int(stroke.w);
+    int tri = gl_VertexID/3, corner = gl_VertexID - tri*3;
+    vec2 pos = VS_stroke_1;
+    vec2 d0 = VS_stroke_2 - VS_stroke_1;
+    float len = length(d0);
+    if(len > 0.0) {
+        d0 /= len;
+        vec2 n = vec2(-d0.y, d0.x)*hw;
+        if(tri < 2) {
+            // quad of the segment (start+n, start-n, end-n), (end-n, end+n, start+n)
+            int k = tri*3 + corner;
+            int v = k<3 ? k : (k==3 ? 2 : (k==4 ? 3 : 0));
+            pos = (v<2 ? VS_stroke_1 : VS_stroke_2) + ((v==0 || v==3) ? n : -n);
+        } else {
+            // fan, corner 0 is the center, unused triangles collapse into it
+            int f = tri - 2;
+            vec2 center = VS_stroke_2;
+            vec2 d1 = VS_stroke_3 - center;
+            int i = f + corner - 1, count = 0;
+            vec2 rim = vec2(0.0);
+            pos = center;
+            if(corner != 0 && length(d1) == 0.0) {
+                // end of an open polyline
+                rim = cap_rim(cap, n, d0*hw, i, count);
+            } else if(corner != 0) {
+                d1 = normalize(d1);
+                vec2 n1 = vec2(-d1.y, d1.x)*hw;
+                // outer side of the turn
+                bool left = d0.x*d1.y - d0.y*d1.x > 0.0;
+                rim = left ? join_rim(join, -n, -n1, d0, d1, 1.0, i, count) :
+                             join_rim(join, n, n1, d0, d1, -1.0, i, count);
+            }
+            if(f < count) pos = center + rim;
+        }
+    }
+    // both are linear in the frame of the segment, caps and joins extend it
+    vec2 rel = pos - VS_stroke_1;
+    PS_stroke_dash = len > 0.0 ?
+            vec2(VS_stroke_length.x + (VS_stroke_length.y - VS_stroke_length.x)*dot(rel, d0)/len,
+                 d0.x*rel.y - d0.y*rel.x) : vec2(VS_stroke_length.x, 0.0);
+    vec2 uv = (pos - bbox.xy)/bbox.zw;
+    uv.y = 1.0 - uv.y;
+    PS_uvs_sampler = vec3((mat_transform_uvs * vec3(uv, 1.0)).st, 1.0);
+    gl_Position = mat_proj * mat_view * mat_model * vec4(pos, 1.0, 1.0);
+}
+
+)foo";
+
+        // vertex shader of bezier patches: vertices are (u, v) of a parametric grid, that is
+        // evaluated on the control points of the patch. Weights of bi-quadratic patches are
+        // zero at the fourth row and column, so both orders go through the same 4x4 sum
+        static constexpr const char * const vert_patch = R"foo(
+// uniforms
+uniform mat4 mat_model;
+uniform mat4 mat_view;
+uniform mat4 mat_proj;
+uniform mat3 mat_transform_uvs;
+uniform vec2 patch_points[16]; // control points, row after row
+uniform int patch_order; // points in a row, 3 for bi-quadratic and 4 for bi-cubic
+uniform vec4 patch_uvs; // uvs window u0, v0, u1, v1
+
+// ATTRIBUTE = in vertex attributes
+ATTRIBUTE vec2 VS_pos; // (u, v) on the grid
+
+// SHADER_OUT = out/varying
+SHADER_OUT vec3 PS_uvs_sampler;
+
+// bernstein polynomials
+vec4 bernstein(float t) {
+    float it = 1.0 - t;
+    return patch_order==3 ? vec4(it*it, 2.0*t*it, t*t, 0.0) :
+                            vec4(it*it*it, 3.0*t*it*it, 3.0*t*t*it, t*t*t);
+}
+
+void main()
+{
+    vec4 bu = bernstein(VS_pos.x), bv = bernstein(VS_pos.y);
+    vec2 pos = vec2(0.0);
+    for (int row = 0; row < 4; ++row) {
+        vec2 curve = vec2(0.0);
+        for (int col = 0; col < 4; ++col)
+            curve += bu[col]*patch_points[row*patch_order + col];
+        pos += bv[row]*curve;
+    }
+    vec2 uv = mix(patch_uvs.xy, patch_uvs.zw, VS_pos);
+    PS_uvs_sampler = vec3((mat_transform_uvs * vec3(uv, 1.0)).st, 1.0);
+    gl_Position = mat_proj * mat_view * mat_model * vec4(pos, 1.0, 1.0);
+}
+
+)foo";
+
+        // vertex shader of triangles with edge antialiasing: every vertex carries its
+        // barycentric coordinates, where the coordinates of edges, that are not on the outline,
+        // are held at 1, and its position along the edges (0 and 1 at their ends). Uvs are
+        // of the bounding box, as missing uvs
+        static constexpr const char * const vert_edge_aa = R"foo(
+// uniforms
+uniform mat4 mat_model;
+uniform mat4 mat_view;
+uniform mat4 mat_proj;
+uniform mat3 mat_transform_uvs;
+uniform vec4 bbox;
+
+// ATTRIBUTE = in vertex attributes
+ATTRIBUTE vec2 VS_pos; // position of vertex
+ATTRIBUTE vec3 VS_edges; // distances to the edges, in barycentric coordinates
+ATTRIBUTE vec3 VS_edges_along; // positions along the edges
+
+// SHADER_OUT = out/varying
+SHADER_OUT vec3 PS_uvs_sampler;
+SHADER_OUT vec3 PS_edges;
+SHADER_OUT vec3 PS_edges_along;
+
+void main()
+{
+    vec2 uv = (VS_pos - bbox.xy)/bbox.zw;
+    uv.y = 1.0 - uv.y;
+    PS_uvs_sampler = vec3((mat_transform_uvs * vec3(uv, 1.0)).st, 1.0);
+    PS_edges = VS_edges;
+    PS_edges_along = VS_edges_along;
+    gl_Position = mat_proj * mat_view * mat_model * vec4(VS_pos, 1.0, 1.0);
+}
+
+)foo";
+
+        // vertex shader of curves fills: triangles with edge antialiasing, that also carry
+        // the implicit coordinates of quadratic curves (u, v, side)
+        static constexpr const char * const vert_curve = R"foo(
+// uniforms
+uniform mat4 mat_model;
+uniform mat4 mat_view;
+uniform mat4 mat_proj;
+uniform mat3 mat_transform_uvs;
+uniform vec4 bbox;
+
+// ATTRIBUTE = in vertex attributes
+ATTRIBUTE vec2 VS_pos; // position of vertex
+ATTRIBUTE vec3 VS_edges; // distances to the edges, in barycentric coordinates
+ATTRIBUTE vec3 VS_edges_along; // positions along the edges
+ATTRIBUTE vec3 VS_curve; // implicit coordinates of the curve, and the side of the fill
+
+// SHADER_OUT = out/varying
+SHADER_OUT vec3 PS_uvs_sampler;
+SHADER_OUT vec3 PS_edges;
+SHADER_OUT vec3 PS_edges_along;
+SHADER_OUT vec3 PS_curve;
+
+void main()
+{
+    vec2 uv = (VS_pos - bbox.xy)/bbox.zw;
+    uv.y = 1.0 - uv.y;
+    PS_uvs_sampler = vec3((mat_transform_uvs * vec3(uv, 1.0)).st, 1.0);
+    PS_edges = VS_edges;
+    PS_edges_along = VS_edges_along;
+    PS_curve = VS_curve;
+    gl_Position = mat_proj * mat_view * mat_model * vec4(VS_pos, 1.0, 1.0);
+}
+
+)foo";
+
         constexpr static const char * const define_sampler = "#define __SAMPLER_MAIN sampler_";
         constexpr static const char * const define_premul_alpha = "\n#define __PRE_MUL_ALPHA\n";
+        constexpr static const char * const define_hw_blend = "\n#define __HW_BLEND\n";
+        constexpr static const char * const define_instanced = "\n#define __INSTANCED\n";
+        constexpr static const char * const define_edge_aa = "\n#define __EDGE_AA\n";
+        constexpr static const char * const define_curve = "\n#define __EDGE_AA\n#define __CURVE\n";
+        constexpr static const char * const define_stroke = "\n#define __STROKE\n#define __STROKE_DASHES "
+                                                            NITROGL_STRINGIFY(NITROGL_STROKE_DASHES) "\n";
 
         constexpr static const char * const frag_other = R"foo(
 // uniforms
@@ -89,6 +403,103 @@ uniform struct DATA_MAIN {
 // in
 SHADER_IN vec3 PS_uvs_sampler;
 
+// shape samplers read their inputs with __SHAPE_INPUT(data.inputs, index), which are
+// the uniforms, unless the draw is instanced
+#ifdef __INSTANCED
+flat SHADER_IN vec4 PS_instance_inputs_0;
+flat SHADER_IN vec4 PS_instance_inputs_1;
+flat SHADER_IN vec4 PS_instance_inputs_2;
+flat SHADER_IN vec4 PS_instance_tint_0;
+flat SHADER_IN vec4 PS_instance_tint_1;
+
+float __instance_input(int index) {
+    return index<4 ? PS_instance_inputs_0[index] :
+          (index<8 ? PS_instance_inputs_1[index-4] : PS_instance_inputs_2[index-8]);
+}
+#define __SHAPE_INPUT(inputs, index) __instance_input(index)
+#else
+#define __SHAPE_INPUT(inputs, index) inputs[index]
+#endif
+
+// coverage of the fragment by the outline edges of its triangle, in pixels from the edge,
+// which is half covered. Other edges have a constant distance, and are always covered
+#ifdef __EDGE_AA
+SHADER_IN vec3 PS_edges;
+SHADER_IN vec3 PS_edges_along;
+
+// pixels per unit of a value
+vec3 __per_pixel(vec3 v) {
+    vec3 dx = dFdx(v), dy = dFdy(v);
+    return max(sqrt(dx*dx + dy*dy), vec3(1e-6));
+}
+
+float __edges_coverage() {
+    vec3 d = PS_edges/__per_pixel(PS_edges);
+    // past the ends of an edge (i.e. slivers at concave corners) the distance is to the end,
+    // instead of to the line of the edge, that runs inside the shape. Distances outside of
+    // the edge (the expanded outline) are negative
+    vec3 past = (max(-PS_edges_along, 0.0) + max(PS_edges_along - 1.0, 0.0))/
+                __per_pixel(PS_edges_along);
+    d = (2.0*step(0.0, d) - 1.0)*sqrt(d*d + past*past);
+    return clamp(0.5 + min(d.x, min(d.y, d.z)), 0.0, 1.0);
+}
+#ifdef __CURVE
+SHADER_IN vec3 PS_curve;
+
+// coverage of quadratic curves (Loop-Blinn), u^2-v is negative between the curve and its
+// chord, the side flips it for curves, that fill towards their control point. The gradient
+// makes it a distance in pixels. Interior triangles have a constant negative value
+float __coverage() {
+    float f = PS_curve.z*(PS_curve.x*PS_curve.x - PS_curve.y);
+    vec2 gradient = PS_curve.z*(2.0*PS_curve.x*vec2(dFdx(PS_curve.x), dFdy(PS_curve.x)) -
+                                vec2(dFdx(PS_curve.y), dFdy(PS_curve.y)));
+    float coverage = clamp(0.5 - f/max(length(gradient), 1e-6), 0.0, 1.0)*__edges_coverage();
+    if(coverage==0.0) discard;
+    return coverage;
+}
+#else
+float __coverage() {
+    // fragments of the expanded outline, that miss the shape, leave the backdrop as is
+    float coverage = __edges_coverage();
+    if(coverage==0.0) discard;
+    return coverage;
+}
+#endif
+// coverage of the fragment of a stroke by its dashes, that end with the cap of the stroke.
+// Uncovered fragments are discarded, so they do not count in the stencil of the stroke
+#elif defined(__STROKE)
+SHADER_IN vec2 PS_stroke_dash;
+uniform vec4 stroke_dash; // period, offset, half width, cap
+uniform int stroke_dash_count; // no dashes if 0
+uniform float stroke_dashes[__STROKE_DASHES]; // ends of the dashes and gaps in a period
+
+float __coverage() {
+    if(stroke_dash_count==0) return 1.0;
+    float phase = mod(PS_stroke_dash.x + stroke_dash.y, stroke_dash.x);
+    float begin = 0.0, end = stroke_dash.x;
+    int index = stroke_dash_count - 1;
+    for (int ix = 0; ix < __STROKE_DASHES; ++ix) {
+        if(ix >= stroke_dash_count) break;
+        if(phase < stroke_dashes[ix]) { index = ix; end = stroke_dashes[ix]; break; }
+        begin = stroke_dashes[ix];
+    }
+    // distance along the line outside of the dash, negative inside of it
+    float d = min(phase - begin, end - phase);
+    bool dash = index - (index/2)*2 == 0;
+    if(dash) d = -d;
+    // round caps (1) are discs at the ends, square caps (2) extend them
+    int cap = int(stroke_dash.w);
+    if(cap==1 && !dash) d = length(vec2(d, PS_stroke_dash.y)) - stroke_dash.z;
+    else if(cap==2) d -= stroke_dash.z;
+    float per_pixel = max(length(vec2(dFdx(PS_stroke_dash.x), dFdy(PS_stroke_dash.x))), 1e-6);
+    float coverage = clamp(0.5 - d/per_pixel, 0.0, 1.0);
+    if(coverage==0.0) discard;
+    return coverage;
+}
+#else
+#define __coverage() 1.0
+#endif
+
 // out
 #if __VERSION__>=130
 out vec4 glFragColor;
@@ -115,6 +526,12 @@ vec4 __blend_in_place(in vec4 src, in vec4 backdrop, in vec3 B) {
 
 void main()
 {
+#ifdef __HW_BLEND
+    // blending and compositing are done by the hardware blend unit, output alpha-multiplied source
+    vec4 sampler_out = __SAMPLER_MAIN(PS_uvs_sampler/PS_uvs_sampler.z);
+    sampler_out.a *= data_main.opacity*__coverage();
+    glFragColor = vec4(sampler_out.rgb * sampler_out.a, sampler_out.a);
+#else
     // get backdrop uvs
     // coords are screen space left to right, bottom is 0, top is 1.
     vec2 bd_uvs = vec2(gl_FragCoord.x, gl_FragCoord.y)/data_main.window_size;
@@ -125,15 +542,15 @@ void main()
 
     // sample from backdrop
     vec4 bd_texel = TEXTURE_2D(data_main.texture_backdrop, bd_uvs);
-    // un mul alpha if backdrop is alpha-mul
+    // un mul alpha if backdrop is alpha-mul, transparent texels are black
 #ifdef __PRE_MUL_ALPHA
-    bd_texel.rgb /= bd_texel.a;
+    bd_texel.rgb /= max(bd_texel.a, 1e-6);
 #endif
 
     // sample from un-multiplied-alpha sampler, also, perspective correct the uvs with q coord
     vec4 sampler_out = __SAMPLER_MAIN(PS_uvs_sampler/PS_uvs_sampler.z);
-    // apply opacity
-    sampler_out.a *= data_main.opacity;
+    // apply opacity and coverage
+    sampler_out.a *= data_main.opacity*__coverage();
     // blend mode with un-multiplied-alpha backdrop
     vec3 blended_colors_only = __BLEND(sampler_out.rgb, bd_texel.rgb);
     vec4 blended_colors_final = __blend_in_place(sampler_out, bd_texel, blended_colors_only);
@@ -144,6 +561,7 @@ void main()
 #ifndef __PRE_MUL_ALPHA
     glFragColor.rgb /= glFragColor.a;
 #endif
+#endif
 }
 )foo";
 
@@ -154,15 +572,29 @@ void main()
             static constexpr unsigned size() { return 3; }
         };
 
+        struct IVAS {
+            shader_program::shader_vertex_attr_t data[9];
+            static constexpr unsigned size() { return 9; }
+        };
+
+        struct SVAS {
+            shader_program::shader_vertex_attr_t data[5];
+            static constexpr unsigned size() { return 5; }
+        };
+
         // I have to have this uniform location cache. It is different
         // from shader to shader instance, so I have no way around saving it.
         struct uniforms_type {
             GLint mat_model=-1, mat_view=-1, mat_proj=-1, mat_transform_uvs=-1,
             bbox=-1, has_missing_uvs=-1, has_missing_q=-1,
-            opacity=-1, time=-1, tex_backdrop=-1, window_size=-1;
+            opacity=-1, time=-1, tex_backdrop=-1, window_size=-1,
+            stroke=-1, stroke_fan=-1, stroke_dash=-1, stroke_dash_count=-1, stroke_dashes=-1,
+            patch_points=-1, patch_order=-1, patch_uvs=-1;
         };
 
         uniforms_type uniforms;
+        // which vertex shader was compiled
+        vertex_kind vertex_type;
 
         const uniforms_type & uniforms_locations() const {
             return uniforms;
@@ -183,16 +615,104 @@ void main()
             return vas;
         }
 
+        static const IVAS & instance_vertex_attributes() {
+            // per instance attributes of instanced draws, they follow the vertex attributes
+            static IVAS vas = {{
+                {"VS_instance_rect", 3,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_instance_transform_0", 4,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_instance_transform_1", 5,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_instance_transform_2", 6,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_instance_inputs_0", 7,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_instance_inputs_1", 8,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_instance_inputs_2", 9,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_instance_tint_0", 10,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_instance_tint_1", 11,
+                 shader_program::shader_attribute_component_type::Float},
+            }};
+            return vas;
+        }
+
+        static const SVAS & stroke_vertex_attributes() {
+            // per instance attributes of strokes, they alias the per instance attributes of
+            // instanced draws, a program has one or the other
+            static SVAS vas = {{
+                {"VS_stroke_0", 3,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_stroke_1", 4,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_stroke_2", 5,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_stroke_3", 6,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_stroke_length", 7,
+                 shader_program::shader_attribute_component_type::Float},
+            }};
+            return vas;
+        }
+
+        struct EVAS {
+            shader_program::shader_vertex_attr_t data[2];
+            static constexpr unsigned size() { return 2; }
+        };
+
+        static const EVAS & edge_vertex_attributes() {
+            // distances to the edges of triangles with edge antialiasing, they alias the
+            // per instance attributes of instanced draws, a program has one or the other
+            static EVAS vas = {{
+                {"VS_edges", 3,
+                 shader_program::shader_attribute_component_type::Float},
+                {"VS_edges_along", 4,
+                 shader_program::shader_attribute_component_type::Float},
+            }};
+            return vas;
+        }
+
+        struct CVAS {
+            shader_program::shader_vertex_attr_t data[1];
+            static constexpr unsigned size() { return 1; }
+        };
+
+        static const CVAS & curve_vertex_attributes() {
+            // implicit coordinates of curves, they follow the edges attributes
+            static CVAS vas = {{
+                {"VS_curve", 5,
+                 shader_program::shader_attribute_component_type::Float},
+            }};
+            return vas;
+        }
+
+        // vertex shader source of a kind
+        static const char * vertex_source(vertex_kind kind) {
+            switch (kind) {
+                case vertex_kind::instanced: return vert_instanced;
+                case vertex_kind::stroke: return vert_stroke;
+                case vertex_kind::patch: return vert_patch;
+                case vertex_kind::edge_aa: return vert_edge_aa;
+                case vertex_kind::curve: return vert_curve;
+                default: return vert;
+            }
+        }
+
         // ctor: internal_init with empty shaders and attach which is legal
         main_shader_program(const shader & vertex, const shader & fragment, bool $link=false) :
-                            shader_program(vertex, fragment, $link), uniforms() {
+                            shader_program(vertex, fragment, $link), uniforms(), vertex_type(vertex_kind::triangles) {
         }
         main_shader_program(shader && vertex, shader && fragment, bool $link=false) :
                     shader_program(nitrogl::traits::move(vertex),
-                                   nitrogl::traits::move(fragment), $link), uniforms() {
+                                   nitrogl::traits::move(fragment), $link), uniforms(),
+                                   vertex_type(vertex_kind::triangles) {
         }
-        main_shader_program() : uniforms(), shader_program() {} // with empty shaders
-        main_shader_program(bool test) : uniforms(), shader_program() {
+        // with empty shaders
+        main_shader_program() : shader_program(), uniforms(), vertex_type(vertex_kind::triangles) {}
+        main_shader_program(bool test) : shader_program(), uniforms(), vertex_type(vertex_kind::triangles) {
             const GLchar * frag_shards[3] = { glsl_version, frag_other, frag_main };
             auto v = shader::from_vertex(vert);
             auto f = shader::from_fragment(frag_shards, 3, nullptr);
@@ -200,16 +720,35 @@ void main()
             resolve_vertex_attributes_and_uniforms_and_link();
         }
         main_shader_program(const main_shader_program & o) = default;
-        main_shader_program(main_shader_program && o) noexcept : shader_program(nitrogl::traits::move(o)), uniforms(o.uniforms) {}
+        main_shader_program(main_shader_program && o) noexcept : shader_program(nitrogl::traits::move(o)),
+                            uniforms(o.uniforms), vertex_type(o.vertex_type) {}
         main_shader_program & operator=(const main_shader_program & o) = default;
         main_shader_program & operator=(main_shader_program && o)  noexcept {
             shader_program::operator=(nitrogl::traits::move(o));
-            uniforms=o.uniforms;return *this;
+            uniforms=o.uniforms; vertex_type=o.vertex_type; return *this;
         }
 
         ~main_shader_program() = default;
 
         void resolve_vertex_attributes_and_uniforms_and_link() {
+            // instance attributes are bound unconditionally, binding a name that is not in
+            // the shader is legal. The link of the next call makes them take effect
+            const auto & ivas = instance_vertex_attributes();
+            for (const auto & attr : ivas.data) {
+                glBindAttribLocation(id(), attr.location, attr.name); glCheckError();
+            }
+            const auto & svas = stroke_vertex_attributes();
+            for (const auto & attr : svas.data) {
+                glBindAttribLocation(id(), attr.location, attr.name); glCheckError();
+            }
+            const auto & evas = edge_vertex_attributes();
+            for (const auto & attr : evas.data) {
+                glBindAttribLocation(id(), attr.location, attr.name); glCheckError();
+            }
+            const auto & cvas = curve_vertex_attributes();
+            for (const auto & attr : cvas.data) {
+                glBindAttribLocation(id(), attr.location, attr.name); glCheckError();
+            }
             // first set vertex attributes locations via binding, in case we are not using location qualifiers
             setVertexAttributesLocations(shader_vertex_attributes().data, shader_vertex_attributes().size());
             // program should be linked by previous call to set, but in case we have zero attributes, make sure
@@ -227,6 +766,14 @@ void main()
             uniforms.time = uniformLocationByName("data_main.time");
             uniforms.tex_backdrop = uniformLocationByName("data_main.texture_backdrop");
             uniforms.window_size = uniformLocationByName("data_main.window_size");
+            uniforms.stroke = uniformLocationByName("stroke");
+            uniforms.stroke_fan = uniformLocationByName("stroke_fan");
+            uniforms.stroke_dash = uniformLocationByName("stroke_dash");
+            uniforms.stroke_dash_count = uniformLocationByName("stroke_dash_count");
+            uniforms.stroke_dashes = uniformLocationByName("stroke_dashes");
+            uniforms.patch_points = uniformLocationByName("patch_points");
+            uniforms.patch_order = uniformLocationByName("patch_order");
+            uniforms.patch_uvs = uniformLocationByName("patch_uvs");
         }
 
     public:
@@ -238,6 +785,17 @@ void main()
         {  glUniformMatrix4fv(uniforms.mat_proj, 1, GL_FALSE, matrix.data()); glCheckError(); }
         void updateUVsTransformMatrix(const nitrogl::mat3f & matrix) const
         {  glUniformMatrix3fv(uniforms.mat_transform_uvs, 1, GL_FALSE, matrix.data()); glCheckError(); }
+        // same, but maps the transformed uvs into the uv window of the sampler if it has one
+        void updateUVsTransformMatrix(const nitrogl::mat3f & matrix, sampler_t & sampler) const {
+            float u0, v0, u1, v1;
+            if(!sampler.resolved()->uv_window(u0, v0, u1, v1)) {
+                updateUVsTransformMatrix(matrix);
+                return;
+            }
+            auto windowed = matrix;
+            windowed.post_scale(nitrogl::vec2f{u1-u0, v1-v0}).post_translate(nitrogl::vec2f{u0, v0});
+            updateUVsTransformMatrix(windowed);
+        }
         void updateBBox(float left, float top, float right, float bottom) const
         {  glUniform4f(uniforms.bbox, left, top, right-left, bottom-top); glCheckError(); }
         void update_has_missing_uvs(bool value) const
@@ -256,6 +814,29 @@ void main()
         void update_window_size(GLuint w, GLuint h) const {
             glUniform2ui(uniforms.window_size, w, h); glCheckError();
         }
+        // stroke programs: half width, miter limit, join, cap and triangles per fan
+        void updateStroke(float half_width, float miter_limit, int join, int cap, int fan) const {
+            glUniform4f(uniforms.stroke, half_width, miter_limit, float(join), float(cap));
+            glCheckError();
+            glUniform1i(uniforms.stroke_fan, fan); glCheckError();
+        }
+        // stroke programs: ends of the dashes and gaps in a period (count of them, 0 for no
+        // dashes), dash offset, half width and cap
+        void updateStrokeDashes(const float * ends, int count, float offset,
+                                float half_width, int cap) const {
+            glUniform1i(uniforms.stroke_dash_count, count); glCheckError();
+            if(count==0) return;
+            glUniform4f(uniforms.stroke_dash, ends[count-1], offset, half_width, float(cap));
+            glCheckError();
+            glUniform1fv(uniforms.stroke_dashes, count, ends); glCheckError();
+        }
+        // patch programs: order*order control points (x, y), order and uvs window
+        void updatePatch(const float * points, int order,
+                         float u0, float v0, float u1, float v1) const {
+            glUniform2fv(uniforms.patch_points, order*order, points); glCheckError();
+            glUniform1i(uniforms.patch_order, order); glCheckError();
+            glUniform4f(uniforms.patch_uvs, u0, v0, u1, v1); glCheckError();
+        }
 
     };
 
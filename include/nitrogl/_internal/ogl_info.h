@@ -33,6 +33,38 @@ namespace nitrogl {
     #endif
 #endif
 
+// instanced arrays (glVertexAttribDivisor) are core in gl>=3.3, and gl-es>=3.0
+#ifndef NITROGL_SUPPORTS_INSTANCING
+    #if (defined(NITROGL_OPEN_GL_ES) && NITROGL_OPENGL_MAJOR_VERSION>=3) || \
+        (NITROGL_OPENGL_MAJOR_VERSION>3) || \
+        (NITROGL_OPENGL_MAJOR_VERSION==3 && NITROGL_OPENGL_MINOR_VERSION>=3)
+        #define NITROGL_SUPPORTS_INSTANCING
+    #endif
+#endif
+
+// multisampled render buffers and frame buffers blits are core in gl>=3.0, and gl-es>=3.0
+#ifndef NITROGL_SUPPORTS_MULTISAMPLING
+    #if (NITROGL_OPENGL_MAJOR_VERSION>=3)
+        #define NITROGL_SUPPORTS_MULTISAMPLING
+    #endif
+#endif
+
+// fence sync objects are core in gl>=3.2, and gl-es>=3.0
+#ifndef NITROGL_SUPPORTS_SYNC
+    #if (defined(NITROGL_OPEN_GL_ES) && NITROGL_OPENGL_MAJOR_VERSION>=3) || \
+        (NITROGL_OPENGL_MAJOR_VERSION>3) || \
+        (NITROGL_OPENGL_MAJOR_VERSION==3 && NITROGL_OPENGL_MINOR_VERSION>=2)
+        #define NITROGL_SUPPORTS_SYNC
+    #endif
+#endif
+
+// fragment derivatives (dFdx, dFdy) are core in gl>=2.0, and gl-es>=3.0
+#ifndef NITROGL_SUPPORTS_DERIVATIVES
+    #if !defined(NITROGL_OPEN_GL_ES) || NITROGL_OPENGL_MAJOR_VERSION>=3
+        #define NITROGL_SUPPORTS_DERIVATIVES
+    #endif
+#endif
+
 #ifndef NITROGL_OPENGL_GLSL_VERSION
     #ifdef NITROGL_OPEN_GL_ES
         #if (NITROGL_OPENGL_MAJOR_VERSION==2)
@@ -90,6 +122,26 @@ namespace nitrogl {
         static constexpr bool supports_vao = true;
 #else
         static constexpr bool supports_vao = false;
+#endif
+#ifdef NITROGL_SUPPORTS_INSTANCING
+        static constexpr bool supports_instancing = true;
+#else
+        static constexpr bool supports_instancing = false;
+#endif
+#ifdef NITROGL_SUPPORTS_MULTISAMPLING
+        static constexpr bool supports_multisampling = true;
+#else
+        static constexpr bool supports_multisampling = false;
+#endif
+#ifdef NITROGL_SUPPORTS_SYNC
+        static constexpr bool supports_sync = true;
+#else
+        static constexpr bool supports_sync = false;
+#endif
+#ifdef NITROGL_SUPPORTS_DERIVATIVES
+        static constexpr bool supports_derivatives = true;
+#else
+        static constexpr bool supports_derivatives = false;
 #endif
         static constexpr int major = NITROGL_OPENGL_MAJOR_VERSION;
         static constexpr int minor = NITROGL_OPENGL_MINOR_VERSION;
@@ -14,6 +14,8 @@
 #include "../compositing/porter_duff.h"
 #include "../_internal/main_shader_program.h"
 #include "../_internal/string_utils.h"
+#include "../_internal/shader_sources_cache.h"
+#include "../ogl/profiler.h"
 #include "../samplers/sampler.h"
 
 namespace nitrogl {
@@ -133,23 +135,29 @@ namespace nitrogl {
 
     private:
         template<unsigned N, unsigned M>
-        static void _internal_composite(sampler_t * sampler, sources_buffer<N, M> & buffer) {
+        static void _internal_composite(sampler_t * sampler, sources_buffer<N, M> & buffer,
+                                        shader_sources_cache * cache) {
+            // identity wrappers were dropped by the fold pass, composite what they pass through
+            if(sampler) sampler = sampler->resolved();
             // if the sampler is nullptr or was already visited, then we don't need to write it
             if(sampler==nullptr || sampler->traversal_info().visited) return;
+            // constant sub-trees were folded into a single color, they have no sub samplers
+            const bool folded = sampler->traversal_info().is_constant;
+            const auto * uniforms = folded ? sampler_t::folded_uniforms() : sampler->uniforms();
             // otherwise, recurse bottom-up
-            const auto sub_samplers_count = sampler->sub_samplers_count();
+            const auto sub_samplers_count = folded ? 0 : sampler->sub_samplers_count();
             for (int ix = 0; ix < sub_samplers_count; ++ix)
-                _internal_composite(sampler->sub_sampler(ix), buffer);
+                _internal_composite(sampler->sub_sampler(ix), buffer, cache);
 
             sampler->traversal_info().visited=true;
 
             // uniform struct DATA_ID { float a;  vec2 b; } data_ID;
-            const bool has_uniforms_data = !nitrogl::is_empty(sampler->uniforms());
+            const bool has_uniforms_data = !nitrogl::is_empty(uniforms);
             if(has_uniforms_data) {
                 buffer.write_char_array_pointer("uniform struct DATA_", -1);
                 buffer.write_char_array_pointer(sampler->traversal_info().id_str(),
                                                 sampler->traversal_info().size_id_str()); // ID from previous stored value
-                buffer.write_char_array_pointer(sampler->uniforms(), -1);
+                buffer.write_char_array_pointer(uniforms, -1);
                 buffer.write_char_array_pointer("data_", -1);
                 buffer.write_char_array_pointer(sampler->traversal_info().id_str(),
                                                 sampler->traversal_info().size_id_str()); // ID from previous stored value
@@ -164,139 +172,129 @@ namespace nitrogl {
             // now the tough part starts function body of sampler. Our goal
             // is to track 'data.' and 'sampler_' strings and to stitch:
             // data. --> data_{SAMPLER_ID}
-            // sampler_ --> data_{SAMPLER_ID}
-            // strategy is to make them race for the next one
-            const auto * main = nitrogl::find_first_not_of_in(sampler->main(), '\n', -1);
-            const auto handle = [&](race_t & race, const char * from) -> const char * {
-                race.handled=true;
-                switch (race.id) {
-                    case 0: { // sampler_{sub_sampler_local_id} -> sampler_{sub_sampler_global_id}
-                        auto begin_0 = from; // latest end loose
-                        auto end_0 = race.next + race.name_len; // end of sampler_
-                        buffer.write_range_pointer(begin_0, end_0); // stitch [main, sampler_)
-                        // parse local_id
-                        auto begin_1 = nitrogl::index_of_in("(", end_0, 1); // ptr to (
-                        auto local_id = nitrogl::s2i(end_0, begin_1-end_0); // local_id to int
-                        // stitch {global_id}
-                        buffer.write_char_array_pointer(sampler->sub_sampler(local_id)->traversal_info().id_str(),
-                                                        sampler->sub_sampler(local_id)->traversal_info().size_id_str());
-                        race.handled=true;
-                        return begin_1;
-                    }
-                    case 1: { // data. --> data_{current_sampler_global_id}.
-                        auto begin_0 = from; // latest end loose
-                        auto end_0 = race.next + race.name_len - 1; // end of '...data'
-                        buffer.write_range_pointer(begin_0, end_0); // stitch [main, data)
-                        //
-                        buffer.write_under_score(); // stitch _
-                        // stitch {current_sampler_id}
-                        buffer.write_char_array_pointer(sampler->traversal_info().id_str(),
-                                                        sampler->traversal_info().size_id_str());
-                        race.handled=true;
-                        return end_0;
-                    }
-                }
-                return nullptr;
-            };
-            race_t races[2] = {
-                    {0, "sampler_", 8, main, true, true},
-                    {1, "data.", 5, main, true, true},
-            };
+            // sampler_{local_id} --> sampler_{SUB_SAMPLER_ID}
+            // tokens of the body are found once, if there is a cache
+            const auto * main = nitrogl::find_first_not_of_in(
+                    folded ? sampler_t::folded_main() : sampler->main(), '\n', -1);
             const auto * latest_main = main;
-            if(sub_samplers_count==0) races[0].enabled=false; // disable 0
-            if(!has_uniforms_data) races[1].enabled=false; // disable 1
-            int arg_min=0;
-            for(; arg_min!=-1; ) {
-                arg_min=-1;
-                // pick next index of handled and argmin
-                for (int ix = 0; ix < 2; ++ix) {
-                    auto & race = races[ix];
-                    if(!race.enabled) continue;
-                    if(race.handled) {
-                        race.next = index_of_in(race.name, latest_main, race.name_len);
-                        if(race.next==nullptr) { // did not find
-                            // let's disable it entirely
-                            race.enabled=false;
-                            continue;
-                        }
-                        // flag it is pending a handle
-                        race.handled=false;
-                    }
+            const auto handle = [&](const shader_sources_cache::token_t & token) {
+                if(token.kind==0) {
+                    if(sub_samplers_count==0) return;
+                    buffer.write_range_pointer(latest_main, main + token.cut); // stitch [latest, sampler_)
+                    // stitch {global_id} of the sub sampler
+                    const auto * sub = sampler->sub_sampler(token.local_id)->resolved();
+                    buffer.write_char_array_pointer(sub->traversal_info().id_str(),
+                                                    sub->traversal_info().size_id_str());
+                } else {
+                    if(!has_uniforms_data) return;
+                    buffer.write_range_pointer(latest_main, main + token.cut); // stitch [latest, data)
+                    buffer.write_under_score(); // stitch _
+                    // stitch {current_sampler_id}
+                    buffer.write_char_array_pointer(sampler->traversal_info().id_str(),
+                                                    sampler->traversal_info().size_id_str());
                 }
-                for (int ix = 0; ix < 2; ++ix) {
-                    auto & race = races[ix];
-                    if(!race.enabled) continue;
-                    if(!race.handled) {
-                        if(arg_min==-1 ||
-                            races[arg_min].next==nullptr ||
-                            race.next<races[arg_min].next)
-                            arg_min=ix;
-                    }
-                }
-                if(arg_min!=-1)
-                    latest_main=handle(races[arg_min], latest_main);
+                latest_main = main + token.resume;
+            };
+            const auto tokens = cache ? cache->tokens(main) : shader_sources_cache::tokens_t{};
+            if(tokens.begin) {
+                for (const auto * token = tokens.begin; token < tokens.end; ++token)
+                    handle(*token);
+            } else {
+                shader_sources_cache::token_t token;
+                for (const char * from = main;
+                     shader_sources_cache::next_token(main, from, token);
+                     from = main + token.resume)
+                    handle(token);
             }
             buffer.write_char_array_pointer(latest_main, -1); // stitch [latest_main, end)
             buffer.write_new_line(); // stitch [latest_main, end)
         }
 
-        struct race_t {
-            int id; // this dictates behaviour
-            const char * name; int name_len;
-            const char * next;
-            bool handled;
-            bool enabled;
-        };
-
     public:
+        /**
+         * Composite the fragment shader of a sampler tree, compile and link the program.
+         * Nothing is shared between calls, other than the cache.
+         * @param cache optional memory of sampler bodies tokens and stitched sources
+         * @param key key of the program (sampler tree and composition), that the stitched
+         *        source is cached by
+         */
         static bool composite_main_program_from_sampler(main_shader_program & program,
                                                         sampler_t & sampler,
                                                         const GLchar * glsl_version=nullptr,
                                                         bool is_premul_alpha_result=true,
                                                         const nitrogl::blend_mode_t blend_mode=nullptr,
-                                                        const nitrogl::compositor_t compositor=nullptr) {
+                                                        const nitrogl::compositor_t compositor=nullptr,
+                                                        bool hardware_blend=false,
+                                                        main_shader_program::vertex_kind vertex=
+                                                                main_shader_program::vertex_kind::triangles,
+                                                        shader_sources_cache * cache=nullptr,
+                                                        nitrogl::uintptr_type key=0) {
+            NITROGL_PROFILE_SCOPE("shader_compositor::composite");
             // fragment shards
             using buffers_type = sources_buffer<1000, 1>;
-            static buffers_type buffers{};
-            buffers.reset();
-            // write version
-            const GLchar * glsl_v = glsl_version ? glsl_version : main_shader_program::glsl_version;
-            buffers.write_char_array_pointer(glsl_v);
-            buffers.write_new_line();
-            // write compatability
-            buffers.write_char_array_pointer(main_shader_program::shader_compat);
-            // write frag variables
-            buffers.write_char_array_pointer(main_shader_program::frag_other);
-            buffers.write_char_array_pointer(nitrogl::porter_duff::base());
-            // add samplers tree recursively
-            _internal_composite(&sampler, buffers);
-            // add define (#define __SAMPLER_MAIN sampler_{id})
-            buffers.write_char_array_pointer(main_shader_program::define_sampler);
-            buffers.write_char_array_pointer(sampler.traversal_info().id_str(),
-                                             sampler.traversal_info().size_id_str());
-            buffers.write_new_line();
-            // write compositing stuff
-            if(compositor) buffers.write_char_array_pointer(compositor);
-            if(blend_mode) buffers.write_char_array_pointer(blend_mode);
-            if(is_premul_alpha_result)
-                buffers.write_char_array_pointer(main_shader_program::define_premul_alpha);
-            // write main shader
-            buffers.write_char_array_pointer(main_shader_program::frag_main);
+            buffers_type buffers{};
+            const GLchar * stitched = cache ? cache->find(key) : nullptr;
+            if(!stitched) {
+                // write version
+                const GLchar * glsl_v = glsl_version ? glsl_version : main_shader_program::glsl_version;
+                buffers.write_char_array_pointer(glsl_v);
+                buffers.write_new_line();
+                // write compatability
+                buffers.write_char_array_pointer(main_shader_program::shader_compat);
+                // instanced draws read per instance inputs, that frag variables declare
+                if(vertex==main_shader_program::vertex_kind::instanced)
+                    buffers.write_char_array_pointer(main_shader_program::define_instanced);
+                // edge antialiased draws cover their fragments by the distances to the edges,
+                // curves fills also by the curves
+                if(vertex==main_shader_program::vertex_kind::edge_aa)
+                    buffers.write_char_array_pointer(main_shader_program::define_edge_aa);
+                if(vertex==main_shader_program::vertex_kind::curve)
+                    buffers.write_char_array_pointer(main_shader_program::define_curve);
+                // strokes expanded on the GPU are covered by their dashes
+                if(vertex==main_shader_program::vertex_kind::stroke)
+                    buffers.write_char_array_pointer(main_shader_program::define_stroke);
+                // write frag variables
+                buffers.write_char_array_pointer(main_shader_program::frag_other);
+                buffers.write_char_array_pointer(nitrogl::porter_duff::base());
+                // add samplers tree recursively
+                _internal_composite(&sampler, buffers, cache);
+                // add define (#define __SAMPLER_MAIN sampler_{id})
+                buffers.write_char_array_pointer(main_shader_program::define_sampler);
+                buffers.write_char_array_pointer(sampler.resolved()->traversal_info().id_str(),
+                                                 sampler.resolved()->traversal_info().size_id_str());
+                buffers.write_new_line();
+                // write compositing stuff, unless the hardware blends (pre-multiplied alpha only)
+                if(hardware_blend) {
+                    buffers.write_char_array_pointer(main_shader_program::define_hw_blend);
+                } else {
+                    if(compositor) buffers.write_char_array_pointer(compositor);
+                    if(blend_mode) buffers.write_char_array_pointer(blend_mode);
+                    if(is_premul_alpha_result)
+                        buffers.write_char_array_pointer(main_shader_program::define_premul_alpha);
+                }
+                // write main shader
+                buffers.write_char_array_pointer(main_shader_program::frag_main);
+                if(cache) stitched = cache->store(key, buffers.sources, buffers.lengths, buffers.size());
+            }
             //
 
-            auto & vertex = program.vertex();
+            NITROGL_PROFILE_SCOPE("shader_compositor::compile");
+            auto & vertex_shader = program.vertex();
             auto & fragment = program.fragment();
 
-            // vertex shader is always the same/constant here, so we can save a compilation once it is hot
+            // vertex shader is one of a few constant shaders, so we can save a compilation once it is hot
             // or was used compiled once in the past.
-            if(!vertex.isCompiled()) {
+            if(!vertex_shader.isCompiled() || program.vertex_type!=vertex) {
                 const GLchar * vertex_shader_sources[3] =
                         { main_shader_program::glsl_version, main_shader_program::shader_compat,
-                          main_shader_program::vert };
-                vertex.updateShaderSource(vertex_shader_sources, 3, nullptr, true);
+                          main_shader_program::vertex_source(vertex) };
+                vertex_shader.updateShaderSource(vertex_shader_sources, 3, nullptr, true);
+                program.vertex_type = vertex;
             }
-            bool stat_compile = fragment.updateShaderSource(buffers.sources, buffers.size(),
-                                                            buffers.lengths, true);
+            bool stat_compile = stitched ?
+                    fragment.updateShaderSource(&stitched, 1, nullptr, true) :
+                    fragment.updateShaderSource(buffers.sources, buffers.size(),
+                                                buffers.lengths, true);
             if(!stat_compile) {
 #ifdef NITROGL_DEBUG_MODE
                 GLchar source[10000];
@@ -0,0 +1,191 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+#pragma once
+
+#include "../traits.h"
+#include "string_utils.h"
+
+// bytes of the arena of stitched fragment sources, a source has to fit in it
+#ifndef NITROGL_SOURCES_CACHE_BYTES
+#define NITROGL_SOURCES_CACHE_BYTES (1<<15)
+#endif
+// count of stitched fragment sources in the arena
+#ifndef NITROGL_SOURCES_CACHE_ENTRIES
+#define NITROGL_SOURCES_CACHE_ENTRIES 32
+#endif
+// count of sampler bodies, whose tokens are memoized
+#ifndef NITROGL_TOKENS_CACHE_ENTRIES
+#define NITROGL_TOKENS_CACHE_ENTRIES 64
+#endif
+// count of tokens of all of the memoized sampler bodies
+#ifndef NITROGL_TOKENS_CACHE_TOKENS
+#define NITROGL_TOKENS_CACHE_TOKENS 1024
+#endif
+
+namespace nitrogl {
+
+    /**
+     * Memory of the shader compositor, so programs that were evicted from the pool are
+     * re-created for the cost of the driver compile only:
+     * 1. tokens of sampler bodies (main()), that the compositor rewrites ('sampler_' and
+     *    'data.'), found once per body. Bodies are keyed by their pointer, so main() has to
+     *    return strings with static storage (string literals)
+     * 2. stitched fragment sources, keyed by the key of the program, in a ring arena. Older
+     *    sources are evicted, when newer ones need the room
+     * Both are bounded, and nothing is allocated.
+     */
+    class shader_sources_cache {
+    public:
+        // a token of a sampler body, offsets are from the beginning of the body
+        struct token_t {
+            // 0 for 'sampler_{local id}(', 1 for 'data.'
+            unsigned char kind;
+            unsigned char local_id;
+            // where the body is cut (end of 'sampler_', or the '.' of 'data.'), and where it
+            // continues after the rewrite
+            unsigned short cut, resume;
+        };
+        struct tokens_t { const token_t * begin, * end; };
+
+        /**
+         * find the next token of a body
+         * @param main the body
+         * @param from where to start looking
+         * @param token the found token
+         * @return false if there are no more tokens
+         */
+        static bool next_token(const char * main, const char * from, token_t & token) {
+            const auto * s = nitrogl::index_of_in("sampler_", from, 8);
+            const auto * d = nitrogl::index_of_in("data.", from, 5);
+            if(s==nullptr && d==nullptr) return false;
+            if(s!=nullptr && (d==nullptr || s<d)) {
+                const auto * end = s + 8;
+                const auto * paren = nitrogl::index_of_in("(", end, 1);
+                if(paren==nullptr) return false;
+                token.kind=0;
+                token.local_id=(unsigned char)nitrogl::s2i(end, int(paren-end));
+                token.cut=(unsigned short)(end-main);
+                token.resume=(unsigned short)(paren-main);
+            } else {
+                token.kind=1;
+                token.local_id=0;
+                token.cut=token.resume=(unsigned short)(d + 4 - main);
+            }
+            return true;
+        }
+
+    private:
+        struct body_t { const char * main; unsigned first, count; };
+        struct source_t { nitrogl::uintptr_type key; unsigned offset, length; bool valid; };
+
+        body_t _bodies[NITROGL_TOKENS_CACHE_ENTRIES];
+        token_t _tokens[NITROGL_TOKENS_CACHE_TOKENS];
+        unsigned _bodies_count, _tokens_count;
+
+        char _arena[NITROGL_SOURCES_CACHE_BYTES];
+        source_t _sources[NITROGL_SOURCES_CACHE_ENTRIES];
+        unsigned _head, _next_source;
+
+        void forget_bodies() { _bodies_count=_tokens_count=0; }
+
+    public:
+        shader_sources_cache() : _bodies(), _tokens(), _bodies_count(0), _tokens_count(0),
+                                 _arena(), _sources(), _head(0), _next_source(0) {}
+        shader_sources_cache(const shader_sources_cache &)=delete;
+        shader_sources_cache & operator=(const shader_sources_cache &)=delete;
+
+        /**
+         * tokens of a body, found once and memoized. When the memory is full, it is forgotten
+         * and the memoization starts over
+         * @param main the body, with static storage
+         */
+        tokens_t tokens(const char * main) {
+            for (unsigned ix = 0; ix < _bodies_count; ++ix)
+                if(_bodies[ix].main==main) {
+                    const auto * first = _tokens + _bodies[ix].first;
+                    return { first, first + _bodies[ix].count };
+                }
+            for (int attempt = 0; attempt < 2; ++attempt) {
+                if(_bodies_count==NITROGL_TOKENS_CACHE_ENTRIES) forget_bodies();
+                const unsigned first = _tokens_count;
+                token_t token;
+                const char * from = main;
+                bool fits = true;
+                while(next_token(main, from, token)) {
+                    if(_tokens_count==NITROGL_TOKENS_CACHE_TOKENS) { fits=false; break; }
+                    _tokens[_tokens_count++]=token;
+                    from = main + token.resume;
+                }
+                if(fits) {
+                    _bodies[_bodies_count++] = { main, first, _tokens_count-first };
+                    return { _tokens + first, _tokens + _tokens_count };
+                }
+                forget_bodies();
+            }
+            // more tokens than the memory holds
+            return { nullptr, nullptr };
+        }
+
+        /**
+         * @param key key of the program
+         * @return the stitched fragment source of the program, null-terminated, or nullptr
+         */
+        const char * find(nitrogl::uintptr_type key) const {
+            for (const auto & s : _sources)
+                if(s.valid && s.key==key) return _arena + s.offset;
+            return nullptr;
+        }
+
+        /**
+         * stitch sources into the arena, evicts older sources that overlap it
+         * @param key key of the program
+         * @param sources sources array
+         * @param lengths lengths of sources, -1 for null-terminated ones
+         * @param count count of sources
+         * @return the stitched source, or nullptr if it is larger than the arena
+         */
+        const char * store(nitrogl::uintptr_type key, const char * const * sources,
+                           const int * lengths, unsigned count) {
+            unsigned length = 1;
+            for (unsigned ix = 0; ix < count; ++ix) {
+                if(lengths[ix]>=0) length += unsigned(lengths[ix]);
+                else for (const char * c = sources[ix]; *c; ++c) ++length;
+            }
+            if(length > NITROGL_SOURCES_CACHE_BYTES) return nullptr;
+            if(_head + length > NITROGL_SOURCES_CACHE_BYTES) _head = 0;
+            // evict what is overlapped, and the source in the next slot
+            for (auto & s : _sources)
+                if(s.valid && s.offset < _head + length && _head < s.offset + s.length)
+                    s.valid=false;
+            auto & source = _sources[_next_source];
+            _next_source = (_next_source + 1) % NITROGL_SOURCES_CACHE_ENTRIES;
+            char * out = _arena + _head;
+            for (unsigned ix = 0; ix < count; ++ix) {
+                const char * c = sources[ix];
+                if(lengths[ix]>=0) for (int jx = 0; jx < lengths[ix]; ++jx) *(out++) = c[jx];
+                else while(*c) *(out++) = *(c++);
+            }
+            *out = '\0';
+            source = { key, _head, length, true };
+            _head += length;
+            return _arena + source.offset;
+        }
+
+        // forget everything
+        void clear() {
+            forget_bodies();
+            for (auto & s : _sources) s.valid=false;
+            _head=_next_source=0;
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "traits.h"
+
+namespace nitrogl {
+
+    /**
+     * Memory arena: allocations bump a pointer in a block, and are released all at once by
+     * reset(). Blocks are added when the current one is full, and are merged into one block
+     * of their total size on reset(), so once the arena has grown to the largest working set,
+     * it does not allocate anymore. Good for the temporary memory of tessellations, that is
+     * freed right after. Not thread safe, use an arena per thread.
+     */
+    class memory_arena {
+    public:
+        static constexpr size_t alignment = 2*sizeof(void *);
+
+    private:
+        struct block_t {
+            block_t * next;
+            size_t size;
+        };
+        static constexpr size_t header = (sizeof(block_t) + alignment - 1) & ~(alignment - 1);
+
+        block_t * _blocks;
+        unsigned char * _head, * _end;
+        size_t _block_size;
+
+        static size_t align_up(size_t bytes) { return (bytes + alignment - 1) & ~(alignment - 1); }
+
+        void push_block(size_t size) {
+            auto * block = static_cast<block_t *>(::operator new(header + size));
+            block->next = _blocks; block->size = size;
+            _blocks = block;
+            _head = reinterpret_cast<unsigned char *>(block) + header;
+            _end = _head + size;
+        }
+
+        void release() {
+            while(_blocks) {
+                auto * next = _blocks->next;
+                ::operator delete(_blocks);
+                _blocks = next;
+            }
+            _head = _end = nullptr;
+        }
+
+    public:
+        /**
+         * @param block_size size in bytes of the first block, next blocks double
+         */
+        explicit memory_arena(size_t block_size=1u<<16) : _blocks(nullptr), _head(nullptr),
+                                    _end(nullptr), _block_size(block_size) {}
+        memory_arena(const memory_arena &)=delete;
+        memory_arena & operator=(const memory_arena &)=delete;
+        ~memory_arena() { release(); }
+
+        void * allocate(size_t bytes) {
+            bytes = align_up(bytes ? bytes : 1);
+            if(_head + bytes > _end) {
+                const size_t grown = _blocks ? 2*_blocks->size : _block_size;
+                push_block(grown > bytes ? grown : bytes);
+            }
+            auto * pointer = _head;
+            _head += bytes;
+            return pointer;
+        }
+
+        // release all of the allocations, the memory is kept for the next ones
+        void reset() {
+            if(!_blocks) return;
+            if(_blocks->next) {
+                size_t total = 0;
+                for (auto * block = _blocks; block; block = block->next) total += block->size;
+                release();
+                push_block(total);
+                return;
+            }
+            _head = reinterpret_cast<unsigned char *>(_blocks) + header;
+        }
+
+        // bytes of all of the blocks
+        size_t capacity() const {
+            size_t total = 0;
+            for (auto * block = _blocks; block; block = block->next) total += block->size;
+            return total;
+        }
+    };
+
+    /**
+     * allocator of a memory arena, that rebinds like std_rebind_allocator, so it can be the
+     * tessellation allocator of micro-tess algorithms. Deallocation does nothing, memory
+     * is released by memory_arena::reset()
+     * @tparam T the allocated object type
+     */
+    template<typename T=unsigned char>
+    class arena_rebind_allocator {
+        memory_arena * _arena;
+
+        template<typename U> friend class arena_rebind_allocator;
+
+    public:
+        using value_type = T;
+        using size_t = unsigned long;
+
+        template<class U>
+        explicit arena_rebind_allocator(const arena_rebind_allocator<U> & other) noexcept :
+                    _arena(other._arena) {};
+        explicit arena_rebind_allocator(memory_arena & arena) noexcept : _arena(&arena) {};
+
+        template <class U, class... Args>
+        void construct(U* p, Args&&... args) {
+            ::new(p) U(traits::forward<Args>(args)...);
+        }
+
+        T * allocate(size_t n) { return static_cast<T *>(_arena->allocate(n * sizeof(T))); }
+        void deallocate(T *, size_t=0) {}
+
+        memory_arena & arena() const { return *_arena; }
+
+        template<class U> struct rebind {
+            typedef arena_rebind_allocator<U> other;
+        };
+    };
+
+    template<class T1, class T2>
+    bool operator==(const arena_rebind_allocator<T1>& lhs, const arena_rebind_allocator<T2>& rhs ) noexcept {
+        return &lhs.arena()==&rhs.arena();
+    }
+}
\ No newline at end of file
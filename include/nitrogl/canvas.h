@@ -18,6 +18,8 @@
 #include "channels.h"
 #include "triangles.h"
 #include "polygons.h"
+#include "compositing/hardware_blending.h"
+#include "ogl/profiler.h"
 
 // micro-tess
 #ifndef NITROGL_USE_EXTERNAL_MICRO_TESS
@@ -54,6 +56,9 @@
 // ogl
 #include "ogl/gl_texture.h"
 #include "ogl/fbo.h"
+#include "ogl/rbo.h"
+#include "ogl/pixels_readback.h"
+#include "ogl/gl_state.h"
 #include "ogl/vbo.h"
 #include "ogl/ebo.h"
 
@@ -61,6 +66,11 @@
 #include "render_nodes/multi_render_node.h"
 #include "render_nodes/multi_render_node_interleaved_xyuv.h"
 #include "render_nodes/p4_render_node.h"
+#include "render_nodes/instanced_p4_render_node.h"
+#include "render_nodes/stroke_render_node.h"
+#include "render_nodes/patch_render_node.h"
+#include "render_nodes/edge_aa_render_node.h"
+#include "render_nodes/curve_render_node.h"
 
 // internal
 #include "_internal/main_shader_program.h"
@@ -69,6 +79,7 @@
 #include "_internal/lru_pool.h"
 #include "camera.h"
 #include "path.h"
+#include "arena_allocator.h"
 
 // samplers
 #include "samplers/test_sampler.h"
@@ -80,15 +91,35 @@
 #include "samplers/channel_sampler.h"
 #include "samplers/shapes/arc_sampler.h"
 #include "samplers/shapes/pie_sampler.h"
+#include "samplers/instance_tint_sampler.h"
+#include "shape_instances.h"
 
 // compositing
 #include "compositing/porter_duff.h"
 #include "compositing/blend_modes.h"
 
+// count of the largest opaque rects of a batch, that cull the instances they hide
+#ifndef NITROGL_BATCH_OCCLUDERS
+#define NITROGL_BATCH_OCCLUDERS 8
+#endif
+
+// bits of the slots count of the shared pool of shader programs, that keeps up to half as many
+// programs (one per sampler, vertex kind, blend and compositor in use), the least recently used
+// is evicted and recompiled when needed again. 1..10 with 32 bit pointers, 1..21 with 64 bit.
+#ifndef NITROGL_SHADER_PROGRAMS_BITS
+#define NITROGL_SHADER_PROGRAMS_BITS 7
+#endif
+
 namespace nitrogl {
 
     // draw mode enables to change the draw mode
     enum class draw_mode { fill=GL_FILL, line=GL_LINE, point=GL_POINT };
+    // how paths are filled, see canvas::updatePathFillMode
+    enum class path_fill_mode { tessellate, stencil, curves };
+    // how paths are stroked, see canvas::updatePathStrokeMode
+    enum class path_stroke_mode { tessellate, gpu };
+    // how bezier patches are evaluated, see canvas::updateBezierPatchMode
+    enum class bezier_patch_mode { tessellate, gpu };
 
     class canvas {
     public:
@@ -103,19 +134,55 @@ namespace nitrogl {
         };
 
     private:
-        using static_alloc = micro_alloc::static_linear_allocator<char, 1<<14, 0>;
-        using lru_main_shader_pool_t = microc::lru_pool<main_shader_program, 5,
-                                                nitrogl::uintptr_type, static_alloc>;
+        // the programs and the pool table of every slot, with room for alignment
+        using static_alloc = micro_alloc::static_linear_allocator<char,
+                ((sizeof(main_shader_program) + 2*sizeof(nitrogl::uintptr_type))
+                        << NITROGL_SHADER_PROGRAMS_BITS) + 256, 0>;
+        using lru_main_shader_pool_t = microc::lru_pool<main_shader_program,
+                NITROGL_SHADER_PROGRAMS_BITS, nitrogl::uintptr_type, static_alloc>;
         window_t _window;
         gl_texture _tex_backdrop;
         fbo_t _fbo;
+        // multisampled render target, draws go into it and are resolved into _fbo
+        rbo_t _rbo_ms;
+        fbo_t _fbo_ms;
+        // stencil buffer of the render target for stencil path fills, state is -1 until it
+        // is looked for, 0 if the render target has none and 1 if it is ready
+        rbo_t _rbo_stencil;
+        int _stencil_state;
         multi_render_node _node_multi;
         multi_render_node_interleaved_xyuv _node_multi_interleaved;
         p4_render_node _node_p4;
+        instanced_p4_render_node _node_instanced;
+        stroke_render_node _node_stroke;
+        patch_render_node _node_patch;
+        edge_aa_render_node _node_edge_aa;
+        curve_render_node _node_curve;
         blend_mode_t _blend_mode;
         compositor_t _alpha_compositor;
         draw_mode _draw_mode;
+        path_fill_mode _path_fill_mode;
+        path_stroke_mode _path_stroke_mode;
+        bezier_patch_mode _bezier_patch_mode;
+        // fade the outline of tessellated paths and polygons, see enableEdgeAntialiasing
+        bool _is_edge_aa_enabled;
         bool _is_pre_mul_alpha;
+        // hardware blending: state of the current draw (null for the shader path), is the
+        // backdrop texture behind the canvas, is the canvas known to be opaque everywhere
+        const hardware_blending::state_t * _hw_blend;
+        bool _is_hw_blend_enabled, _is_source_opaque;
+        mutable bool _is_backdrop_stale, _is_backdrop_opaque;
+        // samples of the multisampled target (0 if disabled), region that was drawn into
+        // it since the last resolve
+        unsigned _samples;
+        mutable rect_i _dirty;
+        // bounds capture, draws are measured instead of drawn
+        mutable bool _is_capturing;
+        mutable rect_i _captured;
+        // asynchronous pixels reads in flight
+        pixels_readback<> _readback;
+        // temporary memory of polygons tessellations, see drawPolygon
+        memory_arena _tessellation_workspace;
 
         static static_alloc get_static_allocator() {
             // static allocator, shared by all canvases
@@ -123,6 +190,12 @@ namespace nitrogl {
             return allocator_static;
         }
 
+        static shader_sources_cache & sources_cache() {
+            // tokens and stitched sources are shared among all canvas instances
+            static shader_sources_cache cache;
+            return cache;
+        }
+
         static lru_main_shader_pool_t & lru_main_shader_pool() {
             // shader pool is shared among all canvas instances
             static lru_main_shader_pool_t pool{0.5f, get_static_allocator()};
@@ -140,6 +213,11 @@ namespace nitrogl {
             generate_backdrop();
             copy_to_backdrop();
             _node_p4.init();
+            _node_instanced.init();
+            _node_stroke.init();
+            _node_patch.init();
+            _node_edge_aa.init();
+            _node_curve.init();
             _node_multi.init();
             _node_multi_interleaved.init();
             updateDrawMode(_draw_mode);
@@ -148,7 +226,7 @@ namespace nitrogl {
     public:
         void generate_backdrop() {
             // move
-            _tex_backdrop = gl_texture::empty(width(), height(), GL_RGBA, _is_pre_mul_alpha,
+            _tex_backdrop = gl_texture::empty(width(), height(), GL_RGBA, _is_pre_mul_alpha, 1,
                                          GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
         }
 
@@ -160,26 +238,155 @@ namespace nitrogl {
             _blend_mode=blend_mode; _alpha_compositor=alpha_compositor;
         }
 
+        /**
+         * Enable/Disable hardware blending. When enabled (default), compositions that the fixed
+         * function blending computes exactly (see hardware_blending) skip the backdrop, on
+         * pre-multiplied alpha canvases. Disable it to always go through the shader path.
+         */
+        void enableHardwareBlending(bool enabled) { _is_hw_blend_enabled=enabled; }
+        bool isHardwareBlendingEnabled() const { return _is_hw_blend_enabled; }
 
-        // if wants AA:
-        // 1. create RBO with multisampling and attach it to color in fbo_t, and then blit to texture's fbo_t
-        // if you are given texture, then draw into it
-        explicit canvas(const gl_texture & tex) : _tex_backdrop(gl_texture::un_generated_dummy()),
-                                                  _fbo(), _node_multi(), _node_multi_interleaved(), _node_p4(), _window(),
-                                                  _is_pre_mul_alpha(tex.is_premul_alpha()),
+        /**
+         * Enable/Disable multisampled anti-aliasing. Draws render into a multisampled render
+         * buffer, that is resolved into the target only where it was drawn into, at flush() or
+         * when the backdrop is needed (shader path compositions). Edges of triangles, polygons
+         * and paths are anti-aliased, without extra geometry or shader cost.
+         * Notes:
+         * - call flush() before the target is read (sampled, read back or presented)
+         * - the multisampled buffer is RGBA8, on GL-ES the target has to be RGBA8 as well
+         * - requires gl>=3.0 or gl-es>=3.0 (NITROGL_SUPPORTS_MULTISAMPLING)
+         * @param samples samples per pixel, clamped to GL_MAX_SAMPLES. 0 or 1 disables it
+         * @return the samples per pixel, that were allocated, 0 if disabled
+         */
+        unsigned enableMultisampling(unsigned samples) {
+            NITROGL_PROFILE_SCOPE("canvas::enableMultisampling");
+            flush();
+            if(_is_backdrop_stale) { copy_to_backdrop(); _is_backdrop_stale = false; }
+            release_stencil();
+            _fbo_ms = fbo_t::un_generated();
+            _rbo_ms = rbo_t::un_generated();
+            _samples = 0;
+            if(!ogl_info::supports_multisampling || samples<=1) return 0;
+            _rbo_ms = rbo_t();
+            const auto allocated = _rbo_ms.storage(GL_RGBA8, GLsizei(width()), GLsizei(height()),
+                                                   GLsizei(samples));
+            if(allocated<=1) { _rbo_ms = rbo_t::un_generated(); return 0; }
+            _fbo_ms = fbo_t();
+            _fbo_ms.attachRenderbuffer(_rbo_ms);
+            _samples = unsigned(allocated);
+            // frame buffers can not be blitted into multisampled ones, so the content of the
+            // target is drawn into it from the backdrop
+            const auto blend_mode = _blend_mode; const auto compositor = _alpha_compositor;
+            const bool hw_blend_enabled = _is_hw_blend_enabled;
+            update_composition(blend_modes::Normal(), porter_duff::Copy());
+            _is_hw_blend_enabled = true;
+            texture_sampler backdrop{_tex_backdrop};
+            const auto & w = _window.canvas_rect;
+            const auto clip = _window.clip_rect;
+            _window.clip_rect = w;
+            drawRect(backdrop, float(w.left), float(w.top), float(w.right), float(w.bottom));
+            _window.clip_rect = clip;
+            update_composition(blend_mode, compositor);
+            _is_hw_blend_enabled = hw_blend_enabled;
+            // both targets agree, the backdrop as well
+            _dirty = rect_i{};
+            _is_backdrop_stale = false;
+            return _samples;
+        }
+        // samples per pixel of the multisampled target, 0 if multisampling is disabled
+        unsigned multisamples() const { return _samples; }
+
+        /**
+         * Resolve the multisampled target into the target, where it was drawn into since the
+         * last resolve. Does nothing if multisampling is disabled.
+         */
+        void flush() const { resolve(); }
+
+        /**
+         * Capture the bounds of the draws, instead of drawing them, until endBoundsCapture().
+         * Used to bin draws into tiles (see tiled_canvas), or to measure them.
+         */
+        void beginBoundsCapture() { _is_capturing = true; _captured = rect_i{}; }
+        /**
+         * @return union of the bounds of the draws since beginBoundsCapture(), in canvas
+         *         coordinates and padded by a couple of pixels. Empty if nothing was drawn
+         */
+        rect_i endBoundsCapture() { _is_capturing = false; return _captured; }
+
+        /**
+         * Read pixels of the target asynchronously, without stalling on the GPU. The pixels are
+         * delivered to the callback by a later call to pollReadPixels(), once the GPU is done
+         * with them (usually a frame or two later), and in the order of the requests.
+         * Requires fences (GL 3.2 or GL-ES 3.0), otherwise the read is synchronous and
+         * delivered right away.
+         * @param rect rectangle to read, in canvas coordinates, clipped to the canvas
+         * @param callback (const rect_i & rect, const unsigned char * pixels, int stride) -> void,
+         *        pixels point to the top row of RGBA8 pixels, next rows are at multiples of stride
+         *        (may be negative). Pixels are valid only during the call, and are delivered as
+         *        they are in the target unless alpha asks to convert them
+         * @param alpha convert to premultiplied or to un-premultiplied alpha
+         */
+        template<class callback_type>
+        void readPixelsAsync(const rect_i & rect, const callback_type & callback,
+                             pixels_alpha alpha=pixels_alpha::as_is) {
+            NITROGL_PROFILE_SCOPE("canvas::readPixelsAsync");
+            flush();
+            _readback.poll();
+            const auto r = rect.intersect(rect_i(0, 0, int(width()), int(height())));
+            _readback.read(_fbo, int(height()), r, alpha, callback);
+        }
+        /**
+         * Deliver the finished asynchronous reads (see readPixelsAsync)
+         * @param wait wait for all of the reads in flight
+         * @return count of delivered reads
+         */
+        unsigned pollReadPixels(bool wait=false) { return _readback.poll(wait); }
+        // count of asynchronous reads in flight
+        unsigned pendingReadPixels() const { return _readback.pending(); }
+
+
+        // if you are given texture, then draw into it. For AA, see enableMultisampling
+        explicit canvas(const gl_texture & tex) : _window(),
+                                                  _tex_backdrop(gl_texture::un_generated_dummy()),
+                                                  _fbo(), _rbo_ms(rbo_t::un_generated()),
+                                                  _fbo_ms(fbo_t::un_generated()),
+                                                  _rbo_stencil(rbo_t::un_generated()),
+                                                  _stencil_state(-1),
+                                                  _node_multi(), _node_multi_interleaved(), _node_p4(),
+                                                  _node_instanced(), _node_stroke(), _node_patch(),
+                                                  _node_edge_aa(), _node_curve(),
                                                   _blend_mode(blend_modes::Normal()),
                                                   _alpha_compositor(porter_duff::SourceOver()),
-                                                  _draw_mode(draw_mode::fill) {
+                                                  _draw_mode(draw_mode::fill),
+                                                  _path_fill_mode(path_fill_mode::tessellate),
+                                                  _path_stroke_mode(path_stroke_mode::tessellate),
+                                                  _bezier_patch_mode(bezier_patch_mode::tessellate),
+                                                  _is_edge_aa_enabled(false),
+                                                  _is_pre_mul_alpha(tex.is_premul_alpha()),
+                                                  _hw_blend(nullptr), _is_hw_blend_enabled(true),
+                                                  _is_source_opaque(false), _is_backdrop_stale(false),
+                                                  _is_backdrop_opaque(false), _samples(0), _dirty(),
+                                                  _is_capturing(false), _captured() {
             _fbo.attachTexture(tex);
             internal_init(tex.width(), tex.height());
         }
 
         // if you got nothing, draw to bound fbo
         canvas(int width, int height, bool is_pre_mul_alpha=true) :
-                _tex_backdrop(gl_texture::un_generated_dummy()), _fbo(fbo_t::from_current()),
-                _node_multi(), _node_p4(), _node_multi_interleaved(), _window(), _is_pre_mul_alpha(is_pre_mul_alpha),
+                _window(), _tex_backdrop(gl_texture::un_generated_dummy()),
+                _fbo(fbo_t::from_current()),
+                _rbo_ms(rbo_t::un_generated()), _fbo_ms(fbo_t::un_generated()),
+                _rbo_stencil(rbo_t::un_generated()), _stencil_state(-1),
+                _node_multi(), _node_multi_interleaved(), _node_p4(), _node_instanced(),
+                _node_stroke(), _node_patch(), _node_edge_aa(), _node_curve(),
                 _blend_mode(blend_modes::Normal()), _alpha_compositor(porter_duff::SourceOver()),
-                _draw_mode(draw_mode::fill) {
+                _draw_mode(draw_mode::fill), _path_fill_mode(path_fill_mode::tessellate),
+                _path_stroke_mode(path_stroke_mode::tessellate),
+                _bezier_patch_mode(bezier_patch_mode::tessellate), _is_edge_aa_enabled(false),
+                _is_pre_mul_alpha(is_pre_mul_alpha),
+                _hw_blend(nullptr), _is_hw_blend_enabled(true),
+                _is_source_opaque(false), _is_backdrop_stale(false), _is_backdrop_opaque(false),
+                _samples(0), _dirty(), _is_capturing(false), _captured() {
             internal_init(width, height);
         }
 
@@ -189,10 +396,96 @@ namespace nitrogl {
          */
         void updateDrawMode(draw_mode mode) {
             _draw_mode = mode;
-            GLenum mode_gl = int(_draw_mode);
-            glPolygonMode(GL_FRONT_AND_BACK, mode_gl);
+            gl_state::get().polygon_mode(GLenum(_draw_mode));
         }
 
+        /**
+         * Change how drawPathFill fills paths:
+         * - path_fill_mode::tessellate (default), the path is planarized on the CPU, and
+         *   the result is cached by the path until it changes
+         * - path_fill_mode::stencil, stencil-then-cover. Fans of the sub-paths accumulate the
+         *   winding into a stencil buffer, then the bounding box is covered where the fill
+         *   rule passes. CPU cost is linear in the vertices, good for paths that change every
+         *   frame (animations) and for complex self-intersecting paths.
+         * - path_fill_mode::curves, Loop-Blinn. Curves are not divided into lines, the polygon
+         *   of their control points is planarized, and every quadratic curve is a triangle,
+         *   that the fragment shader fills exactly and antialiased at any scale. Cubic curves
+         *   are approximated by quadratic curves. Fewer triangles for outlines with many
+         *   curves (i.e. glyphs), cached by the path as the tessellated fill.
+         * Notes:
+         * - the stencil buffer is attached to the render target (or multisampled target) on
+         *   first use. A frame buffer, that the canvas does not own, is used if it has a
+         *   stencil buffer. Stencil fills leave it cleared
+         * - requires gl>=3.0 or gl-es>=3.0 (NITROGL_SUPPORTS_MULTISAMPLING), otherwise, or
+         *   without a stencil buffer, and in line or point draw modes, paths are tessellated
+         * - curves fills are right for outlines, whose contours do not overlap, and whose
+         *   curves do not overlap each other (see microtess::loop_blinn). Straight edges are
+         *   antialiased with edge antialiasing (see enableEdgeAntialiasing), curves always.
+         *   Requires fragment derivatives (NITROGL_SUPPORTS_DERIVATIVES), otherwise, and in
+         *   line or point draw modes, paths are tessellated
+         * @param mode enum { path_fill_mode::tessellate, path_fill_mode::stencil,
+         *                    path_fill_mode::curves }
+         */
+        void updatePathFillMode(path_fill_mode mode) { _path_fill_mode = mode; }
+        path_fill_mode pathFillMode() const { return _path_fill_mode; }
+
+        /**
+         * Change how drawPathStroke strokes paths:
+         * - path_stroke_mode::tessellate (default), joins and caps are tessellated on the CPU,
+         *   and the result is cached by the path until it or the stroke changes
+         * - path_stroke_mode::gpu, every segment of the path is an instance, that the vertex
+         *   shader expands into a quad, a join and caps. CPU cost is a copy of the points,
+         *   so the width and the transform are only uniforms. Good for long polylines, that
+         *   change every frame (live charts), see also drawPolyline
+         * Notes:
+         * - round joins and caps have NITROGL_STROKE_ROUND_SEGMENTS triangles
+         * - dashes are covered per fragment by the arc length, so animated dash offsets are
+         *   only uniforms. Dashes end with the cap of the stroke, and joins inside of a dash
+         *   are kept. Patterns of up to NITROGL_STROKE_DASHES entries (odd ones count twice).
+         *   The offset moves the pattern forward on all paths, tessellated closed paths move
+         *   it backwards
+         * - hardware blended translucent strokes need a stencil buffer (see updatePathFillMode),
+         *   so overlaps of segments are blended once, otherwise they are blended twice
+         * - requires gl>=3.3 or gl-es>=3.0 (NITROGL_SUPPORTS_INSTANCING), otherwise, for
+         *   longer dash patterns and in line or point draw modes, paths are tessellated
+         * @param mode enum { path_stroke_mode::tessellate, path_stroke_mode::gpu }
+         */
+        void updatePathStrokeMode(path_stroke_mode mode) { _path_stroke_mode = mode; }
+        path_stroke_mode pathStrokeMode() const { return _path_stroke_mode; }
+
+        /**
+         * Change how drawBezierPatch evaluates patches:
+         * - bezier_patch_mode::tessellate (default), the surface is evaluated and triangulated
+         *   on the CPU, and uploaded on every draw
+         * - bezier_patch_mode::gpu, the vertex shader evaluates the surface on a (u, v) grid,
+         *   that is uploaded once per resolution (NITROGL_PATCH_GRIDS are kept). Control points
+         *   are uniforms, so a draw uploads 9 or 16 points. Good for animated meshes (warps)
+         * Notes:
+         * - the transform is about the left-top of the bounding box of the control points,
+         *   which contains the surface, instead of the bounding box of the surface
+         * @param mode enum { bezier_patch_mode::tessellate, bezier_patch_mode::gpu }
+         */
+        void updateBezierPatchMode(bezier_patch_mode mode) { _bezier_patch_mode = mode; }
+        bezier_patch_mode bezierPatchMode() const { return _bezier_patch_mode; }
+
+        /**
+         * Enable/Disable edge antialiasing of tessellated paths and polygons (drawPathFill,
+         * drawPolygon). The tessellators mark the edges of triangles, that are on the outline,
+         * and the fragment shader fades the coverage over the pixels they cross, on a fringe of
+         * half a pixel outside of the outline, so the inner edges of the triangles stay
+         * seamless. A cheap alternative to multisampling, without extra memory or resolves.
+         * Notes:
+         * - with projective transforms, and on the straight edges of curve fills (see
+         *   path_fill_mode::curves), there is no fringe, only the inner half of the outline
+         *   pixels is faded, shapes look thinner by about half a pixel there
+         * - miters of very sharp corners are cut at 1.5 pixels
+         * - stencil path fills (see updatePathFillMode) are not antialiased
+         * - requires fragment derivatives, gl>=2.0 or gl-es>=3.0 (NITROGL_SUPPORTS_DERIVATIVES),
+         *   otherwise, and in line or point draw modes, edges are aliased
+         */
+        void enableEdgeAntialiasing(bool enabled) { _is_edge_aa_enabled=enabled; }
+        bool isEdgeAntialiasingEnabled() const { return _is_edge_aa_enabled; }
+
         /**
          * update the clipping rectangle of the canvas
          *
@@ -253,19 +546,532 @@ namespace nitrogl {
             clear(color.r, color.g, color.b, color.a);
         }
         void clear(float r, float g, float b, float a) const {
-            _fbo.bind();
+            // clears the whole frame buffer, wherever it is
+            if(_is_capturing) { _captured = unbounded(); return; }
             if(_is_pre_mul_alpha) { r*=a; g*=a; b*=a; }
             glClearColor(r, g, b, a);
+            gl_state::get().enable_scissor(false);
+            // clear both targets, instead of resolving the multisampled one
+            if(_samples) {
+                _fbo_ms.bind();
+                glClear(GL_COLOR_BUFFER_BIT);
+                _dirty = rect_i{};
+            }
+            _fbo.bind();
             glClear(GL_COLOR_BUFFER_BIT);
             copy_to_backdrop();
-            nitrogl::fbo_t::unbind();
+            _is_backdrop_stale = false;
+            _is_backdrop_opaque = a>=1.0f;
         }
 
     private:
+        // draws go into the multisampled target, if multisampling is enabled
+        const fbo_t & render_target() const { return _samples ? _fbo_ms : _fbo; }
+
+        // inverted y projection of the canvas window, canvas coords to opengl
+        mat4f projection() const {
+            const auto & w = _window.canvas_rect;
+            return camera::orthographic<float>(float(w.left), float(w.right),
+                                               float(w.bottom), float(w.top),
+                                               -1.0f, 1.0f);
+        }
+
+        static rect_i unbounded() { return rect_i{-(1<<28), -(1<<28), 1<<28, 1<<28}; }
+        static rect_i unite(const rect_i & a, const rect_i & b) {
+            if(a.empty()) return b;
+            if(b.empty()) return a;
+            return rect_i{functions::min(a.left, b.left), functions::min(a.top, b.top),
+                          functions::max(a.right, b.right), functions::max(a.bottom, b.bottom)};
+        }
+
+        /**
+         * Bounds of a draw in canvas coordinates, padded by a couple of pixels for rounding,
+         * lines and points. Draws with projective transforms are unbounded.
+         * @param bbox bounding box of the draw
+         * @param transform transform of the draw
+         */
+        static rect_i draw_bounds(const rectf & bbox, const mat3f & transform) {
+            // column major, projective row is [2 5 8]
+            const auto & t = transform;
+            if(t[2]!=0.0f || t[5]!=0.0f) return unbounded();
+            const vec2f corners[4] = {
+                    t*vec2f{bbox.left, bbox.top}, t*vec2f{bbox.right, bbox.top},
+                    t*vec2f{bbox.right, bbox.bottom}, t*vec2f{bbox.left, bbox.bottom}
+            };
+            float l=corners[0].x, r=l, tp=corners[0].y, b=tp;
+            for (const auto & c : corners) {
+                l=functions::min(l, c.x); r=functions::max(r, c.x);
+                tp=functions::min(tp, c.y); b=functions::max(b, c.y);
+            }
+            using functions::clamp;
+            const float u = float(unbounded().right);
+            return rect_i{int(clamp(l, -u, u))-2, int(clamp(tp, -u, u))-2,
+                          int(clamp(r, -u, u))+2, int(clamp(b, -u, u))+2};
+        }
+
+        /**
+         * Account the bounds of a draw, before it is submitted. While capturing bounds, they
+         * are recorded instead of drawing. Otherwise, draws that miss the clip rect are
+         * rejected, the rest are scissored by it and grow the region of the multisampled
+         * target, that needs a resolve.
+         * @param bbox bounding box of the draw
+         * @param transform transform of the draw
+         * @return true if the draw was captured or rejected, and should not be drawn
+         */
+        bool on_draw(const rectf & bbox, const mat3f & transform) const {
+            if(_is_capturing) {
+                _captured = unite(_captured, draw_bounds(bbox, transform));
+                return true;
+            }
+            const auto & w = _window.canvas_rect;
+            const auto clip = w.intersect(_window.clip_rect);
+            auto bounds = draw_bounds(bbox, transform).intersect(clip);
+            if(bounds.empty()) return true;
+            // to the frame buffer of the canvas window, (0,0) is bottom-left
+            auto & state = gl_state::get();
+            const bool clipped = clip.left>w.left || clip.top>w.top ||
+                                 clip.right<w.right || clip.bottom<w.bottom;
+            state.enable_scissor(clipped);
+            if(clipped) state.scissor(clip.left - w.left, w.bottom - clip.bottom,
+                                      clip.width(), clip.height());
+            if(_samples) _dirty = unite(_dirty, bounds.translate(-w.left, -w.top));
+            return false;
+        }
+
+        /**
+         * Find the stencil buffer of the render target, for stencil path fills. Targets, that
+         * the canvas owns, get a stencil render buffer, others are used if they have a
+         * stencil buffer. It is cleared once, stencil fills zero it back after themselves.
+         * @return true if the render target has a stencil buffer
+         */
+        bool prepare_stencil() {
+            if(_stencil_state>=0) return _stencil_state==1;
+            _stencil_state = 0;
+#ifdef NITROGL_SUPPORTS_MULTISAMPLING
+            const auto & target = render_target();
+            if(target.isOwner()) {
+                // samples have to match the multisampled color buffer
+                _rbo_stencil = rbo_t();
+                _rbo_stencil.storage(GL_STENCIL_INDEX8, GLsizei(width()), GLsizei(height()),
+                                     GLsizei(_samples));
+                target.attachRenderbuffer(_rbo_stencil, GL_STENCIL_ATTACHMENT);
+                if(!target.isComplete()) { release_stencil(); _stencil_state = 0; return false; }
+            } else if(target.stencilBits()==0) return false;
+            // clear the stencil of the render target, not of whatever is bound
+            target.bind();
+            auto & state = gl_state::get();
+            const bool scissor = state.scissor_enabled();
+            state.enable_scissor(false);
+            glStencilMask(0xFF);
+            glClearStencil(0);
+            glClear(GL_STENCIL_BUFFER_BIT); glCheckError();
+            state.enable_scissor(scissor);
+            _stencil_state = 1;
+#endif
+            return _stencil_state==1;
+        }
+        // detach the stencil render buffer from the render target, it is looked for again
+        void release_stencil() {
+#ifdef NITROGL_SUPPORTS_MULTISAMPLING
+            if(_rbo_stencil.wasGenerated())
+                render_target().attachRenderbuffer(rbo_t::un_generated(), GL_STENCIL_ATTACHMENT);
+#endif
+            _rbo_stencil = rbo_t::un_generated();
+            _stencil_state = -1;
+        }
+
+        /**
+         * Fill a path with stencil-then-cover. Triangle fans of the sub-paths count the
+         * winding of every pixel in the stencil buffer, with the color writes off. Then the
+         * bounding box is covered with the sampler, where the winding passes the fill rule,
+         * and the stencil is zeroed back on the way. Uvs are of the bounding box, as in
+         * the tessellated fill.
+         * @return false if the render target has no stencil buffer, and nothing was drawn
+         */
+        template <template<typename...> class path_container_template,
+                  class tessellation_allocator>
+        bool stencil_then_cover(sampler_t & sampler,
+                    microtess::path<float, path_container_template, tessellation_allocator> & path,
+                    const microtess::fill_rule &rule,
+                    mat3f transform, mat3f transform_uv, float opacity,
+                    float u0, float v0, float u1, float v1) {
+            if(!prepare_stencil()) return false;
+#ifdef NITROGL_SUPPORTS_MULTISAMPLING
+            NITROGL_PROFILE_SCOPE("canvas::stencil_then_cover");
+            auto & contours = path.paths_vertices();
+            if(contours.size()==0) return true;
+            const vec2f * vertices = contours.data();
+            const auto last = contours.back();
+            const auto vertices_size = index(last.data() + last.size() - vertices);
+            if(vertices_size<3) return true;
+            // fans of all of the contours, into one list of triangles
+            using indices_allocator_t = typename tessellation_allocator::
+                    template rebind<index>::other;
+            dynamic_array<index, indices_allocator_t> fans{
+                    indices_allocator_t(contours.get_allocator())};
+            for (index ix = 0; ix < contours.size(); ++ix) {
+                const auto contour = contours[ix];
+                const auto first = index(contour.data() - vertices);
+                for (index jx = 2; jx < contour.size(); ++jx) {
+                    fans.push_back(first);
+                    fans.push_back(first + jx - 1);
+                    fans.push_back(first + jx);
+                }
+            }
+            if(fans.size()==0) return true;
+            const auto bbox = nitrogl::triangles::triangles_bbox(vertices, vertices_size,
+                                                                 nullptr, 0);
+            prepare_uv_transform(transform_uv, bbox.width(), bbox.height(),
+                                 sampler.intrinsic_width, sampler.intrinsic_height,
+                                 u0, v0, u1, v1);
+
+            //
+            gl_state::get().viewport(0, 0, GLsizei(width()), GLsizei(height()));
+            render_target().bind();
+            const auto mat_proj = projection();
+            // make the transform about its origin, a nice feature
+            transform.post_translate(vec2f(-bbox.left, -bbox.top))
+                     .pre_translate(vec2f(bbox.left, bbox.top));
+            if(on_draw(bbox, transform)) return true;
+            auto & program = get_main_shader_program_for_sampler(sampler, opacity);
+            report_uvs_derivatives(sampler, transform, transform_uv,
+                                   bbox.width(), bbox.height());
+            const mat4f mat_model(transform);
+            const vec2f cover_vertices[4] = {
+                    {bbox.left, bbox.top}, {bbox.right, bbox.top},
+                    {bbox.right, bbox.bottom}, {bbox.left, bbox.bottom}
+            };
+            const index cover_indices[6] = { 0, 1, 2, 2, 3, 0 };
+            const multi_render_node::data_type winding = {
+                    vertices, nullptr, nullptr, fans.data(),
+                    vertices_size, 0, 0, multi_render_node::size_type(fans.size()),
+                    GLenum(triangles::indices::TRIANGLES),
+                    mat_model, mat4f::identity(), mat_proj, transform_uv,
+                    _tex_backdrop, width(), height(), opacity, bbox
+            };
+            const multi_render_node::data_type cover = {
+                    cover_vertices, nullptr, nullptr, cover_indices,
+                    4, 0, 0, 6,
+                    GLenum(triangles::indices::TRIANGLES),
+                    mat_model, mat4f::identity(), mat_proj, transform_uv,
+                    _tex_backdrop, width(), height(), opacity, bbox
+            };
+            const bool even_odd = rule==microtess::fill_rule::even_odd;
+            auto & state = gl_state::get();
+            state.polygon_mode(GLenum(draw_mode::fill));
+            state.enable_stencil(true);
+            state.color_mask(false);
+            glStencilFunc(GL_ALWAYS, 0, 0xFF);
+            if(even_odd) {
+                // parity in the first bit
+                glStencilMask(0x01);
+                glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+            } else {
+                // front faces go up, back faces go down, zero is outside
+                glStencilMask(0xFF);
+                glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
+                glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
+            }
+            glCheckError();
+            _node_multi.render(program, sampler, winding);
+            state.color_mask(true);
+            glStencilMask(0xFF);
+            glStencilFunc(GL_NOTEQUAL, 0, even_odd ? 0x01 : 0xFF);
+            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            glCheckError();
+            begin_composition();
+            _node_multi.render(program, sampler, cover);
+            end_composition();
+            state.enable_stencil(false);
+#endif
+            return true;
+        }
+
+        // are strokes expanded on the GPU possible
+        bool can_stroke_on_gpu() const {
+#ifdef NITROGL_SUPPORTS_INSTANCING
+            return _draw_mode==draw_mode::fill;
+#else
+            return false;
+#endif
+        }
+
+        /**
+         * Pad a polyline with its neighbours for stroke_render_node. Repeated points are
+         * dropped. Closed polylines wrap around, which joins them. Open polylines repeat their
+         * last point, which caps the end, and are led by the reversed first segment and a
+         * collapsed one, which caps the start. Polylines with less than two points are skipped.
+         */
+        template <class points_t, class ranges_t>
+        static void pad_polyline(const vec2f * points, index size, bool closed,
+                                 points_t & padded, ranges_t & ranges) {
+            if(closed) while(size>1 && points[size-1]==points[0]) --size;
+            index count = size ? 1 : 0;
+            for (index ix = 1; ix < size; ++ix) if(!(points[ix]==points[ix-1])) ++count;
+            if(count<2) return;
+            const auto first = GLint(padded.size());
+            if(closed) padded.push_back(points[size-1]);
+            else {
+                // [P1, P1, P0, P0, P1 ...], segments (P1, P0), (P0, P0), (P0, P1) ...
+                index second = 1;
+                while(points[second]==points[0]) ++second;
+                padded.push_back(points[second]);
+                padded.push_back(points[second]);
+                padded.push_back(points[0]);
+            }
+            padded.push_back(points[0]);
+            for (index ix = 1; ix < size; ++ix)
+                if(!(points[ix]==points[ix-1])) padded.push_back(points[ix]);
+            if(closed) {
+                const vec2f second = padded[first + 2];
+                padded.push_back(points[0]);
+                padded.push_back(second);
+            } else padded.push_back(points[size-1]);
+            ranges.push_back({first, GLsizei(closed ? count : count + 1)});
+        }
+
+        /**
+         * Arc lengths at the padded points of polylines (see pad_polyline), for dashes. They
+         * start at the first point, so the reversed first segment of open polylines goes back
+         * from it.
+         */
+        template <class lengths_t>
+        static void polyline_lengths(const vec2f * padded, index padded_size,
+                                     const stroke_render_node::range_type * ranges,
+                                     index ranges_size, lengths_t & lengths) {
+            lengths.resize(padded_size, 0.0f);
+            for (index ix = 0; ix < ranges_size; ++ix) {
+                const auto first = index(ranges[ix].first);
+                const bool open = padded[first]==padded[first + 1];
+                const index last = first + index(ranges[ix].segments) + 1;
+                for (index jx = first + (open ? 4 : 2); jx <= last; ++jx)
+                    lengths[jx] = lengths[jx - 1] + functions::distance(padded[jx], padded[jx - 1]);
+                if(open) lengths[first] = lengths[first + 1] = lengths[first + 4];
+            }
+        }
+
+        /**
+         * Stroke padded polylines (see pad_polyline) on the GPU, with stroke_render_node.
+         * Uvs are of the bounding box of the points, padded by the stroke. Dashed strokes pass
+         * the arc lengths at the points (see polyline_lengths), and the ends of the dashes and
+         * gaps in a period.
+         */
+        void stroke_on_gpu(sampler_t & sampler,
+                           const vec2f * padded, index padded_size,
+                           const stroke_render_node::range_type * ranges, index ranges_size,
+                           const float * lengths, const float * dash_ends, int dash_count,
+                           float dash_offset,
+                           float stroke_width, microtess::stroke_cap cap,
+                           microtess::stroke_line_join line_join, int miter_limit,
+                           mat3f transform, mat3f transform_uv, float opacity,
+                           float u0, float v0, float u1, float v1) {
+#ifdef NITROGL_SUPPORTS_INSTANCING
+            NITROGL_PROFILE_SCOPE("canvas::stroke_on_gpu");
+            if(ranges_size==0) return;
+            const float half_width = stroke_width/2.0f;
+            const bool is_miter = line_join==microtess::stroke_line_join::miter ||
+                                  line_join==microtess::stroke_line_join::miter_clip;
+            // square caps reach sqrt(2) half widths, miters reach the limit
+            const float reach = half_width*functions::max(1.415f,
+                                                          is_miter ? float(miter_limit) : 0.0f);
+            auto bbox = nitrogl::triangles::triangles_bbox(padded, padded_size, nullptr, 0);
+            bbox.left-=reach; bbox.top-=reach; bbox.right+=reach; bbox.bottom+=reach;
+            prepare_uv_transform(transform_uv, bbox.width(), bbox.height(),
+                                 sampler.intrinsic_width, sampler.intrinsic_height,
+                                 u0, v0, u1, v1);
+
+            //
+            gl_state::get().viewport(0, 0, GLsizei(width()), GLsizei(height()));
+            render_target().bind();
+            const auto mat_proj = projection();
+            // make the transform about its origin, a nice feature
+            transform.post_translate(vec2f(-bbox.left, -bbox.top))
+                     .pre_translate(vec2f(bbox.left, bbox.top));
+            if(on_draw(bbox, transform)) return;
+            auto & program = get_main_shader_program_for_sampler(sampler, opacity,
+                                             main_shader_program::vertex_kind::stroke, dash_count!=0);
+            report_uvs_derivatives(sampler, transform, transform_uv,
+                                   bbox.width(), bbox.height());
+            // triangles of the largest fan of the joins and caps. Bevels take one, but mesa
+            // (llvmpipe) drops instances of three triangles, that end with a collapsed one
+            const int join_fan[5] = { 0, 2, 3, NITROGL_STROKE_ROUND_SEGMENTS, 2 };
+            const int cap_fan[3] = { 0, NITROGL_STROKE_ROUND_SEGMENTS, 3 };
+            const mat4f mat_model(transform);
+            const stroke_render_node::data_type data = {
+                    ranges, GLsizei(ranges_size),
+                    half_width, float(miter_limit), int(line_join), int(cap),
+                    functions::max(join_fan[int(line_join)], cap_fan[int(cap)]),
+                    dash_ends, dash_count, dash_offset,
+                    mat_model, mat4f::identity(), mat_proj, transform_uv,
+                    _tex_backdrop, width(), height(), opacity, bbox
+            };
+            _node_stroke.upload_points(padded, GLsizeiptr(padded_size));
+            if(dash_count) _node_stroke.upload_lengths(lengths, GLsizeiptr(padded_size));
+            // hardware blending would blend the overlaps of segments and joins twice, unless
+            // the source replaces the backdrop. The stencil lets every pixel in once
+            const bool once = _hw_blend && !(_is_source_opaque &&
+                    hardware_blending::opaque_source_replaces_backdrop(_blend_mode, _alpha_compositor))
+                    && prepare_stencil();
+            auto & state = gl_state::get();
+            begin_composition();
+            if(once) {
+                state.enable_stencil(true);
+                glStencilMask(0xFF);
+                glStencilFunc(GL_EQUAL, 0, 0xFF);
+                glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+                glCheckError();
+            }
+            _node_stroke.render(program, sampler, data);
+            if(once) {
+                // zero the stencil back
+                state.color_mask(false);
+                glStencilFunc(GL_ALWAYS, 0, 0xFF);
+                glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+                glCheckError();
+                _node_stroke.render(program, sampler, data);
+                state.color_mask(true);
+                state.enable_stencil(false);
+            }
+            end_composition();
+#endif
+        }
+
+        // convert vertices of paths of other number types, i.e. fixed point, into floats
+        template <class source_vertices, class float_vertices>
+        static void to_float_vertices(const source_vertices & source, float_vertices & out) {
+            out.reserve(source.size());
+            for (const auto & v : source)
+                out.push_back(vec2f(float(v.x), float(v.y)));
+        }
+
+        /**
+         * Fill a path with its curves (see path_fill_mode::curves). Interior triangles and
+         * triangles of curves are one draw. Uvs are of the bounding box of the path, as in
+         * the stencil fill.
+         * @return false if fragment derivatives are not supported, and nothing was drawn
+         */
+        template <template<typename...> class path_container_template,
+                  class tessellation_allocator>
+        bool fill_curves(sampler_t & sampler,
+                         microtess::path<float, path_container_template, tessellation_allocator> & path,
+                         const microtess::fill_rule &rule,
+                         const microtess::tess_quality &quality,
+                         mat3f transform, mat3f transform_uv, float opacity,
+                         float u0, float v0, float u1, float v1) {
+#ifndef NITROGL_SUPPORTS_DERIVATIVES
+            return false;
+#else
+            NITROGL_PROFILE_SCOPE("canvas::fill_curves");
+            const bool edge_aa = is_edge_aa();
+            NITROGL_PROFILE_BEGIN(tessellation, "canvas::tessellation");
+            const auto & buffers = path.tessellateFillCurves(rule, quality, edge_aa);
+            NITROGL_PROFILE_END(tessellation);
+            if(buffers.output_vertices.size()==0 && buffers.output_curves.size()==0) return true;
+            const auto & contours = path.paths_vertices();
+            const auto last = contours.back();
+            const auto bbox = nitrogl::triangles::triangles_bbox(contours.data(),
+                                    index(last.data() + last.size() - contours.data()), nullptr, 0);
+            prepare_uv_transform(transform_uv, bbox.width(), bbox.height(),
+                                 sampler.intrinsic_width, sampler.intrinsic_height,
+                                 u0, v0, u1, v1);
+
+            //
+            gl_state::get().viewport(0, 0, GLsizei(width()), GLsizei(height()));
+            render_target().bind();
+            const auto mat_proj = projection();
+            // make the transform about its origin, a nice feature
+            transform.post_translate(vec2f(-bbox.left, -bbox.top))
+                     .pre_translate(vec2f(bbox.left, bbox.top));
+            if(on_draw(bbox, transform)) return true;
+            auto & program = get_main_shader_program_for_sampler(sampler, opacity,
+                                             main_shader_program::vertex_kind::curve, true);
+            report_uvs_derivatives(sampler, transform, transform_uv,
+                                   bbox.width(), bbox.height());
+            const mat4f mat_model(transform);
+            const auto type = nitrogl::triangles::microtess_indices_type_to_nitrogl(
+                    buffers.output_indices_type);
+            const curve_render_node::data_type data = {
+                    buffers.output_vertices.data(), buffers.output_indices.data(),
+                    edge_aa ? buffers.output_boundary.data() : nullptr,
+                    GLsizeiptr(buffers.output_indices.size()), GLenum(type),
+                    buffers.output_curves.data(), GLsizeiptr(buffers.output_curves.size()),
+                    mat_model, mat4f::identity(), mat_proj, transform_uv,
+                    _tex_backdrop, width(), height(), opacity, bbox
+            };
+            begin_composition();
+            _node_curve.render(program, sampler, data);
+            end_composition();
+            return true;
+#endif
+        }
+
+        // are edges of tessellated paths and polygons antialiased
+        bool is_edge_aa() const {
+#ifdef NITROGL_SUPPORTS_DERIVATIVES
+            return _is_edge_aa_enabled && _draw_mode==draw_mode::fill;
+#else
+            return false;
+#endif
+        }
+
+        /**
+         * Draw indexed triangles with their boundary info (one per triangle), with edge
+         * antialiasing of the outline edges (see edge_aa_render_node). Uvs are of the bounding
+         * box, as missing uvs of drawTriangles.
+         */
+        void draw_triangles_with_boundary(sampler_t & sampler,
+                                          enum triangles::indices type,
+                                          const vec2f * vertices, index vertices_size,
+                                          const index * indices, index indices_size,
+                                          const microtess::triangles::boundary_info * boundaries,
+                                          mat3f transform, float opacity, mat3f transform_uv,
+                                          float u0, float v0, float u1, float v1) {
+            NITROGL_PROFILE_SCOPE("canvas::draw_triangles_with_boundary");
+            const auto bbox = nitrogl::triangles::triangles_bbox(vertices, vertices_size,
+                                                                 indices, indices_size);
+            prepare_uv_transform(transform_uv, bbox.width(), bbox.height(),
+                                 sampler.intrinsic_width, sampler.intrinsic_height,
+                                 u0, v0, u1, v1);
+
+            //
+            gl_state::get().viewport(0, 0, GLsizei(width()), GLsizei(height()));
+            render_target().bind();
+            const auto mat_proj = projection();
+            // make the transform about its origin, a nice feature
+            transform.post_translate(vec2f(-bbox.left, -bbox.top))
+                     .pre_translate(vec2f(bbox.left, bbox.top));
+            if(on_draw(bbox, transform)) return;
+            auto & program = get_main_shader_program_for_sampler(sampler, opacity,
+                                             main_shader_program::vertex_kind::edge_aa, true);
+            report_uvs_derivatives(sampler, transform, transform_uv,
+                                   bbox.width(), bbox.height());
+            const mat4f mat_model(transform);
+            const edge_aa_render_node::data_type data = {
+                    vertices, vertices_size, indices, boundaries,
+                    indices_size, GLenum(type),
+                    mat_model, mat4f::identity(), mat_proj, transform_uv,
+                    _tex_backdrop, width(), height(), opacity, bbox
+            };
+            begin_composition();
+            _node_edge_aa.render(program, sampler, data);
+            end_composition();
+        }
+
+        // blit the dirty region of the multisampled target into the target
+        void resolve() const {
+            if(!_samples || _dirty.empty()) return;
+            NITROGL_PROFILE_SCOPE("canvas::resolve");
+            // invert to opengl coordinates (0,0) is bottom-left
+            const int h = int(height());
+            _fbo_ms.blitTo(_fbo, _dirty.left, h - _dirty.bottom, _dirty.right, h - _dirty.top);
+            _dirty = rect_i{};
+        }
+
         void copy_region_to_backdrop(int left, int top, int right, int bottom) const {
             copy_region_to_texture(_tex_backdrop, left, top, left, top, right, bottom);
         }
         void copy_to_backdrop() const {
+            NITROGL_PROFILE_SCOPE("canvas::copy_to_backdrop");
             copy_region_to_backdrop(0, 0, int(width()), int(height()));
         }
 
@@ -278,36 +1084,55 @@ namespace nitrogl {
                         .translate(textureLeft, textureTop)
                         .intersect(t)
                         .translate(-textureLeft, -textureTop)
-                        .intersect(canvasWindowRect());
+                        .intersect(rect_i(0, 0, int(width()), int(height())));
             // invert to opengl coordinates (0,0) is bottom-left
             int y_canvas = int(height()) - c.bottom;
             int y_texture = texture.height() - (textureTop + c.height());
+            resolve();
             _fbo.bind();
             texture.use(0);
             glCopyTexSubImage2D(GL_TEXTURE_2D, 0, textureLeft, y_texture,
                                 c.left, y_canvas, c.width(), c.height());
-            gl_texture::unuse();
-            fbo_t::unbind();
         }
 
         /**
          * Given a sampler, generate the main shader of it and use the pool
          * to get it or update it
          * @param sampler Sampler object
+         * @param opacity opacity of the draw
+         * @param vertex vertex shader of the program, triangles, instanced quads or strokes
+         * @param is_covered does the program multiply a coverage into the alpha (edge
+         *        antialiasing, curves, dashes), so the source is not opaque at edges
          * @return a program
          */
         main_shader_program & get_main_shader_program_for_sampler(
-                sampler_t & sampler) {
+                sampler_t & sampler, float opacity,
+                main_shader_program::vertex_kind vertex=main_shader_program::vertex_kind::triangles,
+                bool is_covered=false) {
+            NITROGL_PROFILE_SCOPE("canvas::shader_program");
             // we always regenerate a traversal because parts of a sampler
             // tree may have been used in another sampler, which might have
-            // written the traversal info
+            // written the traversal info. Traversal also folds the tree, so the key is
+            // computed over the folded tree
             sampler.generate_traversal(0);
+            // uvs derivatives are unknown, unless the draw reports them
+            sampler.on_uvs_derivatives(0.0f, 0.0f, 0.0f, 0.0f);
+            // pick the hardware blending path, if it computes the composition exactly
+            _is_source_opaque = sampler.traversal_info().opaque && opacity>=1.0f && !is_covered;
+            _hw_blend = (_is_hw_blend_enabled && _is_pre_mul_alpha) ?
+                    hardware_blending::find(_blend_mode, _alpha_compositor,
+                                            _is_source_opaque, _is_backdrop_opaque) : nullptr;
             microc::iterative_murmur<nitrogl::uintptr_type> murmur;
-            const auto sampler_key = sampler.hash_code();
-            const auto key = murmur.begin(sampler_key)
+            const auto sampler_key = sampler.tree_hash_code();
+            // hardware blended programs do not depend on the composition
+            auto key = _hw_blend ? murmur.begin(sampler_key).next(2).end() :
+                  murmur.begin(sampler_key)
                   .next(_is_pre_mul_alpha ? 0 : 1)
                   .next_cast(_blend_mode)
                   .next_cast(_alpha_compositor).end();
+            // instanced and stroke programs have another vertex shader
+            if(vertex!=main_shader_program::vertex_kind::triangles)
+                key = murmur.begin(key).next(2 + unsigned(vertex)).end();
             auto & pool = lru_main_shader_pool();
             auto res = pool.get(key);
             auto & program = res.object;
@@ -317,11 +1142,45 @@ namespace nitrogl {
                         program,sampler,
                         ogl_info::glsl_version_string,
                         _is_pre_mul_alpha,
-                        _blend_mode, _alpha_compositor);
+                        _blend_mode, _alpha_compositor,
+                        _hw_blend!=nullptr, vertex,
+                        &sources_cache(), key);
             }
             return program;
         }
 
+        /**
+         * setup the fixed function state for the draw of the current program. The shader
+         * path reads the backdrop, so it is brought up to date if hardware blended draws
+         * came before it. State is not restored after the draw, the state cache elides it
+         * when the next draw sets the same.
+         */
+        void begin_composition() {
+            auto & state = gl_state::get();
+            state.polygon_mode(GLenum(_draw_mode));
+            if(_hw_blend) {
+                hardware_blending::apply(*_hw_blend);
+                return;
+            }
+            if(_is_backdrop_stale) {
+                copy_to_backdrop();
+                _is_backdrop_stale = false;
+                render_target().bind();
+            }
+            state.enable_blend(false);
+        }
+
+        /**
+         * finish the draw: copy the result to the backdrop for the shader path. Hardware
+         * blended draws defer the copy until it is needed.
+         */
+        void end_composition() {
+            _is_backdrop_opaque = _is_backdrop_opaque &&
+                    hardware_blending::preserves_opaque_backdrop(_alpha_compositor, _is_source_opaque);
+            if(_hw_blend) _is_backdrop_stale = true;
+            else copy_to_backdrop();
+        }
+
         /**
          * Prepare a UV transform:
          * 1. Focus on a rectangle (u0, v0, u1, v1)
@@ -357,6 +1216,33 @@ namespace nitrogl {
             return transform_uv;
         }
 
+        /**
+         * Report the uvs derivatives of an affine draw to the sampler, so it may select a mip
+         * level on the client. The uvs are relative to the bounding box (y is flipped) and
+         * then transformed by transform_uv, the geometry is transformed by transform.
+         * @param sampler the sampler
+         * @param transform geometry transform
+         * @param transform_uv prepared uvs transform
+         * @param bbox_width object bounding box width
+         * @param bbox_height object bounding box height
+         */
+        static void report_uvs_derivatives(sampler_t & sampler, const mat3f & transform,
+                                           const mat3f & transform_uv,
+                                           float bbox_width, float bbox_height) {
+            // column major, linear part is [0 3; 1 4], projective row is [2 5 8]
+            const auto & t = transform, & u = transform_uv;
+            const bool affine = t[2]==0.0f && t[5]==0.0f && u[2]==0.0f && u[5]==0.0f;
+            const float det = t[0]*t[4] - t[3]*t[1];
+            if(!affine || det==0.0f || bbox_width==0.0f || bbox_height==0.0f) return;
+            // d(local)/d(canvas) is the inverse of the linear part of transform
+            const float ia=t[4]/det, ib=-t[3]/det, ic=-t[1]/det, id=t[0]/det;
+            // d(uv)/d(local) is the linear part of transform_uv after the bbox mapping
+            const float sx=1.0f/bbox_width, sy=-1.0f/bbox_height;
+            const float ua=u[0]*sx, ub=u[3]*sy, uc=u[1]*sx, ud=u[4]*sy;
+            sampler.on_uvs_derivatives(ua*ia + ub*ic, uc*ia + ud*ic,
+                                       ua*ib + ub*id, uc*ib + ud*id);
+        }
+
     public:
 
         /**
@@ -389,6 +1275,7 @@ namespace nitrogl {
                            float opacity=1.0f,
                            mat3f transform_uv = mat3f::identity(),
                            float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawTriangles");
             // I const-cast to avoid overloading l-val/r-val with perfect forwarding because
             // I feel it can be accomplished with const ref and const-cast. r-val is important
             // to catch samplers that are created in place
@@ -400,17 +1287,18 @@ namespace nitrogl {
                                  u0, v0, u1, v1);
 
             //
-            glViewport(0, 0, GLsizei(width()), GLsizei(height()));
-            _fbo.bind();
-            // inverted y projection, canvas coords to opengl
-            auto mat_proj = camera::orthographic<float>(0.0f, float(width()),
-                                                        float(height()), 0.0f,
-                                                        -1.0f, 1.0f);
+            gl_state::get().viewport(0, 0, GLsizei(width()), GLsizei(height()));
+            render_target().bind();
+            const auto mat_proj = projection();
             // make the transform about its origin, a nice feature
             transform.post_translate(vec2f(-bbox.left, -bbox.top))
                      .pre_translate(vec2f(bbox.left, bbox.top));
             // buffers
-            auto & program = get_main_shader_program_for_sampler(sampler_casted);
+            if(on_draw(bbox, transform)) return;
+            auto & program = get_main_shader_program_for_sampler(sampler_casted, opacity);
+            if(uvs==nullptr)
+                report_uvs_derivatives(sampler_casted, transform, transform_uv,
+                                       bbox.width(), bbox.height());
             // data
             multi_render_node::data_type data = {
                     vertices, uvs, nullptr, indices,
@@ -425,11 +1313,9 @@ namespace nitrogl {
                     opacity,
                     bbox
             };
-            glDisable(GL_BLEND);
+            begin_composition();
             _node_multi.render(program, sampler_casted, data);
-            glEnable(GL_BLEND);
-            fbo_t::unbind();
-            copy_to_backdrop();
+            end_composition();
         }
 
         /**
@@ -458,6 +1344,7 @@ namespace nitrogl {
                                    float opacity=1.0f,
                                    mat3f transform_uv = mat3f::identity(),
                                    float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawInterleavedTriangles");
             auto & sampler_casted = const_cast<sampler_t &>(sampler);
             const auto bbox = nitrogl::triangles::triangles_bbox_from_attribs(xyuv,
                                                                               xyuv_size/4, indices, indices_size,
@@ -467,16 +1354,14 @@ namespace nitrogl {
                                  u0, v0, u1, v1);
 
             //
-            glViewport(0, 0, GLsizei(width()), GLsizei(height()));
-            _fbo.bind();
-            // inverted y projection, canvas coords to opengl
-            auto mat_proj = camera::orthographic<float>(0.0f, float(width()),
-                                                        float(height()), 0.0f,
-                                                        -1.0f, 1.0f);
+            gl_state::get().viewport(0, 0, GLsizei(width()), GLsizei(height()));
+            render_target().bind();
+            const auto mat_proj = projection();
             // make the transform about its origin, a nice feature
             transform.post_translate(vec2f(-bbox.left, -bbox.top)).pre_translate(vec2f(bbox.left, bbox.top));
             // buffers
-            auto & program = get_main_shader_program_for_sampler(sampler_casted);
+            if(on_draw(bbox, transform)) return;
+            auto & program = get_main_shader_program_for_sampler(sampler_casted, opacity);
             // data
             multi_render_node_interleaved_xyuv::data_type data = {
                     xyuv, indices,
@@ -490,11 +1375,9 @@ namespace nitrogl {
                     width(), height(),
                     opacity,
             };
-            glDisable(GL_BLEND);
+            begin_composition();
             _node_multi_interleaved.render(program, sampler_casted, data);
-            glEnable(GL_BLEND);
-            fbo_t::unbind();
-            copy_to_backdrop();
+            end_composition();
         }
 
         /**
@@ -520,12 +1403,32 @@ namespace nitrogl {
                           const mat3f & transform_uv = mat3f::identity(),
                           float opacity=1.0f,
                           float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawPathFill");
             auto & sampler_casted = const_cast<sampler_t &>(sampler);
-            const auto & buffers= path.tessellateFill(rule, quality, false, false);
+            if(_path_fill_mode==path_fill_mode::stencil && _draw_mode==draw_mode::fill &&
+               stencil_then_cover(sampler_casted, path, rule, transform, transform_uv,
+                                  opacity, u0, v0, u1, v1))
+                return;
+            if(_path_fill_mode==path_fill_mode::curves && _draw_mode==draw_mode::fill &&
+               fill_curves(sampler_casted, path, rule, quality, transform, transform_uv,
+                           opacity, u0, v0, u1, v1))
+                return;
+            const bool edge_aa = is_edge_aa();
+            NITROGL_PROFILE_BEGIN(tessellation, "canvas::tessellation");
+            const auto & buffers= path.tessellateFill(rule, quality, edge_aa, false);
+            NITROGL_PROFILE_END(tessellation);
             if(buffers.output_vertices.size()==0) return;
             const auto type_out =
                     nitrogl::triangles::microtess_indices_type_to_nitrogl(
                             buffers.output_indices_type);
+            if(edge_aa) {
+                draw_triangles_with_boundary(sampler_casted, type_out,
+                        buffers.output_vertices.data(), buffers.output_vertices.size(),
+                        buffers.output_indices.data(), buffers.output_indices.size(),
+                        buffers.output_boundary.data(),
+                        transform, opacity, transform_uv, u0, v0, u1, v1);
+                return;
+            }
 
             drawTriangles(
                     sampler_casted,
@@ -581,9 +1484,58 @@ namespace nitrogl {
                           const mat3f & transform_uv = mat3f::identity(),
                           float opacity=1.0f,
                           float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawPathStroke");
             auto & sampler_casted = const_cast<sampler_t &>(sampler);
+            int dashes = 0;
+            for (const auto & dash : stroke_dash_array) dashes+=int(dash);
+            // odd patterns repeat twice, to alternate dashes and gaps
+            const auto entries = int(stroke_dash_array.size());
+            const int dash_count = dashes==0 ? 0 : (entries%2 ? 2*entries : entries);
+            if(_path_stroke_mode==path_stroke_mode::gpu && can_stroke_on_gpu() &&
+               dash_count<=NITROGL_STROKE_DASHES) {
+                using points_allocator_t = typename tessellation_allocator::
+                        template rebind<vec2f>::other;
+                using ranges_allocator_t = typename tessellation_allocator::
+                        template rebind<stroke_render_node::range_type>::other;
+                using lengths_allocator_t = typename tessellation_allocator::
+                        template rebind<float>::other;
+                auto & contours = path.paths_vertices();
+                dynamic_array<vec2f, points_allocator_t> padded{
+                        points_allocator_t(contours.get_allocator())};
+                dynamic_array<stroke_render_node::range_type, ranges_allocator_t> ranges{
+                        ranges_allocator_t(contours.get_allocator())};
+                for (index ix = 0; ix < contours.size(); ++ix) {
+                    const auto contour = contours[ix];
+                    const vec2f * points = contour.data();
+                    auto size = index(contour.size());
+                    // closed sub-paths end with their last point three times
+                    const bool closed = size>=3 && points[size-1]==points[size-2] &&
+                                        points[size-2]==points[size-3];
+                    pad_polyline(points, closed ? size-2 : size, closed, padded, ranges);
+                }
+                // dashes are uniforms, the offset and the pattern do not change the geometry
+                float dash_ends[NITROGL_STROKE_DASHES];
+                dynamic_array<float, lengths_allocator_t> lengths{
+                        lengths_allocator_t(contours.get_allocator())};
+                if(dash_count) {
+                    float end = 0.0f;
+                    for (int ix = 0; ix < dash_count; )
+                        for (const auto & dash : stroke_dash_array)
+                            dash_ends[ix++] = end += float(dash);
+                    polyline_lengths(padded.data(), index(padded.size()),
+                                     ranges.data(), index(ranges.size()), lengths);
+                }
+                stroke_on_gpu(sampler_casted, padded.data(), index(padded.size()),
+                              ranges.data(), index(ranges.size()),
+                              lengths.data(), dash_ends, dash_count, float(stroke_dash_offset),
+                              stroke_width, cap, line_join, miter_limit,
+                              transform, transform_uv, opacity, u0, v0, u1, v1);
+                return;
+            }
+            NITROGL_PROFILE_BEGIN(tessellation, "canvas::tessellation");
             const auto & buffers= path.template tessellateStroke<Iterable>(
                     stroke_width, cap, line_join, miter_limit, stroke_dash_array, stroke_dash_offset);
+            NITROGL_PROFILE_END(tessellation);
             if(buffers.output_vertices.size()==0) return;
             const auto type_out =
                     nitrogl::triangles::microtess_indices_type_to_nitrogl(
@@ -609,6 +1561,155 @@ namespace nitrogl {
 
         }
 
+        /**
+         * Draw a Path Fill of a path of another number type, i.e. a fixed point path (see
+         * nitrogl::fixed_path). The path is always tessellated, the stencil fill mode does not
+         * apply. The output vertices are converted into floats, rest is same as drawPathFill.
+         * @tparam number the number type of the path
+         * @tparam path_container_template template of container used by path
+         * @tparam tessellation_allocator the path allocator
+         */
+        template <typename number, template<typename...> class path_container_template,
+                  class tessellation_allocator>
+        void drawPathFill(const sampler_t & sampler,
+                          microtess::path<number, path_container_template, tessellation_allocator> & path,
+                          const microtess::fill_rule &rule,
+                          const microtess::tess_quality &quality,
+                          const mat3f & transform = mat3f::identity(),
+                          const mat3f & transform_uv = mat3f::identity(),
+                          float opacity=1.0f,
+                          float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawPathFill");
+            auto & sampler_casted = const_cast<sampler_t &>(sampler);
+            const bool edge_aa = is_edge_aa();
+            NITROGL_PROFILE_BEGIN(tessellation, "canvas::tessellation");
+            const auto & buffers= path.tessellateFill(rule, quality, edge_aa, false);
+            NITROGL_PROFILE_END(tessellation);
+            if(buffers.output_vertices.size()==0) return;
+            using points_allocator_t = typename tessellation_allocator::
+                    template rebind<vec2f>::other;
+            dynamic_array<vec2f, points_allocator_t> vertices{
+                    points_allocator_t(path.get_allocator())};
+            to_float_vertices(buffers.output_vertices, vertices);
+            const auto type_out =
+                    nitrogl::triangles::microtess_indices_type_to_nitrogl(
+                            buffers.output_indices_type);
+            if(edge_aa) {
+                draw_triangles_with_boundary(sampler_casted, type_out,
+                        vertices.data(), vertices.size(),
+                        buffers.output_indices.data(), buffers.output_indices.size(),
+                        buffers.output_boundary.data(),
+                        transform, opacity, transform_uv, u0, v0, u1, v1);
+                return;
+            }
+            drawTriangles(sampler_casted, type_out,
+                          vertices.data(), vertices.size(),
+                          buffers.output_indices.data(), buffers.output_indices.size(),
+                          nullptr, 0, transform, opacity, transform_uv, u0, v0, u1, v1);
+        }
+
+        /**
+         * Draw a Path Stroke of a path of another number type, i.e. a fixed point path (see
+         * nitrogl::fixed_path). The path is always tessellated, the gpu stroke mode does not
+         * apply. The output vertices are converted into floats, rest is same as drawPathStroke.
+         * @tparam Iterable Any numbers iterable container (implements begin()/)end())
+         * @tparam number the number type of the path
+         * @tparam path_container_template template of container used by path
+         * @tparam tessellation_allocator the path allocator
+         */
+        template <class Iterable, typename number, template<typename...> class path_container_template,
+                  class tessellation_allocator>
+        void drawPathStroke(const sampler_t & sampler,
+                          microtess::path<number, path_container_template, tessellation_allocator> & path,
+                          float stroke_width=1.0f,
+                          microtess::stroke_cap cap=microtess::stroke_cap::butt,
+                          microtess::stroke_line_join line_join=microtess::stroke_line_join::bevel,
+                          const int miter_limit=4,
+                          const Iterable & stroke_dash_array={},
+                          int stroke_dash_offset=0,
+                          const mat3f & transform = mat3f::identity(),
+                          const mat3f & transform_uv = mat3f::identity(),
+                          float opacity=1.0f,
+                          float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawPathStroke");
+            auto & sampler_casted = const_cast<sampler_t &>(sampler);
+            NITROGL_PROFILE_BEGIN(tessellation, "canvas::tessellation");
+            const auto & buffers= path.template tessellateStroke<Iterable>(
+                    number(stroke_width), cap, line_join, miter_limit,
+                    stroke_dash_array, stroke_dash_offset);
+            NITROGL_PROFILE_END(tessellation);
+            if(buffers.output_vertices.size()==0) return;
+            using points_allocator_t = typename tessellation_allocator::
+                    template rebind<vec2f>::other;
+            dynamic_array<vec2f, points_allocator_t> vertices{
+                    points_allocator_t(path.get_allocator())};
+            to_float_vertices(buffers.output_vertices, vertices);
+            drawTriangles(sampler_casted,
+                          nitrogl::triangles::microtess_indices_type_to_nitrogl(
+                                  buffers.output_indices_type),
+                          vertices.data(), vertices.size(),
+                          buffers.output_indices.data(), buffers.output_indices.size(),
+                          nullptr, 0, transform, opacity, transform_uv, u0, v0, u1, v1);
+        }
+
+        /**
+         * Draw a stroke of a polyline, i.e. a line series of a chart. Segments are expanded
+         * on the GPU (see updatePathStrokeMode), so large and changing polylines cost a copy
+         * of their points. Falls back to a tessellated path stroke, where it is not available.
+         * @tparam tessellation_allocator type of allocator
+         * @param sampler       sampler reference
+         * @param points        vertex array pointer
+         * @param size          size of vertex array
+         * @param stroke_width  stroke width in pixels
+         * @param cap           stroke cap enum {butt, round, square}
+         * @param line_join     stroke line join {none, miter, miter_clip, round, bevel}
+         * @param miter_limit   the miter limit
+         * @param closed        is the polyline closed, the last point joins the first
+         * @param transform     vertices transform
+         * @param transform_uv  UVs transform
+         * @param opacity       Opacity
+         * @param u0/v0/u1/v1   UVs window
+         */
+        template <class tessellation_allocator=nitrogl::std_rebind_allocator<>>
+        void drawPolyline(const sampler_t & sampler,
+                          const vec2f * points,
+                          index size,
+                          float stroke_width=1.0f,
+                          microtess::stroke_cap cap=microtess::stroke_cap::butt,
+                          microtess::stroke_line_join line_join=microtess::stroke_line_join::bevel,
+                          const int miter_limit=4,
+                          bool closed=false,
+                          const mat3f & transform = mat3f::identity(),
+                          const mat3f & transform_uv = mat3f::identity(),
+                          float opacity=1.0f,
+                          float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f,
+                          const tessellation_allocator & allocator=tessellation_allocator()) {
+            NITROGL_PROFILE_SCOPE("canvas::drawPolyline");
+            auto & sampler_casted = const_cast<sampler_t &>(sampler);
+            if(!can_stroke_on_gpu()) {
+                microtess::path<float, dynamic_array, tessellation_allocator> path(allocator);
+                path.addPoly(points, size);
+                if(closed) path.closePath();
+                const dynamic_array<int> no_dash{};
+                drawPathStroke(sampler, path, stroke_width, cap, line_join, miter_limit,
+                               no_dash, 0, transform, transform_uv, opacity, u0, v0, u1, v1);
+                return;
+            }
+            using points_allocator_t = typename tessellation_allocator::
+                    template rebind<vec2f>::other;
+            using ranges_allocator_t = typename tessellation_allocator::
+                    template rebind<stroke_render_node::range_type>::other;
+            dynamic_array<vec2f, points_allocator_t> padded{points_allocator_t(allocator)};
+            dynamic_array<stroke_render_node::range_type, ranges_allocator_t> ranges{
+                    ranges_allocator_t(allocator)};
+            padded.reserve(size + 4);
+            pad_polyline(points, size, closed, padded, ranges);
+            stroke_on_gpu(sampler_casted, padded.data(), index(padded.size()),
+                          ranges.data(), index(ranges.size()), nullptr, nullptr, 0, 0.0f,
+                          stroke_width, cap, line_join, miter_limit,
+                          transform, transform_uv, opacity, u0, v0, u1, v1);
+        }
+
         /**
          * Draw a polygon of any type via tesselation given a hint.
          * Notes:
@@ -620,6 +1721,12 @@ namespace nitrogl {
          * - TIPS:
          *      - CONVEX polygons do not allocate more memory !!!
          *      - Use the hints properly to max your performance
+         * - Memory:
+         *      - With the default allocator, tessellations are in the workspace of the canvas,
+         *        a memory arena that is reset after every draw, and keeps its memory. Once it
+         *        has grown to the largest polygon, drawing polygons does not allocate
+         *      - An arena_rebind_allocator of a user memory arena tessellates in it, the arena
+         *        is reset by the user
          *
          * @tparam hint the type of polygon {SIMPLE, CONCAVE, X_MONOTONE, Y_MONOTONE, CONVEX, COMPLEX, SELF_INTERSECTING}
          * @tparam tessellation_allocator type of allocator
@@ -644,6 +1751,14 @@ namespace nitrogl {
                          float opacity=1.0f,
                          float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f,
                          const tessellation_allocator & allocator=tessellation_allocator()) {
+            if(traits::is_same<tessellation_allocator, nitrogl::std_rebind_allocator<>>::value) {
+                // tessellate in the workspace
+                drawPolygon<hint>(sampler, points, size, transform, transform_uv, opacity,
+                                  u0, v0, u1, v1, arena_rebind_allocator<>(_tessellation_workspace));
+                _tessellation_workspace.reset();
+                return;
+            }
+            NITROGL_PROFILE_SCOPE("canvas::drawPolygon");
             auto & sampler_casted = const_cast<sampler_t &>(sampler);
             microtess::triangles::indices type;
             using indices_allocator_t = typename tessellation_allocator::
@@ -654,12 +1769,16 @@ namespace nitrogl {
             using boundaries_t = dynamic_array<microtess::triangles::boundary_info, boundary_allocator_t>;
 
             indices_t indices{indices_allocator_t(allocator)};
-            boundaries_t * boundary_buffer_ptr=nullptr;
+            // outline edges of the triangles, for edge antialiasing
+            const bool edge_aa = is_edge_aa();
+            boundaries_t boundaries{boundary_allocator_t(allocator)};
+            boundaries_t * boundary_buffer_ptr=edge_aa ? &boundaries : nullptr;
 
             switch (hint) {
                 case nitrogl::polygons::CONCAVE:
                 case nitrogl::polygons::SIMPLE:
                 {
+                    NITROGL_PROFILE_SCOPE("canvas::tessellation");
                     using ect=microtess::ear_clipping_triangulation<float, indices_t,
                                     boundaries_t, tessellation_allocator>;
                     ect::compute(points, size, indices, boundary_buffer_ptr, type, allocator);
@@ -668,6 +1787,7 @@ namespace nitrogl {
                 case nitrogl::polygons::X_MONOTONE:
                 case nitrogl::polygons::Y_MONOTONE:
                 {
+                    NITROGL_PROFILE_SCOPE("canvas::tessellation");
                     using mpt=microtess::monotone_polygon_triangulation<float, indices_t, boundaries_t,
                                     tessellation_allocator>;
                     typename mpt::monotone_axis axis=hint==polygons::X_MONOTONE ?
@@ -678,6 +1798,10 @@ namespace nitrogl {
                 case nitrogl::polygons::CONVEX:
                 {
                     type = microtess::triangles::indices::TRIANGLES_FAN;
+                    if(edge_aa) {
+                        using ft=microtess::fan_triangulation<float, indices_t, boundaries_t>;
+                        ft::compute(points, size, indices, boundary_buffer_ptr, type);
+                    }
                     break;
                 }
                 case nitrogl::polygons::NON_SIMPLE:
@@ -702,6 +1826,12 @@ namespace nitrogl {
             }
             // convert from micro-tess indices type to nitro-gl indices type
             const auto type_out = nitrogl::triangles::microtess_indices_type_to_nitrogl(type);
+            if(edge_aa) {
+                draw_triangles_with_boundary(sampler_casted, type_out, points, size,
+                                             indices.data(), indices.size(), boundaries.data(),
+                                             transform, opacity, transform_uv, u0, v0, u1, v1);
+                return;
+            }
             drawTriangles(sampler_casted,
                     type_out,
                     points, size,
@@ -745,7 +1875,43 @@ namespace nitrogl {
                              float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f,
                              mat3f transform_uv = mat3f::identity(),
                              const Allocator & allocator=Allocator()) {
+            NITROGL_PROFILE_SCOPE("canvas::drawBezierPatch");
             auto & sampler_casted = const_cast<sampler_t &>(sampler);
+            if(_bezier_patch_mode==bezier_patch_mode::gpu && uSamples>1 && vSamples>1) {
+                const int order = patch_type==microtess::patch_type::BI_CUBIC ? 4 : 3;
+                // the surface is inside the convex hull of the control points
+                rectf bbox{mesh[0], mesh[1], mesh[0], mesh[1]};
+                for (int ix = 1; ix < order*order; ++ix) {
+                    const float x = mesh[ix*2], y = mesh[ix*2 + 1];
+                    bbox.left = functions::min(bbox.left, x); bbox.right = functions::max(bbox.right, x);
+                    bbox.top = functions::min(bbox.top, y); bbox.bottom = functions::max(bbox.bottom, y);
+                }
+                // uvs window is of the grid, as in the tessellated patch
+                prepare_uv_transform(transform_uv, bbox.width(), bbox.height(),
+                                     sampler.intrinsic_width, sampler.intrinsic_height,
+                                     0.0f, 0.0f, 1.0f, 1.0f);
+
+                //
+                gl_state::get().viewport(0, 0, GLsizei(width()), GLsizei(height()));
+                render_target().bind();
+                const auto mat_proj = projection();
+                // make the transform about its origin, a nice feature
+                transform.post_translate(vec2f(-bbox.left, -bbox.top))
+                         .pre_translate(vec2f(bbox.left, bbox.top));
+                if(on_draw(bbox, transform)) return;
+                auto & program = get_main_shader_program_for_sampler(sampler_casted, opacity,
+                                                 main_shader_program::vertex_kind::patch);
+                const mat4f mat_model(transform);
+                const patch_render_node::data_type data = {
+                        mesh, order, GLuint(uSamples), GLuint(vSamples), u0, v0, u1, v1,
+                        mat_model, mat4f::identity(), mat_proj, transform_uv,
+                        _tex_backdrop, width(), height(), opacity
+                };
+                begin_composition();
+                _node_patch.render(program, sampler_casted, data, allocator);
+                end_composition();
+                return;
+            }
             using rebind_alloc_t1 = typename Allocator::template rebind<float>::other;
             using rebind_alloc_t2 = typename Allocator::template rebind<index>::other;
             rebind_alloc_t1 rebind_1{allocator};
@@ -757,10 +1923,12 @@ namespace nitrogl {
                                         dynamic_array<float, rebind_alloc_t1>,
                                         dynamic_array<index, rebind_alloc_t2>>;
             microtess::triangles::indices indices_type;
+            NITROGL_PROFILE_BEGIN(tessellation, "canvas::tessellation");
             const auto window_size = tess::template compute<patch_type>(
                     mesh, 2, uSamples, vSamples, true, true,
                     v_a, indices, indices_type,
                     u0, v0, u1, v1);
+            NITROGL_PROFILE_END(tessellation);
             const index size = indices.size();
             if(size==0) return;
             const auto type_out = nitrogl::triangles::microtess_indices_type_to_nitrogl(indices_type);
@@ -797,16 +1965,14 @@ namespace nitrogl {
                       mat3f transform = mat3f::identity(),
                       float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f,
                       mat3f transform_uv = mat3f::identity()) {
+            NITROGL_PROFILE_SCOPE("canvas::drawRect");
             auto & sampler_casted = const_cast<sampler_t &>(sampler);
             prepare_uv_transform(transform_uv, right-left, bottom-top,
                                  sampler.intrinsic_width, sampler.intrinsic_height,
                                  u0, v0, u1, v1);
-            glViewport(0, 0, GLsizei(width()), GLsizei(height()));
-            _fbo.bind();
-            // inverted y projection, canvas coords to opengl
-            auto mat_proj = camera::orthographic<float>(0.0f, float(width()),
-                                                        float(height()), 0.0f,
-                                                        -1.0f, 1.0f);
+            gl_state::get().viewport(0, 0, GLsizei(width()), GLsizei(height()));
+            render_target().bind();
+            const auto mat_proj = projection();
             // make the transform about its origin, a nice feature
             transform.post_translate(vec2f(left, top)).pre_translate(vec2f(-left, -top));
             // buffers
@@ -816,7 +1982,10 @@ namespace nitrogl {
                     right, top,    1.0f, 1.0f, 1.0f,
                     left,  top,    0.0f, 1.0f, 1.0f,
             };
-            auto & program = get_main_shader_program_for_sampler(sampler_casted);
+            if(on_draw(rectf{left, top, right, bottom}, transform)) return;
+            auto & program = get_main_shader_program_for_sampler(sampler_casted, opacity);
+            report_uvs_derivatives(sampler_casted, transform, transform_uv,
+                                   right-left, bottom-top);
             // data
             p4_render_node::data_type data = {
                     puvs, 20,
@@ -828,11 +1997,9 @@ namespace nitrogl {
                     width(), height(),
                     opacity
             };
-            glDisable(GL_BLEND);
+            begin_composition();
             _node_p4.render(program, sampler_casted, data);
-            glEnable(GL_BLEND);
-            fbo_t::unbind();
-            copy_to_backdrop();
+            end_composition();
         }
 
         /**
@@ -856,6 +2023,7 @@ namespace nitrogl {
                       mat3f transform = mat3f::identity(),
                       float u0=0., float v0=0., float u1=1., float v1=1.,
                       const mat3f & transform_uv = mat3f::identity()) {
+            NITROGL_PROFILE_SCOPE("canvas::drawMask");
             auto & sampler_casted = const_cast<sampler_t &>(sampler);
             const auto * current_blend_mode = _blend_mode;
             const auto * current_alpha_compositor = _alpha_compositor;
@@ -888,27 +2056,13 @@ namespace nitrogl {
                         const mat3f & transform = mat3f::identity(),
                         float u0=0., float v0=0., float u1=1., float v1=1.,
                         const mat3f & transform_uv = mat3f::identity()) {
+            NITROGL_PROFILE_SCOPE("canvas::drawCircle");
             auto & sampler_fill_casted = const_cast<sampler_t &>(sampler_fill);
             auto & sampler_stroke_casted = const_cast<sampler_t &>(sampler_stroke);
-            float pad = stroke/2.0f + 5.0f;
-            float ex_radi = radius + pad; // extended radius
-            float l = x - ex_radi, t = y - ex_radi;
-            float r = x + ex_radi, b = y + ex_radi;
-            float w = r-l, h = b-t;
-            float radius_n = radius/w;
-            float stroke_n = stroke/w;
-            float aa_fill = 1.0f/w;
-            float aa_stroke = stroke_n==0.0f ? 0.0f : (1.f/w);
-
-            circle_sampler cs(&sampler_fill_casted, &sampler_stroke_casted, radius_n,
-                              stroke_n, aa_fill, aa_stroke);
-
-            // make the transform about left-top of shape
+            circle_sampler cs(&sampler_fill_casted, &sampler_stroke_casted);
             auto transform_modified = transform;
-//            pad/=2.0f;
-            transform_modified.post_translate(vec2f(pad, pad)).pre_translate(vec2f(-pad, -pad));
-
-            drawRect(cs, l, t, r, b,
+            const auto bbox = layout_circle(cs, x, y, radius, stroke, transform_modified);
+            drawRect(cs, bbox.left, bbox.top, bbox.right, bbox.bottom,
                      opacity,
                      transform_modified,
                      u0, v0, u1, v1, transform_uv);
@@ -942,28 +2096,14 @@ namespace nitrogl {
                         const mat3f & transform = mat3f::identity(),
                         float u0=0., float v0=0., float u1=1., float v1=1.,
                         const mat3f & transform_uv = mat3f::identity()) {
+            NITROGL_PROFILE_SCOPE("canvas::drawArc");
             auto & sampler_fill_casted = const_cast<sampler_t &>(sampler_fill);
             auto & sampler_stroke_casted = const_cast<sampler_t &>(sampler_stroke);
-            float pad = inner_radius + (stroke)/2.0f + 5.0f;
-            float ex_radi = radius + pad; // extended radius
-            float l = x - ex_radi, t = y - ex_radi;
-            float r = x + ex_radi, b = y + ex_radi;
-            float w = r-l, h = b-t;
-            float radius_n = radius/w;
-            float radius_inner_n = inner_radius/w;
-            float stroke_n = stroke/w;
-            float aa_fill = 1.0f/w;
-            float aa_stroke = stroke_n==0.0f ? 0.0f : (1.0f/w);
-            from_angle = nitrogl::math::clamp(from_angle, 0.0f, math::pi<float>()*2.0f);
-            to_angle = nitrogl::math::clamp(to_angle, 0.0f, math::pi<float>()*2.0f);
-            arc_sampler cs {&sampler_fill_casted, &sampler_stroke_casted, from_angle, to_angle, radius_n,
-                            radius_inner_n, stroke_n, aa_fill, aa_stroke };
-            // make the transform about left-top of shape
+            arc_sampler cs {&sampler_fill_casted, &sampler_stroke_casted, from_angle, to_angle };
             auto transform_modified = transform;
-            //            pad/=2.0f;
-            transform_modified.post_translate(vec2f(pad, pad)).pre_translate(vec2f(-pad, -pad));
-
-            drawRect(cs, l, t, r, b,
+            const auto bbox = layout_arc(cs, x, y, radius, from_angle, to_angle,
+                                         inner_radius, stroke, transform_modified);
+            drawRect(cs, bbox.left, bbox.top, bbox.right, bbox.bottom,
                      opacity,
                      transform_modified,
                      u0, v0, u1, v1, transform_uv);
@@ -995,27 +2135,14 @@ namespace nitrogl {
                      const mat3f & transform = mat3f::identity(),
                      float u0=0., float v0=0., float u1=1., float v1=1.,
                      const mat3f & transform_uv = mat3f::identity()) {
+            NITROGL_PROFILE_SCOPE("canvas::drawPie");
             auto & sampler_fill_casted = const_cast<sampler_t &>(sampler_fill);
             auto & sampler_stroke_casted = const_cast<sampler_t &>(sampler_stroke);
-            float pad = (stroke)/2.0f + 5.0f;
-            float ex_radi = radius + pad; // extended radius
-            float l = x - ex_radi, t = y - ex_radi;
-            float r = x + ex_radi, b = y + ex_radi;
-            float w = r-l, h = b-t;
-            float radius_n = radius/w;
-            float stroke_n = stroke/w;
-            float aa_fill = 1.0f/w;
-            float aa_stroke = stroke_n==0.0f ? 0.0f : (1.0f/w);
-//            from_angle = nitrogl::math::clamp(from_angle, 0.0f, math::pi<float>()*2.0f);
-//            to_angle = nitrogl::math::clamp(to_angle, 0.0f, math::pi<float>()*2.0f);
-            pie_sampler cs {&sampler_fill_casted, &sampler_stroke_casted, from_angle, to_angle, radius_n,
-                            stroke_n, aa_fill, aa_stroke };
-            // make the transform about left-top of shape
+            pie_sampler cs {&sampler_fill_casted, &sampler_stroke_casted, from_angle, to_angle };
             auto transform_modified = transform;
-            //            pad/=2.0f;
-            transform_modified.post_translate(vec2f(pad, pad)).pre_translate(vec2f(-pad, -pad));
-
-            drawRect(cs, l, t, r, b,
+            const auto bbox = layout_pie(cs, x, y, radius, from_angle, to_angle,
+                                         stroke, transform_modified);
+            drawRect(cs, bbox.left, bbox.top, bbox.right, bbox.bottom,
                      opacity,
                      transform_modified,
                      u0, v0, u1, v1, transform_uv);
@@ -1049,6 +2176,7 @@ namespace nitrogl {
                                mat3f transform = mat3f::identity(),
                                float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f,
                                const mat3f & transform_uv = mat3f::identity()) {
+            NITROGL_PROFILE_SCOPE("canvas::drawQuadrilateral");
             auto & sampler_casted = const_cast<sampler_t &>(sampler);
             float q0 = 1.0f, q1 = 1.0f, q2 = 1.0f, q3 = 1.0f;
             float p0x = v0_x, p0y = v0_y;
@@ -1080,11 +2208,9 @@ namespace nitrogl {
             float u2_q2 = u2_*q2, v2_q2 = v2_*q2;
             float u3_q3 = u3_*q3, v3_q3 = v3_*q3;
             //
-            glViewport(0, 0, width(), height());
-            _fbo.bind();
-            // inverted y projection, canvas coords to opengl
-            auto mat_proj = camera::orthographic<float>(0.0f, float(width()),
-                                                        float(height()), 0, -1, 1);
+            gl_state::get().viewport(0, 0, GLsizei(width()), GLsizei(height()));
+            render_target().bind();
+            const auto mat_proj = projection();
             // make the transform about it's origin, a nice feature
             transform.post_translate(vec2f(v0_x, v0_y)).pre_translate(vec2f(-v0_x, -v0_y));
             // buffers
@@ -1094,7 +2220,11 @@ namespace nitrogl {
                     v2_x,  v2_y, u2_q2, v2_q2, q2,
                     v3_x,  v3_y, u3_q3, v3_q3, q3,
             };
-            auto & program = get_main_shader_program_for_sampler(sampler_casted);
+            if(on_draw(rectf{functions::min(v0_x, v1_x, v2_x, v3_x),
+                             functions::min(v0_y, v1_y, v2_y, v3_y),
+                             functions::max(v0_x, v1_x, v2_x, v3_x),
+                             functions::max(v0_y, v1_y, v2_y, v3_y)}, transform)) return;
+            auto & program = get_main_shader_program_for_sampler(sampler_casted, opacity);
             // data
             p4_render_node::data_type data = {
                     puvs, 20,
@@ -1106,11 +2236,9 @@ namespace nitrogl {
                     width(), height(),
                     opacity
             };
-            glDisable(GL_BLEND);
+            begin_composition();
             _node_p4.render(program, sampler_casted, data);
-            glEnable(GL_BLEND);
-            fbo_t::unbind();
-            copy_to_backdrop();
+            end_composition();
         }
 
         /**
@@ -1138,36 +2266,441 @@ namespace nitrogl {
                              const mat3f & transform = mat3f::identity(),
                              float u0=0., float v0=0., float u1=1., float v1=1.,
                              const mat3f & transform_uv = mat3f::identity()) {
+            NITROGL_PROFILE_SCOPE("canvas::drawRoundedRect");
             auto & sampler_fill_casted = const_cast<sampler_t &>(sampler_fill);
             auto & sampler_stroke_casted = const_cast<sampler_t &>(sampler_stroke);
+            rounded_rect_sampler cs(&sampler_fill_casted, &sampler_stroke_casted, 0.0f, 0.0f);
+            auto transform_modified = transform;
+            const auto bbox = layout_rounded_rect(cs, left, top, right, bottom,
+                                                  radius, stroke, transform_modified);
+            drawRect(cs,
+                     bbox.left, bbox.top, bbox.right, bbox.bottom,
+                     opacity, transform_modified,
+                     u0, v0, u1, v1, transform_uv);
+        }
+
+    private:
+        // shape layouts: write the inputs of the shape sampler, that are normalized by the
+        // bounding box the shape is drawn on, and make the transform about the left-top of
+        // the shape. Returns the bounding box.
+
+        static rectf layout_circle(circle_sampler & cs, float x, float y, float radius,
+                                   float stroke, mat3f & transform) {
+            float pad = stroke/2.0f + 5.0f;
+            float ex_radi = radius + pad; // extended radius
+            float l = x - ex_radi, t = y - ex_radi;
+            float r = x + ex_radi, b = y + ex_radi;
+            float w = r-l;
+            cs.radius = radius/w;
+            cs.stroke_width = stroke/w;
+            cs.aa_fill = 1.0f/w;
+            cs.aa_stroke = cs.stroke_width==0.0f ? 0.0f : (1.f/w);
+            transform.post_translate(vec2f(pad, pad)).pre_translate(vec2f(-pad, -pad));
+            return rectf{l, t, r, b};
+        }
+
+        static rectf layout_arc(arc_sampler & cs, float x, float y, float radius,
+                                float from_angle, float to_angle, float inner_radius,
+                                float stroke, mat3f & transform) {
+            float pad = inner_radius + (stroke)/2.0f + 5.0f;
+            float ex_radi = radius + pad; // extended radius
+            float l = x - ex_radi, t = y - ex_radi;
+            float r = x + ex_radi, b = y + ex_radi;
+            float w = r-l;
+            cs.radius = radius/w;
+            cs.radius_b = inner_radius/w;
+            cs.stroke_width = stroke/w;
+            cs.aa_fill = 1.0f/w;
+            cs.aa_stroke = cs.stroke_width==0.0f ? 0.0f : (1.0f/w);
+            cs.from_angle = nitrogl::math::clamp(from_angle, 0.0f, math::pi<float>()*2.0f);
+            cs.to_angle = nitrogl::math::clamp(to_angle, 0.0f, math::pi<float>()*2.0f);
+            transform.post_translate(vec2f(pad, pad)).pre_translate(vec2f(-pad, -pad));
+            return rectf{l, t, r, b};
+        }
+
+        static rectf layout_pie(pie_sampler & cs, float x, float y, float radius,
+                                float from_angle, float to_angle,
+                                float stroke, mat3f & transform) {
+            float pad = (stroke)/2.0f + 5.0f;
+            float ex_radi = radius + pad; // extended radius
+            float l = x - ex_radi, t = y - ex_radi;
+            float r = x + ex_radi, b = y + ex_radi;
+            float w = r-l;
+            cs.radius = radius/w;
+            cs.stroke_width = stroke/w;
+            cs.aa_fill = 1.0f/w;
+            cs.aa_stroke = cs.stroke_width==0.0f ? 0.0f : (1.0f/w);
+            cs.from_angle = from_angle;
+            cs.to_angle = to_angle;
+            transform.post_translate(vec2f(pad, pad)).pre_translate(vec2f(-pad, -pad));
+            return rectf{l, t, r, b};
+        }
+
+        static rectf layout_rounded_rect(rounded_rect_sampler & cs,
+                                         float left, float top, float right, float bottom,
+                                         float radius, float stroke, mat3f & transform) {
             float pad_and_stroke = 5.0f + stroke/2.0f;
-            float l = left + radius, t = top + radius;
-            float r = right - radius, b = bottom - radius;
-            float w = r-l, h = b-t;
             float w_c = right-left + pad_and_stroke*2.0f, h_c = bottom-top + pad_and_stroke*2.0f;
             float max_d = w_c > h_c ? w_c : h_c;
-            float l_c = left-pad_and_stroke, t_c = top-pad_and_stroke;
-            w /= max_d; h /= max_d;
             float off_l = (max_d-(right-left))/2.0f;
             float off_t = (max_d-(bottom-top))/2.0f;
-            l_c=left-off_l;
-            t_c=top-off_t;
-            float radius_n = radius/max_d;
-            float stroke_n = stroke/max_d;
-            float aa_fill = 1.0f/max_d;
-            float aa_stroke = stroke_n==0.0f ? 0.0f : (1.0f/max_d);
-            rounded_rect_sampler cs(&sampler_fill_casted, &sampler_stroke_casted, w, h,
-                                    radius_n, stroke_n, aa_fill, aa_stroke);
-
-            // make the transform about left-top of shape
-            auto transform_modified = transform;
-            transform_modified.post_translate(vec2f(off_l, off_t))
-                              .pre_translate(vec2f(-off_l, -off_t));
+            float l_c=left-off_l, t_c=top-off_t;
+            cs.w = (right-left-radius*2.0f)/max_d;
+            cs.h = (bottom-top-radius*2.0f)/max_d;
+            cs.radius = radius/max_d;
+            cs.stroke_width = stroke/max_d;
+            cs.aa_fill = 1.0f/max_d;
+            cs.aa_stroke = cs.stroke_width==0.0f ? 0.0f : (1.0f/max_d);
+            transform.post_translate(vec2f(off_l, off_t))
+                     .pre_translate(vec2f(-off_l, -off_t));
+            return rectf{l_c, t_c, l_c + max_d, t_c + max_d};
+        }
 
-            drawRect(cs,
-                     l_c, t_c, l_c + max_d, t_c + max_d,
-                     opacity, transform_modified,
-                     u0, v0, u1, v1, transform_uv);
+        /**
+         * The instances of a batch are drawn in a single pass, so they can not read each other
+         * from the backdrop. Batches are instanced only if the hardware blends the composition,
+         * otherwise the instances are drawn one by one. The source is not known to be opaque,
+         * shapes have anti-aliased boundaries and tints are per instance.
+         */
+        bool can_draw_instanced() const {
+            return ogl_info::supports_instancing && _is_hw_blend_enabled && _is_pre_mul_alpha &&
+                   hardware_blending::find(_blend_mode, _alpha_compositor,
+                                           false, _is_backdrop_opaque);
+        }
+
+        // write an instance, the transform is made about the left-top of the bounding box
+        float * write_instance(float * out, const rectf & bbox, mat3f transform,
+                               const float * inputs, unsigned inputs_count,
+                               const color_t & fill_tint, const color_t & stroke_tint) {
+            transform.post_translate(vec2f(bbox.left, bbox.top))
+                     .pre_translate(vec2f(-bbox.left, -bbox.top));
+            // rejected instances are not written
+            if(on_draw(bbox, transform)) return out;
+            return instanced_p4_render_node::write_instance(out,
+                            bbox.left, bbox.top, bbox.right, bbox.bottom,
+                            transform, inputs, inputs_count, fill_tint, stroke_tint);
+        }
+
+        /**
+         * Largest opaque axis aligned rects of a batch, found front to back (last instance
+         * first). An instance, that is inside of an occluder drawn after it, is hidden and
+         * does not need to be drawn.
+         */
+        struct occluders_t {
+            static constexpr unsigned capacity = NITROGL_BATCH_OCCLUDERS;
+            rectf rects[capacity];
+            index order[capacity];
+            unsigned size=0;
+
+            static float area(const rectf & r) { return r.width()*r.height(); }
+            void add(const rectf & r, index ix) {
+                unsigned at = size;
+                if(size==capacity) {
+                    // replace the smallest, if this one is larger
+                    at = 0;
+                    for (unsigned k = 1; k < size; ++k) if(area(rects[k])<area(rects[at])) at=k;
+                    if(area(r)<=area(rects[at])) return;
+                } else ++size;
+                rects[at]=r; order[at]=ix;
+            }
+            bool hides(const rectf & r, index ix) const {
+                for (unsigned k = 0; k < size; ++k) {
+                    const auto & o = rects[k];
+                    if(order[k]>ix && r.left>=o.left && r.top>=o.top &&
+                       r.right<=o.right && r.bottom<=o.bottom) return true;
+                }
+                return false;
+            }
+        };
+
+        /**
+         * exact bounds of a rect instance in canvas coordinates, unbounded if projective
+         * @return true if it is axis aligned, so it covers its bounds
+         */
+        static bool rect_instance_bounds(const rect_instance & i, rectf & bounds) {
+            auto transform = i.transform;
+            transform.post_translate(vec2f(i.left, i.top)).pre_translate(vec2f(-i.left, -i.top));
+            // column major, projective row is [2 5 8]
+            const auto & t = transform;
+            if(t[2]!=0.0f || t[5]!=0.0f) {
+                const float u = float(unbounded().right);
+                bounds = rectf{-u, -u, u, u};
+                return false;
+            }
+            const vec2f a = t*vec2f{i.left, i.top}, b = t*vec2f{i.right, i.bottom};
+            bounds = rectf{functions::min(a.x, b.x), functions::min(a.y, b.y),
+                           functions::max(a.x, b.x), functions::max(a.y, b.y)};
+            if(t[1]==0.0f && t[3]==0.0f) return true;
+            // rotated or skewed, bounds of all corners
+            const vec2f c = t*vec2f{i.right, i.top}, d = t*vec2f{i.left, i.bottom};
+            bounds = rectf{functions::min(bounds.left, c.x, d.x), functions::min(bounds.top, c.y, d.y),
+                           functions::max(bounds.right, c.x, d.x), functions::max(bounds.bottom, c.y, d.y)};
+            return false;
+        }
+
+        /**
+         * Draw a batch of instances with a single instanced draw
+         * @param sampler the root sampler, shared by the instances
+         * @param instances instances array
+         * @param count count of instances
+         * @param opacity opacity [0..1]
+         * @param write callback (const instance_type &, float * out) -> float *, that writes
+         *        an instance and returns the next position, or out to skip it
+         */
+        template<class instance_type, class write_callback>
+        void draw_instanced(sampler_t & sampler, const instance_type * instances, index count,
+                            float opacity, const write_callback & write) {
+            if(count==0) return;
+            if(_is_capturing) {
+                // the instances account their bounds as they are written
+                float scratch[instanced_p4_render_node::floats_per_instance];
+                for (index ix = 0; ix < count; ++ix) write(instances[ix], scratch);
+                return;
+            }
+            gl_state::get().viewport(0, 0, GLsizei(width()), GLsizei(height()));
+            render_target().bind();
+            const auto mat_proj = projection();
+            auto & program = get_main_shader_program_for_sampler(
+                    sampler, opacity, main_shader_program::vertex_kind::instanced);
+            NITROGL_PROFILE_BEGIN(instances_phase, "canvas::instances");
+            float * const begin = _node_instanced.map_instances(GLsizei(count));
+            if(begin==nullptr) return;
+            float * out = begin;
+            for (index ix = 0; ix < count; ++ix)
+                out = write(instances[ix], out);
+            _node_instanced.unmap_instances();
+            NITROGL_PROFILE_END(instances_phase);
+            // culled instances were not written
+            const auto written = GLsizei((out - begin)/instanced_p4_render_node::floats_per_instance);
+            if(written==0) return;
+            // data
+            instanced_p4_render_node::data_type data = {
+                    mat4f::identity(),
+                    mat4f::identity(),
+                    mat_proj,
+                    mat3f::identity(),
+                    _tex_backdrop,
+                    width(), height(),
+                    opacity
+            };
+            begin_composition();
+            _node_instanced.render(program, sampler, data, written);
+            end_composition();
+        }
+
+    public:
+
+        /**
+         * Draw a batch of Rectangles, in a single draw call if possible. Instances are
+         * drawn in order, as if drawRect was called for each one of them.
+         * @param sampler Sampler, that is tinted per instance
+         * @param instances rect instances array
+         * @param count count of instances
+         * @param opacity opacity [0..1]
+         */
+        void drawRects(const sampler_t & sampler,
+                       const rect_instance * instances, index count,
+                       float opacity = 1.0f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawRects");
+            auto & sampler_casted = const_cast<sampler_t &>(sampler);
+            if(!can_draw_instanced()) {
+                for (index ix = 0; ix < count; ++ix) {
+                    const auto & i = instances[ix];
+                    tint_sampler tinted(i.tint, &sampler_casted);
+                    drawRect(tinted, i.left, i.top, i.right, i.bottom, opacity, i.transform);
+                }
+                return;
+            }
+            // opaque rects hide the instances under them, when an opaque source replaces
+            // the backdrop. Find the occluders front to back.
+            occluders_t occluders;
+            sampler_casted.generate_traversal(0);
+            if(!_is_capturing && _draw_mode==draw_mode::fill && opacity>=1.0f &&
+               sampler_casted.traversal_info().opaque &&
+               hardware_blending::opaque_source_replaces_backdrop(_blend_mode, _alpha_compositor)) {
+                NITROGL_PROFILE_SCOPE("canvas::drawRects::occluders");
+                rectf bounds;
+                for (index ix = count; ix-- > 0;) {
+                    const auto & i = instances[ix];
+                    if(i.tint.a<1.0f || !rect_instance_bounds(i, bounds) ||
+                       occluders.hides(bounds, ix)) continue;
+                    // inset a bit, float rounding of the GPU might differ at the edges
+                    bounds.left+=1.0f/16.0f; bounds.top+=1.0f/16.0f;
+                    bounds.right-=1.0f/16.0f; bounds.bottom-=1.0f/16.0f;
+                    if(!bounds.empty()) occluders.add(bounds, ix);
+                }
+            }
+            instance_tint_sampler tinted(0, &sampler_casted);
+            draw_instanced(tinted, instances, count, opacity,
+                   [this, instances, &occluders](const rect_instance & i, float * out) {
+                       rectf bounds;
+                       rect_instance_bounds(i, bounds);
+                       if(occluders.hides(bounds, index(&i - instances))) return out;
+                       return write_instance(out, rectf{i.left, i.top, i.right, i.bottom},
+                                            i.transform, nullptr, 0, i.tint, i.tint);
+                   });
+        }
+
+        /**
+         * Draw a batch of Circles, in a single draw call if possible. Instances are
+         * drawn in order, as if drawCircle was called for each one of them.
+         * @param sampler_fill Sampler used for interior, that is tinted per instance
+         * @param sampler_stroke Sampler used for boundary, that is tinted per instance
+         * @param instances circle instances array
+         * @param count count of instances
+         * @param opacity opacity [0..1]
+         */
+        void drawCircles(const sampler_t & sampler_fill, const sampler_t & sampler_stroke,
+                         const circle_instance * instances, index count,
+                         float opacity = 1.0f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawCircles");
+            auto & sampler_fill_casted = const_cast<sampler_t &>(sampler_fill);
+            auto & sampler_stroke_casted = const_cast<sampler_t &>(sampler_stroke);
+            if(!can_draw_instanced()) {
+                for (index ix = 0; ix < count; ++ix) {
+                    const auto & i = instances[ix];
+                    tint_sampler fill(i.fill_tint, &sampler_fill_casted);
+                    tint_sampler stroke(i.stroke_tint, &sampler_stroke_casted);
+                    drawCircle(fill, stroke, i.x, i.y, i.radius, i.stroke, opacity, i.transform);
+                }
+                return;
+            }
+            instance_tint_sampler fill(0, &sampler_fill_casted), stroke(1, &sampler_stroke_casted);
+            circle_sampler cs(&fill, &stroke);
+            cs.per_instance = true;
+            draw_instanced(cs, instances, count, opacity,
+                   [this, &cs](const circle_instance & i, float * out) {
+                       auto transform = i.transform;
+                       const auto bbox = layout_circle(cs, i.x, i.y, i.radius, i.stroke, transform);
+                       float inputs[circle_sampler::inputs_count];
+                       cs.get_inputs(inputs);
+                       return write_instance(out, bbox, transform, inputs,
+                                             circle_sampler::inputs_count,
+                                             i.fill_tint, i.stroke_tint);
+                   });
+        }
+
+        /**
+         * Draw a batch of Rounded Rectangles, in a single draw call if possible. Instances are
+         * drawn in order, as if drawRoundedRect was called for each one of them.
+         * @param sampler_fill Sampler used for interior, that is tinted per instance
+         * @param sampler_stroke Sampler used for boundary, that is tinted per instance
+         * @param instances rounded rect instances array
+         * @param count count of instances
+         * @param opacity opacity [0..1]
+         */
+        void drawRoundedRects(const sampler_t & sampler_fill, const sampler_t & sampler_stroke,
+                              const rounded_rect_instance * instances, index count,
+                              float opacity = 1.0f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawRoundedRects");
+            auto & sampler_fill_casted = const_cast<sampler_t &>(sampler_fill);
+            auto & sampler_stroke_casted = const_cast<sampler_t &>(sampler_stroke);
+            if(!can_draw_instanced()) {
+                for (index ix = 0; ix < count; ++ix) {
+                    const auto & i = instances[ix];
+                    tint_sampler fill(i.fill_tint, &sampler_fill_casted);
+                    tint_sampler stroke(i.stroke_tint, &sampler_stroke_casted);
+                    drawRoundedRect(fill, stroke, i.left, i.top, i.right, i.bottom,
+                                    i.radius, i.stroke, opacity, i.transform);
+                }
+                return;
+            }
+            instance_tint_sampler fill(0, &sampler_fill_casted), stroke(1, &sampler_stroke_casted);
+            rounded_rect_sampler cs(&fill, &stroke, 0.0f, 0.0f);
+            cs.per_instance = true;
+            draw_instanced(cs, instances, count, opacity,
+                   [this, &cs](const rounded_rect_instance & i, float * out) {
+                       auto transform = i.transform;
+                       const auto bbox = layout_rounded_rect(cs, i.left, i.top, i.right, i.bottom,
+                                                             i.radius, i.stroke, transform);
+                       float inputs[rounded_rect_sampler::inputs_count];
+                       cs.get_inputs(inputs);
+                       return write_instance(out, bbox, transform, inputs,
+                                             rounded_rect_sampler::inputs_count,
+                                             i.fill_tint, i.stroke_tint);
+                   });
+        }
+
+        /**
+         * Draw a batch of Arcs, in a single draw call if possible. Instances are
+         * drawn in order, as if drawArc was called for each one of them.
+         * @param sampler_fill Sampler used for interior, that is tinted per instance
+         * @param sampler_stroke Sampler used for boundary, that is tinted per instance
+         * @param instances arc instances array
+         * @param count count of instances
+         * @param opacity opacity [0..1]
+         */
+        void drawArcs(const sampler_t & sampler_fill, const sampler_t & sampler_stroke,
+                      const arc_instance * instances, index count,
+                      float opacity = 1.0f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawArcs");
+            auto & sampler_fill_casted = const_cast<sampler_t &>(sampler_fill);
+            auto & sampler_stroke_casted = const_cast<sampler_t &>(sampler_stroke);
+            if(!can_draw_instanced()) {
+                for (index ix = 0; ix < count; ++ix) {
+                    const auto & i = instances[ix];
+                    tint_sampler fill(i.fill_tint, &sampler_fill_casted);
+                    tint_sampler stroke(i.stroke_tint, &sampler_stroke_casted);
+                    drawArc(fill, stroke, i.x, i.y, i.radius, i.from_angle, i.to_angle,
+                            i.inner_radius, i.stroke, opacity, i.transform);
+                }
+                return;
+            }
+            instance_tint_sampler fill(0, &sampler_fill_casted), stroke(1, &sampler_stroke_casted);
+            arc_sampler cs(&fill, &stroke, 0.0f, 0.0f);
+            cs.per_instance = true;
+            draw_instanced(cs, instances, count, opacity,
+                   [this, &cs](const arc_instance & i, float * out) {
+                       auto transform = i.transform;
+                       const auto bbox = layout_arc(cs, i.x, i.y, i.radius, i.from_angle, i.to_angle,
+                                                    i.inner_radius, i.stroke, transform);
+                       float inputs[arc_sampler::inputs_count];
+                       cs.get_inputs(inputs);
+                       return write_instance(out, bbox, transform, inputs,
+                                             arc_sampler::inputs_count,
+                                             i.fill_tint, i.stroke_tint);
+                   });
+        }
+
+        /**
+         * Draw a batch of Pies, in a single draw call if possible. Instances are
+         * drawn in order, as if drawPie was called for each one of them.
+         * @param sampler_fill Sampler used for interior, that is tinted per instance
+         * @param sampler_stroke Sampler used for boundary, that is tinted per instance
+         * @param instances pie instances array
+         * @param count count of instances
+         * @param opacity opacity [0..1]
+         */
+        void drawPies(const sampler_t & sampler_fill, const sampler_t & sampler_stroke,
+                      const pie_instance * instances, index count,
+                      float opacity = 1.0f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawPies");
+            auto & sampler_fill_casted = const_cast<sampler_t &>(sampler_fill);
+            auto & sampler_stroke_casted = const_cast<sampler_t &>(sampler_stroke);
+            if(!can_draw_instanced()) {
+                for (index ix = 0; ix < count; ++ix) {
+                    const auto & i = instances[ix];
+                    tint_sampler fill(i.fill_tint, &sampler_fill_casted);
+                    tint_sampler stroke(i.stroke_tint, &sampler_stroke_casted);
+                    drawPie(fill, stroke, i.x, i.y, i.radius, i.from_angle, i.to_angle,
+                            i.stroke, opacity, i.transform);
+                }
+                return;
+            }
+            instance_tint_sampler fill(0, &sampler_fill_casted), stroke(1, &sampler_stroke_casted);
+            pie_sampler cs(&fill, &stroke, 0.0f, 0.0f);
+            cs.per_instance = true;
+            draw_instanced(cs, instances, count, opacity,
+                   [this, &cs](const pie_instance & i, float * out) {
+                       auto transform = i.transform;
+                       const auto bbox = layout_pie(cs, i.x, i.y, i.radius, i.from_angle, i.to_angle,
+                                                    i.stroke, transform);
+                       float inputs[pie_sampler::inputs_count];
+                       cs.get_inputs(inputs);
+                       return write_instance(out, bbox, transform, inputs,
+                                             pie_sampler::inputs_count,
+                                             i.fill_tint, i.stroke_tint);
+                   });
         }
 
         /**
@@ -1195,6 +2728,7 @@ namespace nitrogl {
                       mat3f transform = mat3f::identity(),
                       float opacity=1.0f,
                       const Allocator & allocator=Allocator()) {
+            NITROGL_PROFILE_SCOPE("canvas::drawText");
             auto old=clipRect(); updateClipRect(left, top, right, bottom);
             unsigned int text_size=0;
             { const char * iter=text; while(*iter++!= '\0' && ++text_size); }
@@ -1230,6 +2764,7 @@ namespace nitrogl {
 
             // tessellate quads to triangles
             {
+                NITROGL_PROFILE_SCOPE("canvas::tessellation");
                 const auto tess_quad = [&](const nitrogl::text::char_location & l, int index) {
                     // p0  p2
                     // |A /|
@@ -1318,6 +2853,7 @@ namespace nitrogl {
                        float opacity=1.0f,
                        mat3f transform_uv = mat3f::identity(),
                        float u0=0.f, float v0=0.f, float u1=1.f, float v1=1.f) {
+            NITROGL_PROFILE_SCOPE("canvas::drawLines");
             auto & sampler_casted = const_cast<sampler_t &>(sampler);
             const auto bbox = nitrogl::triangles::triangles_bbox(points, size, nullptr, 0);
             prepare_uv_transform(transform_uv, bbox.width(), bbox.height(),
@@ -1325,16 +2861,14 @@ namespace nitrogl {
                                  u0, v0, u1, v1);
 
             //
-            glViewport(0, 0, GLsizei(width()), GLsizei(height()));
-            _fbo.bind();
-            // inverted y projection, canvas coords to opengl
-            auto mat_proj = camera::orthographic<float>(0.0f, float(width()),
-                                                        float(height()), 0.0f,
-                                                        -1.0f, 1.0f);
+            gl_state::get().viewport(0, 0, GLsizei(width()), GLsizei(height()));
+            render_target().bind();
+            const auto mat_proj = projection();
             // make the transform about its origin, a nice feature
             transform.post_translate(vec2f(-bbox.left, -bbox.top)).pre_translate(vec2f(bbox.left, bbox.top));
             // buffers
-            auto & program = get_main_shader_program_for_sampler(sampler_casted);
+            if(on_draw(bbox, transform)) return;
+            auto & program = get_main_shader_program_for_sampler(sampler_casted, opacity);
             // data
             const auto type = closed_path ? nitrogl::triangles::LINE_LOOP : nitrogl::triangles::LINE_STRIP;
             multi_render_node::data_type data = {
@@ -1350,11 +2884,9 @@ namespace nitrogl {
                     opacity,
                     bbox
             };
-            glDisable(GL_BLEND);
+            begin_composition();
             _node_multi.render(program, sampler_casted, data);
-            glEnable(GL_BLEND);
-            fbo_t::unbind();
-            copy_to_backdrop();
+            end_composition();
         }
 
     };
@@ -10,6 +10,8 @@
 ========================================================================================*/
 #pragma once
 
+#include "color.h"
+
 namespace nitrogl {
     namespace channels {
         enum class channel {
@@ -22,5 +24,22 @@ namespace nitrogl {
             blue_channel_inverted,
             alpha_channel_inverted,
         };
+
+        /**
+         * value of a channel of a color, same as the samplers compute it in the shader
+         */
+        inline float value_of(channel ch, const color_t & c) {
+            switch (ch) {
+                case channel::red_channel: return c.r;
+                case channel::green_channel: return c.g;
+                case channel::blue_channel: return c.b;
+                case channel::alpha_channel: return c.a;
+                case channel::red_channel_inverted: return 1.0f - c.r;
+                case channel::green_channel_inverted: return 1.0f - c.g;
+                case channel::blue_channel_inverted: return 1.0f - c.b;
+                case channel::alpha_channel_inverted: return 1.0f - c.a;
+            }
+            return 0.0f;
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "../ogl/debug.h"
+#include "../ogl/gl_state.h"
+#include "blend_modes.h"
+#include "porter_duff.h"
+
+namespace nitrogl {
+
+    /**
+     * Capability table of compositions (blend mode + alpha compositor), that the fixed function
+     * blending of the hardware computes exactly as the shader path does, on a pre-multiplied
+     * alpha target. With it, the fragment shader only outputs the pre-multiplied source and does
+     * not sample the backdrop, so the backdrop copy after the draw is not needed.
+     *
+     * With Ps, Pb the pre-multiplied source/backdrop, every Porter-Duff operator with Normal
+     * blending is exactly Ps*Fa + Pb*Fb. Some separable blend modes collapse as well:
+     * - Screen    = Ps + Pb*(1-Ps)
+     * - Exclusion = Ps*(1-Pb) + Pb*(1-Ps)
+     * - Multiply  = Ps*Pb + Pb*(1-αs), when the backdrop is opaque
+     * - Darken/Lighten/LinearDodge = min/max/sum, when both are opaque
+     */
+    struct hardware_blending {
+        struct state_t {
+            GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
+            GLenum equation_rgb, equation_alpha;
+        };
+        enum class requirement { none, opaque_backdrop, opaque_source_and_backdrop };
+
+    private:
+        struct entry_t {
+            blend_mode_t blend_mode;
+            compositor_t compositor;
+            state_t state;
+            requirement condition;
+        };
+        static constexpr GLenum ADD = GL_FUNC_ADD;
+
+        static const entry_t * table(unsigned & size) {
+            static const entry_t entries[] = {
+                // Porter-Duff with Normal blending
+                { blend_modes::Normal(), porter_duff::SourceOver(),
+                  { GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::Clear(),
+                  { GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::Copy(),
+                  { GL_ONE, GL_ZERO, GL_ONE, GL_ZERO, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::Source(),
+                  { GL_ONE, GL_ZERO, GL_ONE, GL_ZERO, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::Destination(),
+                  { GL_ZERO, GL_ONE, GL_ZERO, GL_ONE, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::SourceIn(),
+                  { GL_DST_ALPHA, GL_ZERO, GL_DST_ALPHA, GL_ZERO, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::SourceOut(),
+                  { GL_ONE_MINUS_DST_ALPHA, GL_ZERO, GL_ONE_MINUS_DST_ALPHA, GL_ZERO, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::SourceAtop(),
+                  { GL_DST_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_DST_ALPHA, GL_ONE_MINUS_SRC_ALPHA, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::DestinationOver(),
+                  { GL_ONE_MINUS_DST_ALPHA, GL_ONE, GL_ONE_MINUS_DST_ALPHA, GL_ONE, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::DestinationIn(),
+                  { GL_ZERO, GL_SRC_ALPHA, GL_ZERO, GL_SRC_ALPHA, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::DestinationOut(),
+                  { GL_ZERO, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::DestinationAtop(),
+                  { GL_ONE_MINUS_DST_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_DST_ALPHA, GL_SRC_ALPHA, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::XOR(),
+                  { GL_ONE_MINUS_DST_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE_MINUS_DST_ALPHA, GL_ONE_MINUS_SRC_ALPHA, ADD, ADD }, requirement::none },
+                { blend_modes::Normal(), porter_duff::Lighter(),
+                  { GL_ONE, GL_ONE, GL_ONE, GL_ONE, ADD, ADD }, requirement::none },
+                // separable blend modes with source-over
+                { blend_modes::Screen(), porter_duff::SourceOver(),
+                  { GL_ONE, GL_ONE_MINUS_SRC_COLOR, GL_ONE, GL_ONE_MINUS_SRC_ALPHA, ADD, ADD }, requirement::none },
+                { blend_modes::Exclusion(), porter_duff::SourceOver(),
+                  { GL_ONE_MINUS_DST_COLOR, GL_ONE_MINUS_SRC_COLOR, GL_ONE, GL_ONE_MINUS_SRC_ALPHA, ADD, ADD }, requirement::none },
+                { blend_modes::Multiply(), porter_duff::SourceOver(),
+                  { GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA, ADD, ADD }, requirement::opaque_backdrop },
+                { blend_modes::Darken(), porter_duff::SourceOver(),
+                  { GL_ONE, GL_ONE, GL_ONE, GL_ONE, GL_MIN, GL_MIN }, requirement::opaque_source_and_backdrop },
+                { blend_modes::Lighten(), porter_duff::SourceOver(),
+                  { GL_ONE, GL_ONE, GL_ONE, GL_ONE, GL_MAX, GL_MAX }, requirement::opaque_source_and_backdrop },
+                { blend_modes::LinearDodge(), porter_duff::SourceOver(),
+                  { GL_ONE, GL_ONE, GL_ZERO, GL_ONE, ADD, ADD }, requirement::opaque_source_and_backdrop },
+            };
+            size = sizeof(entries)/sizeof(entry_t);
+            return entries;
+        }
+
+    public:
+        /**
+         * find the hardware blend state of a composition
+         * @param blend_mode the blend mode
+         * @param compositor the alpha compositor
+         * @param is_source_opaque is the source alpha always 1
+         * @param is_backdrop_opaque is the backdrop alpha always 1
+         * @return the state or null if the composition has to go through the shader path
+         */
+        static const state_t * find(blend_mode_t blend_mode, compositor_t compositor,
+                                    bool is_source_opaque, bool is_backdrop_opaque) {
+            unsigned size;
+            const auto * entries = table(size);
+            for (unsigned ix = 0; ix < size; ++ix) {
+                const auto & e = entries[ix];
+                if(e.blend_mode!=blend_mode || e.compositor!=compositor) continue;
+                switch (e.condition) {
+                    case requirement::none: return &e.state;
+                    case requirement::opaque_backdrop:
+                        return is_backdrop_opaque ? &e.state : nullptr;
+                    case requirement::opaque_source_and_backdrop:
+                        return (is_source_opaque && is_backdrop_opaque) ? &e.state : nullptr;
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * does an opaque source replace the backdrop, so whatever was drawn under it is hidden
+         */
+        static bool opaque_source_replaces_backdrop(blend_mode_t blend_mode, compositor_t compositor) {
+            return blend_mode==blend_modes::Normal() &&
+                   (compositor==porter_duff::SourceOver() || compositor==porter_duff::SourceOverOpaque() ||
+                    compositor==porter_duff::Copy() || compositor==porter_duff::Source());
+        }
+
+        /**
+         * does an opaque backdrop stay opaque after compositing on it
+         */
+        static bool preserves_opaque_backdrop(compositor_t compositor, bool is_source_opaque) {
+            if(compositor==porter_duff::SourceOver() || compositor==porter_duff::SourceOverOpaque() ||
+               compositor==porter_duff::Destination() || compositor==porter_duff::DestinationOver() ||
+               compositor==porter_duff::SourceAtop() || compositor==porter_duff::Lighter())
+                return true;
+            return is_source_opaque &&
+                   (compositor==porter_duff::Copy() || compositor==porter_duff::Source() ||
+                    compositor==porter_duff::SourceIn() || compositor==porter_duff::DestinationIn() ||
+                    compositor==porter_duff::DestinationAtop());
+        }
+
+        static void apply(const state_t & state) {
+            auto & gl = gl_state::get();
+            gl.enable_blend(true);
+            gl.blend_func(state.src_rgb, state.dst_rgb, state.src_alpha, state.dst_alpha);
+            gl.blend_equation(state.equation_rgb, state.equation_alpha);
+        }
+    };
+
+}
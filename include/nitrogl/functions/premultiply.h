@@ -0,0 +1,66 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+
+namespace nitrogl {
+
+    namespace functions {
+
+        /**
+         * premultiply RGBA8 pixels by their alpha. Branch free integer loop, that compilers
+         * vectorize. src and dst may be the same.
+         * @param src source pixels
+         * @param dst destination pixels
+         * @param count count of pixels
+         */
+        inline void premultiply_rgba8(const unsigned char * src, unsigned char * dst,
+                                      unsigned long count) {
+            for (unsigned long ix = 0; ix < count*4; ix+=4) {
+                const unsigned a = src[ix+3];
+                for (unsigned c = 0; c < 3; ++c) {
+                    // exact rounded division by 255
+                    const unsigned t = src[ix+c]*a + 128u;
+                    dst[ix+c] = (unsigned char)((t + (t >> 8u)) >> 8u);
+                }
+                dst[ix+3] = (unsigned char)a;
+            }
+        }
+
+        /**
+         * un-premultiply RGBA8 pixels by their alpha, with a reciprocal table instead of
+         * divisions. src and dst may be the same.
+         * @param src source pixels
+         * @param dst destination pixels
+         * @param count count of pixels
+         */
+        inline void unpremultiply_rgba8(const unsigned char * src, unsigned char * dst,
+                                        unsigned long count) {
+            // 8.24 fixed point of 255/a, zero alpha stays zero
+            struct table_t {
+                unsigned data[256];
+                table_t() : data() {
+                    for (unsigned a = 1; a < 256; ++a) data[a] = ((255u << 24u) + a/2u) / a;
+                }
+            };
+            static const table_t table;
+            for (unsigned long ix = 0; ix < count*4; ix+=4) {
+                const unsigned a = src[ix+3];
+                const unsigned r = table.data[a];
+                for (unsigned c = 0; c < 3; ++c) {
+                    const auto v = (src[ix+c]*(unsigned long long)r + 0x800000u) >> 24u;
+                    dst[ix+c] = (unsigned char)(v > 255u ? 255u : v);
+                }
+                dst[ix+3] = (unsigned char)a;
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,425 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "tessellate.h"
+#include "triangles.h"
+#include "math/rect.h"
+#include "functions/minmax.h"
+
+// max count of boxes in a leaf of a bounding volume hierarchy
+#ifndef NITROGL_BVH_LEAF_SIZE
+#define NITROGL_BVH_LEAF_SIZE 4
+#endif
+
+namespace nitrogl {
+
+    /**
+     * Bounding volume hierarchy of boxes. Nodes are kept in one array, the children of a node
+     * are a pair that comes after it, so refit() walks the array backwards. The build sorts
+     * an order of the boxes, and a leaf is a range of it, so owners of data per box can store
+     * it in that order, and have the data of a leaf contiguous. Boxes are split in the middle
+     * of the longest axis of their centers, or in halves when that does not split them, or
+     * the tree got too deep. Arrays keep their memory between builds.
+     * @tparam allocator_type allocator of the arrays
+     */
+    template<class allocator_type=std_rebind_allocator<>>
+    class bvh {
+    public:
+        struct node_t {
+            rectf bounds;
+            // leaf: first position in the order and count of boxes. inner: first is the
+            // left child, the right child follows it, and count is 0
+            unsigned first, count;
+        };
+        // past half of it, boxes are split in halves, so deeper trees are not possible
+        static constexpr unsigned max_depth = 64;
+
+    private:
+        struct range_t { unsigned node, begin, end, depth; };
+        dynamic_array<node_t, allocator_type> _nodes;
+        dynamic_array<unsigned, allocator_type> _order;
+        dynamic_array<range_t, allocator_type> _stack;
+
+    public:
+        static void merge(rectf & a, const rectf & b) {
+            a.left = functions::min(a.left, b.left);
+            a.top = functions::min(a.top, b.top);
+            a.right = functions::max(a.right, b.right);
+            a.bottom = functions::max(a.bottom, b.bottom);
+        }
+        // edges are inclusive, so a point is an area of zero size
+        static bool overlap(const rectf & a, const rectf & b) {
+            return a.left<=b.right && b.left<=a.right && a.top<=b.bottom && b.top<=a.bottom;
+        }
+        // bounds of nothing, they overlap nothing and grow nothing they merge into
+        static rectf nothing() {
+            const float max = 3.402823466e+38f;
+            return rectf{max, max, -max, -max};
+        }
+
+        explicit bvh(const allocator_type & allocator=allocator_type()) :
+                    _nodes(allocator), _order(allocator), _stack(allocator) {}
+
+        /**
+         * build the hierarchy
+         * @param boxes array of boxes
+         * @param count count of boxes
+         */
+        void build(const rectf * boxes, unsigned count) {
+            _nodes.clear(); _order.clear();
+            if(count==0) return;
+            for (unsigned ix = 0; ix < count; ++ix) _order.push_back(ix);
+            _nodes.push_back(node_t{nothing(), 0, 0});
+            unsigned top = 0;
+            const auto push = [&](const range_t & range) {
+                if(top==_stack.size()) _stack.push_back(range); else _stack[top]=range;
+                ++top;
+            };
+            push(range_t{0, 0, count, 0});
+            while(top) {
+                const range_t range = _stack[--top];
+                // bounds of the boxes, and of their centers (doubled)
+                rectf bounds=nothing(), centers=nothing();
+                for (unsigned ix = range.begin; ix < range.end; ++ix) {
+                    const rectf & box = boxes[_order[ix]];
+                    const float x = box.left + box.right, y = box.top + box.bottom;
+                    merge(bounds, box);
+                    merge(centers, rectf{x, y, x, y});
+                }
+                _nodes[range.node].bounds = bounds;
+                const unsigned size = range.end - range.begin;
+                if(size <= NITROGL_BVH_LEAF_SIZE) {
+                    _nodes[range.node].first = range.begin;
+                    _nodes[range.node].count = size;
+                    continue;
+                }
+                unsigned split = range.begin + size/2;
+                if(range.depth < max_depth/2) {
+                    const bool horizontal = centers.width() >= centers.height();
+                    const float middle = horizontal ? (centers.left + centers.right)/2.0f :
+                                         (centers.top + centers.bottom)/2.0f;
+                    unsigned low = range.begin, high = range.end;
+                    while(low < high) {
+                        const rectf & box = boxes[_order[low]];
+                        const float center = horizontal ? box.left + box.right : box.top + box.bottom;
+                        if(center < middle) { ++low; continue; }
+                        const unsigned swap = _order[low];
+                        _order[low] = _order[--high]; _order[high] = swap;
+                    }
+                    if(low!=range.begin && low!=range.end) split = low;
+                }
+                const unsigned left = _nodes.size();
+                _nodes.push_back(node_t{nothing(), 0, 0});
+                _nodes.push_back(node_t{nothing(), 0, 0});
+                _nodes[range.node].first = left;
+                _nodes[range.node].count = 0;
+                push(range_t{left + 1, split, range.end, range.depth + 1});
+                push(range_t{left, range.begin, split, range.depth + 1});
+            }
+        }
+
+        /**
+         * update the bounds of the nodes to boxes, that moved since the build. The structure
+         * stays, so it is cheap, but queries slow down as the boxes move away from where they
+         * were built.
+         * @param boxes the boxes of the build, in the same order
+         */
+        void refit(const rectf * boxes) {
+            for (unsigned ix = _nodes.size(); ix-- > 0;) {
+                node_t & node = _nodes[ix];
+                if(node.count) {
+                    node.bounds = nothing();
+                    for (unsigned jx = node.first; jx < node.first + node.count; ++jx)
+                        merge(node.bounds, boxes[_order[jx]]);
+                } else {
+                    node.bounds = _nodes[node.first].bounds;
+                    merge(node.bounds, _nodes[node.first + 1].bounds);
+                }
+            }
+        }
+
+        /**
+         * visit the boxes in the leaves that overlap an area
+         * @param area the area
+         * @param visit callback(position in order), stops the query if it returns true
+         * @return true if stopped
+         */
+        template<class visitor>
+        bool query(const rectf & area, const visitor & visit) const {
+            if(_nodes.size()==0) return false;
+            unsigned stack[max_depth + 1];
+            unsigned top = 0;
+            stack[top++] = 0;
+            while(top) {
+                const node_t & node = _nodes[stack[--top]];
+                if(!overlap(node.bounds, area)) continue;
+                if(node.count) {
+                    for (unsigned ix = node.first; ix < node.first + node.count; ++ix)
+                        if(visit(ix)) return true;
+                    continue;
+                }
+                stack[top++] = node.first + 1;
+                stack[top++] = node.first;
+            }
+            return false;
+        }
+
+        void clear() { _nodes.clear(); _order.clear(); }
+        // count of boxes
+        unsigned size() const { return _order.size(); }
+        // box index of every position in the order
+        const unsigned * order() const { return _order.data(); }
+        const node_t * nodes() const { return _nodes.data(); }
+        unsigned nodes_count() const { return _nodes.size(); }
+        rectf bounds() const { return _nodes.size() ? _nodes[0].bounds : nothing(); }
+    };
+
+    /**
+     * Bounding volume hierarchy of triangles, for hit testing of tessellated geometry.
+     * Triangles are copied in the order of the leaves, so queries do not chase indices.
+     * Degenerate triangles, that strips use to jump between pieces, are dropped, so the
+     * static tests are for triangles with area.
+     * @tparam allocator_type allocator of the arrays
+     */
+    template<class allocator_type=std_rebind_allocator<>>
+    class triangles_bvh {
+    public:
+        struct triangle_t { vec2f a, b, c; };
+
+    private:
+        bvh<allocator_type> _tree;
+        dynamic_array<triangle_t, allocator_type> _triangles;
+        dynamic_array<triangle_t, allocator_type> _built;
+        dynamic_array<rectf, allocator_type> _boxes;
+
+        static float cross(const vec2f & o, const vec2f & a, const vec2f & b) {
+            return (a.x-o.x)*(b.y-o.y) - (a.y-o.y)*(b.x-o.x);
+        }
+
+        // does the line of edge (p, q) separate the area from the triangle
+        static bool separates(const vec2f & p, const vec2f & q, const vec2f & o,
+                              const rectf & area) {
+            const float nx = q.y - p.y, ny = p.x - q.x;
+            const float side = nx*(o.x - p.x) + ny*(o.y - p.y);
+            const float low = nx*((nx > 0 ? area.left : area.right) - p.x) +
+                              ny*((ny > 0 ? area.top : area.bottom) - p.y);
+            const float high = nx*((nx > 0 ? area.right : area.left) - p.x) +
+                               ny*((ny > 0 ? area.bottom : area.top) - p.y);
+            return side >= 0 ? (high < 0 || low > side) : (low > 0 || high < side);
+        }
+
+    public:
+        // edges are inclusive, either winding
+        static bool contains(const triangle_t & t, const vec2f & point) {
+            const float d1 = cross(t.a, t.b, point), d2 = cross(t.b, t.c, point),
+                        d3 = cross(t.c, t.a, point);
+            const bool negative = d1 < 0 || d2 < 0 || d3 < 0;
+            const bool positive = d1 > 0 || d2 > 0 || d3 > 0;
+            return !(negative && positive);
+        }
+
+        // separating axes are the axes of the area, and the normals of the edges
+        static bool intersects(const triangle_t & t, const rectf & area) {
+            rectf box{t.a.x, t.a.y, t.a.x, t.a.y};
+            bvh<allocator_type>::merge(box, rectf{t.b.x, t.b.y, t.b.x, t.b.y});
+            bvh<allocator_type>::merge(box, rectf{t.c.x, t.c.y, t.c.x, t.c.y});
+            return bvh<allocator_type>::overlap(box, area) && !separates(t.a, t.b, t.c, area) &&
+                   !separates(t.b, t.c, t.a, area) && !separates(t.c, t.a, t.b, area);
+        }
+
+        explicit triangles_bvh(const allocator_type & allocator=allocator_type()) :
+                _tree(allocator), _triangles(allocator), _built(allocator), _boxes(allocator) {}
+
+        /**
+         * build from triangles
+         * @param vertices the vertices
+         * @param indices the indices
+         * @param size count of indices
+         * @param type the type of triangles
+         */
+        void build(const vec2f * vertices, const triangles::index * indices,
+                   triangles::index size, triangles::indices type) {
+            _built.clear(); _boxes.clear(); _triangles.clear();
+            if(type!=triangles::indices::TRIANGLES && size < 3) { _tree.clear(); return; }
+            triangles::iterate_triangles(indices, size, type,
+                 [&](triangles::index, triangles::index a, triangles::index b, triangles::index c,
+                     triangles::index, triangles::index, triangles::index) {
+                const triangle_t t{vertices[a], vertices[b], vertices[c]};
+                const float area = cross(t.a, t.b, t.c);
+                if(!(area > 0 || area < 0)) return;
+                rectf box{t.a.x, t.a.y, t.a.x, t.a.y};
+                bvh<allocator_type>::merge(box, rectf{t.b.x, t.b.y, t.b.x, t.b.y});
+                bvh<allocator_type>::merge(box, rectf{t.c.x, t.c.y, t.c.x, t.c.y});
+                _built.push_back(t);
+                _boxes.push_back(box);
+            });
+            _tree.build(_boxes.data(), _boxes.size());
+            const unsigned * order = _tree.order();
+            for (unsigned ix = 0; ix < _built.size(); ++ix)
+                _triangles.push_back(_built[order[ix]]);
+        }
+
+        /**
+         * build from the tessellation buffers of a path
+         */
+        template<class buffers_type>
+        void build(const buffers_type & buffers) {
+            build(buffers.output_vertices.data(), buffers.output_indices.data(),
+                  buffers.output_indices.size(),
+                  triangles::microtess_indices_type_to_nitrogl(buffers.output_indices_type));
+        }
+
+        bool contains(const vec2f & point) const {
+            return _tree.query(rectf{point.x, point.y, point.x, point.y}, [&](unsigned position) {
+                return contains(_triangles[position], point);
+            });
+        }
+
+        bool intersects(const rectf & area) const {
+            return _tree.query(area, [&](unsigned position) {
+                return intersects(_triangles[position], area);
+            });
+        }
+
+        void clear() { _tree.clear(); _triangles.clear(); }
+        unsigned size() const { return _triangles.size(); }
+        const triangle_t * data() const { return _triangles.data(); }
+        rectf bounds() const { return _tree.bounds(); }
+    };
+
+    /**
+     * Hit testing and picking of paths by their tessellation. Every path has a hierarchy of
+     * its triangles, and the scene has a hierarchy of the bounds of the paths. update()
+     * rebuilds only the paths, that were invalidated since the last update (see
+     * microtess::path::version), and refits the hierarchy of the scene, so a scene of mostly
+     * static paths updates in the time of the changed ones. The scene is rebuilt when paths
+     * were added, or more than a quarter of them changed.
+     *
+     * - Queries answer as of the last update()
+     * - Paths are in their own coordinates, map points and areas by the inverse of the
+     *   transform the paths are drawn with
+     * - Paths are referenced, they must outlive the scene
+     * - Tessellation is cached by the paths, use the options they are drawn with, so draws
+     *   and hit testing share it. tessellate_all before update() tessellates changed paths
+     *   in parallel
+     * @tparam path_type type of the paths
+     * @tparam allocator_type allocator of the arrays
+     */
+    template<class path_type, class allocator_type=std_rebind_allocator<>>
+    class hit_test_scene {
+        struct entry_t {
+            path_type * path;
+            tessellate_options options;
+            unsigned version;
+            bool built;
+            triangles_bvh<allocator_type> fill, stroke;
+        };
+        allocator_type _allocator;
+        dynamic_array<entry_t, allocator_type> _entries;
+        dynamic_array<rectf, allocator_type> _bounds;
+        bvh<allocator_type> _tree;
+        memory_arena _arena;
+        bool _rebuild=false;
+
+    public:
+        explicit hit_test_scene(const allocator_type & allocator=allocator_type()) :
+                _allocator(allocator), _entries(allocator), _bounds(allocator), _tree(allocator) {}
+
+        /**
+         * add a path on top of the previous ones
+         * @param path the path
+         * @param options what is hit, the fill, the stroke or both of them
+         * @return index of the path
+         */
+        unsigned add(path_type & path, const tessellate_options & options) {
+            _entries.push_back(entry_t{&path, options, 0, false,
+                                       triangles_bvh<allocator_type>(_allocator),
+                                       triangles_bvh<allocator_type>(_allocator)});
+            _bounds.push_back(bvh<allocator_type>::nothing());
+            _rebuild=true;
+            return _entries.size()-1;
+        }
+
+        void clear() { _entries.clear(); _bounds.clear(); _tree.clear(); _rebuild=false; }
+        unsigned size() const { return _entries.size(); }
+
+        /**
+         * tessellate and rebuild the changed paths, and update the scene
+         * @return count of rebuilt paths
+         */
+        unsigned update() {
+            unsigned changed = 0;
+            for (unsigned ix = 0; ix < _entries.size(); ++ix) {
+                entry_t & entry = _entries[ix];
+                if(entry.built && entry.version==entry.path->version()) continue;
+                tessellate(*entry.path, entry.options, _arena);
+                _arena.reset();
+                if(entry.options.fill) entry.fill.build(entry.path->buffers_fill());
+                else entry.fill.clear();
+                if(entry.options.stroke) entry.stroke.build(entry.path->buffers_stroke());
+                else entry.stroke.clear();
+                entry.version = entry.path->version();
+                entry.built = true;
+                _bounds[ix] = entry.fill.bounds();
+                bvh<allocator_type>::merge(_bounds[ix], entry.stroke.bounds());
+                ++changed;
+            }
+            if(_rebuild || changed*4 > _entries.size()) _tree.build(_bounds.data(), _bounds.size());
+            else if(changed) _tree.refit(_bounds.data());
+            _rebuild=false;
+            return changed;
+        }
+
+        bool contains(unsigned index, const vec2f & point) const {
+            const entry_t & entry = _entries[index];
+            return entry.fill.contains(point) || entry.stroke.contains(point);
+        }
+
+        bool intersects(unsigned index, const rectf & area) const {
+            const entry_t & entry = _entries[index];
+            return entry.fill.intersects(area) || entry.stroke.intersects(area);
+        }
+
+        /**
+         * the top most path under a point
+         * @return index of the path, or -1 if none
+         */
+        int pick(const vec2f & point) const {
+            int hit = -1;
+            _tree.query(rectf{point.x, point.y, point.x, point.y}, [&](unsigned position) {
+                const unsigned index = _tree.order()[position];
+                if(int(index) > hit && contains(index, point)) hit = int(index);
+                return false;
+            });
+            return hit;
+        }
+
+        /**
+         * visit the paths, that intersect an area, in no particular order
+         * @param area the area
+         * @param visit callback(index of path)
+         */
+        template<class visitor>
+        void query(const rectf & area, const visitor & visit) const {
+            _tree.query(area, [&](unsigned position) {
+                const unsigned index = _tree.order()[position];
+                if(bvh<allocator_type>::overlap(_bounds[index], area) && intersects(index, area))
+                    visit(index);
+                return false;
+            });
+        }
+
+        // bounds of a path as of the last update
+        const rectf & bounds(unsigned index) const { return _bounds[index]; }
+    };
+
+}
\ No newline at end of file
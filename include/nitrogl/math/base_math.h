@@ -82,5 +82,18 @@ namespace nitrogl {
         number tan_bhaskara_cpu(number radians) {
             return sin_bhaskara_cpu<number>(radians)/cos_bhaskara_cpu<number>(radians);
         }
+
+        template<typename number>
+        number log2_cpu(number val) {
+            // val = m * 2^e, m in [1, 2), and ln(m) = 2*atanh((m-1)/(m+1)) as a short series
+            if(val<=number(0)) return number(-1000);
+            int e=0;
+            while (val>=number(2)) { val/=number(2); ++e; }
+            while (val<number(1)) { val*=number(2); --e; }
+            const number s = (val-number(1))/(val+number(1)), s2=s*s;
+            const number ln = number(2)*s*(number(1) + s2*(number(1)/number(3) +
+                                       s2*(number(1)/number(5) + s2/number(7))));
+            return number(e) + ln*number(1.4426950408889634);
+        }
     };
 }
\ No newline at end of file
@@ -41,6 +41,7 @@ public:
                          recommended_mul_strategy : multiplication_strategy;
 
 private:
+    template<unsigned, typename, typename, char> friend class Q;
     integer _value;
 
     /**
@@ -59,12 +60,13 @@ private:
         return result;
     }
 
-    template<unsigned char S> inline void multiply(const integer val) {}
-    template<> inline void multiply<0>(const integer val) {
+    // multiplication strategies are overloads of a tag, members can not be specialized in class
+    template<char S> struct strategy {};
+    inline void multiply(const integer val, strategy<0>) {
         inter_integer inter = ((inter_integer)_value)*val;
         _value = shift_right_correctly_by<inter_integer>(inter, P);
     }
-    template<> inline void multiply<1>(const integer val) {
+    inline void multiply(const integer val, strategy<1>) {
         using int_t = inter_integer;
         const int_t fpValue1 = _value;
         const int_t fpValue2 = val;
@@ -76,7 +78,7 @@ private:
         _value = ((intPart1 * intPart2)<<P) + (intPart1 * fracPart2) +
                  (fracPart1 * intPart2) + (((fracPart1 * fracPart2)>>P) & MASK_FRAC_BITS);
     }
-    template<> inline void multiply<2>(const integer val)
+    inline void multiply(const integer val, strategy<2>)
             { _value = (((inter_integer)_value)*val)>>P; }
 
 public:
@@ -84,7 +86,7 @@ public:
     template<unsigned from_precision, unsigned to_precision>
     static inline integer convert_compile_time_variant(const integer from_value) {
         // the constexpr will elliminate the branching at compile time with simple compiler optimization
-        constexpr auto delta = from_precision - to_precision;
+        constexpr int delta = int(from_precision) - int(to_precision);
         if(delta==0) return from_value;
         else if(delta>0) return shift_right_correctly_by<integer>(from_value, delta);
         else return (from_value<<(-delta));
@@ -92,7 +94,7 @@ public:
 
     static inline integer convert_runtime_variant(const integer from_value, precision_t from_precision,
                                   precision_t to_precision) {
-        const auto delta = from_precision-to_precision;
+        const int delta = int(from_precision) - int(to_precision);
         if(delta==0) return from_value;
         else if(delta>0) return shift_right_correctly_by<integer>(from_value, delta);
         else return (from_value<<(-delta));
@@ -115,7 +117,7 @@ public:
     // with assignments operators
     q_ref operator =(const_ref q) { _value = q.value(); return *this; }
     q_ref operator *=(const_ref q) {
-        multiply<inferred_mul_strategy>(q.value()); return *this;
+        multiply(q.value(), strategy<inferred_mul_strategy>()); return *this;
     }
     q_ref operator *=(unsigned val) {_value *= val; return *this;}
     q_ref operator *=(signed val) {_value *= val; return *this;}
@@ -178,7 +180,7 @@ public:
     integer fraction() const { return (_value<0?-_value:_value)&MASK_FRAC_BITS; }
     inline integer value() const { return _value; }
     q_ref updateValue(const integer & val) { _value=val; return (*this); }
-    Q abs() const { return _value<0? (*this):-(*this); }
+    Q abs() const { return _value<0? -(*this):(*this); }
     Q mod(const_ref val) const { return (*this)%val; }
     Q sqrt() const {
         Q val = *this, x = val, y = Q(1);
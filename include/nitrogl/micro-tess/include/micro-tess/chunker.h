@@ -118,8 +118,8 @@ public:
         cut_chunk_if_current_not_empty();
         for (int ix = 0; ix < $chunker.size(); ++ix) {
             const auto chunk = $chunker[ix];
-            for (int jx = 0; jx < chunk.size; ++jx) {
-                push_back(chunk.data[jx]);
+            for (int jx = 0; jx < chunk.size(); ++jx) {
+                push_back(chunk.data()[jx]);
             }
             cut_chunk_if_current_not_empty();
         }
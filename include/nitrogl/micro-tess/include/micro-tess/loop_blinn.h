@@ -0,0 +1,289 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "vec2.h"
+#include "curve_divider.h"
+#include "triangles.h"
+
+namespace microtess {
+
+    /**
+     * a curve of a path, as it was added, before it was divided into lines.
+     * @tparam number the number type of a vertex
+     */
+    template<typename number>
+    struct path_curve {
+        using index = unsigned int;
+        // start, control points and end (3 points for quadratic and 4 for cubic curves)
+        vec2<number> points[4];
+        CurveType type;
+        // range of the lines of the curve in the vertices of the path, they end at the
+        // end of the curve
+        index first, last;
+    };
+
+    /**
+     * Fill of paths with curves after Loop and Blinn. Curves of the outline are replaced by
+     * the lines between their control points, this interior polygon is planarized as usual.
+     * Every quadratic curve is a triangle (start, control, end), with the implicit
+     * coordinates (0, 0), (1/2, 0) and (1, 1) at its corners, where u^2-v is negative between
+     * the curve and its chord, so a fragment shader fills the curve exactly at any scale. Cubic curves are approximated by quadratic curves within a tolerance.
+     * - a curve, that bulges out of the fill, has its chord in the interior polygon, and its
+     *   triangle fills between the chord and the curve
+     * - a curve, that bulges into the fill, goes around its control point in the interior
+     *   polygon, and its triangle fills between the control point and the curve
+     * Notes:
+     * - the fill is on the side of the outline, that the sign of its area tells, which is
+     *   right for outlines, whose contours do not overlap (i.e. glyphs)
+     * - triangles of curves should not overlap each other or the interior polygon, curves
+     *   are not subdivided to avoid it
+     * @tparam number the number type of a vertex
+     * @tparam chunker_type chunker of the vertices of the path, and of the interior polygon
+     * @tparam container_output_curves the output vertices container type of curves
+     * @tparam computation_allocator allocator of temporary memory
+     */
+    template<typename number, class chunker_type, class container_output_curves,
+             class computation_allocator>
+    class loop_blinn {
+    public:
+        using index = unsigned int;
+        using vertex = microtess::vec2<number>;
+        using curve = path_curve<number>;
+
+        loop_blinn()=delete;
+        loop_blinn(const loop_blinn &)=delete;
+        loop_blinn(loop_blinn &&)=delete;
+        loop_blinn & operator=(const loop_blinn &)=delete;
+        loop_blinn & operator=(loop_blinn &&)=delete;
+        ~loop_blinn()=delete;
+
+    private:
+        // a line of the interior polygon along a curve, its ends are sorted
+        struct leg {
+            vertex a, b;
+            leg(const vertex & p, const vertex & q) : a(less(p, q) ? p : q), b(less(p, q) ? q : p) {}
+            bool operator<(const leg & o) const {
+                return less(a, o.a) || (a==o.a && less(b, o.b));
+            }
+        };
+
+        static bool less(const vertex & a, const vertex & b) {
+            return a.x<b.x || (a.x==b.x && a.y<b.y);
+        }
+
+        static double cross(const vertex & a, const vertex & b) {
+            return double(a.x)*double(b.y) - double(a.y)*double(b.x);
+        }
+
+        // orientation of a triangle, positive if counter clockwise (y up)
+        static double orientation(const vertex & a, const vertex & b, const vertex & c) {
+            return cross(b - a, c - a);
+        }
+
+        static vertex lerp(const vertex & a, const vertex & b, const number & t) {
+            return a + (b - a)*t;
+        }
+
+        /**
+         * call back every quadratic curve of a curve. Cubic curves are divided uniformly, until
+         * the midpoint quadratic curve of every piece is within the tolerance, the error of
+         * which is sqrt(3)/36*|p3-3p2+3p1-p0|/n^3 for n pieces
+         */
+        template<class callback_type>
+        static void quadratics(const curve & c, const number & tolerance,
+                               const callback_type & callback) {
+            const auto * p = c.points;
+            if(c.type==CurveType::Quadratic) { callback(p[0], p[1], p[2]); return; }
+            const auto d = p[3] - p[2]*number(3) + p[1]*number(3) - p[0];
+            const double d2 = double(d.x)*double(d.x) + double(d.y)*double(d.y);
+            const double t2 = double(tolerance)*double(tolerance);
+            index pieces = 1;
+            while (pieces<64 && double(pieces*pieces*pieces)*double(pieces*pieces*pieces)*t2*432.0 < d2)
+                ++pieces;
+            vertex start = p[0];
+            for (index ix = 1; ix <= pieces; ++ix) {
+                const number t0 = number(ix-1)/number(pieces), t1 = number(ix)/number(pieces);
+                // control points of the piece [t0, t1], by de Casteljau
+                const auto a = lerp(p[0], p[1], t0), b = lerp(p[1], p[2], t0), e = lerp(p[2], p[3], t0);
+                const auto ab = lerp(a, b, t0), be = lerp(b, e, t0);
+                const auto a1 = lerp(p[0], p[1], t1), b1 = lerp(p[1], p[2], t1), e1 = lerp(p[2], p[3], t1);
+                const auto ab1 = lerp(a1, b1, t1), be1 = lerp(b1, e1, t1);
+                const number s = t1 - t0;
+                // tangents at the ends of the piece are along (be-ab) and (be1-ab1)
+                const vertex c1 = start + (be - ab)*s;
+                const vertex end = ix==pieces ? p[3] : lerp(ab1, be1, t1);
+                const vertex c2 = end - (be1 - ab1)*s;
+                callback(start, (c1 + c2)*number(3)/number(4) - (start + end)/number(4), end);
+                start = end;
+            }
+        }
+
+        // triangle of a quadratic curve, counter clockwise if it fills between the curve and
+        // its control point. False if the curve is a line
+        static bool curve_triangle(const vertex & p0, const vertex & c, const vertex & p1,
+                                   bool fill_left, bool & inwards, vertex (&triangle)[3]) {
+            const double side = orientation(p0, p1, c);
+            if(!(side>0 || side<0)) return false;
+            inwards = (side>0)==fill_left;
+            const bool ccw = orientation(p0, c, p1)>0;
+            const bool keep = ccw==inwards;
+            triangle[0] = keep ? p0 : p1; triangle[1] = c; triangle[2] = keep ? p1 : p0;
+            return true;
+        }
+
+        // sort by the heap, curves are not allocated in a container
+        static void sort(leg * legs, index size) {
+            const auto sift = [&](index root, index end) {
+                while (2*root+1 < end) {
+                    index child = 2*root+1;
+                    if(child+1 < end && legs[child] < legs[child+1]) ++child;
+                    if(!(legs[root] < legs[child])) return;
+                    const leg temp = legs[root]; legs[root] = legs[child]; legs[child] = temp;
+                    root = child;
+                }
+            };
+            for (index ix = size/2; ix-- > 0; ) sift(ix, size);
+            for (index end = size; end-- > 1; ) {
+                const leg temp = legs[0]; legs[0] = legs[end]; legs[end] = temp;
+                sift(0, end);
+            }
+        }
+
+    public:
+
+        /**
+         * compute the interior polygon and the triangles of the curves
+         * @param pieces the vertices of the path, where curves are divided into lines
+         * @param curves the curves of the path, in the order they were added
+         * @param curves_size count of curves
+         * @param tolerance distance of quadratic curves to cubic curves
+         * @param interior output interior polygon
+         * @param output_curves output triangles of quadratic curves, 3 vertices each (see
+         *        curve_triangle), counter clockwise (y up) if they fill between the curve
+         *        and its control point, and clockwise if they fill between the curve and
+         *        its chord
+         */
+        static void compute(const chunker_type & pieces, const curve * curves, index curves_size,
+                            const number & tolerance,
+                            chunker_type & interior,
+                            container_output_curves & output_curves) {
+            const vertex * base = pieces.data();
+            // area of the outline, the fill is on its left if it is positive
+            double area = 0;
+            for (index ix = 0, next = 0; ix < pieces.size(); ++ix) {
+                const auto chunk = pieces[ix];
+                if(chunk.size()==0) continue;
+                const index first = index(chunk.data() - base), end = first + chunk.size();
+                // curves start after the first vertex of their sub-path
+                while (next<curves_size && curves[next].first<=first) ++next;
+                vertex last = chunk[0];
+                for (index jx = first; jx <= end; ) {
+                    if(next<curves_size && curves[next].first==jx && jx>first) {
+                        quadratics(curves[next], tolerance,
+                                   [&](const vertex & p0, const vertex & c, const vertex & p1) {
+                            area += cross(p0, p1) + orientation(p0, c, p1)*2.0/3.0;
+                        });
+                        last = curves[next].points[curves[next].type==CurveType::Cubic ? 3 : 2];
+                        jx = curves[next++].last;
+                        continue;
+                    }
+                    if(jx==end) break;
+                    area += cross(last, base[jx]);
+                    last = base[jx++];
+                }
+                area += cross(last, chunk[0]);
+            }
+            const bool fill_left = !(area<0);
+            for (index ix = 0, next = 0; ix < pieces.size(); ++ix) {
+                const auto chunk = pieces[ix];
+                if(chunk.size()==0) continue;
+                const index first = index(chunk.data() - base), end = first + chunk.size();
+                while (next<curves_size && curves[next].first<=first) ++next;
+                interior.cut_chunk_if_current_not_empty();
+                const auto push = [&](const vertex & v) {
+                    const auto current = interior.back();
+                    if(current.size()==0 || !(current[current.size()-1]==v)) interior.push_back(v);
+                };
+                for (index jx = first; jx <= end; ) {
+                    if(next<curves_size && curves[next].first==jx && jx>first) {
+                        quadratics(curves[next], tolerance,
+                                   [&](const vertex & p0, const vertex & c, const vertex & p1) {
+                            vertex triangle[3];
+                            bool inwards;
+                            if(curve_triangle(p0, c, p1, fill_left, inwards, triangle)) {
+                                for (const auto & v : triangle) output_curves.push_back(v);
+                                if(inwards) push(c);
+                            }
+                            push(p1);
+                        });
+                        jx = curves[next++].last;
+                        continue;
+                    }
+                    if(jx==end) break;
+                    push(base[jx++]);
+                }
+            }
+        }
+
+        /**
+         * the lines of the interior polygon along curves are inside of the fill, unmark them in
+         * the boundary info of its triangles, so edge antialiasing does not fade them
+         * @param vertices vertices of the triangles
+         * @param indices indices of the triangles (triangles::indices::TRIANGLES_WITH_BOUNDARY)
+         * @param indices_size count of indices
+         * @param boundary boundary info of the triangles
+         * @param curves triangles of the curves (see compute)
+         * @param curves_size count of vertices of the curves
+         * @param allocator allocator of temporary memory
+         */
+        template<class container_boundary>
+        static void unmark_curves_edges(const vertex * vertices,
+                                        const index * indices, index indices_size,
+                                        container_boundary & boundary,
+                                        const vertex * curves, index curves_size,
+                                        const computation_allocator & allocator=computation_allocator()) {
+            using leg_allocator_t = typename computation_allocator::template rebind<leg>::other;
+            leg_allocator_t leg_allocator{allocator};
+            const index max_legs = (curves_size/3)*2;
+            if(max_legs==0) return;
+            leg * legs = leg_allocator.allocate(max_legs);
+            index size = 0;
+            for (index ix = 0; ix + 2 < curves_size; ix+=3) {
+                const auto * t = curves + ix;
+                if(orientation(t[0], t[1], t[2])>0) {
+                    new (legs + size++) leg(t[0], t[1]);
+                    new (legs + size++) leg(t[1], t[2]);
+                } else new (legs + size++) leg(t[0], t[2]);
+            }
+            sort(legs, size);
+            const auto found = [&](const leg & key) {
+                index lo = 0, hi = size;
+                while (lo < hi) {
+                    const index mid = (lo + hi)/2;
+                    if(legs[mid] < key) lo = mid + 1; else hi = mid;
+                }
+                return lo < size && !(key < legs[lo]);
+            };
+            for (index ix = 0, idx = 0; ix + 2 < indices_size; ix+=3, ++idx) {
+                const auto info = boundary[idx];
+                if(!info) continue;
+                bool on[3];
+                for (index e = 0; e < 3; ++e) {
+                    on[e] = triangles::classify_boundary_info(info, e) &&
+                            !found(leg(vertices[indices[ix + e]], vertices[indices[ix + (e+1)%3]]));
+                }
+                boundary[idx] = triangles::create_boundary_info(on[0], on[1], on[2]);
+            }
+            leg_allocator.deallocate(legs);
+        }
+    };
+}
\ No newline at end of file
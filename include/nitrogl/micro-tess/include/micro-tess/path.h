@@ -25,6 +25,7 @@
 #include "elliptic_arc_divider.h"
 #include "stroke_tessellation.h"
 #include "planarize_division.h"
+#include "loop_blinn.h"
 #include "chunker.h"
 #include "std_rebind_allocator.h"
 #include "traits.h"
@@ -63,13 +64,21 @@ namespace microtess {
         using allocator_type = Allocator;
         using value_type = vertex;
         using chunker_t = allocator_aware_chunker<vertex, container_template_type, allocator_type>;
+        using curve = path_curve<number>;
+        using curves_t = container_template_type<curve,
+                typename allocator_type::template rebind<curve>::other>;
 
     private:
         allocator_type _allocator;
         chunker_t _paths_vertices;
-        bool _invalid=true;
+        // curves, before they were divided into the vertices
+        curves_t _curves;
+        // fill, stroke and curves fill share the vertices, but are cached separately
+        bool _invalid_fill=true, _invalid_stroke=true, _invalid_curves=true;
+        unsigned _version=0;
         buffers _tess_fill;
         buffers _tess_stroke;
+        buffers _tess_curves;
 
         vertex firstPointOfCurrentSubPath() const {
             auto current_path = _paths_vertices.back();
@@ -90,44 +99,62 @@ namespace microtess {
     public:
         explicit path(const allocator_type & allocator=allocator_type()) :
                     _allocator(allocator), _paths_vertices(allocator),
-                    _tess_fill(allocator), _tess_stroke(allocator) {}
+                    _curves(typename curves_t::allocator_type(allocator)),
+                    _tess_fill(allocator), _tess_stroke(allocator), _tess_curves(allocator) {}
         path(const path & $path) : _allocator($path.get_allocator()),
                                    _paths_vertices($path._paths_vertices, _allocator),
-                                   _tess_fill(_allocator), _tess_stroke(_allocator) {}
+                                   _curves($path._curves, typename curves_t::allocator_type(_allocator)),
+                                   _tess_fill(_allocator), _tess_stroke(_allocator),
+                                   _tess_curves(_allocator) {}
         path(path && $path) noexcept : _allocator($path.get_allocator()),
                                    _paths_vertices(microtess::traits::move($path._paths_vertices)),
+                                   _curves(microtess::traits::move($path._curves)),
                                    _tess_fill(microtess::traits::move($path._tess_fill)),
-                                   _tess_stroke(microtess::traits::move($path._tess_stroke)) {}
+                                   _tess_stroke(microtess::traits::move($path._tess_stroke)),
+                                   _tess_curves(microtess::traits::move($path._tess_curves)) {}
         ~path() = default;
 
         path &operator=(const path & $path) {
             _paths_vertices=$path._paths_vertices;
+            _curves=$path._curves;
             _tess_fill=$path._tess_fill;
             _tess_stroke=$path._tess_stroke;
+            invalidate();
             return *this;
         }
         path &operator=(path && $path) noexcept {
             _paths_vertices=microtess::traits::move($path._paths_vertices);
+            _curves=microtess::traits::move($path._curves);
             _tess_fill=microtess::traits::move($path._tess_fill);
             _tess_stroke=microtess::traits::move($path._tess_stroke);
+            _tess_curves=microtess::traits::move($path._tess_curves);
+            invalidate();
             return *this;
         }
 
-        allocator_type get_allocator() { return _allocator; }
+        allocator_type get_allocator() const { return _allocator; }
         int subpathsCount() const { return _paths_vertices.size(); }
         auto getSubPath(index idx) -> typename chunker_t::chunk {
             return _paths_vertices[idx];
         }
         auto clear() -> path & {
             _paths_vertices.clear();
+            _curves.clear();
             _tess_fill.clear();
             _tess_stroke.clear();
+            _tess_curves.clear();
             invalidate();
             return *this;
         }
 
         auto addPath(const path & $path) -> path & {
+            const auto offset = _paths_vertices.unchunked_size();
             _paths_vertices.push_back($path._paths_vertices);
+            for (const auto & item : $path._curves) {
+                curve moved = item;
+                moved.first += offset; moved.last += offset;
+                _curves.push_back(moved);
+            }
             invalidate();
             return *this;
         }
@@ -235,7 +262,11 @@ namespace microtess {
             output.clear();
             curve_divider<number, decltype(output)>::compute(
                     bezier, output, bezier_curve_divider, CurveType::Cubic);
+            const bool recorded = sizeOfCurrentSubPath()!=0;
+            const index first = _paths_vertices.unchunked_size();
             for (unsigned ix = 0; ix < output.size(); ++ix) lineTo(output[ix]);
+            if(recorded) _curves.push_back({{bezier[0], bezier[1], bezier[2], bezier[3]},
+                                            CurveType::Cubic, first, _paths_vertices.unchunked_size()});
             invalidate();
             return *this;
         }
@@ -250,7 +281,11 @@ namespace microtess {
             output.clear();
             curve_divider<number, decltype(output)>::compute(
                     bezier, output, bezier_curve_divider, CurveType::Quadratic);
+            const bool recorded = sizeOfCurrentSubPath()!=0;
+            const index first = _paths_vertices.unchunked_size();
             for (unsigned ix = 0; ix < output.size(); ++ix) lineTo(output[ix]);
+            if(recorded) _curves.push_back({{bezier[0], bezier[1], bezier[2], bezier[2]},
+                                            CurveType::Quadratic, first, _paths_vertices.unchunked_size()});
             invalidate();
             return *this;
         }
@@ -291,10 +326,17 @@ namespace microtess {
         }
 
         auto invalidate() -> path & {
-            _invalid=true;
+            _invalid_fill=_invalid_stroke=_invalid_curves=true;
+            ++_version;
             return *this;
         }
 
+        /**
+         * counter of invalidations, it changes whenever the vertices may have changed, so
+         * observers of the path can tell if their state, that is derived from it, is stale.
+         */
+        unsigned version() const { return _version; }
+
         struct buffers {
             using allocator_type_vertices = typename allocator_type::template rebind<vertex>::other;
             using allocator_type_indices = typename allocator_type::template rebind<index>::other;
@@ -309,6 +351,8 @@ namespace microtess {
             vertices output_vertices;
             indices output_indices;
             boundaries output_boundary;
+            // triangles of curves of curves fills, 3 vertices each (see loop_blinn)
+            vertices output_curves;
             trapezes DEBUG_output_trapezes;
             triangles::indices output_indices_type;
             const allocator_type & allocator;
@@ -318,6 +362,7 @@ namespace microtess {
                     output_vertices(allocator_type_vertices(allocator)),
                     output_indices(allocator_type_indices(allocator)),
                     output_boundary(allocator_type_boundaries(allocator)),
+                    output_curves(allocator_type_vertices(allocator)),
                     DEBUG_output_trapezes(allocator_type_vertices(allocator)),
                     output_indices_type() {}
             buffers(buffers && val) noexcept :
@@ -325,6 +370,7 @@ namespace microtess {
                     output_vertices(microtess::traits::move(val.output_vertices)),
                     output_indices(microtess::traits::move(val.output_indices)),
                     output_boundary(microtess::traits::move(val.output_boundary)),
+                    output_curves(microtess::traits::move(val.output_curves)),
                     DEBUG_output_trapezes(microtess::traits::move(val.DEBUG_output_trapezes)),
                     output_indices_type(val.output_indices_type) {
             }
@@ -337,6 +383,7 @@ namespace microtess {
                 output_vertices=microtess::traits::move(val.output_vertices);
                 output_indices=microtess::traits::move(val.output_indices);
                 output_boundary=microtess::traits::move(val.output_boundary);
+                output_curves=microtess::traits::move(val.output_curves);
                 DEBUG_output_trapezes=microtess::traits::move(val.DEBUG_output_trapezes);
                 output_indices_type=val.output_indices_type;
             }
@@ -346,21 +393,24 @@ namespace microtess {
                 output_vertices = vertices(allocator);
                 output_indices = indices(allocator);
                 output_boundary = boundaries(allocator);
+                output_curves = vertices(allocator);
             }
             void clear() {
                 DEBUG_output_trapezes.clear();
                 output_vertices.clear();
                 output_indices.clear();
                 output_boundary.clear();
+                output_curves.clear();
             }
         };
 
     private:
         struct fill_cache_info {
-            fill_rule rule; tess_quality quality;
+            fill_rule rule; tess_quality quality; bool boundary;
             bool operator==(const fill_cache_info &val) {
                 bool a= rule==val.rule &&
-                        quality==val.quality;
+                        quality==val.quality &&
+                        boundary==val.boundary;
                 return a;
             }
         };
@@ -412,6 +462,8 @@ namespace microtess {
 
         stroke_cache_info _latest_stroke_cache_info;
         fill_cache_info _latest_fill_cache_info;
+        fill_cache_info _latest_curves_cache_info;
+        number _latest_curves_tolerance;
 
     public:
         template <bool APPLY_MERGE=true, unsigned MAX_ITERATIONS=200>
@@ -419,19 +471,34 @@ namespace microtess {
                                  const tess_quality &quality=tess_quality::better,
                                  bool compute_boundary_buffer = true,
                                  bool debug_trapezes = false) {
-            fill_cache_info info{rule, quality};
+            return tessellateFillWith<APPLY_MERGE, MAX_ITERATIONS, allocator_type>(
+                    _allocator, rule, quality, compute_boundary_buffer, debug_trapezes);
+        }
+
+        /**
+         * same as tessellateFill, but the temporary memory of the planarization is allocated
+         * with another allocator (i.e. an arena of a worker thread), the result is allocated
+         * with the allocator of the path.
+         */
+        template <bool APPLY_MERGE=true, unsigned MAX_ITERATIONS=200, class computation_allocator>
+        buffers & tessellateFillWith(const computation_allocator & computation,
+                                     const fill_rule &rule=fill_rule::non_zero,
+                                     const tess_quality &quality=tess_quality::better,
+                                     bool compute_boundary_buffer = true,
+                                     bool debug_trapezes = false) {
+            fill_cache_info info{rule, quality, compute_boundary_buffer};
             const bool was_computed=(info==_latest_fill_cache_info) &&
                     _tess_fill.output_vertices.size()!=0;
-            if(_invalid || !was_computed) {
+            if(_invalid_fill || !was_computed) {
                 _latest_fill_cache_info=info;
-                _invalid=false;
+                _invalid_fill=false;
                 _tess_fill.clear();
 
                 using planarize_division_tess = planarize_division<number,
                     decltype(_tess_fill.output_vertices),
                     decltype(_tess_fill.output_indices),
                     decltype(_tess_fill.output_boundary),
-                    allocator_type,
+                    computation_allocator,
                     APPLY_MERGE, MAX_ITERATIONS>;
 
                 planarize_division_tess::template compute<decltype(_paths_vertices)>(
@@ -441,11 +508,59 @@ namespace microtess {
                         _tess_fill.output_indices,
                         compute_boundary_buffer ? &_tess_fill.output_boundary : nullptr,
                         debug_trapezes ? &_tess_fill.DEBUG_output_trapezes : nullptr,
-                        _allocator);
+                        computation);
             }
             return _tess_fill;
         }
 
+        /**
+         * tessellate the fill of the path with its curves, after Loop and Blinn (see
+         * loop_blinn). The interior polygon is planarized into the output vertices, indices and
+         * boundary, where the lines along curves are not on the boundary, and the triangles of
+         * the curves are in the output curves. Cached separately from tessellateFill.
+         * @param tolerance distance of the quadratic curves to cubic curves
+         */
+        template <bool APPLY_MERGE=true, unsigned MAX_ITERATIONS=200>
+        buffers & tessellateFillCurves(const fill_rule &rule=fill_rule::non_zero,
+                                       const tess_quality &quality=tess_quality::better,
+                                       bool compute_boundary_buffer = true,
+                                       const number & tolerance=number(1)/number(4)) {
+            fill_cache_info info{rule, quality, compute_boundary_buffer};
+            const bool was_computed=(info==_latest_curves_cache_info) &&
+                    tolerance==_latest_curves_tolerance &&
+                    (_tess_curves.output_vertices.size()!=0 || _tess_curves.output_curves.size()!=0);
+            if(_invalid_curves || !was_computed) {
+                _latest_curves_cache_info=info;
+                _latest_curves_tolerance=tolerance;
+                _invalid_curves=false;
+                _tess_curves.clear();
+                chunker_t interior(_allocator);
+                using loop_blinn_t = loop_blinn<number, chunker_t,
+                        decltype(_tess_curves.output_curves), allocator_type>;
+                loop_blinn_t::compute(_paths_vertices, _curves.data(), index(_curves.size()),
+                                      tolerance, interior, _tess_curves.output_curves);
+                using planarize_division_tess = planarize_division<number,
+                    decltype(_tess_curves.output_vertices),
+                    decltype(_tess_curves.output_indices),
+                    decltype(_tess_curves.output_boundary),
+                    allocator_type, APPLY_MERGE, MAX_ITERATIONS>;
+                planarize_division_tess::template compute<chunker_t>(
+                        interior, rule, quality,
+                        _tess_curves.output_vertices,
+                        _tess_curves.output_indices_type,
+                        _tess_curves.output_indices,
+                        compute_boundary_buffer ? &_tess_curves.output_boundary : nullptr,
+                        nullptr, _allocator);
+                if(compute_boundary_buffer)
+                    loop_blinn_t::unmark_curves_edges(_tess_curves.output_vertices.data(),
+                            _tess_curves.output_indices.data(), index(_tess_curves.output_indices.size()),
+                            _tess_curves.output_boundary,
+                            _tess_curves.output_curves.data(), index(_tess_curves.output_curves.size()),
+                            _allocator);
+            }
+            return _tess_curves;
+        }
+
         template<class Iterable>
         buffers & tessellateStroke(const number & stroke_width=number(1),
                                    const stroke_cap &cap=stroke_cap::butt,
@@ -460,8 +575,8 @@ namespace microtess {
 
             const bool was_computed=(info==_latest_stroke_cache_info) &&
                     _tess_stroke.output_vertices.size()!=0;
-            if(_invalid || !was_computed) {
-                _invalid=false;
+            if(_invalid_stroke || !was_computed) {
+                _invalid_stroke=false;
                 _latest_stroke_cache_info=info;
                 _tess_stroke.clear();
                 unsigned paths = _paths_vertices.size();
@@ -494,11 +609,15 @@ namespace microtess {
             _paths_vertices.drain();
             _tess_fill.drain();
             _tess_stroke.drain();
-            _invalid=true;
+            _tess_curves.drain();
+            _curves = curves_t(typename curves_t::allocator_type(_allocator));
+            invalidate();
         }
         buffers & buffers_fill() { return _tess_fill; }
         buffers & buffers_stroke() { return _tess_stroke; }
+        buffers & buffers_curves() { return _tess_curves; }
         chunker_t & paths_vertices() { return _paths_vertices; }
+        const curves_t & curves() const { return _curves; }
 
     };
 }
\ No newline at end of file
@@ -25,6 +25,7 @@
 #include "half_edge.h"
 #include "dynamic_array.h"
 #include "triangles.h"
+#include "predicates.h"
 
 #ifdef MICROTESS_PLANAR_DEBUG_MESSAGES
 #include <stdexcept>
@@ -123,7 +124,6 @@ namespace microtess {
         using half_edge_face = half_edge_face_t<number>;
         using conflict = conflict_node_t<number>;
         using poly_info = poly_info_t<number>;
-        static int id_a;
 
         struct dynamic_pool {
         private:
@@ -363,7 +363,6 @@ namespace microtess {
         }
 
     private:
-#define abs__(x) (((x)<0)?(-(x)):(x))
 #define min__(a,b) (((a)<(b))?(a):(b))
 #define max__(a, b) ((a)>(b) ? (a) : (b))
 
@@ -462,9 +461,9 @@ namespace microtess {
                             if(requested_boundary_info) {
                                 triangles::boundary_info aa_info =
                                         triangles::create_boundary_info(
-                                                second->prev == start && !infer_fill(start->twin->face->winding, rule),
-                                                !infer_fill(second->twin->face->winding, rule),
-                                                third->next==start && !infer_fill(third->twin->face->winding, rule)
+                                                second->prev == start && is_outside(start, rule),
+                                                is_outside(second, rule),
+                                                third->next==start && is_outside(third, rule)
                                         );
                                 boundary_buffer->push_back(aa_info);
                             }
@@ -500,9 +499,9 @@ namespace microtess {
                                     bool b_root=b_edge->next==root &&
                                                 do_a_b_lies_on_same_trapeze_wall(trapeze, b_edge->origin->coords,
                                                                                  root->origin->coords, cls_b, cls_root)!=point_class_with_trapeze::unknown;
-                                    root_a=root_a ? !infer_fill(root->twin->face->winding, rule) : root_a;
-                                    a_b=(a_b) ? !infer_fill(a_edge->twin->face->winding, rule) : a_b;
-                                    b_root=b_root ? !infer_fill(b_edge->twin->face->winding, rule) : b_root;
+                                    root_a=root_a ? is_outside(root, rule) : root_a;
+                                    a_b=(a_b) ? is_outside(a_edge, rule) : a_b;
+                                    b_root=b_root ? is_outside(b_edge, rule) : b_root;
                                     boundary_buffer->push_back(triangles::create_boundary_info(root_a, a_b, b_root));
                                 }
                             }
@@ -535,7 +534,7 @@ namespace microtess {
                             if(requested_boundary_info) {
                                 triangles::boundary_info aa_info =
                                         triangles::create_boundary_info(false,
-                                                                        !infer_fill(iter->twin->face->winding, rule), false);
+                                                                        is_outside(iter, rule), false);
                                 boundary_buffer->push_back(aa_info);
                             }
                             iter=iter->next;
@@ -639,11 +638,7 @@ namespace microtess {
         }
 
         static int classify_point(const vertex &point, const vertex &a, const vertex &b) {
-            auto a_p=point-a, a_b=b-a;
-            auto result= robust_dot(a_b.orthogonalLeft(), a_p);
-            if(result>0) return 1;
-            else if(result<0) return -1;
-            else return 0;
+            return predicates<number>::classify_point(point, a, b);
         }
 
         static intersection_status finite_segment_intersection_test(const vertex &a, const vertex &b,
@@ -653,17 +648,18 @@ namespace microtess {
             // this procedure will find proper and improper(touches) intersections, but no
             // overlaps, since overlaps induce parallel classification, this would have to be resolved outside,
             // this is NOT sub-pixel robust when underflows occur, but I don't need it that robust
+            // cross products are exact for fixed points, see predicates
+            using cross_type = typename predicates<number>::cross_type;
             if(a==b || c==d) return intersection_status::degenerate_line;
             auto ab = b - a;
             auto cd = d - c;
-            auto dem = ab.x * cd.y - ab.y * cd.x;
-            auto abs_dem = dem<0?-dem:dem;
+            const cross_type dem = predicates<number>::cross(ab, cd);
             // parallel lines
-            if (abs_dem <= number(0)) return intersection_status::parallel;
+            if (dem == cross_type(0)) return intersection_status::parallel;
             else {
                 auto ca = a - c;
-                auto numerator_1 = ca.y*cd.x - ca.x*cd.y;
-                auto numerator_2 = -ab.y*ca.x + ab.x*ca.y;
+                const cross_type numerator_1 = predicates<number>::cross(cd, ca);
+                const cross_type numerator_2 = predicates<number>::cross(ab, ca);
                 if (dem > 0) {
                     if (numerator_1 < 0 || numerator_1 > dem ||
                         numerator_2 < 0 || numerator_2 > dem)
@@ -679,10 +675,8 @@ namespace microtess {
                 else if(numerator_2==0) { alpha=0; intersection = c;}// c lies on a--b segment
                 else if(numerator_2==dem) { alpha=1; intersection = d;}// d lies on a--b segment
                 else { // proper intersection
-                    alpha = numerator_1/dem;
-                    // alpha1 = numerator_2/dem;
-                    intersection = a + (ab*numerator_1)/dem;
-//                    intersection = a + ab*(numerator_1/dem);
+                    alpha = predicates<number>::ratio(numerator_1, dem);
+                    intersection = predicates<number>::interpolate(a, ab, numerator_1, dem);
                 }
             }
             return intersection_status::intersect;
@@ -1221,9 +1215,6 @@ namespace microtess {
                             try_insert_vertex_on_trapeze_boundary_at(a, trapeze, mutual_wall, dynamic_pool);
                     auto * edge_vertex_b =
                             try_insert_vertex_on_trapeze_boundary_at(b, trapeze, mutual_wall, dynamic_pool);
-                    if(id_a!=-1 && edge_vertex_a->origin->id!=id_a) {
-                        int n=0;
-                    }
                     handle_co_linear_edge_with_trapeze(trapeze, edge_vertex_a, edge_vertex_b,
                                                        mutual_wall, winding);
                     result.planar_vertex_a=edge_vertex_a->origin;
@@ -1335,12 +1326,12 @@ namespace microtess {
                     auto next= locate_next_trapeze_boundary_vertex_from(iter, trapeze_adj)->origin->coords;
                     // todo:: add safety tests if prev==root || next==root ?
                     int cross=classify_point(next, root, prev);
-                    number dot=robust_dot(prev-root, next-root);
+                    int dot=predicates<number>::dot_sign(prev-root, next-root);
                     bool is_prev_after_next=cross>=0 && dot>=0;// cross left-of or on root->prev ray, dot: 0-90 or 270-360
                     if(is_prev_after_next) { // pick a better candidate
                         prev=locate_prev_trapeze_boundary_vertex_from(iter, trapeze_adj)->origin->coords;
                         cross=classify_point(next, root, prev);
-                        dot=robust_dot(prev-root, next-root);
+                        dot=predicates<number>::dot_sign(prev-root, next-root);
                     }
                     //
                     bool is_0_or_360_degrees= cross==0 && dot>=0;
@@ -1365,25 +1356,7 @@ namespace microtess {
 
         static bool is_distance_to_line_less_than_epsilon(const vertex &v, const vertex &a,
                                                           const vertex &b, number epsilon) {
-            // we use the equation 2*A = h*d(a,b)
-            // where A = area of triangle spanned by (a,b,v), h= distance of v to (a,b)
-            // we raise everything to quads to avoid square function and we avoid division.
-            // while this is more robust, you have to make sure that your number type will
-            // not overflow (use 64 bit for fixed point integers)
-            number numerator= (b.x - a.x) * (v.y - a.y) - (v.x - a.x) * (b.y - a.y); // 2*A
-            number numerator_abs= abs__(numerator); // 2*A
-            number numerator_abs2= abs__((b.x - a.x) * (v.y - a.y) - (v.x - a.x) * (b.y - a.y)); // 2*A
-            number numerator_quad = numerator_abs*numerator_abs; // (2A)^2
-            number ab_length_quad = (b.y - a.y)*(b.y - a.y) + (b.x - a.x)*(b.x - a.x); // (length(a,b))^2
-            number epsilon_quad = epsilon*epsilon;
-
-            // error detection, this fights overflows that wraps to negative, and because
-            // merging is optional we can avoid.
-            if(numerator_quad<number(0))
-                return false;
-            if(epsilon==number(1))
-                return numerator_quad < ab_length_quad;
-            return numerator_quad < epsilon_quad*ab_length_quad;
+            return predicates<number>::is_distance_to_line_less_than_epsilon(v, a, b, epsilon);
         }
 
         static void remove_edge(half_edge *edge) {
@@ -1559,6 +1532,11 @@ namespace microtess {
             return face->winding;
         }
 
+        // is the face across the edge not filled, edges of the frame have no face across them
+        static bool is_outside(const half_edge * edge, const fill_rule &rule) {
+            return !edge->twin || !edge->twin->face || !infer_fill(edge->twin->face->winding, rule);
+        }
+
         static bool infer_fill(int winding, const fill_rule &rule) {
             unsigned int abs_winding = winding < 0 ? -winding : winding;
             switch (rule) {
@@ -1656,7 +1634,6 @@ namespace microtess {
                                     poly.id, edge, count)
                         return;
                     }
-                    id_a=b_tag_planar ? b_tag_planar->id : -1;
                     const auto face_split_result= handle_face_split(trapeze, a, b_tag, direction, class_a,
                                                                     class_b_tag, winding, dynamic_pool);
 
@@ -1758,23 +1735,6 @@ namespace microtess {
             return origin_b;
         }
 
-        static number robust_dot(const vertex &u, const vertex &v) {
-            int f1=1, f2=1;
-            bool skip=u.x>=number(1) || u.y>=number(1) || v.x>=number(1) || v.y>=number(1);
-//            skip=false;
-            if(!skip) {
-                number w_u=u.x<0?(-u.x):u.x;
-                number h_u=u.y<0?(-u.y):u.y;
-                if(w_u>0 && w_u<number(1)) f1=int(number(2)/w_u);
-                if(h_u>0 && h_u<number(1)) f2=int(number(2)/h_u);
-            }
-            int f=f1>f2?f1:f2;
-//            auto A=u*f, B=v*f;
-//            auto C=A.dot(B);
-            auto result= (u * f).dot(v * f);
-            return result;
-        }
-
         static void wall_vertex_endpoints(const trapeze_t &trapeze, const point_class_with_trapeze &wall,
                               vertex &start, vertex &end) {
             half_edge *edge_start, *edge_end;
@@ -1807,18 +1767,6 @@ namespace microtess {
         }
 
     };
-#undef abs__
 #undef min__
 #undef max__
-
-    template<typename number,
-            class container_vertices,
-            class container_indices,
-            class container_boundary,
-            class computation_allocator,
-            bool APPLY_MERGE,
-            unsigned MAX_ITERATIONS>
-    int planarize_division<number, container_vertices, container_indices,
-                            container_boundary, computation_allocator,
-                            APPLY_MERGE, MAX_ITERATIONS>::id_a(-1);
 }
@@ -0,0 +1,141 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "vec2.h"
+#include "Q.h"
+
+namespace microtess {
+
+    /**
+     * Geometric predicates and constructions of planarize_division.
+     *
+     * - floating points: products are computed in the number type, tiny vectors are
+     *   scaled up before the signs are taken, and near collinear vertices are merged by
+     *   an epsilon, so results depend on rounding
+     * - fixed points (Q): signs are exact. Products of the raw integers are computed in
+     *   the intermediate integer, and do not overflow as long as the raw coordinates are
+     *   below 2^30 in magnitude for 64 bits, i.e. coordinates below 2^(30-precision) for
+     *   precision fraction bits (+-16384 for Q<16, long long, long long>). Intersections
+     *   are computed in double, and rounded to the nearest fixed point
+     * @tparam number the number type of the vertices
+     */
+    template<typename number>
+    struct predicates {
+        using vertex = vec2<number>;
+        // type of cross products of the predicates
+        using cross_type = number;
+
+        static number robust_dot(const vertex &u, const vertex &v) {
+            int f1=1, f2=1;
+            bool skip=u.x>=number(1) || u.y>=number(1) || v.x>=number(1) || v.y>=number(1);
+            if(!skip) {
+                number w_u=u.x<0?(-u.x):u.x;
+                number h_u=u.y<0?(-u.y):u.y;
+                if(w_u>0 && w_u<number(1)) f1=int(number(2)/w_u);
+                if(h_u>0 && h_u<number(1)) f2=int(number(2)/h_u);
+            }
+            int f=f1>f2?f1:f2;
+            return (u * f).dot(v * f);
+        }
+
+        // 1 if point is left of a->b, -1 if right of it, 0 if on it
+        static int classify_point(const vertex &point, const vertex &a, const vertex &b) {
+            const auto result= robust_dot((b-a).orthogonalLeft(), point-a);
+            return result>0 ? 1 : (result<0 ? -1 : 0);
+        }
+
+        // sign of the dot product
+        static int dot_sign(const vertex &u, const vertex &v) {
+            const auto result= robust_dot(u, v);
+            return result>0 ? 1 : (result<0 ? -1 : 0);
+        }
+
+        static cross_type cross(const vertex &u, const vertex &v) { return u.x * v.y - u.y * v.x; }
+
+        // numerator/denominator of cross products
+        static number ratio(const cross_type &numerator, const cross_type &denominator) {
+            return numerator/denominator;
+        }
+
+        // a + ab*numerator/denominator of cross products
+        static vertex interpolate(const vertex &a, const vertex &ab, const cross_type &numerator,
+                                  const cross_type &denominator) {
+            return a + (ab*numerator)/denominator;
+        }
+
+        static bool is_distance_to_line_less_than_epsilon(const vertex &v, const vertex &a,
+                                                          const vertex &b, number epsilon) {
+            // we use the equation 2*A = h*d(a,b)
+            // where A = area of triangle spanned by (a,b,v), h= distance of v to (a,b)
+            // we raise everything to quads to avoid square function and we avoid division.
+            number numerator= (b.x - a.x) * (v.y - a.y) - (v.x - a.x) * (b.y - a.y); // 2*A
+            number numerator_abs= numerator<0 ? -numerator : numerator; // 2*A
+            number numerator_quad = numerator_abs*numerator_abs; // (2A)^2
+            number ab_length_quad = (b.y - a.y)*(b.y - a.y) + (b.x - a.x)*(b.x - a.x); // (length(a,b))^2
+            number epsilon_quad = epsilon*epsilon;
+            // error detection, this fights overflows that wraps to negative
+            if(numerator_quad<number(0))
+                return false;
+            if(epsilon==number(1))
+                return numerator_quad < ab_length_quad;
+            return numerator_quad < epsilon_quad*ab_length_quad;
+        }
+    };
+
+    template<unsigned P, typename integer, typename inter_integer, char S>
+    struct predicates<Q<P, integer, inter_integer, S>> {
+        using number = Q<P, integer, inter_integer, S>;
+        using vertex = vec2<number>;
+        using cross_type = inter_integer;
+
+        static cross_type cross(const vertex &u, const vertex &v) {
+            return inter_integer(u.x.value())*inter_integer(v.y.value()) -
+                   inter_integer(u.y.value())*inter_integer(v.x.value());
+        }
+
+        static int sign(const cross_type &value) { return value>0 ? 1 : (value<0 ? -1 : 0); }
+
+        // dot((b-a).orthogonalLeft(), point-a) == cross(point-a, b-a)
+        static int classify_point(const vertex &point, const vertex &a, const vertex &b) {
+            return sign(cross(point-a, b-a));
+        }
+
+        static int dot_sign(const vertex &u, const vertex &v) {
+            return sign(inter_integer(u.x.value())*inter_integer(v.x.value()) +
+                        inter_integer(u.y.value())*inter_integer(v.y.value()));
+        }
+
+        static integer round(double value) { return integer(value<0 ? value-0.5 : value+0.5); }
+
+        static number ratio(const cross_type &numerator, const cross_type &denominator) {
+            return number().updateValue(round(double(numerator)*double(integer(1)<<P)/double(denominator)));
+        }
+
+        static vertex interpolate(const vertex &a, const vertex &ab, const cross_type &numerator,
+                                  const cross_type &denominator) {
+            const double t = double(numerator)/double(denominator);
+            vertex result=a;
+            result.x.updateValue(a.x.value() + round(double(ab.x.value())*t));
+            result.y.updateValue(a.y.value() + round(double(ab.y.value())*t));
+            return result;
+        }
+
+        static bool is_distance_to_line_less_than_epsilon(const vertex &v, const vertex &a,
+                                                          const vertex &b, number epsilon) {
+            // (2*A)^2 < (epsilon*d(a,b))^2, in double, the squares overflow the integers
+            const double area = double(cross(b-a, v-a));
+            const double dx = double((b.x-a.x).value()), dy = double((b.y-a.y).value());
+            const double e = double(epsilon.value());
+            return area*area < e*e*(dx*dx + dy*dy);
+        }
+    };
+}
\ No newline at end of file
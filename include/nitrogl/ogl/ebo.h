@@ -11,6 +11,7 @@
 #pragma once
 
 #include "debug.h"
+#include "gl_state.h"
 
 namespace nitrogl {
 
@@ -47,9 +48,14 @@ namespace nitrogl {
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, array_size_bytes, array, usage); glCheckError();
         }
         GLuint id() const { return _id; }
-        void del() { if(_id && owner) { glDeleteBuffers(1, &_id); glCheckError(); _id=0; } }
-        void bind() const { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _id); glCheckError(); }
-        static void unbind() { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); glCheckError(); }
+        void del() {
+            if(_id && owner) {
+                glDeleteBuffers(1, &_id); glCheckError();
+                gl_state::get().on_delete_buffer(_id); _id=0;
+            }
+        }
+        void bind() const { gl_state::get().bind_element_buffer(_id); }
+        static void unbind() { gl_state::get().bind_element_buffer(0); }
     };
 
 }
@@ -11,6 +11,8 @@
 #pragma once
 
 #include "gl_texture.h"
+#include "gl_state.h"
+#include "rbo.h"
 
 namespace nitrogl {
 
@@ -52,13 +54,66 @@ namespace nitrogl {
 //            if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 //                log("ERROR::FRAMEBUFFER:: Framebuffer is not complete!");
         }
+        void attachRenderbuffer(const rbo_t & rbo, GLenum attachment=GL_COLOR_ATTACHMENT0) const {
+            bind();
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment,
+                                      GL_RENDERBUFFER, rbo.id());
+            glCheckError();
+        }
+        /**
+         * Blit a region into the same region of another frame buffer, resolves a multisampled
+         * frame buffer into a single sampled one. The region is in opengl window coordinates,
+         * (0,0) is bottom-left.
+         */
+        void blitTo(const fbo_t & to, GLint left, GLint bottom, GLint right, GLint top) const {
+#ifdef NITROGL_SUPPORTS_MULTISAMPLING
+            bind_read();
+            to.bind_draw();
+            auto & state = gl_state::get();
+            const bool scissor = state.scissor_enabled();
+            state.enable_scissor(false);
+            glBlitFramebuffer(left, bottom, right, top, left, bottom, right, top,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glCheckError();
+            state.enable_scissor(scissor);
+#endif
+        }
+        bool isComplete() const {
+            bind();
+            return glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE;
+        }
+        /**
+         * Bits of the stencil buffer of the frame buffer, 0 if it has none. Works for the
+         * default frame buffer as well. Requires gl>=3.0 or gl-es>=3.0, 0 otherwise.
+         */
+        GLint stencilBits() const {
+            GLint type=GL_NONE, bits=0;
+#ifdef NITROGL_SUPPORTS_MULTISAMPLING
+            bind();
+            const GLenum attachment = _id ? GL_STENCIL_ATTACHMENT : GL_STENCIL;
+            glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, attachment,
+                    GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type); glCheckError();
+            if(type!=GL_NONE) {
+                glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, attachment,
+                        GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &bits); glCheckError();
+            }
+#endif
+            return bits;
+        }
+        bool isOwner() const { return owner; }
         bool wasGenerated() const { return _id; }
         GLuint id() const { return _id; }
-        void del() { if(_id && owner) { glDeleteFramebuffers(1, &_id); glCheckError(); _id=0; owner=false; } }
-        void bind() const { glBindFramebuffer(GL_FRAMEBUFFER, _id); glCheckError(); }
-        void bind_read() const { glBindFramebuffer(GL_READ_FRAMEBUFFER, _id); glCheckError(); }
-        void bind_draw() const { glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _id); glCheckError(); }
-        static void unbind() { glBindFramebuffer(GL_FRAMEBUFFER, 0); glCheckError(); }
+        void del() {
+            if(_id && owner) {
+                glDeleteFramebuffers(1, &_id); glCheckError();
+                gl_state::get().on_delete_framebuffer(_id);
+                _id=0; owner=false;
+            }
+        }
+        void bind() const { gl_state::get().bind_framebuffer(_id); }
+        void bind_read() const { gl_state::get().bind_read_framebuffer(_id); }
+        void bind_draw() const { gl_state::get().bind_draw_framebuffer(_id); }
+        static void unbind() { gl_state::get().bind_framebuffer(0); }
     };
 
 }
@@ -0,0 +1,288 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "debug.h"
+#include "../_internal/ogl_info.h"
+
+// texture units, whose bindings are tracked, binds to higher units always go to GL
+#ifndef NITROGL_GL_STATE_TEXTURE_UNITS
+#define NITROGL_GL_STATE_TEXTURE_UNITS 32
+#endif
+
+namespace nitrogl {
+
+    /**
+     * Shadow copy of the GL state, that nitrogl changes (bindings, viewport, blending, scissor,
+     * stencil test, color mask and polygon mode). Calls that set a value, which is already
+     * current, are elided.
+     *
+     * Notes:
+     * - all of nitrogl's binds go through here, so the shadow stays correct as long as
+     *   nobody else changes that state. If you call GL yourself, or switch contexts, call
+     *   invalidate() afterwards
+     * - unknown values are read lazily from GL, when they are needed
+     * - define NITROGL_DISABLE_STATE_CACHE to forward every call to GL
+     * - elided_calls() counts the saved driver calls, reset_counters() every frame to
+     *   get the reduction per frame
+     */
+    class gl_state {
+    public:
+        static constexpr unsigned texture_units = NITROGL_GL_STATE_TEXTURE_UNITS;
+
+    private:
+        static constexpr GLuint unknown = ~GLuint(0);
+
+        GLuint _read_fbo, _draw_fbo, _renderbuffer;
+        GLuint _array_buffer, _element_buffer;
+        GLuint _pixel_pack_buffer, _pixel_unpack_buffer;
+        GLuint _vao, _program;
+        GLuint _active_unit;
+        GLuint _textures[texture_units];
+        GLint _viewport[4];
+        GLuint _blend, _scissor, _stencil, _color_mask;
+        GLint _scissor_box[4];
+        GLenum _blend_func[4], _blend_equation[2];
+        GLenum _polygon_mode;
+        unsigned long _elided, _issued;
+
+        gl_state() : _elided(0), _issued(0) { invalidate(); }
+
+        // true if the call can be skipped, otherwise the caller issues it
+        bool elide(bool is_current) {
+#ifndef NITROGL_DISABLE_STATE_CACHE
+            if(is_current) { ++_elided; return true; }
+#endif
+            ++_issued;
+            return false;
+        }
+
+    public:
+        gl_state(const gl_state &)=delete;
+        gl_state & operator=(const gl_state &)=delete;
+
+        static gl_state & get() {
+            static gl_state state;
+            return state;
+        }
+
+        /**
+         * forget everything, GL state changed behind our back (foreign GL calls, context switch)
+         */
+        void invalidate() {
+            _read_fbo=_draw_fbo=unknown;
+            _renderbuffer=unknown;
+            _array_buffer=_element_buffer=unknown;
+            _pixel_pack_buffer=_pixel_unpack_buffer=unknown;
+            _vao=_program=unknown;
+            _active_unit=unknown;
+            for (auto & t : _textures) t=unknown;
+            _viewport[0]=_viewport[1]=-1; _viewport[2]=_viewport[3]=-1;
+            _blend=unknown;
+            _scissor=unknown;
+            _scissor_box[0]=_scissor_box[1]=-1; _scissor_box[2]=_scissor_box[3]=-1;
+            _stencil=_color_mask=unknown;
+            _blend_func[0]=_blend_func[1]=_blend_func[2]=_blend_func[3]=unknown;
+            _blend_equation[0]=_blend_equation[1]=unknown;
+            _polygon_mode=unknown;
+        }
+
+        unsigned long elided_calls() const { return _elided; }
+        unsigned long issued_calls() const { return _issued; }
+        void reset_counters() { _elided=_issued=0; }
+
+        // frame buffers
+        void bind_framebuffer(GLuint id) {
+            if(elide(_read_fbo==id && _draw_fbo==id)) return;
+            glBindFramebuffer(GL_FRAMEBUFFER, id); glCheckError();
+            _read_fbo=_draw_fbo=id;
+        }
+        void bind_read_framebuffer(GLuint id) {
+            if(elide(_read_fbo==id)) return;
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, id); glCheckError();
+            _read_fbo=id;
+        }
+        void bind_draw_framebuffer(GLuint id) {
+            if(elide(_draw_fbo==id)) return;
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, id); glCheckError();
+            _draw_fbo=id;
+        }
+        GLuint read_framebuffer() {
+            if(_read_fbo==unknown) {
+                GLint id; glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &id); _read_fbo=GLuint(id);
+            }
+            return _read_fbo;
+        }
+        GLuint draw_framebuffer() {
+            if(_draw_fbo==unknown) {
+                GLint id; glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &id); _draw_fbo=GLuint(id);
+            }
+            return _draw_fbo;
+        }
+        void on_delete_framebuffer(GLuint id) {
+            // GL reverts the bindings of a deleted object to zero
+            if(_read_fbo==id) _read_fbo=0;
+            if(_draw_fbo==id) _draw_fbo=0;
+        }
+
+        // render buffers
+        void bind_renderbuffer(GLuint id) {
+            if(elide(_renderbuffer==id)) return;
+            glBindRenderbuffer(GL_RENDERBUFFER, id); glCheckError();
+            _renderbuffer=id;
+        }
+        void on_delete_renderbuffer(GLuint id) {
+            if(_renderbuffer==id) _renderbuffer=0;
+        }
+
+        // buffers
+        void bind_array_buffer(GLuint id) {
+            if(elide(_array_buffer==id)) return;
+            glBindBuffer(GL_ARRAY_BUFFER, id); glCheckError();
+            _array_buffer=id;
+        }
+        void bind_element_buffer(GLuint id) {
+            if(elide(_element_buffer==id)) return;
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id); glCheckError();
+            _element_buffer=id;
+        }
+        // pixel buffers, pixel transfers read from or write to the bound buffer instead of
+        // client memory, so they are unbound after use
+        void bind_pixel_pack_buffer(GLuint id) {
+            if(elide(_pixel_pack_buffer==id)) return;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, id); glCheckError();
+            _pixel_pack_buffer=id;
+        }
+        void bind_pixel_unpack_buffer(GLuint id) {
+            if(elide(_pixel_unpack_buffer==id)) return;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, id); glCheckError();
+            _pixel_unpack_buffer=id;
+        }
+        void on_delete_buffer(GLuint id) {
+            if(_array_buffer==id) _array_buffer=0;
+            if(_element_buffer==id) _element_buffer=0;
+            if(_pixel_pack_buffer==id) _pixel_pack_buffer=0;
+            if(_pixel_unpack_buffer==id) _pixel_unpack_buffer=0;
+        }
+
+        // vertex arrays, the element buffer binding is part of the vertex array state
+        void bind_vertex_array(GLuint id) {
+            if(elide(_vao==id)) return;
+#ifdef NITROGL_SUPPORTS_VAO
+            glBindVertexArray(id); glCheckError();
+#endif
+            _vao=id;
+            _element_buffer=unknown;
+        }
+        void on_delete_vertex_array(GLuint id) {
+            if(_vao==id) { _vao=0; _element_buffer=unknown; }
+        }
+
+        // programs
+        void use_program(GLuint id) {
+            if(elide(_program==id)) return;
+            glUseProgram(id); glCheckError();
+            _program=id;
+        }
+        void on_delete_program(GLuint id) {
+            // a program in use is deleted only once it is not in use anymore
+            if(_program==id) _program=unknown;
+        }
+
+        // textures
+        void active_texture(GLuint unit) {
+            if(elide(_active_unit==unit)) return;
+            glActiveTexture(GL_TEXTURE0 + unit); glCheckError();
+            _active_unit=unit;
+        }
+        GLuint active_texture_unit() {
+            if(_active_unit==unknown) {
+                GLint unit; glGetIntegerv(GL_ACTIVE_TEXTURE, &unit);
+                _active_unit=GLuint(unit) - GL_TEXTURE0;
+            }
+            return _active_unit;
+        }
+        void bind_texture(GLuint unit, GLuint id) {
+            active_texture(unit);
+            const bool tracked = unit < texture_units;
+            if(elide(tracked && _textures[unit]==id)) return;
+            glBindTexture(GL_TEXTURE_2D, id); glCheckError();
+            if(tracked) _textures[unit]=id;
+        }
+        // bind to the active unit
+        void bind_texture(GLuint id) { bind_texture(active_texture_unit(), id); }
+        void on_delete_texture(GLuint id) {
+            // GL unbinds a deleted texture from all of the units
+            for (auto & t : _textures) if(t==id) t=0;
+        }
+
+        // fixed function
+        void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+            if(elide(_viewport[0]==x && _viewport[1]==y &&
+                     _viewport[2]==width && _viewport[3]==height)) return;
+            glViewport(x, y, width, height); glCheckError();
+            _viewport[0]=x; _viewport[1]=y; _viewport[2]=width; _viewport[3]=height;
+        }
+        void enable_blend(bool enabled) {
+            if(elide(_blend==GLuint(enabled))) return;
+            if(enabled) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+            glCheckError();
+            _blend=GLuint(enabled);
+        }
+        // scissor affects draws, clears and blits
+        void enable_scissor(bool enabled) {
+            if(elide(_scissor==GLuint(enabled))) return;
+            if(enabled) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
+            glCheckError();
+            _scissor=GLuint(enabled);
+        }
+        // blits and clears, that run in the middle of a draw, turn it back on after themselves
+        bool scissor_enabled() const { return _scissor==1; }
+        void scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+            const auto * b = _scissor_box;
+            if(elide(b[0]==x && b[1]==y && b[2]==width && b[3]==height)) return;
+            glScissor(x, y, width, height); glCheckError();
+            _scissor_box[0]=x; _scissor_box[1]=y; _scissor_box[2]=width; _scissor_box[3]=height;
+        }
+        // stencil test, its function and operations are set by whoever enables it
+        void enable_stencil(bool enabled) {
+            if(elide(_stencil==GLuint(enabled))) return;
+            if(enabled) glEnable(GL_STENCIL_TEST); else glDisable(GL_STENCIL_TEST);
+            glCheckError();
+            _stencil=GLuint(enabled);
+        }
+        // write all of the color channels or none of them
+        void color_mask(bool enabled) {
+            if(elide(_color_mask==GLuint(enabled))) return;
+            const GLboolean m = enabled ? GL_TRUE : GL_FALSE;
+            glColorMask(m, m, m, m); glCheckError();
+            _color_mask=GLuint(enabled);
+        }
+        void blend_func(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha) {
+            const auto * f = _blend_func;
+            if(elide(f[0]==src_rgb && f[1]==dst_rgb && f[2]==src_alpha && f[3]==dst_alpha)) return;
+            glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha); glCheckError();
+            _blend_func[0]=src_rgb; _blend_func[1]=dst_rgb;
+            _blend_func[2]=src_alpha; _blend_func[3]=dst_alpha;
+        }
+        void blend_equation(GLenum rgb, GLenum alpha) {
+            if(elide(_blend_equation[0]==rgb && _blend_equation[1]==alpha)) return;
+            glBlendEquationSeparate(rgb, alpha); glCheckError();
+            _blend_equation[0]=rgb; _blend_equation[1]=alpha;
+        }
+        void polygon_mode(GLenum mode) {
+            if(elide(_polygon_mode==mode)) return;
+            glPolygonMode(GL_FRONT_AND_BACK, mode); glCheckError();
+            _polygon_mode=mode;
+        }
+    };
+
+}
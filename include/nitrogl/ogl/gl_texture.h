@@ -11,6 +11,7 @@
 #pragma once
 
 #include "debug.h"
+#include "gl_state.h"
 
 namespace nitrogl {
 
@@ -20,6 +21,10 @@ namespace nitrogl {
         static GLenum bits2type(unsigned bits)
         { return (bits<=8) ? GL_UNSIGNED_BYTE : (bits<=16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT); }
         static unsigned max(unsigned a, unsigned b) { return a<b ? b : a; }
+        static GLint min_i(GLint a, GLint b) { return a<b ? a : b; }
+        static GLint max_i(GLint a, GLint b) { return a<b ? b : a; }
+        static bool is_mip_map_filter(GLint filter_min)
+        { return filter_min!=GL_NEAREST && filter_min!=GL_LINEAR; }
 
     public:
         static GLint next_texture_unit() {
@@ -123,6 +128,22 @@ namespace nitrogl {
         GLsizei _width, _height;
         bool owner, _is_pre_mul_alpha;
         GLint _slot;
+        // minifying filter, uploads dirty the mip-maps only if it samples them.
+        // opengl's default filter is a mip-maps filter
+        mutable GLint _filter_min=GL_NEAREST_MIPMAP_LINEAR;
+        // mip-maps state: lazy mip-maps are only regenerated on resolveMipMaps(), and
+        // only in the region that was dirtied since, [x0, y0, x1, y1)
+        bool _lazy_mip_maps=false;
+        mutable bool _has_mip_maps=false;
+        mutable GLint _mips_dirty[4] {0, 0, 0, 0};
+
+        void on_mip_maps_dirty(GLint x, GLint y, GLsizei width, GLsizei height) const {
+            if(!_lazy_mip_maps) { updateMipMaps(x, y, width, height); return; }
+            auto & d = _mips_dirty;
+            if(d[0]>=d[2] || d[1]>=d[3]) { d[0]=x; d[1]=y; d[2]=x+width; d[3]=y+height; return; }
+            d[0]=min_i(d[0], x); d[1]=min_i(d[1], y);
+            d[2]=max_i(d[2], x+width); d[3]=max_i(d[3], y+height);
+        }
 
 //        gl_texture(GLuint id, GLint internalformat, GLsizei width, GLsizei height, bool owner) :
 //            _id(id), _internalformat(internalformat), _width(width), _height(height), owner(owner) {};
@@ -145,7 +166,9 @@ namespace nitrogl {
         }
         gl_texture(gl_texture && o)  noexcept : _id(o._id), _internalformat(o._internalformat),
             _width(o._width), _height(o._height), owner(o.owner), _is_pre_mul_alpha(o._is_pre_mul_alpha),
-            _slot(o._slot) {
+            _slot(o._slot), _filter_min(o._filter_min), _lazy_mip_maps(o._lazy_mip_maps),
+            _has_mip_maps(o._has_mip_maps),
+            _mips_dirty{o._mips_dirty[0], o._mips_dirty[1], o._mips_dirty[2], o._mips_dirty[3]} {
             o._id=0; o.owner=false;
         }
         gl_texture & operator=(gl_texture && o) noexcept {
@@ -153,25 +176,46 @@ namespace nitrogl {
                 del();
                 _id=o._id; _internalformat=o._internalformat; _is_pre_mul_alpha=o._is_pre_mul_alpha;
                 _width=o._width, _height=o._height; owner=o.owner; _slot=o._slot;
+                copy_mip_maps_state(o);
                 o._id=0; o.owner=false;
             }
             return *this;
         }
         gl_texture(const gl_texture & o) : _id(o._id), _internalformat(o._internalformat),
             _width(o._width), _height(o._height), owner(false), _is_pre_mul_alpha(o._is_pre_mul_alpha),
-            _slot(o._slot) {}
+            _slot(o._slot), _filter_min(o._filter_min), _lazy_mip_maps(o._lazy_mip_maps),
+            _has_mip_maps(o._has_mip_maps),
+            _mips_dirty{o._mips_dirty[0], o._mips_dirty[1], o._mips_dirty[2], o._mips_dirty[3]} {}
         gl_texture & operator=(const gl_texture & o) {
             if(this!=&o) {
                 del();
                 _id = o._id; _internalformat = o._internalformat;
                 _width = o._width, _height = o._height; _is_pre_mul_alpha=o._is_pre_mul_alpha;
                 _slot=o._slot;
+                copy_mip_maps_state(o);
                 owner = false;
             }
             return *this;
         }
         ~gl_texture() { _id=_internalformat=_width=_height=0; }
 
+    private:
+        void set_parameters(GLint filter_mag, GLint filter_min, GLint wrap_s, GLint wrap_t) const {
+            use(_slot);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min); glCheckError();
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mag); glCheckError();
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s); glCheckError();
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t); glCheckError();
+            _filter_min=filter_min;
+        }
+
+        void copy_mip_maps_state(const gl_texture & o) {
+            _filter_min=o._filter_min; _lazy_mip_maps=o._lazy_mip_maps; _has_mip_maps=o._has_mip_maps;
+            for (int ix = 0; ix < 4; ++ix) _mips_dirty[ix]=o._mips_dirty[ix];
+        }
+
+    public:
+
         void generate() {
             if(!_id) {
                 glGenTextures(1, &_id); glCheckError();
@@ -196,16 +240,24 @@ namespace nitrogl {
                          GLint filter_mag=GL_LINEAR, GLint filter_min=GL_LINEAR_MIPMAP_LINEAR,
                          GLint wrap_s=GL_REPEAT, GLint wrap_t=GL_REPEAT) const {
             if(!wasGenerated()) return false;
+            set_parameters(filter_mag, filter_min, wrap_s, wrap_t);
+            return updateImage(format, type, data, unpack_row_alignment);
+        }
+
+        /**
+         * Same as uploadImage, but only moves the pixels, the parameters stay as they are.
+         * If an unpack buffer is bound (see pbo_t), data is an offset into it.
+         */
+        bool updateImage(GLenum format, GLenum type, const void * data,
+                         GLint unpack_row_alignment=1) const {
+            if(!wasGenerated()) return false;
             use(_slot);
             glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_row_alignment); glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min); glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mag); glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s); glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t); glCheckError();
             glTexImage2D(GL_TEXTURE_2D, 0, _internalformat, _width, _height, 0,
                          format, type, data); glCheckError();
-            const bool requires_mip_maps = filter_min!=GL_NEAREST && filter_min!=GL_LINEAR;
-            if(requires_mip_maps) { glGenerateMipmap(GL_TEXTURE_2D); glCheckError(); }
+            // a new image has no mip-maps chain
+            _has_mip_maps=false;
+            if(is_mip_map_filter(_filter_min)) on_mip_maps_dirty(0, 0, _width, _height);
             return true;
         }
 
@@ -221,46 +273,112 @@ namespace nitrogl {
                             GLint filter_mag=GL_LINEAR, GLint filter_min=GL_LINEAR_MIPMAP_LINEAR,
                             GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE) const {
             if(!wasGenerated()) return false;
+            set_parameters(filter_mag, filter_min, wrap_s, wrap_t);
+            return updateSubImage(x, y, width, height, format, type, pixels, unpack_row_alignment);
+        }
+
+        /**
+         * Same as uploadSubImage, but only moves the pixels, the parameters stay as they are.
+         * Use it for frequent updates (streaming). If an unpack buffer is bound (see pbo_t),
+         * pixels is an offset into it.
+         */
+        bool updateSubImage(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format,
+                            GLenum type, const void * pixels, GLint unpack_row_alignment=1) const {
+            if(!wasGenerated()) return false;
             use(_slot);
             glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_row_alignment); glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min); glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mag); glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s); glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t); glCheckError();
             glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, pixels); glCheckError();
-            const bool requires_mip_maps = filter_min!=GL_NEAREST && filter_min!=GL_LINEAR;
-            if(requires_mip_maps) { glGenerateMipmap(GL_TEXTURE_2D); glCheckError(); }
+            if(is_mip_map_filter(_filter_min)) on_mip_maps_dirty(x, y, width, height);
             return true;
         }
         void createMipMaps() const {
             use(_slot);
             glGenerateMipmap(GL_TEXTURE_2D); glCheckError();
+            _has_mip_maps=true;
+            _mips_dirty[0]=_mips_dirty[2]=0;
+        }
+
+        /**
+         * Regenerate the mip-maps levels, only in the region of the base level that changed.
+         * Every level is box filtered from the level above it, with a linear blit. If the
+         * texture has no mip-maps chain yet, the whole chain is created.
+         * @param x, y, width, height region of the base level
+         */
+        void updateMipMaps(GLint x, GLint y, GLsizei width, GLsizei height) const {
+            if(!_has_mip_maps || (x<=0 && y<=0 && width>=_width && height>=_height)) {
+                createMipMaps();
+                return;
+            }
+            // names of a context are not valid in others, so the blit fbos live for the call only
+            GLuint fbos[2];
+            glGenFramebuffers(2, fbos); glCheckError();
+            auto & state = gl_state::get();
+            const GLuint read_fbo = state.read_framebuffer(), draw_fbo = state.draw_framebuffer();
+            state.bind_read_framebuffer(fbos[0]);
+            state.bind_draw_framebuffer(fbos[1]);
+            const bool scissor = state.scissor_enabled();
+            state.enable_scissor(false);
+            GLint x0=max_i(x, 0), y0=max_i(y, 0), x1=min_i(x+width, _width), y1=min_i(y+height, _height);
+            GLint w=_width, h=_height;
+            for (GLint level = 1; w>1 || h>1; ++level) {
+                const GLint nw=max_i(w>>1, 1), nh=max_i(h>>1, 1);
+                // covering region in the next level
+                const GLint nx0=x0*nw/w, ny0=y0*nh/h;
+                const GLint nx1=min_i((x1*nw + w - 1)/w, nw), ny1=min_i((y1*nh + h - 1)/h, nh);
+                glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_2D, _id, level-1);
+                glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_2D, _id, level);
+                glBlitFramebuffer(nx0*w/nw, ny0*h/nh, nx1*w/nw, ny1*h/nh,
+                                  nx0, ny0, nx1, ny1, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+                glCheckError();
+                x0=nx0; y0=ny0; x1=nx1; y1=ny1; w=nw; h=nh;
+            }
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+            state.bind_read_framebuffer(read_fbo);
+            state.bind_draw_framebuffer(draw_fbo);
+            state.enable_scissor(scissor);
+            glDeleteFramebuffers(2, fbos); glCheckError();
+            state.on_delete_framebuffer(fbos[0]);
+            state.on_delete_framebuffer(fbos[1]);
+        }
+
+        /**
+         * Lazy mip-maps are not regenerated on uploads, the dirtied region accumulates
+         * until resolveMipMaps(). Good for streaming many updates between draws.
+         */
+        void setLazyMipMaps(bool lazy) { _lazy_mip_maps=lazy; }
+        bool isLazyMipMaps() const { return _lazy_mip_maps; }
+        bool hasDirtyMipMaps() const { return _mips_dirty[0]<_mips_dirty[2] && _mips_dirty[1]<_mips_dirty[3]; }
+        // regenerate the dirtied region of lazy mip-maps, samplers call it before sampling
+        void resolveMipMaps() const {
+            if(!hasDirtyMipMaps()) return;
+            const auto * d = _mips_dirty;
+            updateMipMaps(d[0], d[1], d[2]-d[0], d[3]-d[1]);
+            _mips_dirty[0]=_mips_dirty[2]=0;
         }
         void update_parameters(GLint filter_mag=GL_LINEAR, GLint filter_min=GL_LINEAR_MIPMAP_LINEAR,
                                GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE) const {
-            use(_slot);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min); glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mag); glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s); glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t); glCheckError();
-            const bool requires_mip_maps = filter_min!=GL_NEAREST && filter_min!=GL_LINEAR;
-            if(requires_mip_maps) { glGenerateMipmap(GL_TEXTURE_2D); glCheckError(); }
+            set_parameters(filter_mag, filter_min, wrap_s, wrap_t);
+            // parameters do not change the image, create the mip-maps chain only if missing
+            if(is_mip_map_filter(filter_min) && !_has_mip_maps) on_mip_maps_dirty(0, 0, _width, _height);
         }
         bool is_premul_alpha() const { return _is_pre_mul_alpha; }
         GLuint id() const { return _id; }
-        static void unuse() { glBindTexture(GL_TEXTURE_2D, 0); glCheckError(); }
+        static void unuse() { gl_state::get().bind_texture(0); }
         void use() const { use(_slot); }
-        void use(int index) const {
-            glActiveTexture(GL_TEXTURE0 + (unsigned int)index); glCheckError();
-            glBindTexture(GL_TEXTURE_2D, _id); glCheckError();
-        }
+        void use(int index) const { gl_state::get().bind_texture(GLuint(index), _id); }
         GLsizei width() const { return _width; }
         GLsizei height() const { return _height; }
         GLint slot() const { return _slot; }
         GLint internalFormat() const { return _internalformat; }
 
         void del() {
-            if(_id && owner) { glDeleteTextures(1, &_id); glCheckError(); }
+            if(_id && owner) {
+                glDeleteTextures(1, &_id); glCheckError();
+                gl_state::get().on_delete_texture(_id);
+            }
             _id=_internalformat=_width=_height=0;
         }
     };
@@ -0,0 +1,90 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+
+#include "debug.h"
+#include "gl_state.h"
+
+namespace nitrogl {
+
+    /**
+     * Pixel buffer object, pixel transfers go through it instead of client memory. A pack
+     * buffer receives glReadPixels, an unpack buffer feeds glTexSubImage2D. Keep it unbound
+     * when you are done, otherwise transfers from client memory read the buffer instead.
+     */
+    class pbo_t {
+        GLuint _id;
+        bool owner;
+        GLenum _target;
+        GLsizeiptr _size;
+
+        pbo_t(GLuint id, bool owner, GLenum target) : _id(id), owner(owner), _target(target), _size(0) {};
+
+    public:
+        static pbo_t un_generated(GLenum target) { return { 0, false, target }; }
+        /**
+         * @param target GL_PIXEL_PACK_BUFFER or GL_PIXEL_UNPACK_BUFFER
+         */
+        explicit pbo_t(GLenum target) : _id(0), owner(true), _target(target), _size(0) { generate(); };
+        pbo_t(pbo_t && o)  noexcept : _id(o._id), owner(o.owner), _target(o._target), _size(o._size) {
+            o.owner=false;
+        }
+        pbo_t(const pbo_t & o) : _id(o._id), owner(false), _target(o._target), _size(o._size) {}
+        pbo_t & operator=(const pbo_t & o) {
+            if(&o!=this) { del(); _id=o._id; owner=false; _target=o._target; _size=o._size; }
+            return *this;
+        };
+        pbo_t & operator=(pbo_t && o) noexcept {
+            if(&o!=this) {
+                del(); _id=o._id; owner=o.owner; _target=o._target; _size=o._size; o.owner=false;
+            }
+            return *this;
+        }
+        ~pbo_t() { del(); }
+
+        void generate() {
+            if(_id) return;
+            glGenBuffers(1, &_id); glCheckError();
+            owner=true;
+        }
+        /**
+         * allocate storage, the previous storage is orphaned, so pending transfers into
+         * it do not stall
+         */
+        void allocate(GLsizeiptr size_bytes, GLenum usage) {
+            if(_id==0) return;
+            bind();
+            glBufferData(_target, size_bytes, nullptr, usage); glCheckError();
+            _size=size_bytes;
+        }
+        bool wasGenerated() const { return _id; }
+        GLuint id() const { return _id; }
+        GLenum target() const { return _target; }
+        GLsizeiptr size() const { return _size; }
+        void del() {
+            if(_id && owner) {
+                glDeleteBuffers(1, &_id); glCheckError();
+                gl_state::get().on_delete_buffer(_id);
+                _id=0; owner=false; _size=0;
+            }
+        }
+        void bind() const {
+            if(_target==GL_PIXEL_PACK_BUFFER) gl_state::get().bind_pixel_pack_buffer(_id);
+            else gl_state::get().bind_pixel_unpack_buffer(_id);
+        }
+        void unbind() const {
+            if(_target==GL_PIXEL_PACK_BUFFER) gl_state::get().bind_pixel_pack_buffer(0);
+            else gl_state::get().bind_pixel_unpack_buffer(0);
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,253 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+
+#include "debug.h"
+#include "gl_state.h"
+#include "fbo.h"
+#include "pbo.h"
+#include "profiler.h"
+#include "../math.h"
+#include "../traits.h"
+#include "../functions/premultiply.h"
+#include "../_internal/ogl_info.h"
+
+#ifndef NITROGL_USE_EXTERNAL_MICRO_TESS
+#include "../micro-tess/include/micro-tess/dynamic_array.h"
+#else
+#include <micro-tess/dynamic_array.h>
+#endif
+
+// count of pixel pack buffers in the ring, reads in flight before a read waits
+#ifndef NITROGL_READBACK_RING_SIZE
+#define NITROGL_READBACK_RING_SIZE 3
+#endif
+
+namespace nitrogl {
+
+    // alpha of delivered pixels
+    enum class pixels_alpha { as_is, premultiply, unpremultiply };
+
+    /**
+     * Asynchronous read back of frame buffer pixels, through a ring of pixel pack buffers and
+     * fences. glReadPixels into a buffer returns right away, the pixels are mapped and
+     * delivered once the GPU is done with them, usually a frame or two later.
+     *
+     * Notes:
+     * - poll() delivers the finished reads, in the order of their requests
+     * - when all buffers are in flight, a new read waits for the oldest one
+     * - pixels are RGBA8 and delivered zero copy from the mapped buffer, unless an alpha
+     *   conversion was asked for
+     * - without fences (NITROGL_SUPPORTS_SYNC), reads are synchronous and delivered right away
+     *
+     * @tparam allocator_type allocator for the callbacks and the conversion buffer
+     */
+    template<class allocator_type=nitrogl::std_rebind_allocator<>>
+    class pixels_readback {
+    public:
+        static constexpr unsigned ring_size = NITROGL_READBACK_RING_SIZE;
+
+    private:
+        using bytes_allocator = typename allocator_type::template rebind<unsigned char>::other;
+        using bytes_t = dynamic_array<unsigned char, bytes_allocator>;
+
+        struct slot_t {
+            pbo_t pbo{pbo_t::un_generated(GL_PIXEL_PACK_BUFFER)};
+#ifdef NITROGL_SUPPORTS_SYNC
+            GLsync fence=nullptr;
+#endif
+            rect_i rect;
+            pixels_alpha alpha=pixels_alpha::as_is;
+            void * callback=nullptr;
+            void (*invoke)(void *, const rect_i &, const unsigned char *, int)=nullptr;
+            void (*destroy)(void *, const allocator_type &)=nullptr;
+            bool busy=false;
+        };
+
+        template<class callback_type>
+        static void invoke(void * object, const rect_i & rect, const unsigned char * pixels,
+                           int stride) {
+            (*reinterpret_cast<callback_type *>(object))(rect, pixels, stride);
+        }
+
+        template<class callback_type>
+        static void destroy(void * object, const allocator_type & allocator) {
+            using rebind_allocator = typename allocator_type::template rebind<callback_type>::other;
+            rebind_allocator alloc(allocator);
+            auto * callback = reinterpret_cast<callback_type *>(object);
+            callback->~callback_type();
+            alloc.deallocate(callback, 1);
+        }
+
+        allocator_type _allocator;
+        slot_t _slots[ring_size];
+        // next slot to read into, oldest read in flight
+        unsigned _next, _oldest;
+        bytes_t _converted;
+
+        // deliver bottom to top rows of pixels, as top to bottom rows
+        void deliver(slot_t & slot, const unsigned char * pixels) {
+            const auto & r = slot.rect;
+            const int stride = r.width()*4;
+            const unsigned long count = (unsigned long)(r.width())*(unsigned long)(r.height());
+            if(slot.alpha==pixels_alpha::as_is) {
+                // zero copy, start at the top row and go down
+                slot.invoke(slot.callback, r, pixels + (r.height()-1)*stride, -stride);
+                return;
+            }
+            _converted.resize(count*4);
+            auto * out = _converted.data();
+            for (int row = 0; row < r.height(); ++row) {
+                const auto * in = pixels + (r.height()-1-row)*stride;
+                if(slot.alpha==pixels_alpha::premultiply)
+                    functions::premultiply_rgba8(in, out + row*stride, (unsigned long)r.width());
+                else functions::unpremultiply_rgba8(in, out + row*stride, (unsigned long)r.width());
+            }
+            slot.invoke(slot.callback, r, out, stride);
+        }
+
+        void release(slot_t & slot) {
+            slot.destroy(slot.callback, _allocator);
+            slot.callback=nullptr;
+            slot.busy=false;
+        }
+
+        /**
+         * deliver the read of a slot, if it is done
+         * @param wait wait for the GPU to be done
+         * @return true if delivered
+         */
+        bool complete(slot_t & slot, bool wait) {
+#ifdef NITROGL_SUPPORTS_SYNC
+            GLenum status;
+            do {
+                // flushes, otherwise the fence might never be reached
+                status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                          wait ? GLuint64(1000000000) : GLuint64(0));
+                glCheckError();
+            } while(wait && status==GL_TIMEOUT_EXPIRED);
+            if(status==GL_TIMEOUT_EXPIRED) return false;
+            NITROGL_PROFILE_SCOPE("pixels_readback::deliver");
+            glDeleteSync(slot.fence); slot.fence=nullptr;
+            const auto bytes = GLsizeiptr(slot.rect.width())*slot.rect.height()*4;
+            slot.pbo.bind();
+            const auto * pixels = reinterpret_cast<const unsigned char *>(
+                    glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT));
+            glCheckError();
+            // buffers stay mapped while unbound, so the callback may use GL
+            slot.pbo.unbind();
+            if(pixels) deliver(slot, pixels);
+            slot.pbo.bind();
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER); glCheckError();
+            slot.pbo.unbind();
+#else
+            (void)wait;
+#endif
+            release(slot);
+            return true;
+        }
+
+    public:
+        explicit pixels_readback(const allocator_type & allocator=allocator_type()) :
+                _allocator(allocator), _slots(), _next(0), _oldest(0),
+                _converted(bytes_allocator(allocator)) {}
+        pixels_readback(const pixels_readback &)=delete;
+        pixels_readback & operator=(const pixels_readback &)=delete;
+        ~pixels_readback() {
+            // pending reads are dropped
+            for (auto & slot : _slots) {
+                if(!slot.busy) continue;
+#ifdef NITROGL_SUPPORTS_SYNC
+                glDeleteSync(slot.fence);
+#endif
+                release(slot);
+            }
+        }
+
+        // count of reads in flight
+        unsigned pending() const {
+            unsigned count=0;
+            for (const auto & slot : _slots) count += slot.busy ? 1 : 0;
+            return count;
+        }
+
+        /**
+         * Read pixels of a frame buffer
+         * @param fbo frame buffer to read from
+         * @param fbo_height height of the frame buffer
+         * @param rect rectangle to read, (0,0) is the left-top of the frame buffer
+         * @param alpha convert the alpha of the pixels, when delivered
+         * @param callback (const rect_i & rect, const unsigned char * pixels, int stride) -> void,
+         *        pixels point to the top row of RGBA8 pixels, next rows are at multiples of stride,
+         *        which may be negative. Pixels are valid only during the call
+         */
+        template<class callback_type>
+        void read(const fbo_t & fbo, int fbo_height, const rect_i & rect, pixels_alpha alpha,
+                  const callback_type & callback) {
+            NITROGL_PROFILE_SCOPE("pixels_readback::read");
+            if(rect.empty()) return;
+            auto & slot = _slots[_next];
+            // all buffers are in flight, wait for the oldest one, which is this one
+            if(slot.busy) { complete(slot, true); _oldest = (_oldest + 1) % ring_size; }
+            using rebind_allocator = typename allocator_type::template rebind<callback_type>::other;
+            rebind_allocator alloc(_allocator);
+            auto * object = alloc.allocate(1);
+            alloc.construct(object, callback);
+            slot.callback=object;
+            slot.invoke=&invoke<callback_type>;
+            slot.destroy=&destroy<callback_type>;
+            slot.rect=rect;
+            slot.alpha=alpha;
+            slot.busy=true;
+            const auto bytes = GLsizeiptr(rect.width())*rect.height()*4;
+            // invert to opengl coordinates (0,0) is bottom-left
+            const int y = fbo_height - rect.bottom;
+            fbo.bind_read();
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+#ifdef NITROGL_SUPPORTS_SYNC
+            slot.pbo.generate();
+            if(slot.pbo.size() < bytes) slot.pbo.allocate(bytes, GL_STREAM_READ);
+            slot.pbo.bind();
+            glReadPixels(rect.left, y, rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE,
+                         nullptr);
+            glCheckError();
+            slot.pbo.unbind();
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); glCheckError();
+            _next = (_next + 1) % ring_size;
+#else
+            // synchronous
+            bytes_t pixels{bytes_allocator(_allocator)};
+            pixels.resize((unsigned long)bytes);
+            glReadPixels(rect.left, y, rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE,
+                         pixels.data());
+            glCheckError();
+            deliver(slot, pixels.data());
+            release(slot);
+#endif
+        }
+
+        /**
+         * Deliver the finished reads, in the order of their requests
+         * @param wait wait for all of the reads in flight
+         * @return count of delivered reads
+         */
+        unsigned poll(bool wait=false) {
+            unsigned count=0;
+            while(_slots[_oldest].busy && complete(_slots[_oldest], wait)) {
+                _oldest = (_oldest + 1) % ring_size;
+                ++count;
+            }
+            return count;
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,355 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+/**
+ * Opt-in profiler, define NITROGL_PROFILING to compile it in, otherwise all of the
+ * NITROGL_PROFILE_* macros expand to nothing.
+ *
+ * Usage:
+ *  NITROGL_PROFILE_FRAME_BEGIN();
+ *  canvas.drawRect(...);                   // instrumented phases are recorded
+ *  NITROGL_PROFILE_FRAME_END();
+ *  ...
+ *  nitrogl::profiling::profiler::get().export_chrome_trace(
+ *          [&](const char * str) { out << str; });
+ *
+ * Notes:
+ * - every event records CPU begin/end and, where timer queries exist (desktop gl>=3.3), GPU
+ *   begin/end with glQueryCounter(GL_TIMESTAMP)
+ * - queries are double buffered: the GPU times of frame N are read at the end of frame N+1,
+ *   without stalling. Unavailable results leave the frame without GPU times
+ * - finished frames are published into a ring of NITROGL_PROFILER_FRAMES records, that other
+ *   threads may read lock free with read_frame(), the GL thread is the only writer
+ * - the trace is in the chrome trace event format (chrome://tracing, perfetto), CPU events
+ *   are on thread 1 and GPU events on thread 2, aligned to the CPU clock
+ */
+
+#ifdef NITROGL_PROFILING
+
+#include "../_internal/ogl_info.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// frames kept in the ring
+#ifndef NITROGL_PROFILER_FRAMES
+#define NITROGL_PROFILER_FRAMES 8
+#endif
+
+// max events recorded per frame, later events of a frame are dropped
+#ifndef NITROGL_PROFILER_MAX_EVENTS
+#define NITROGL_PROFILER_MAX_EVENTS 512
+#endif
+
+// GPU timestamps need GL_ARB_timer_query (core in gl-3.3), gl-es does not have it
+#ifndef NITROGL_PROFILER_GPU_TIMESTAMPS
+    #if !defined(NITROGL_OPEN_GL_ES) && \
+        ((NITROGL_OPENGL_MAJOR_VERSION>3) || \
+         (NITROGL_OPENGL_MAJOR_VERSION==3 && NITROGL_OPENGL_MINOR_VERSION>=3))
+        #define NITROGL_PROFILER_GPU_TIMESTAMPS
+    #endif
+#endif
+
+namespace nitrogl {
+    namespace profiling {
+
+        using time_ns = unsigned long long;
+
+        struct event_t {
+            const char * name;
+            unsigned depth;
+            time_ns cpu_begin, cpu_end;
+            // GPU times, already aligned to the CPU clock
+            time_ns gpu_begin, gpu_end;
+        };
+
+        struct frame_t {
+            static constexpr unsigned max_events = NITROGL_PROFILER_MAX_EVENTS;
+            unsigned long index;
+            time_ns cpu_begin, cpu_end;
+            unsigned events_count;
+            unsigned dropped_events;
+            bool has_gpu;
+            event_t events[max_events];
+        };
+
+        class profiler {
+        public:
+            static constexpr unsigned frames = NITROGL_PROFILER_FRAMES;
+            static constexpr unsigned max_events = frame_t::max_events;
+
+        private:
+            // sequence is odd while the slot is written, and 2*(index+1) once frame
+            // of index was published
+            struct slot_t {
+                std::atomic<unsigned long> sequence;
+                frame_t frame;
+            };
+            // frame begin timestamp, begin/end timestamp per event, and frame end timestamp
+            static constexpr unsigned queries_per_set = 2 + 2*max_events;
+            static constexpr unsigned query_frame_end = queries_per_set - 1;
+
+            slot_t _slots[frames];
+            unsigned long _frame;
+            std::atomic<unsigned long> _published;
+            unsigned _depth;
+            bool _in_frame;
+#ifdef NITROGL_PROFILER_GPU_TIMESTAMPS
+            GLuint _queries[2][queries_per_set];
+            bool _has_queries;
+#endif
+
+            profiler() : _slots(), _frame(0), _published(0), _depth(0), _in_frame(false)
+#ifdef NITROGL_PROFILER_GPU_TIMESTAMPS
+                , _queries(), _has_queries(false)
+#endif
+            {}
+
+            static time_ns cpu_now() {
+                using namespace std::chrono;
+                return time_ns(duration_cast<nanoseconds>(
+                        steady_clock::now().time_since_epoch()).count());
+            }
+
+            slot_t & slot_of(unsigned long index) { return _slots[index%frames]; }
+            const slot_t & slot_of(unsigned long index) const { return _slots[index%frames]; }
+            frame_t & current() { return slot_of(_frame).frame; }
+
+            void query(unsigned index) {
+#ifdef NITROGL_PROFILER_GPU_TIMESTAMPS
+                glQueryCounter(_queries[_frame%2][index], GL_TIMESTAMP);
+#else
+                (void)index;
+#endif
+            }
+
+            // read the GPU times of a frame, that was recorded into query set of its index
+            void resolve(frame_t & frame, bool wait) {
+                frame.has_gpu = false;
+#ifdef NITROGL_PROFILER_GPU_TIMESTAMPS
+                const GLuint * set = _queries[frame.index%2];
+                const auto last = set[query_frame_end];
+                GLint available = 0;
+                if(wait) glGetQueryObjectiv(last, GL_QUERY_RESULT, &available);
+                glGetQueryObjectiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
+                if(!available) return;
+                // timestamps complete in order of issue, so all the others are available
+                GLuint64 base=0, t0=0, t1=0;
+                glGetQueryObjectui64v(set[0], GL_QUERY_RESULT, &base);
+                for (unsigned ix = 0; ix < frame.events_count; ++ix) {
+                    auto & e = frame.events[ix];
+                    glGetQueryObjectui64v(set[1 + 2*ix], GL_QUERY_RESULT, &t0);
+                    glGetQueryObjectui64v(set[2 + 2*ix], GL_QUERY_RESULT, &t1);
+                    e.gpu_begin = frame.cpu_begin + time_ns(t0 - base);
+                    e.gpu_end = frame.cpu_begin + time_ns(t1 - base);
+                }
+                frame.has_gpu = true;
+#else
+                (void)wait;
+#endif
+            }
+
+            void publish(unsigned long index, bool wait) {
+                auto & slot = slot_of(index);
+                resolve(slot.frame, wait);
+                slot.sequence.store(2*(index+1), std::memory_order_release);
+                _published.store(index+1, std::memory_order_release);
+            }
+
+        public:
+            profiler(const profiler &)=delete;
+            profiler & operator=(const profiler &)=delete;
+
+            static profiler & get() {
+                static profiler p;
+                return p;
+            }
+
+            /**
+             * start recording a frame, events outside of frames are not recorded.
+             * Needs a current gl context.
+             */
+            void begin_frame() {
+                if(_in_frame) end_frame();
+#ifdef NITROGL_PROFILER_GPU_TIMESTAMPS
+                if(!_has_queries) {
+                    glGenQueries(GLsizei(queries_per_set), _queries[0]);
+                    glGenQueries(GLsizei(queries_per_set), _queries[1]);
+                    _has_queries = true;
+                }
+#endif
+                auto & slot = slot_of(_frame);
+                slot.sequence.store(2*_frame + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                auto & f = slot.frame;
+                f.index = _frame;
+                f.events_count = 0;
+                f.dropped_events = 0;
+                f.has_gpu = false;
+                f.cpu_begin = f.cpu_end = cpu_now();
+                query(0);
+                _depth = 0;
+                _in_frame = true;
+            }
+
+            /**
+             * finish recording the current frame, and publish the previous one, whose GPU
+             * times should be ready by now
+             */
+            void end_frame() {
+                if(!_in_frame) return;
+                _in_frame = false;
+                auto & f = current();
+                f.cpu_end = cpu_now();
+                // close events, that are still open
+                for (unsigned ix = 0; ix < f.events_count; ++ix) {
+                    if(f.events[ix].cpu_end) continue;
+                    f.events[ix].cpu_end = f.cpu_end;
+                    query(2 + 2*ix);
+                }
+                query(query_frame_end);
+                if(_frame) publish(_frame - 1, false);
+                ++_frame;
+            }
+
+            /**
+             * publish the last recorded frame, waits for its GPU times. Call before
+             * exporting, when no more frames are recorded.
+             */
+            void flush() {
+                if(_in_frame) end_frame();
+                if(_frame && _published.load(std::memory_order_relaxed)!=_frame)
+                    publish(_frame - 1, true);
+            }
+
+            /**
+             * @return event id for end_event, or -1 if the event is not recorded
+             */
+            int begin_event(const char * name) {
+                if(!_in_frame) return -1;
+                auto & f = current();
+                if(f.events_count==max_events) { ++f.dropped_events; return -1; }
+                const auto id = f.events_count++;
+                auto & e = f.events[id];
+                e.name = name;
+                e.depth = _depth++;
+                e.gpu_begin = e.gpu_end = 0;
+                query(1 + 2*id);
+                e.cpu_begin = cpu_now();
+                e.cpu_end = 0;
+                return int(id);
+            }
+
+            void end_event(int id) {
+                if(id<0 || !_in_frame) return;
+                auto & e = current().events[id];
+                e.cpu_end = cpu_now();
+                query(2 + 2*unsigned(id));
+                --_depth;
+            }
+
+            /**
+             * @return count of published frames, the latest one is published_frames()-1
+             */
+            unsigned long published_frames() const {
+                return _published.load(std::memory_order_acquire);
+            }
+
+            /**
+             * copy a published frame, safe to call from any thread
+             * @return false if the frame was overwritten or is not published yet
+             */
+            bool read_frame(unsigned long index, frame_t & frame) const {
+                const auto & slot = slot_of(index);
+                const auto before = slot.sequence.load(std::memory_order_acquire);
+                if(before!=2*(index+1)) return false;
+                memcpy(&frame, &slot.frame, sizeof(frame_t));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return slot.sequence.load(std::memory_order_relaxed)==before;
+            }
+
+            /**
+             * write the published frames in the ring as a chrome trace events JSON
+             * @param writer callable of (const char *)
+             */
+            template<class writer_type>
+            void export_chrome_trace(const writer_type & writer) const {
+                char line[256];
+                bool first = true;
+                const auto emit = [&](const char * name, const char * category, int tid,
+                                      time_ns begin, time_ns end, time_ns origin) {
+                    snprintf(line, sizeof(line),
+                             "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                             "\"ts\":%.3f,\"dur\":%.3f}",
+                             first ? "" : ",", name, category, tid,
+                             double(begin - origin)/1000.0, double(end - begin)/1000.0);
+                    first = false;
+                    writer(line);
+                };
+                writer("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+                const auto published = published_frames();
+                const auto from = published > frames ? published - frames : 0;
+                // a frame is too big for the stack of some threads
+                auto * frame = new frame_t;
+                char frame_name[32];
+                time_ns origin = 0;
+                for (auto index = from; index < published; ++index) {
+                    if(!read_frame(index, *frame)) continue;
+                    if(!origin) origin = frame->cpu_begin;
+                    snprintf(frame_name, sizeof(frame_name), "frame %lu", frame->index);
+                    emit(frame_name, "frame", 1, frame->cpu_begin, frame->cpu_end, origin);
+                    for (unsigned ix = 0; ix < frame->events_count; ++ix) {
+                        const auto & e = frame->events[ix];
+                        emit(e.name, "cpu", 1, e.cpu_begin, e.cpu_end, origin);
+                        if(frame->has_gpu)
+                            emit(e.name, "gpu", 2, e.gpu_begin, e.gpu_end, origin);
+                    }
+                }
+                delete frame;
+                writer("\n],\"otherData\":{\"version\":\"nitro-gl profiler\"}}\n");
+            }
+        };
+
+        /**
+         * records an event for the life time of the scope
+         */
+        struct scope {
+            const int id;
+            explicit scope(const char * name) : id(profiler::get().begin_event(name)) {}
+            ~scope() { profiler::get().end_event(id); }
+            scope(const scope &)=delete;
+            scope & operator=(const scope &)=delete;
+        };
+
+    }
+}
+
+#define NITROGL_PROFILE_CONCAT_1(a, b) a##b
+#define NITROGL_PROFILE_CONCAT(a, b) NITROGL_PROFILE_CONCAT_1(a, b)
+#define NITROGL_PROFILE_SCOPE(name) \
+    const nitrogl::profiling::scope NITROGL_PROFILE_CONCAT(nitrogl_profile_scope_, __LINE__)(name)
+#define NITROGL_PROFILE_BEGIN(tag, name) \
+    const int nitrogl_profile_##tag = nitrogl::profiling::profiler::get().begin_event(name)
+#define NITROGL_PROFILE_END(tag) nitrogl::profiling::profiler::get().end_event(nitrogl_profile_##tag)
+#define NITROGL_PROFILE_FRAME_BEGIN() nitrogl::profiling::profiler::get().begin_frame()
+#define NITROGL_PROFILE_FRAME_END() nitrogl::profiling::profiler::get().end_frame()
+
+#else
+
+#define NITROGL_PROFILE_SCOPE(name)
+#define NITROGL_PROFILE_BEGIN(tag, name)
+#define NITROGL_PROFILE_END(tag)
+#define NITROGL_PROFILE_FRAME_BEGIN()
+#define NITROGL_PROFILE_FRAME_END()
+
+#endif
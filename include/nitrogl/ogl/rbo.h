@@ -0,0 +1,99 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+
+#include "gl_state.h"
+
+namespace nitrogl {
+
+#ifdef NITROGL_SUPPORTS_MULTISAMPLING
+    /**
+     * Render buffer object, with multisampled storage. Attach it to a fbo_t, render into it
+     * and blit it into a single sampled frame buffer to resolve it.
+     */
+    class rbo_t {
+        GLuint _id;
+        bool owner;
+        GLsizei _samples;
+
+        rbo_t(GLuint id, bool owner) : _id(id), owner(owner), _samples(0) {};
+
+    public:
+        static rbo_t un_generated() { return { 0, false }; }
+        rbo_t() : _id(0), owner(true), _samples(0) { generate(); };
+        rbo_t(rbo_t && o)  noexcept : _id(o._id), owner(o.owner), _samples(o._samples) { o.owner=false; }
+        rbo_t(const rbo_t & o) : _id(o._id), owner(false), _samples(o._samples) {}
+        rbo_t & operator=(const rbo_t & o) {
+            if(&o!=this) { del(); _id=o._id; owner=false; _samples=o._samples; }
+            return *this;
+        };
+        rbo_t & operator=(rbo_t && o) noexcept {
+            if(&o!=this) { del(); _id=o._id; owner=o.owner; _samples=o._samples; o.owner=false; }
+            return *this;
+        }
+        ~rbo_t() { del(); }
+
+        void generate() { if(!_id) glGenRenderbuffers(1, &_id); glCheckError(); }
+
+        /**
+         * Allocate multisampled storage
+         * @param internal_format sized internal format, i.e GL_RGBA8
+         * @param width width
+         * @param height height
+         * @param samples requested samples per pixel, clamped to GL_MAX_SAMPLES
+         * @return the samples count, that was allocated by the driver
+         */
+        GLsizei storage(GLenum internal_format, GLsizei width, GLsizei height, GLsizei samples) {
+            GLint max_samples=0;
+            glGetIntegerv(GL_MAX_SAMPLES, &max_samples); glCheckError();
+            if(samples>max_samples) samples=max_samples;
+            bind();
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, internal_format,
+                                             width, height);
+            glCheckError();
+            GLint allocated=0;
+            glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_SAMPLES, &allocated);
+            glCheckError();
+            _samples=allocated;
+            return _samples;
+        }
+
+        GLsizei samples() const { return _samples; }
+        bool wasGenerated() const { return _id; }
+        GLuint id() const { return _id; }
+        void del() {
+            if(_id && owner) {
+                glDeleteRenderbuffers(1, &_id); glCheckError();
+                gl_state::get().on_delete_renderbuffer(_id);
+                _id=0; owner=false; _samples=0;
+            }
+        }
+        void bind() const { gl_state::get().bind_renderbuffer(_id); }
+        static void unbind() { gl_state::get().bind_renderbuffer(0); }
+    };
+#else
+    class rbo_t {
+    public:
+        static rbo_t un_generated() { return {}; }
+        rbo_t()=default;
+        ~rbo_t()=default;
+        GLsizei storage(GLenum internal_format, GLsizei width, GLsizei height,
+                        GLsizei samples) { return 0; }
+        GLsizei samples() const { return 0; }
+        bool wasGenerated() const { return false; }
+        GLuint id() const { return 0; }
+        void del() {}
+        void bind() const {}
+        static void unbind() {}
+    };
+#endif
+}
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include "gva.h"
 #include "../traits.h"
 #include "debug.h"
+#include "gl_state.h"
 
 namespace nitrogl {
 //#define BUFFER_OFFSET(i) ((char *)NULL + (i))
@@ -156,8 +157,8 @@ namespace nitrogl {
         GLuint id() const { return _id; }
         shader & vertex() { return _vertex; }
         shader & fragment() { return _fragment; }
-        void use() const { glUseProgram(_id); glCheckError(); }
-        static void unuse() { glUseProgram(0); glCheckError(); }
+        void use() const { gl_state::get().use_program(_id); }
+        static void unuse() { gl_state::get().use_program(0); }
         bool link() {
             glLinkProgram(_id); glCheckError();
             // it is okay to have a get after a gl command
@@ -177,6 +178,7 @@ namespace nitrogl {
             if(!(_id && owner)) return;
             detachShaders(); glCheckError();
             glDeleteProgram(_id); glCheckError();
+            gl_state::get().on_delete_program(_id);
             _id=0;
         }
 
@@ -331,7 +333,7 @@ namespace nitrogl {
             // this avoids extra bindings if all the vertex attributes are mapped
             // from the same vbo
             if(uniform_vbo && gva->vbo >= 0) {
-                glBindBuffer(GL_ARRAY_BUFFER, gva->vbo); glCheckError();
+                gl_state::get().bind_array_buffer(gva->vbo);
             }
 
             auto * it2 = sva;
@@ -342,7 +344,7 @@ namespace nitrogl {
                 // then enable the location and then point the shader program via generic vertex attributes. If using VAO,
                 // then those are part of its state (VBO binding is not, only the mapping from VBO
                 // to the vertex shader)
-                if(!uniform_vbo && it->vbo>=0) { glBindBuffer(GL_ARRAY_BUFFER, it->vbo); glCheckError(); }
+                if(!uniform_vbo && it->vbo>=0) gl_state::get().bind_array_buffer(it->vbo);
                 // enable generic vertex attrib for bound VAO or global state if you dont support VAO
                 glEnableVertexAttribArray((GLuint)it->index); glCheckError();
 
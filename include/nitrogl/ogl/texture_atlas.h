@@ -0,0 +1,333 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "gl_texture.h"
+#include "fbo.h"
+
+// max amount of live entries in a single atlas
+#ifndef NITROGL_TEXTURE_ATLAS_MAX_ENTRIES
+#define NITROGL_TEXTURE_ATLAS_MAX_ENTRIES 256
+#endif
+
+namespace nitrogl {
+
+    /**
+     * Texture Atlas.
+     * Packs many small images into a single large texture, so samplers of different
+     * images share the same texture, slot and therefore the same shader and binding.
+     *
+     * Notes:
+     * - Packing is a bottom-left skyline
+     * - Images are inserted with uploadSubImage
+     * - When the atlas is full, it is compacted: live entries are re-packed by recency and
+     *   the least recently used entries that do not fit anymore are evicted
+     * - Entries are referenced by handles, a handle of an evicted entry resolves to nothing
+     * - Every entry is padded with transparent texels to avoid bleeding with linear filtering
+     * - Texel (0, 0) is reserved and transparent, samplers of evicted entries sample it
+     */
+    class texture_atlas {
+    public:
+        static constexpr int max_entries = NITROGL_TEXTURE_ATLAS_MAX_ENTRIES;
+
+        struct handle_t {
+            int index=-1;
+            unsigned generation=0;
+            bool valid() const { return index>=0; }
+        };
+        struct region_t {
+            GLint x=0, y=0;
+            GLsizei width=0, height=0;
+        };
+
+    private:
+        struct entry_t {
+            region_t region;
+            unsigned generation=0;
+            unsigned last_used=0;
+            bool alive=false;
+        };
+        struct skyline_node_t {
+            GLint x, y;
+            GLsizei width;
+        };
+        static constexpr int max_skyline_nodes = 2*max_entries + 2;
+        struct skyline_t {
+            skyline_node_t nodes[max_skyline_nodes];
+            int size=0;
+        };
+
+        gl_texture _texture;
+        entry_t _entries[max_entries];
+        skyline_t _skyline;
+        GLint _padding;
+        GLint _filter_mag, _filter_min;
+        unsigned _clock;
+        int _alive;
+
+        void reset_skyline(skyline_t & sky) const {
+            sky.size=1;
+            sky.nodes[0] = { 0, 0, _texture.width() };
+            // the transparent texel, it lands at (0, 0)
+            region_t reserved;
+            skyline_insert(sky, 1 + _padding, 1 + _padding, reserved);
+        }
+
+        // clear the attached texture to transparent, regardless of the scissor test
+        static void clear_attached() {
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            auto & state = gl_state::get();
+            const bool scissor = state.scissor_enabled();
+            state.enable_scissor(false);
+            glClear(GL_COLOR_BUFFER_BIT); glCheckError();
+            state.enable_scissor(scissor);
+        }
+
+        // the y at which a rect of width w can rest on node index, or -1 if it does not fit
+        int skyline_fit(const skyline_t & sky, int index, GLsizei w, GLsizei h) const {
+            const auto x = sky.nodes[index].x;
+            if(x + w > _texture.width()) return -1;
+            GLint y = 0;
+            GLsizei left = w;
+            for (int ix = index; left > 0; ++ix) {
+                if(ix==sky.size) return -1;
+                const auto & node = sky.nodes[ix];
+                y = node.y > y ? node.y : y;
+                if(y + h > _texture.height()) return -1;
+                left -= node.width;
+            }
+            return y;
+        }
+
+        bool skyline_insert(skyline_t & sky, GLsizei w, GLsizei h, region_t & result) const {
+            if(sky.size + 1 > max_skyline_nodes) return false;
+            int best_index=-1;
+            GLint best_y=0; GLsizei best_width=0;
+            for (int ix = 0; ix < sky.size; ++ix) {
+                const int y = skyline_fit(sky, ix, w, h);
+                if(y<0) continue;
+                const auto width = sky.nodes[ix].width;
+                if(best_index==-1 || y < best_y || (y==best_y && width < best_width)) {
+                    best_index=ix; best_y=y; best_width=width;
+                }
+            }
+            if(best_index==-1) return false;
+            result.x = sky.nodes[best_index].x; result.y = best_y;
+            result.width = w; result.height = h;
+            // insert the new node and shrink the nodes it shadows
+            for (int ix = sky.size; ix > best_index; --ix)
+                sky.nodes[ix] = sky.nodes[ix-1];
+            sky.nodes[best_index] = { result.x, best_y + h, w };
+            ++sky.size;
+            for (int ix = best_index + 1; ix < sky.size; ++ix) {
+                auto & prev = sky.nodes[ix-1];
+                auto & node = sky.nodes[ix];
+                const auto shadow = prev.x + prev.width - node.x;
+                if(shadow <= 0) break;
+                node.x += shadow;
+                node.width -= shadow;
+                if(node.width > 0) break;
+                for (int jx = ix; jx < sky.size-1; ++jx)
+                    sky.nodes[jx] = sky.nodes[jx+1];
+                --sky.size; --ix;
+            }
+            // merge neighbours of the same height
+            for (int ix = 0; ix < sky.size-1; ++ix) {
+                if(sky.nodes[ix].y != sky.nodes[ix+1].y) continue;
+                sky.nodes[ix].width += sky.nodes[ix+1].width;
+                for (int jx = ix+1; jx < sky.size-1; ++jx)
+                    sky.nodes[jx] = sky.nodes[jx+1];
+                --sky.size; --ix;
+            }
+            return true;
+        }
+
+        void evict(int index) {
+            auto & e = _entries[index];
+            if(!e.alive) return;
+            e.alive=false;
+            ++e.generation;
+            --_alive;
+        }
+
+        /**
+         * re-pack live entries by recency, after making room for a pending rect of (w, h).
+         * Entries that do not fit anymore are evicted, survivors texels are moved on the GPU.
+         * @return false if the pending rect can not fit even in an empty atlas
+         */
+        bool compact(GLsizei w, GLsizei h, region_t & pending) {
+            skyline_t sky;
+            reset_skyline(sky);
+            if(!skyline_insert(sky, w, h, pending)) return false;
+            // order live entries by recency, most recent first
+            int order[max_entries]; int count=0;
+            for (int ix = 0; ix < max_entries; ++ix) {
+                if(!_entries[ix].alive) continue;
+                int jx = count++;
+                for (; jx > 0 && _entries[order[jx-1]].last_used < _entries[ix].last_used; --jx)
+                    order[jx] = order[jx-1];
+                order[jx] = ix;
+            }
+            region_t placed[max_entries];
+            for (int ix = 0; ix < count; ++ix) {
+                const auto & r = _entries[order[ix]].region;
+                if(!skyline_insert(sky, r.width + _padding, r.height + _padding, placed[order[ix]]))
+                    evict(order[ix]);
+            }
+            // move survivors, through a scratch copy of the atlas
+            gl_texture scratch(_texture.width(), _texture.height(), _texture.internalFormat(),
+                               _texture.is_premul_alpha(), _texture.slot());
+            scratch.uploadImage(GL_RED, GL_UNSIGNED_BYTE, nullptr, 1, GL_NEAREST, GL_NEAREST,
+                                GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+            {
+                fbo_t fbo;
+                fbo.attachTexture(_texture);
+                scratch.use();
+                glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0,
+                                    _texture.width(), _texture.height()); glCheckError();
+                clear_attached();
+                fbo.attachTexture(scratch);
+                _texture.use();
+                for (int ix = 0; ix < count; ++ix) {
+                    auto & e = _entries[order[ix]];
+                    if(!e.alive) continue;
+                    const auto & to = placed[order[ix]];
+                    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, to.x, to.y, e.region.x, e.region.y,
+                                        e.region.width, e.region.height); glCheckError();
+                    e.region.x = to.x; e.region.y = to.y;
+                }
+            }
+            scratch.del();
+            _skyline = sky;
+            _texture.update_parameters(_filter_mag, _filter_min, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+            return true;
+        }
+
+        int free_entry() {
+            int lru=0;
+            for (int ix = 0; ix < max_entries; ++ix) {
+                if(!_entries[ix].alive) return ix;
+                if(_entries[ix].last_used < _entries[lru].last_used) lru=ix;
+            }
+            // all entries are live, evict the least recently used one. Its
+            // space is reclaimed on the next compaction. Call it only after the
+            // region of the new entry is secured
+            evict(lru);
+            return lru;
+        }
+
+        const entry_t * resolve(const handle_t & handle) const {
+            if(handle.index<0 || handle.index>=max_entries) return nullptr;
+            const auto & e = _entries[handle.index];
+            return (e.alive && e.generation==handle.generation) ? &e : nullptr;
+        }
+
+    public:
+        /**
+         * @param width atlas width
+         * @param height atlas height
+         * @param internalformat The Internal Format of pixel data in the GPU
+         * @param is_pre_mul_alpha are the inserted images pre-multiplied alpha ?
+         * @param padding transparent texels between entries
+         * @param filter_mag/filter_min filters, mip-map filters are not recommended, because
+         *        entries bleed into each other in lower levels
+         */
+        explicit texture_atlas(GLsizei width=2048, GLsizei height=2048, GLint internalformat=GL_RGBA,
+                               bool is_pre_mul_alpha=false, GLint padding=1,
+                               GLint filter_mag=GL_LINEAR, GLint filter_min=GL_LINEAR) :
+                _texture(gl_texture::empty(width, height, internalformat, is_pre_mul_alpha, 1,
+                                           filter_mag, filter_min,
+                                           GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE)),
+                _entries(), _skyline(), _padding(padding), _filter_mag(filter_mag),
+                _filter_min(filter_min), _clock(0), _alive(0) {
+            reset_skyline(_skyline);
+            // new texels are undefined, padding and the reserved texel must be transparent
+            fbo_t fbo;
+            fbo.attachTexture(_texture);
+            clear_attached();
+        }
+        texture_atlas(const texture_atlas &)=delete;
+        texture_atlas & operator=(const texture_atlas &)=delete;
+        ~texture_atlas() { _texture.del(); }
+
+        /**
+         * pack an image into the atlas
+         * @param width/height image dimensions
+         * @param format/type pixel layout, same as in gl_texture::uploadImage
+         * @param data image data
+         * @param unpack_row_alignment row alignment of image data
+         * @return a handle, invalid if the image does not fit in the atlas, no entry is evicted then
+         */
+        handle_t add(GLsizei width, GLsizei height, GLenum format, GLenum type,
+                     const void * data, GLint unpack_row_alignment=1) {
+            handle_t handle;
+            region_t region;
+            if(!skyline_insert(_skyline, width + _padding, height + _padding, region) &&
+               !compact(width + _padding, height + _padding, region))
+                return handle;
+            const auto index = free_entry();
+            region.width = width; region.height = height;
+            auto & e = _entries[index];
+            e.region = region;
+            e.alive = true;
+            e.last_used = ++_clock;
+            ++_alive;
+            // parameters were set when the atlas was created
+            _texture.updateSubImage(region.x, region.y, width, height, format, type, data,
+                                    unpack_row_alignment);
+            handle.index = index;
+            handle.generation = e.generation;
+            return handle;
+        }
+
+        void remove(const handle_t & handle) {
+            if(resolve(handle)) evict(handle.index);
+        }
+
+        bool contains(const handle_t & handle) const { return resolve(handle); }
+
+        /**
+         * texels region of an entry, null if it was evicted
+         */
+        const region_t * region(const handle_t & handle) const {
+            const auto * e = resolve(handle);
+            return e ? &e->region : nullptr;
+        }
+
+        /**
+         * uv window of an entry, this also marks the entry as recently used
+         * @return false if the entry was evicted
+         */
+        bool uv_window(const handle_t & handle, float & u0, float & v0, float & u1, float & v1) {
+            const auto * e = resolve(handle);
+            if(!e) return false;
+            _entries[handle.index].last_used = ++_clock;
+            const auto & r = e->region;
+            const float w = float(_texture.width()), h = float(_texture.height());
+            u0 = float(r.x)/w; v0 = float(r.y)/h;
+            u1 = float(r.x + r.width)/w; v1 = float(r.y + r.height)/h;
+            return true;
+        }
+
+        /**
+         * uv window of the reserved transparent texel, it is a point at the texel center, so
+         * linear filtering samples only it
+         */
+        void transparent_uv_window(float & u0, float & v0, float & u1, float & v1) const {
+            u0 = u1 = 0.5f/float(_texture.width());
+            v0 = v1 = 0.5f/float(_texture.height());
+        }
+
+        const gl_texture & texture() const { return _texture; }
+        int size() const { return _alive; }
+    };
+
+}
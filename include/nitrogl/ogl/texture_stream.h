@@ -0,0 +1,241 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+
+#include "debug.h"
+#include "gl_state.h"
+#include "gl_texture.h"
+#include "pbo.h"
+#include "profiler.h"
+#include "shader_program.h"
+#include "../traits.h"
+#include "../_internal/ogl_info.h"
+
+#ifndef NITROGL_USE_EXTERNAL_MICRO_TESS
+#include "../micro-tess/include/micro-tess/dynamic_array.h"
+#else
+#include <micro-tess/dynamic_array.h>
+#endif
+
+// count of pixel unpack buffers in the ring, frames in flight before a producer waits
+#ifndef NITROGL_STREAM_RING_SIZE
+#define NITROGL_STREAM_RING_SIZE 3
+#endif
+
+namespace nitrogl {
+
+    /**
+     * Streaming of frames into a texture (video, large images), through a ring of pixel unpack
+     * buffers and fences. A frame is written into mapped buffer memory, and the texture is
+     * updated from the buffer, so the copy is done by the GPU and the render thread does not
+     * wait for the driver to copy client memory.
+     *
+     * Usage:
+     * 1. map() a frame on the GL thread, it is write only memory of frameBytes() bytes,
+     *    rows are rowBytes() apart and go from the bottom of the texture up
+     * 2. fill it on any thread (a decoder thread), hand it back to the GL thread
+     * 3. submit() it on the GL thread, it is copied into the texture by the GPU
+     *
+     * Notes:
+     * - up to ring_size frames can be mapped at once, they are submitted in the order they were
+     *   mapped
+     * - a buffer is mapped again only after the GPU is done copying from it (fence), map() waits
+     *   for it, or returns nullptr if asked not to wait
+     * - only pixels move per frame, the parameters of the texture are not touched
+     * - without fences and mapping (NITROGL_SUPPORTS_SYNC), frames are staged in client memory
+     *   and uploaded on submit()
+     *
+     * @tparam allocator_type allocator for the client memory staging
+     */
+    template<class allocator_type=nitrogl::std_rebind_allocator<>>
+    class texture_stream {
+    public:
+        static constexpr unsigned ring_size = NITROGL_STREAM_RING_SIZE;
+
+    private:
+        using bytes_allocator = typename allocator_type::template rebind<unsigned char>::other;
+        using bytes_t = dynamic_array<unsigned char, bytes_allocator>;
+
+        enum class state_t { free, mapped, in_flight };
+        struct slot_t {
+            pbo_t pbo{pbo_t::un_generated(GL_PIXEL_UNPACK_BUFFER)};
+#ifdef NITROGL_SUPPORTS_SYNC
+            GLsync fence=nullptr;
+#else
+            bytes_t staging;
+#endif
+            state_t state=state_t::free;
+        };
+
+        static GLsizei bytes_per_pixel(GLenum format, GLenum type) {
+            switch (type) {
+                case GL_UNSIGNED_BYTE_3_3_2: return 1;
+                case GL_UNSIGNED_SHORT_5_6_5:
+                case GL_UNSIGNED_SHORT_4_4_4_4:
+                case GL_UNSIGNED_SHORT_5_5_5_1: return 2;
+                case GL_UNSIGNED_INT_8_8_8_8:
+                case GL_UNSIGNED_INT_10_10_10_2: return 4;
+                default: break;
+            }
+            const GLsizei channels = (format==GL_RGBA || format==GL_BGRA) ? 4 :
+                                     ((format==GL_RGB || format==GL_BGR) ? 3 : (format==GL_RG ? 2 : 1));
+            const GLsizei size = (type==GL_UNSIGNED_BYTE || type==GL_BYTE) ? 1 :
+                                 ((type==GL_UNSIGNED_SHORT || type==GL_SHORT) ? 2 : 4);
+            return channels*size;
+        }
+
+        const gl_texture * _texture;
+        GLenum _format, _type;
+        GLint _unpack_row_alignment;
+        GLsizei _row_bytes;
+        slot_t _slots[ring_size];
+        // next slot to map, next slot to submit
+        unsigned _next, _next_submit;
+
+        // wait until the GPU is done copying from a slot
+        bool retire(slot_t & slot, bool wait) {
+#ifdef NITROGL_SUPPORTS_SYNC
+            GLenum status;
+            do {
+                status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                          wait ? GLuint64(1000000000) : GLuint64(0));
+                glCheckError();
+            } while(wait && status==GL_TIMEOUT_EXPIRED);
+            if(status==GL_TIMEOUT_EXPIRED) return false;
+            glDeleteSync(slot.fence); slot.fence=nullptr;
+#else
+            (void)wait;
+#endif
+            slot.state=state_t::free;
+            return true;
+        }
+
+    public:
+        /**
+         * @param texture texture to stream into, it has to outlive the stream
+         * @param format/type pixel layout of frames, same as in gl_texture::uploadImage
+         * @param unpack_row_alignment rows of frames are padded to this alignment (1|2|4|8)
+         * @param allocator allocator
+         */
+        explicit texture_stream(const gl_texture & texture, GLenum format=GL_RGBA,
+                                GLenum type=GL_UNSIGNED_BYTE, GLint unpack_row_alignment=4,
+                                const allocator_type & allocator=allocator_type()) :
+                _texture(&texture), _format(format), _type(type),
+                _unpack_row_alignment(unpack_row_alignment), _row_bytes(0), _slots(),
+                _next(0), _next_submit(0) {
+            const GLsizei a = unpack_row_alignment;
+            _row_bytes = ((texture.width()*bytes_per_pixel(format, type) + a - 1)/a)*a;
+#ifndef NITROGL_SUPPORTS_SYNC
+            for (auto & slot : _slots) slot.staging = bytes_t(bytes_allocator(allocator));
+#else
+            (void)allocator;
+#endif
+        }
+        texture_stream(const texture_stream &)=delete;
+        texture_stream & operator=(const texture_stream &)=delete;
+        ~texture_stream() {
+#ifdef NITROGL_SUPPORTS_SYNC
+            for (auto & slot : _slots) {
+                if(slot.state==state_t::mapped) {
+                    slot.pbo.bind();
+                    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER); glCheckError();
+                    slot.pbo.unbind();
+                }
+                if(slot.fence) glDeleteSync(slot.fence);
+            }
+#endif
+        }
+
+        // bytes between rows of a frame
+        GLsizei rowBytes() const { return _row_bytes; }
+        // bytes of a frame
+        GLsizeiptr frameBytes() const { return GLsizeiptr(_row_bytes)*_texture->height(); }
+        const gl_texture & texture() const { return *_texture; }
+
+        /**
+         * Map the memory of the next frame, call on the GL thread
+         * @param wait if the GPU still copies from the buffer, wait for it or return nullptr
+         * @return write only memory of frameBytes() bytes, nullptr if every buffer is mapped
+         *         (submit them), or the buffer is busy and wait is false
+         */
+        void * map(bool wait=true) {
+            NITROGL_PROFILE_SCOPE("texture_stream::map");
+            auto & slot = _slots[_next];
+            if(slot.state==state_t::mapped) return nullptr;
+            if(slot.state==state_t::in_flight && !retire(slot, wait)) return nullptr;
+            void * memory;
+#ifdef NITROGL_SUPPORTS_SYNC
+            const auto bytes = frameBytes();
+            slot.pbo.generate();
+            if(slot.pbo.size()!=bytes) slot.pbo.allocate(bytes, GL_STREAM_DRAW);
+            slot.pbo.bind();
+            // the fence says the GPU is done with the buffer, no need to synchronize
+            memory = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT |
+                                      GL_MAP_UNSYNCHRONIZED_BIT);
+            glCheckError();
+            // mapped buffers stay mapped while unbound, other uploads read client memory
+            slot.pbo.unbind();
+            if(!memory) return nullptr;
+#else
+            slot.staging.resize((unsigned long)frameBytes());
+            memory = slot.staging.data();
+#endif
+            slot.state=state_t::mapped;
+            _next = (_next + 1) % ring_size;
+            return memory;
+        }
+
+        /**
+         * Copy the oldest mapped frame into the texture, call on the GL thread after the frame
+         * was written. The memory of the frame is not valid anymore.
+         * @return false if no frame is mapped
+         */
+        bool submit() {
+            NITROGL_PROFILE_SCOPE("texture_stream::submit");
+            auto & slot = _slots[_next_submit];
+            if(slot.state!=state_t::mapped) return false;
+#ifdef NITROGL_SUPPORTS_SYNC
+            slot.pbo.bind();
+            // false if the memory was lost while mapped (i.e. screen mode change), skip the frame
+            const bool valid = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)==GL_TRUE; glCheckError();
+            if(valid) _texture->updateSubImage(0, 0, _texture->width(), _texture->height(),
+                                               _format, _type, OFFSET(0), _unpack_row_alignment);
+            slot.pbo.unbind();
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); glCheckError();
+            slot.state=state_t::in_flight;
+#else
+            _texture->updateSubImage(0, 0, _texture->width(), _texture->height(),
+                                     _format, _type, slot.staging.data(), _unpack_row_alignment);
+            slot.state=state_t::free;
+#endif
+            _next_submit = (_next_submit + 1) % ring_size;
+            return true;
+        }
+
+        /**
+         * Convenience, map a frame, copy pixels into it and submit it
+         * @param pixels frame of frameBytes() bytes
+         * @param wait wait for a free buffer, or drop the frame
+         * @return false if the frame was dropped
+         */
+        bool push(const void * pixels, bool wait=true) {
+            auto * memory = reinterpret_cast<unsigned char *>(map(wait));
+            if(!memory) return false;
+            const auto * from = reinterpret_cast<const unsigned char *>(pixels);
+            const auto bytes = frameBytes();
+            for (GLsizeiptr ix = 0; ix < bytes; ++ix) memory[ix] = from[ix];
+            return submit();
+        }
+    };
+
+}
\ No newline at end of file
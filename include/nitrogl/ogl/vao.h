@@ -10,6 +10,8 @@
 ========================================================================================*/
 #pragma once
 
+#include "gl_state.h"
+
 namespace nitrogl {
 
 #ifdef NITROGL_SUPPORTS_VAO
@@ -37,9 +39,14 @@ namespace nitrogl {
 
         bool wasGenerated() const { return _id; }
         GLuint id() const { return _id; }
-        void del() { if(_id && owner) { glDeleteVertexArrays(1, &_id); glCheckError(); _id=0; } }
-        void bind() const { glBindVertexArray(_id); glCheckError(); }
-        static void unbind() { glBindVertexArray(0); glCheckError(); }
+        void del() {
+            if(_id && owner) {
+                glDeleteVertexArrays(1, &_id); glCheckError();
+                gl_state::get().on_delete_vertex_array(_id); _id=0;
+            }
+        }
+        void bind() const { gl_state::get().bind_vertex_array(_id); }
+        static void unbind() { gl_state::get().bind_vertex_array(0); }
     };
 #else
     class vao_t {
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "debug.h"
+#include "gl_state.h"
 
 namespace nitrogl {
 
@@ -48,9 +49,14 @@ namespace nitrogl {
             glBufferSubData(GL_ARRAY_BUFFER, offset, size_bytes, array); glCheckError();
         }
         GLuint id() const { return _id; }
-        void del() { if(_id && owner) { glDeleteBuffers(1, &_id); glCheckError(); _id=0; } }
-        void bind() const { glBindBuffer(GL_ARRAY_BUFFER, _id); glCheckError(); }
-        static void unbind() { glBindBuffer(GL_ARRAY_BUFFER, 0); glCheckError(); }
+        void del() {
+            if(_id && owner) {
+                glDeleteBuffers(1, &_id); glCheckError();
+                gl_state::get().on_delete_buffer(_id); _id=0;
+            }
+        }
+        void bind() const { gl_state::get().bind_array_buffer(_id); }
+        static void unbind() { gl_state::get().bind_array_buffer(0); }
     };
 
 }
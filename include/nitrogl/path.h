@@ -12,12 +12,19 @@
 #ifndef NITROGL_USE_EXTERNAL_MICRO_TESS
 #include "micro-tess/include/micro-tess/path.h"
 #include "micro-tess/include/micro-tess/dynamic_array.h"
+#include "micro-tess/include/micro-tess/Q.h"
 #else
 #include <micro-tess/path.h>
 #include <micro-tess/dynamic_array.h>
+#include <micro-tess/Q.h>
 #endif
 #include "traits.h"
 
+// fraction bits of fixed point paths
+#ifndef NITROGL_FIXED_PRECISION
+#define NITROGL_FIXED_PRECISION 16
+#endif
+
 namespace nitrogl {
 
     /**
@@ -28,4 +35,27 @@ namespace nitrogl {
     template <template<typename...> class container_template_type=dynamic_array,
               class Allocator=nitrogl::std_rebind_allocator<>>
     using path = microtess::path<float, container_template_type, Allocator>;
+
+    /**
+     * Fixed point number of paths, 64 bit storage and products. Intersections and
+     * orientations of the planarization are exact, while raw values are below 2^30 in
+     * magnitude, i.e. coordinates below 2^(30-precision) (16384 for 16 fraction bits).
+     * @tparam precision fraction bits
+     */
+    template <unsigned precision=NITROGL_FIXED_PRECISION>
+    using fixed_number = Q<precision, long long, long long>;
+
+    /**
+     * Path alias (fixed point version). Tessellation of it does not depend on the
+     * rounding of floats, but degenerate input that breaks the planarization breaks it
+     * as well (see benchmarks/fuzz_tessellation). The canvas tessellates and converts the
+     * output into floats for drawing.
+     * @tparam precision fraction bits
+     * @tparam container_template_type the container template type
+     * @tparam Allocator the memory allocator for the container and tessellation
+     */
+    template <unsigned precision=NITROGL_FIXED_PRECISION,
+              template<typename...> class container_template_type=dynamic_array,
+              class Allocator=nitrogl::std_rebind_allocator<>>
+    using fixed_path = microtess::path<fixed_number<precision>, container_template_type, Allocator>;
 }
\ No newline at end of file
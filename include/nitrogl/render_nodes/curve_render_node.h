@@ -0,0 +1,216 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "edge_aa_render_node.h"
+
+namespace nitrogl {
+
+    /**
+     * node for fills of paths with curves (see microtess::loop_blinn). Triangles of the
+     * interior polygon, with their boundary info, and triangles of quadratic curves are
+     * expanded into one list of triangles, that carry the attributes of edge antialiasing
+     * (see edge_aa_render_node) and the implicit coordinates of the curves, so a fill is one
+     * draw. Interior triangles have constant coordinates inside of the curve, and edges of
+     * curves are not on the outline (see main_shader_program::vertex_kind::curve).
+     * Expansion goes through a fixed chunk on the stack into the buffer, nothing is allocated.
+     *
+     * Usage: render() with the interior triangles and the triangles of the curves
+     */
+    class curve_render_node {
+
+    public:
+        using program_type = main_shader_program;
+        using size_type = GLsizeiptr;
+        using boundary_info = microtess::triangles::boundary_info;
+        struct data_type {
+            const vec2f * vertices;
+            const GLuint * indices;
+            // boundary info per triangle, nullptr for no edge antialiasing
+            const boundary_info * boundaries;
+
+            size_type indices_size;
+            GLenum triangles_type;
+
+            // triangles of curves, 3 vertices each, counter clockwise (y up) if they fill
+            // towards their control point
+            const vec2f * curves;
+            size_type curves_size;
+
+            const mat4f & mat_model;
+            const mat4f & mat_view;
+            const mat4f & mat_proj;
+            const mat3f & mat_uvs_sampler;
+            const gl_texture & backdrop_texture;
+            const GLuint window_width;
+            const GLuint window_height;
+            const float opacity;
+            rectf bbox;
+        };
+
+        // (x, y, edges(3), along edges(3), curve(3)) per vertex
+        static constexpr unsigned floats_per_vertex = 11;
+
+        struct GVA {
+            GVA()=default;
+            nitrogl::generic_vertex_attrib_t data[1];
+            static constexpr unsigned size() { return 1; }
+        };
+        struct EGVA {
+            EGVA()=default;
+            nitrogl::generic_vertex_attrib_t data[2];
+            static constexpr unsigned size() { return 2; }
+        };
+        struct CGVA {
+            CGVA()=default;
+            nitrogl::generic_vertex_attrib_t data[1];
+            static constexpr unsigned size() { return 1; }
+        };
+
+        GVA gva{};
+        EGVA egva{};
+        CGVA cgva{};
+        vbo_t _vbo{};
+        vao_t _vao{};
+
+    private:
+        void point_attributes() const {
+            program_type::point_generic_vertex_attributes(gva.data,
+                      program_type::shader_vertex_attributes().data, GVA::size());
+            program_type::point_generic_vertex_attributes(egva.data,
+                      program_type::edge_vertex_attributes().data, EGVA::size());
+            program_type::point_generic_vertex_attributes(cgva.data,
+                      program_type::curve_vertex_attributes().data, CGVA::size());
+        }
+
+        static GLsizei triangles_count(GLenum type, size_type indices_size) {
+            if(type==GL_TRIANGLES) return GLsizei(indices_size/3);
+            return indices_size>2 ? GLsizei(indices_size-2) : 0;
+        }
+
+    public:
+        curve_render_node()=default;
+        ~curve_render_node()=default;
+
+        void init() {
+            const int STRIDE = floats_per_vertex*sizeof (GLfloat);
+            gva = {{ { 0, GL_FLOAT, 2, OFFSET(0), STRIDE, _vbo.id()} }};
+            egva = {{
+                { 3, GL_FLOAT, 3, OFFSET(2*sizeof (GLfloat)), STRIDE, _vbo.id()},
+                { 4, GL_FLOAT, 3, OFFSET(5*sizeof (GLfloat)), STRIDE, _vbo.id()},
+            }};
+            cgva = {{ { 5, GL_FLOAT, 3, OFFSET(8*sizeof (GLfloat)), STRIDE, _vbo.id()} }};
+#ifdef NITROGL_SUPPORTS_VAO
+            _vao.bind();
+            point_attributes();
+            vao_t::unbind();
+#endif
+        }
+
+        void render(const program_type & program, sampler_t & sampler, const data_type & data) const {
+            const auto & d = data;
+            const GLsizei interior = triangles_count(d.triangles_type, d.indices_size);
+            const GLsizei count = interior + GLsizei(d.curves_size/3);
+            if(count==0) return;
+            NITROGL_PROFILE_BEGIN(uniforms, "curve_render_node::uniforms");
+            program.use();
+            // vertex uniforms
+            program.updateModelMatrix(d.mat_model);
+            program.updateViewMatrix(d.mat_view);
+            program.updateProjectionMatrix(d.mat_proj);
+            program.updateUVsTransformMatrix(d.mat_uvs_sampler, sampler);
+            program.updateBBox(d.bbox.left, d.bbox.top, d.bbox.right, d.bbox.bottom);
+
+            // fragment uniforms
+            program.update_backdrop_texture(d.backdrop_texture);
+            program.update_window_size(d.window_width, d.window_height);
+            program.updateOpacity(d.opacity);
+
+            // sampler uniforms
+            sampler.upload_uniforms(program.id());
+            NITROGL_PROFILE_END(uniforms);
+            NITROGL_PROFILE_BEGIN(buffers, "curve_render_node::buffers");
+            static constexpr GLsizeiptr TRIANGLE_SIZE = 3*floats_per_vertex*sizeof(GLfloat);
+            _vbo.uploadData(nullptr, GLsizeiptr(count)*TRIANGLE_SIZE, GL_STREAM_DRAW);
+            GLfloat chunk[NITROGL_EDGE_AA_CHUNK*3*floats_per_vertex];
+            GLfloat * out = chunk;
+            GLintptr offset = 0;
+            const auto flush = [&]() {
+                const auto bytes = GLuint((out - chunk)*sizeof(GLfloat));
+                if(bytes) _vbo.uploadSubData(offset, chunk, bytes);
+                offset += GLintptr(bytes);
+                out = chunk;
+            };
+            // corners of a triangle, with their implicit coordinates of the curve
+            const auto write = [&](const vec2f * p, const bool * outline,
+                                   const GLfloat (*curve)[2], GLfloat side) {
+                for (unsigned k = 0; k < 3; ++k) {
+                    *(out++)=p[k].x; *(out++)=p[k].y;
+                    out = edge_aa_render_node::write_edges(out, p, outline, k);
+                    *(out++)=curve[k][0]; *(out++)=curve[k][1]; *(out++)=side;
+                }
+                if(out==chunk + sizeof(chunk)/sizeof(GLfloat)) flush();
+            };
+            // u^2-v is -1 over interior triangles, that are always covered
+            static constexpr GLfloat inside[3][2] = { {0.0f, 1.0f}, {0.0f, 1.0f}, {0.0f, 1.0f} };
+            static constexpr GLfloat implicit[3][2] = { {0.0f, 0.0f}, {0.5f, 0.0f}, {1.0f, 1.0f} };
+            const auto * v = d.vertices;
+            const auto * b = d.boundaries;
+            if(interior) {
+                triangles::iterate_triangles(d.indices, GLuint(d.indices_size),
+                                             triangles::indices(d.triangles_type),
+                     [&](GLuint idx, GLuint a, GLuint bb, GLuint c,
+                         GLuint ea, GLuint eb, GLuint ec) {
+                    const auto info = b ? b[idx] : boundary_info(0);
+                    const bool outline[3] = {
+                            microtess::triangles::classify_boundary_info(info, eb),
+                            microtess::triangles::classify_boundary_info(info, ec),
+                            microtess::triangles::classify_boundary_info(info, ea) };
+                    const vec2f p[3] = { v[a], v[bb], v[c] };
+                    write(p, outline, inside, 1.0f);
+                });
+            }
+            // the side is 1 where the fill is between the curve and its chord, and -1 where
+            // it is between the curve and its control point
+            static constexpr bool none[3] = { false, false, false };
+            for (size_type ix = 0; ix + 2 < d.curves_size; ix+=3) {
+                const auto * p = d.curves + ix;
+                const float orientation = (p[1].x-p[0].x)*(p[2].y-p[0].y) -
+                                          (p[1].y-p[0].y)*(p[2].x-p[0].x);
+                write(p, none, implicit, orientation>0.0f ? -1.0f : 1.0f);
+            }
+            flush();
+            NITROGL_PROFILE_END(buffers);
+            NITROGL_PROFILE_BEGIN(draw, "curve_render_node::draw");
+#ifdef NITROGL_SUPPORTS_VAO
+            _vao.bind();
+            glDrawArrays(GL_TRIANGLES, 0, count*3);
+            glCheckError();
+            vao_t::unbind();
+#else
+            point_attributes();
+#ifdef NITROGL_SUPPORTS_INSTANCING
+            // stroke and instanced nodes leave divisors at these locations
+            for (const auto & a : egva.data) { glVertexAttribDivisor(GLuint(a.index), 0); glCheckError(); }
+            for (const auto & a : cgva.data) { glVertexAttribDivisor(GLuint(a.index), 0); glCheckError(); }
+#endif
+            glDrawArrays(GL_TRIANGLES, 0, count*3);
+            glCheckError();
+            program.disableLocations(program_type::curve_vertex_attributes().data, CGVA::size());
+            program.disableLocations(program_type::edge_vertex_attributes().data, EGVA::size());
+            program.disableLocations(program_type::shader_vertex_attributes().data, GVA::size());
+#endif
+            NITROGL_PROFILE_END(draw);
+        }
+
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,394 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+
+#include "../ogl/shader_program.h"
+#include "../ogl/vao.h"
+#include "../ogl/vbo.h"
+#include "../_internal/main_shader_program.h"
+#include "../samplers/sampler.h"
+#include "../triangles.h"
+#include "../math.h"
+#include "../ogl/profiler.h"
+#include "../traits.h"
+
+#ifndef NITROGL_USE_EXTERNAL_MICRO_TESS
+#include "../micro-tess/include/micro-tess/dynamic_array.h"
+#else
+#include <micro-tess/dynamic_array.h>
+#endif
+
+// triangles, that edge antialiasing nodes expand at a time, before they are uploaded. At
+// least 13, a triangle and the fringes of its edges
+#ifndef NITROGL_EDGE_AA_CHUNK
+#define NITROGL_EDGE_AA_CHUNK 256
+#endif
+
+namespace nitrogl {
+
+    /**
+     * node for triangles with edge antialiasing. Indexed triangles and their boundary info
+     * (which edges are on the outline, see microtess::triangles::boundary_info) are expanded
+     * into separate triangles, that carry per vertex barycentric coordinates, and positions
+     * along the edges. Coordinates of edges, that are not on the outline, are held at 1, so
+     * the fragment shader fades only the outline (see main_shader_program::vertex_kind::edge_aa).
+     * Outline edges get a fringe of half a pixel outside of them, so the pixels they cross fade
+     * on both sides of them. Fringes are quads along the edges, that meet at concave vertices
+     * and are joined by miters at convex vertices, so no pixel is drawn twice. Vertices find
+     * their neighbours on the outline in a buffer of the node, that grows with the vertices.
+     * Projective transforms have no fringes, only the inner half of the outline pixels fades.
+     * Expansion goes through a fixed chunk on the stack into the buffer.
+     *
+     * Usage: render() with the triangles and their boundary info
+     */
+    class edge_aa_render_node {
+
+    public:
+        using program_type = main_shader_program;
+        using size_type = GLsizeiptr;
+        using boundary_info = microtess::triangles::boundary_info;
+        struct data_type {
+            const vec2f * vertices;
+            size_type vertices_size;
+            const GLuint * indices;
+            // boundary info per triangle
+            const boundary_info * boundaries;
+
+            size_type indices_size;
+            GLenum triangles_type;
+
+            const mat4f & mat_model;
+            const mat4f & mat_view;
+            const mat4f & mat_proj;
+            const mat3f & mat_uvs_sampler;
+            const gl_texture & backdrop_texture;
+            const GLuint window_width;
+            const GLuint window_height;
+            const float opacity;
+            rectf bbox;
+        };
+
+        // (x, y, edges(3), along edges(3)) per vertex
+        static constexpr unsigned floats_per_vertex = 8;
+
+        struct GVA {
+            GVA()=default;
+            nitrogl::generic_vertex_attrib_t data[1];
+            static constexpr unsigned size() { return 1; }
+        };
+        struct EGVA {
+            EGVA()=default;
+            nitrogl::generic_vertex_attrib_t data[2];
+            static constexpr unsigned size() { return 2; }
+        };
+
+        GVA gva{};
+        EGVA egva{};
+        vbo_t _vbo{};
+        vao_t _vao{};
+
+    private:
+        // width of the fringe and the longest miter, in pixels
+        static constexpr float fringe() { return 0.5f; }
+        static constexpr float max_miter() { return 1.5f; }
+        // two neighbours on the outline per vertex. Free slots are none, and both slots of
+        // vertices with more neighbours (contours that touch) are many
+        enum : GLuint { none = ~GLuint(0), many = ~GLuint(0) - 1 };
+        mutable dynamic_array<GLuint, nitrogl::std_rebind_allocator<>> _neighbours{};
+
+        void point_attributes() const {
+            program_type::point_generic_vertex_attributes(gva.data,
+                      program_type::shader_vertex_attributes().data, GVA::size());
+            program_type::point_generic_vertex_attributes(egva.data,
+                      program_type::edge_vertex_attributes().data, EGVA::size());
+        }
+
+        // position of c along the edge (a, b), 0 at a and 1 at b. Ends of degenerate
+        // edges are anywhere
+        static float along(const vec2f & a, const vec2f & b, const vec2f & c) {
+            const auto ab = b - a;
+            const float length2 = ab.x*ab.x + ab.y*ab.y;
+            if(length2<=0.0f) return 0.5f;
+            const auto ac = c - a;
+            return (ac.x*ab.x + ac.y*ab.y)/length2;
+        }
+
+        static float cross(const vec2f & a, const vec2f & b) { return a.x*b.y - a.y*b.x; }
+
+        // linear part of the map of the plane of the triangles into window pixels
+        struct pixel_map_t {
+            float a, b, c, d;
+            bool affine;
+            vec2f map(const vec2f & v) const { return { a*v.x + b*v.y, c*v.x + d*v.y }; }
+            vec2f unmap(const vec2f & v) const {
+                const float det = a*d - b*c;
+                return { (d*v.x - b*v.y)/det, (a*v.y - c*v.x)/det };
+            }
+        };
+        static pixel_map_t pixel_map(const data_type & d) {
+            const vec2f p[3] = { {0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f} };
+            vec4f q[3];
+            for (unsigned k = 0; k < 3; ++k)
+                q[k] = d.mat_proj*(d.mat_view*(d.mat_model*vec4f{p[k].x, p[k].y, 1.0f, 1.0f}));
+            pixel_map_t m{};
+            m.affine = q[0].w>0.0f && q[0].w==q[1].w && q[0].w==q[2].w;
+            if(!m.affine) return m;
+            const float sx = 0.5f*float(d.window_width)/q[0].w;
+            const float sy = 0.5f*float(d.window_height)/q[0].w;
+            m.a = (q[1].x - q[0].x)*sx; m.b = (q[2].x - q[0].x)*sx;
+            m.c = (q[1].y - q[0].y)*sy; m.d = (q[2].y - q[0].y)*sy;
+            m.affine = m.a*m.d - m.b*m.c!=0.0f;
+            return m;
+        }
+
+        // unit normal of the edge (u, v) away from its left, where the shape is
+        static vec2f outward(const vec2f & u, const vec2f & v) {
+            const auto e = v - u;
+            const float length = math::sqrt(e.x*e.x + e.y*e.y);
+            if(length<=0.0f) return { 0.0f, 0.0f };
+            return { e.y/length, -e.x/length };
+        }
+
+        // the outline turns at v from (u, v) to (v, w), in pixels. Fringes of convex turns end
+        // square and are joined by the miter, other fringes end at the miter, where they meet
+        struct turn_t { bool convex; vec2f miter; };
+        static turn_t turn(const vec2f & u, const vec2f & v, const vec2f & w) {
+            const auto n1 = outward(u, v), n2 = outward(v, w);
+            turn_t t{ cross(v - u, w - v)>0.0f, n1*fringe() };
+            const float det = cross(n1, n2);
+            if(math::abs(det)<=1e-4f) return t;
+            t.miter = vec2f{ n2.y - n1.y, n1.x - n2.x }*(fringe()/det);
+            const float length = math::sqrt(t.miter.x*t.miter.x + t.miter.y*t.miter.y);
+            if(length>max_miter()) t.miter = t.miter*(max_miter()/length);
+            return t;
+        }
+
+        // record u and w as neighbours on the outline
+        void link(GLuint u, GLuint w) const {
+            const GLuint ends[2][2] = { { u, w }, { w, u } };
+            for (const auto & end : ends) {
+                auto * slots = _neighbours.data() + 2*end[0];
+                if(slots[0]==none) slots[0]=end[1];
+                else if(slots[1]==none) slots[1]=end[1];
+                else slots[0]=slots[1]=many;
+            }
+        }
+        // neighbour of v on the outline, other than u
+        GLuint next(GLuint v, GLuint u) const {
+            const auto * slots = _neighbours.data() + 2*v;
+            if(slots[0]==many || slots[1]==none || slots[0]==slots[1]) return none;
+            return slots[0]==u ? slots[1] : (slots[1]==u ? slots[0] : none);
+        }
+
+        static GLsizei triangles_count(GLenum type, size_type indices_size) {
+            if(type==GL_TRIANGLES) return GLsizei(indices_size/3);
+            return indices_size>2 ? GLsizei(indices_size-2) : 0;
+        }
+
+    public:
+        /**
+         * write the edges attributes of a corner of a triangle
+         * @param out where to write 6 floats
+         * @param p corners of the triangle
+         * @param outline is edge k, that is opposite to corner k, on the outline
+         * @param k the corner
+         * @return pointer past the attributes
+         */
+        static GLfloat * write_edges(GLfloat * out, const vec2f * p, const bool * outline, unsigned k) {
+            for (unsigned e = 0; e < 3; ++e)
+                *(out++)=(k==e || !outline[e]) ? 1.0f : 0.0f;
+            // edge e goes from corner e+1 to corner e+2
+            for (unsigned e = 0; e < 3; ++e)
+                *(out++)=!outline[e] ? 0.5f :
+                         along(p[(e+1)%3], p[(e+2)%3], p[k]);
+            return out;
+        }
+
+        /**
+         * write the edges attributes of a point of the fringe of an outline edge of a triangle,
+         * coordinates of the other edges are held at 1
+         * @param out where to write 6 floats
+         * @param p corners of the triangle
+         * @param e the outline edge, that is opposite to corner e
+         * @param c the point
+         * @return pointer past the attributes
+         */
+        static GLfloat * write_fringe_edges(GLfloat * out, const vec2f * p, unsigned e,
+                                            const vec2f & c) {
+            const auto & u = p[(e+1)%3], & w = p[(e+2)%3];
+            const float area = cross(w - u, p[e] - u);
+            for (unsigned k = 0; k < 3; ++k)
+                *(out++)=k!=e || area==0.0f ? 1.0f : cross(w - u, c - u)/area;
+            for (unsigned k = 0; k < 3; ++k)
+                *(out++)=k!=e ? 0.5f : along(u, w, c);
+            return out;
+        }
+
+        edge_aa_render_node()=default;
+        ~edge_aa_render_node()=default;
+
+        void init() {
+            const int STRIDE = floats_per_vertex*sizeof (GLfloat);
+            gva = {{ { 0, GL_FLOAT, 2, OFFSET(0), STRIDE, _vbo.id()} }};
+            egva = {{
+                { 3, GL_FLOAT, 3, OFFSET(2*sizeof (GLfloat)), STRIDE, _vbo.id()},
+                { 4, GL_FLOAT, 3, OFFSET(5*sizeof (GLfloat)), STRIDE, _vbo.id()},
+            }};
+#ifdef NITROGL_SUPPORTS_VAO
+            _vao.bind();
+            point_attributes();
+            vao_t::unbind();
+#endif
+        }
+
+        void render(const program_type & program, sampler_t & sampler, const data_type & data) const {
+            const auto & d = data;
+            const GLsizei count = triangles_count(d.triangles_type, d.indices_size);
+            if(count==0) return;
+            NITROGL_PROFILE_BEGIN(uniforms, "edge_aa_render_node::uniforms");
+            program.use();
+            // vertex uniforms
+            program.updateModelMatrix(d.mat_model);
+            program.updateViewMatrix(d.mat_view);
+            program.updateProjectionMatrix(d.mat_proj);
+            program.updateUVsTransformMatrix(d.mat_uvs_sampler, sampler);
+            program.updateBBox(d.bbox.left, d.bbox.top, d.bbox.right, d.bbox.bottom);
+
+            // fragment uniforms
+            program.update_backdrop_texture(d.backdrop_texture);
+            program.update_window_size(d.window_width, d.window_height);
+            program.updateOpacity(d.opacity);
+
+            // sampler uniforms
+            sampler.upload_uniforms(program.id());
+            NITROGL_PROFILE_END(uniforms);
+            NITROGL_PROFILE_BEGIN(buffers, "edge_aa_render_node::buffers");
+            const auto * v = d.vertices;
+            const auto * b = d.boundaries;
+            const auto type = triangles::indices(d.triangles_type);
+            const auto map = pixel_map(d);
+            // neighbours of vertices on the outline, and the most triangles of the fringes:
+            // a quad per outline edge, and a miter at its end
+            GLsizeiptr fringes = 0;
+            if(map.affine) {
+                _neighbours.clear();
+                _neighbours.reserve(2*d.vertices_size);
+                for (size_type ix = 0; ix < 2*d.vertices_size; ++ix) _neighbours.push_back(none);
+                triangles::iterate_triangles(d.indices, GLuint(d.indices_size), type,
+                     [&](GLuint idx, GLuint a, GLuint bb, GLuint c,
+                         GLuint ea, GLuint eb, GLuint ec) {
+                    const auto info = b[idx];
+                    const GLuint edges[3][3] = { { ea, a, bb }, { eb, bb, c }, { ec, c, a } };
+                    for (const auto & e : edges) {
+                        if(!microtess::triangles::classify_boundary_info(info, e[0])) continue;
+                        link(e[1], e[2]);
+                        fringes+=4;
+                    }
+                });
+            }
+            static constexpr GLsizeiptr TRIANGLE_SIZE = 3*floats_per_vertex*sizeof(GLfloat);
+            _vbo.uploadData(nullptr, (GLsizeiptr(count) + fringes)*TRIANGLE_SIZE,
+                            GL_STREAM_DRAW);
+            GLfloat chunk[NITROGL_EDGE_AA_CHUNK*3*floats_per_vertex];
+            GLfloat * out = chunk;
+            GLintptr offset = 0;
+            const auto flush = [&]() {
+                const auto bytes = GLuint((out - chunk)*sizeof(GLfloat));
+                if(bytes) _vbo.uploadSubData(offset, chunk, bytes);
+                offset += GLintptr(bytes);
+                out = chunk;
+            };
+            const auto write_fringe = [&](const vec2f * p, unsigned e, const vec2f & corner) {
+                *(out++)=corner.x; *(out++)=corner.y;
+                out = write_fringe_edges(out, p, e, corner);
+            };
+            // corners are a, b, c and ea, eb, ec are the boundary edges (a, b), (b, c) and
+            // (c, a). Edge k is the one opposite to corner k, where its coordinate is zero
+            triangles::iterate_triangles(d.indices, GLuint(d.indices_size), type,
+                 [&](GLuint idx, GLuint a, GLuint bb, GLuint c,
+                     GLuint ea, GLuint eb, GLuint ec) {
+                // room for the triangle and the fringes of its three edges
+                if(out + 13*3*floats_per_vertex > chunk + sizeof(chunk)/sizeof(GLfloat)) flush();
+                const auto info = b[idx];
+                const bool outline[3] = {
+                        microtess::triangles::classify_boundary_info(info, eb),
+                        microtess::triangles::classify_boundary_info(info, ec),
+                        microtess::triangles::classify_boundary_info(info, ea) };
+                const GLuint corners[3] = { a, bb, c };
+                const vec2f p[3] = { v[a], v[bb], v[c] };
+                for (unsigned k = 0; k < 3; ++k) {
+                    *(out++)=p[k].x; *(out++)=p[k].y;
+                    out = write_edges(out, p, outline, k);
+                }
+                if(!map.affine) return;
+                const vec2f q[3] = { map.map(p[0]), map.map(p[1]), map.map(p[2]) };
+                for (unsigned e = 0; e < 3; ++e) {
+                    if(!outline[e]) continue;
+                    // the edge (u, w) with the shape on its left
+                    unsigned u = (e+1)%3, w = (e+2)%3;
+                    const float area = cross(q[w] - q[u], q[e] - q[u]);
+                    if(area==0.0f) continue;
+                    if(area<0.0f) { const auto t = u; u = w; w = t; }
+                    const auto n = outward(q[u], q[w]);
+                    const GLuint before = next(corners[u], corners[w]);
+                    const GLuint after = next(corners[w], corners[u]);
+                    const auto square = n*fringe();
+                    auto from = square, to = square;
+                    if(before!=none) {
+                        const auto t = turn(map.map(v[before]), q[u], q[w]);
+                        if(!t.convex) from = t.miter;
+                    }
+                    turn_t end{ false, square };
+                    if(after!=none) {
+                        end = turn(q[u], q[w], map.map(v[after]));
+                        if(!end.convex) to = end.miter;
+                    }
+                    const vec2f pu = p[u], pw = p[w];
+                    const vec2f pu1 = pu + map.unmap(from), pw1 = pw + map.unmap(to);
+                    write_fringe(p, e, pu); write_fringe(p, e, pw); write_fringe(p, e, pw1);
+                    write_fringe(p, e, pu); write_fringe(p, e, pw1); write_fringe(p, e, pu1);
+                    if(!end.convex) continue;
+                    // the miter, halves by the edge before and after the corner
+                    const vec2f next_edge[3] = { pu, pw, v[after] };
+                    const auto square_after = outward(q[w], map.map(v[after]))*fringe();
+                    const vec2f miter = pw + map.unmap(end.miter);
+                    write_fringe(p, e, pw); write_fringe(p, e, pw1); write_fringe(p, e, miter);
+                    write_fringe(next_edge, 0, pw); write_fringe(next_edge, 0, miter);
+                    write_fringe(next_edge, 0, pw + map.unmap(square_after));
+                }
+            });
+            flush();
+            const auto vertices = GLsizei(offset/GLintptr(floats_per_vertex*sizeof(GLfloat)));
+            NITROGL_PROFILE_END(buffers);
+            NITROGL_PROFILE_BEGIN(draw, "edge_aa_render_node::draw");
+#ifdef NITROGL_SUPPORTS_VAO
+            _vao.bind();
+            glDrawArrays(GL_TRIANGLES, 0, vertices);
+            glCheckError();
+            vao_t::unbind();
+#else
+            point_attributes();
+#ifdef NITROGL_SUPPORTS_INSTANCING
+            // stroke and instanced nodes leave divisors at these locations
+            for (const auto & a : egva.data) { glVertexAttribDivisor(GLuint(a.index), 0); glCheckError(); }
+#endif
+            glDrawArrays(GL_TRIANGLES, 0, vertices);
+            glCheckError();
+            program.disableLocations(program_type::edge_vertex_attributes().data, EGVA::size());
+            program.disableLocations(program_type::shader_vertex_attributes().data, GVA::size());
+#endif
+            NITROGL_PROFILE_END(draw);
+        }
+
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "../ogl/shader_program.h"
+#include "../_internal/main_shader_program.h"
+#include "../samplers/sampler.h"
+#include "../ogl/profiler.h"
+#include "../color.h"
+
+namespace nitrogl {
+
+    /**
+     * node for instanced 4 point meshes. A unit quad is drawn once per instance, stretched on
+     * the bounding box of the instance. Every instance carries its transform, the inputs of
+     * the shape sampler and two tints, so a batch of shapes is a single draw call.
+     * Requires instanced arrays (NITROGL_SUPPORTS_INSTANCING), otherwise it does nothing.
+     *
+     * Usage: map_instances(count), write_instance() per instance, unmap_instances() and render()
+     */
+    class instanced_p4_render_node {
+
+    public:
+        using program_type = main_shader_program;
+        using size_type = GLsizeiptr;
+        struct data_type {
+            const mat4f & mat_model;
+            const mat4f & mat_view;
+            const mat4f & mat_proj;
+            const mat3f & mat_uvs_sampler;
+            const gl_texture & backdrop_texture;
+            const GLuint window_width;
+            const GLuint window_height;
+            const float opacity;
+        };
+
+        // (rect(4), transform rows(3x3), inputs(12), fill tint(4), stroke tint(4))
+        static constexpr unsigned max_inputs = 12;
+        static constexpr unsigned floats_per_instance = 4 + 9 + max_inputs + 4 + 4;
+
+        struct GVA {
+            GVA()=default;
+            nitrogl::generic_vertex_attrib_t data[2];
+            static constexpr unsigned size() { return 2; }
+        };
+        struct IGVA {
+            IGVA()=default;
+            nitrogl::generic_vertex_attrib_t data[9];
+            static constexpr unsigned size() { return 9; }
+        };
+
+        GVA gva{};
+        IGVA igva{};
+        vbo_t _vbo_quad{};
+        vbo_t _vbo_instances{};
+        vao_t _vao{};
+        ebo_t _ebo{};
+
+    private:
+        void point_attributes() const {
+            program_type::point_generic_vertex_attributes(gva.data,
+                      program_type::shader_vertex_attributes().data, GVA::size());
+            program_type::point_generic_vertex_attributes(igva.data,
+                      program_type::instance_vertex_attributes().data, IGVA::size());
+#ifdef NITROGL_SUPPORTS_INSTANCING
+            for (const auto & a : igva.data) { glVertexAttribDivisor(GLuint(a.index), 1); glCheckError(); }
+#endif
+        }
+
+    public:
+        instanced_p4_render_node()=default;
+        ~instanced_p4_render_node()=default;
+
+        void init() {
+#ifdef NITROGL_SUPPORTS_INSTANCING
+            // unit quad [(corner x, corner y, u, v) ....], corners are relative to the left-top
+            // of the bounding box. Same vertices order and uvs as p4 rectangles
+            const int STRIDE = 4*sizeof (GLfloat);
+            gva = {{
+                { 0, GL_FLOAT, 2, OFFSET(0), STRIDE, _vbo_quad.id()},
+                { 1, GL_FLOAT, 2, OFFSET(2*sizeof (GLfloat)), STRIDE, _vbo_quad.id()},
+            }};
+            // per instance attributes, interleaved
+            const int I_STRIDE = floats_per_instance*sizeof (GLfloat);
+            const auto at = [](unsigned floats) { return OFFSET(floats*sizeof (GLfloat)); };
+            const auto id = _vbo_instances.id();
+            igva = {{
+                { 3, GL_FLOAT, 4, at(0), I_STRIDE, id},
+                { 4, GL_FLOAT, 3, at(4), I_STRIDE, id},
+                { 5, GL_FLOAT, 3, at(7), I_STRIDE, id},
+                { 6, GL_FLOAT, 3, at(10), I_STRIDE, id},
+                { 7, GL_FLOAT, 4, at(13), I_STRIDE, id},
+                { 8, GL_FLOAT, 4, at(17), I_STRIDE, id},
+                { 9, GL_FLOAT, 4, at(21), I_STRIDE, id},
+                { 10, GL_FLOAT, 4, at(25), I_STRIDE, id},
+                { 11, GL_FLOAT, 4, at(29), I_STRIDE, id},
+            }};
+
+            GLfloat quad[16] = {
+                    0.0f, 1.0f, 0.0f, 0.0f, // left-bottom
+                    1.0f, 1.0f, 1.0f, 0.0f, // right-bottom
+                    1.0f, 0.0f, 1.0f, 1.0f, // right-top
+                    0.0f, 0.0f, 0.0f, 1.0f, // left-top
+            };
+            _vbo_quad.uploadData(quad, sizeof(quad), GL_STATIC_DRAW);
+            // elements buffer
+            GLuint e[6] = { 0, 1, 2, 2, 3, 0 };
+            _vao.bind();
+            _ebo.uploadData(e, sizeof(e), GL_STATIC_DRAW);
+
+#ifdef NITROGL_SUPPORTS_VAO
+            point_attributes();
+            vao_t::unbind();
+#endif
+#endif
+        }
+
+        /**
+         * orphan the instances buffer, and map it for writing of count instances
+         * @return pointer to write into, nullptr if failed
+         */
+        float * map_instances(GLsizei count) const {
+#ifdef NITROGL_SUPPORTS_INSTANCING
+            const auto bytes = GLsizeiptr(count) * GLsizeiptr(floats_per_instance*sizeof(float));
+            _vbo_instances.uploadData(nullptr, bytes, GL_STREAM_DRAW);
+            auto * out = glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes,
+                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            glCheckError();
+            return reinterpret_cast<float *>(out);
+#else
+            return nullptr;
+#endif
+        }
+
+        void unmap_instances() const {
+#ifdef NITROGL_SUPPORTS_INSTANCING
+            _vbo_instances.bind();
+            glUnmapBuffer(GL_ARRAY_BUFFER); glCheckError();
+#endif
+        }
+
+        /**
+         * write an instance into a mapped buffer
+         * @param out where to write
+         * @param left left of bounding box
+         * @param top top of bounding box
+         * @param right right of bounding box
+         * @param bottom bottom of bounding box
+         * @param transform transform of the bounding box
+         * @param inputs inputs of the shape sampler
+         * @param inputs_count count of inputs, no more than max_inputs
+         * @param fill_tint fill tint
+         * @param stroke_tint stroke tint
+         * @return pointer to the next instance
+         */
+        static float * write_instance(float * out,
+                                      float left, float top, float right, float bottom,
+                                      const mat3f & transform,
+                                      const float * inputs, unsigned inputs_count,
+                                      const color_t & fill_tint, const color_t & stroke_tint) {
+            *(out++)=left; *(out++)=top; *(out++)=right; *(out++)=bottom;
+            for (unsigned row = 0; row < 3; ++row)
+                for (unsigned col = 0; col < 3; ++col)
+                    *(out++)=transform(row, col);
+            for (unsigned ix = 0; ix < max_inputs; ++ix)
+                *(out++) = ix < inputs_count ? inputs[ix] : 0.0f;
+            *(out++)=fill_tint.r; *(out++)=fill_tint.g; *(out++)=fill_tint.b; *(out++)=fill_tint.a;
+            *(out++)=stroke_tint.r; *(out++)=stroke_tint.g; *(out++)=stroke_tint.b; *(out++)=stroke_tint.a;
+            return out;
+        }
+
+        void render(const program_type & program, sampler_t & sampler,
+                    const data_type & data, GLsizei count) const {
+#ifdef NITROGL_SUPPORTS_INSTANCING
+            const auto & d = data;
+            NITROGL_PROFILE_BEGIN(uniforms, "instanced_p4_render_node::uniforms");
+            program.use();
+            // vertex uniforms
+            program.updateModelMatrix(d.mat_model);
+            program.updateViewMatrix(d.mat_view);
+            program.updateProjectionMatrix(d.mat_proj);
+            program.updateUVsTransformMatrix(d.mat_uvs_sampler, sampler);
+
+            // fragment uniforms
+            program.update_backdrop_texture(d.backdrop_texture);
+            program.update_window_size(d.window_width, d.window_height);
+            program.updateOpacity(d.opacity);
+
+            // sampler uniforms, shapes inputs are per instance
+            sampler.upload_uniforms(program.id());
+            NITROGL_PROFILE_END(uniforms);
+            NITROGL_PROFILE_BEGIN(draw, "instanced_p4_render_node::draw");
+#ifdef NITROGL_SUPPORTS_VAO
+            _vao.bind();
+            glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, OFFSET(0), count);
+            glCheckError();
+            vao_t::unbind();
+#else
+            _ebo.bind();
+            point_attributes();
+            glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, OFFSET(0), count);
+            glCheckError();
+            // other nodes do not read these locations, the divisors stay
+            program.disableLocations(program_type::shader_vertex_attributes().data, GVA::size());
+            program.disableLocations(program_type::instance_vertex_attributes().data,
+                                     IGVA::size());
+#endif
+            NITROGL_PROFILE_END(draw);
+#endif
+        }
+
+    };
+
+}
\ No newline at end of file
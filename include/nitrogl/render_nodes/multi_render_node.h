@@ -17,6 +17,7 @@
 #include "../_internal/main_shader_program.h"
 #include "../samplers/sampler.h"
 #include "../math.h"
+#include "../ogl/profiler.h"
 
 namespace nitrogl {
 
@@ -88,12 +89,13 @@ namespace nitrogl {
             const bool has_missing_qs = d.qs == nullptr;
             const bool has_missing_indices = d.indices == nullptr || d.indices_size==0;
 
+            NITROGL_PROFILE_BEGIN(uniforms, "multi_render_node::uniforms");
             program.use();
             // vertex uniforms
             program.updateModelMatrix(d.mat_model);
             program.updateViewMatrix(d.mat_view);
             program.updateProjectionMatrix(d.mat_proj);
-            program.updateUVsTransformMatrix(d.mat_uvs_sampler);
+            program.updateUVsTransformMatrix(d.mat_uvs_sampler, sampler);
 
             // fragment uniforms
             program.update_backdrop_texture(d.backdrop_texture);
@@ -106,6 +108,8 @@ namespace nitrogl {
 
             // sampler uniforms
             sampler.upload_uniforms(program.id());
+            NITROGL_PROFILE_END(uniforms);
+            NITROGL_PROFILE_BEGIN(buffers, "multi_render_node::buffers");
 
             static constexpr auto FLOAT_SIZE = GLsizeiptr (sizeof(float));
             static constexpr auto VEC2_SIZE = GLsizeiptr (sizeof(vec2f));
@@ -142,6 +146,8 @@ namespace nitrogl {
             _ebo.uploadData(d.indices, GLsizeiptr(sizeof(GLuint))*d.indices_size,
                             GL_DYNAMIC_DRAW);
 
+            NITROGL_PROFILE_END(buffers);
+            NITROGL_PROFILE_BEGIN(draw, "multi_render_node::draw");
 #ifdef NITROGL_SUPPORTS_VAO
             // VAO binds the: glEnableVertex attribs and pointing vertex attribs to VBO and binds the EBO
             _vao.bind();
@@ -168,8 +174,8 @@ namespace nitrogl {
             program.disableLocations(program_type::shader_vertex_attributes().data,
                                      program_type::shader_vertex_attributes().size());
 #endif
-            // un-use shader
-            shader_program::unuse();
+            // the program stays in use, so the next draw with it does not rebind it
+            NITROGL_PROFILE_END(draw);
         }
 
     };
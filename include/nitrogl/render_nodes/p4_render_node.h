@@ -13,6 +13,7 @@
 #include "../ogl/shader_program.h"
 #include "../_internal/main_shader_program.h"
 #include "../samplers/sampler.h"
+#include "../ogl/profiler.h"
 
 namespace nitrogl {
 
@@ -79,12 +80,13 @@ namespace nitrogl {
 
         void render(const program_type & program, sampler_t & sampler, const data_type & data) const {
             const auto & d = data;
+            NITROGL_PROFILE_BEGIN(uniforms, "p4_render_node::uniforms");
             program.use();
             // vertex uniforms
             program.updateModelMatrix(d.mat_model);
             program.updateViewMatrix(d.mat_view);
             program.updateProjectionMatrix(d.mat_proj);
-            program.updateUVsTransformMatrix(d.mat_uvs_sampler);
+            program.updateUVsTransformMatrix(d.mat_uvs_sampler, sampler);
             program.update_has_missing_uvs(false);
             program.update_has_missing_qs(false);
 
@@ -95,6 +97,8 @@ namespace nitrogl {
 
             // sampler uniforms
             sampler.upload_uniforms(program.id());
+            NITROGL_PROFILE_END(uniforms);
+            NITROGL_PROFILE_BEGIN(buffers, "p4_render_node::buffers");
 
             static constexpr auto FLOAT_SIZE = GLsizeiptr (sizeof(float));
             // upload data
@@ -102,6 +106,8 @@ namespace nitrogl {
                                        d.size*FLOAT_SIZE,
                                        GL_DYNAMIC_DRAW);
 
+            NITROGL_PROFILE_END(buffers);
+            NITROGL_PROFILE_BEGIN(draw, "p4_render_node::draw");
 #ifdef NITROGL_SUPPORTS_VAO
             // VAO binds the: glEnableVertex attribs and pointing vertex attribs to VBO and binds the EBO
             _vao.bind();
@@ -118,8 +124,8 @@ namespace nitrogl {
             program.disableLocations(program_type::shader_vertex_attributes().data,
                                      program_type::shader_vertex_attributes().size());
 #endif
-            // unuse shader
-            shader_program::unuse();
+            // the program stays in use, so the next draw with it does not rebind it
+            NITROGL_PROFILE_END(draw);
         }
 
     };
@@ -0,0 +1,184 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+
+#include "../ogl/shader_program.h"
+#include "../ogl/vao.h"
+#include "../ogl/vbo.h"
+#include "../ogl/ebo.h"
+#include "../_internal/main_shader_program.h"
+#include "../samplers/sampler.h"
+#include "../math.h"
+#include "../ogl/profiler.h"
+
+#ifndef NITROGL_USE_EXTERNAL_MICRO_TESS
+#include "../micro-tess/include/micro-tess/bezier_patch_tesselator.h"
+#include "../micro-tess/include/micro-tess/dynamic_array.h"
+#else
+#include <micro-tess/bezier_patch_tesselator.h>
+#include <micro-tess/dynamic_array.h>
+#endif
+
+// parametric grids, that bezier patches nodes keep, one per resolution
+#ifndef NITROGL_PATCH_GRIDS
+#define NITROGL_PATCH_GRIDS 4
+#endif
+
+namespace nitrogl {
+
+    /**
+     * node for bezier patches, that are evaluated on the GPU. A (u, v) grid of the resolution,
+     * and its triangles strip are uploaded once, and are kept for the next draws (the least
+     * recently used grid is replaced). Control points are uniforms, so a patch, that changes
+     * every frame, uploads only them.
+     *
+     * Usage: render() with the control points and the resolution
+     */
+    class patch_render_node {
+
+    public:
+        using program_type = main_shader_program;
+        using size_type = GLsizeiptr;
+        struct data_type {
+            // order*order control points (x, y), row after row
+            const float * points;
+            int order;
+            GLuint u_samples, v_samples;
+            float u0, v0, u1, v1;
+
+            const mat4f & mat_model;
+            const mat4f & mat_view;
+            const mat4f & mat_proj;
+            const mat3f & mat_uvs_sampler;
+            const gl_texture & backdrop_texture;
+            const GLuint window_width;
+            const GLuint window_height;
+            const float opacity;
+        };
+
+        struct GVA {
+            GVA()=default;
+            nitrogl::generic_vertex_attrib_t data[1];
+            static constexpr unsigned size() { return 1; }
+        };
+
+        struct grid_type {
+            GLuint u_samples=0, v_samples=0;
+            GLsizei indices_size=0;
+            // last use, for replacing the least recently used
+            unsigned long used=0;
+            vbo_t vbo=vbo_t::from_id(0);
+            ebo_t ebo=ebo_t::from_id(0);
+            vao_t vao=vao_t::from_id(0);
+            GVA gva{};
+        };
+
+    private:
+        grid_type _grids[NITROGL_PATCH_GRIDS];
+        unsigned long _clock=0;
+
+        static void point_attributes(const grid_type & grid) {
+            program_type::point_generic_vertex_attributes(grid.gva.data,
+                      program_type::shader_vertex_attributes().data, GVA::size());
+        }
+
+        // find the grid of the resolution, or replace the least recently used with it
+        template<class Allocator>
+        const grid_type & grid(GLuint u_samples, GLuint v_samples, const Allocator & allocator) {
+            grid_type * lru = _grids;
+            ++_clock;
+            for (auto & g : _grids) {
+                if(g.u_samples==u_samples && g.v_samples==v_samples) {
+                    g.used = _clock;
+                    return g;
+                }
+                if(g.used < lru->used) lru = &g;
+            }
+            NITROGL_PROFILE_SCOPE("patch_render_node::grid");
+            using rebind_alloc_t1 = typename Allocator::template rebind<float>::other;
+            using rebind_alloc_t2 = typename Allocator::template rebind<GLuint>::other;
+            using uvs_t = dynamic_array<float, rebind_alloc_t1>;
+            using indices_t = dynamic_array<GLuint, rebind_alloc_t2>;
+            uvs_t uvs{rebind_alloc_t1(allocator)};
+            indices_t indices{rebind_alloc_t2(allocator)};
+            // uvs only, of the unit window, same vertices and strip as the CPU tessellation
+            using tess = microtess::bezier_patch_tesselator<float, float, uvs_t, indices_t>;
+            microtess::triangles::indices type;
+            tess::template compute<microtess::patch_type::BI_CUBIC>(nullptr, 2, u_samples, v_samples,
+                          false, true, uvs, indices, type, 0.0f, 0.0f, 1.0f, 1.0f);
+            auto & g = *lru;
+            if(!g.vbo.wasGenerated()) {
+                g.vbo = vbo_t(); g.ebo = ebo_t(); g.vao = vao_t();
+                g.gva = {{ { 0, GL_FLOAT, 2, OFFSET(0), 0, g.vbo.id() } }};
+            }
+            g.u_samples = u_samples; g.v_samples = v_samples; g.used = _clock;
+            g.indices_size = GLsizei(indices.size());
+            g.vbo.uploadData(uvs.data(), GLsizeiptr(uvs.size()*sizeof(float)), GL_STATIC_DRAW);
+#ifdef NITROGL_SUPPORTS_VAO
+            g.vao.bind();
+            g.ebo.uploadData(indices.data(), GLsizeiptr(indices.size()*sizeof(GLuint)),
+                             GL_STATIC_DRAW);
+            point_attributes(g);
+            vao_t::unbind();
+#else
+            g.ebo.uploadData(indices.data(), GLsizeiptr(indices.size()*sizeof(GLuint)),
+                             GL_STATIC_DRAW);
+#endif
+            return g;
+        }
+
+    public:
+        patch_render_node()=default;
+        ~patch_render_node()=default;
+
+        void init() {}
+
+        template<class Allocator>
+        void render(const program_type & program, sampler_t & sampler, const data_type & data,
+                    const Allocator & allocator) {
+            const auto & d = data;
+            const auto & g = grid(d.u_samples, d.v_samples, allocator);
+            NITROGL_PROFILE_BEGIN(uniforms, "patch_render_node::uniforms");
+            program.use();
+            // vertex uniforms
+            program.updateModelMatrix(d.mat_model);
+            program.updateViewMatrix(d.mat_view);
+            program.updateProjectionMatrix(d.mat_proj);
+            program.updateUVsTransformMatrix(d.mat_uvs_sampler, sampler);
+            program.updatePatch(d.points, d.order, d.u0, d.v0, d.u1, d.v1);
+
+            // fragment uniforms
+            program.update_backdrop_texture(d.backdrop_texture);
+            program.update_window_size(d.window_width, d.window_height);
+            program.updateOpacity(d.opacity);
+
+            // sampler uniforms
+            sampler.upload_uniforms(program.id());
+            NITROGL_PROFILE_END(uniforms);
+            NITROGL_PROFILE_BEGIN(draw, "patch_render_node::draw");
+#ifdef NITROGL_SUPPORTS_VAO
+            g.vao.bind();
+            glDrawElements(GL_TRIANGLE_STRIP, g.indices_size, GL_UNSIGNED_INT, OFFSET(0));
+            glCheckError();
+            vao_t::unbind();
+#else
+            g.ebo.bind();
+            point_attributes(g);
+            glDrawElements(GL_TRIANGLE_STRIP, g.indices_size, GL_UNSIGNED_INT, OFFSET(0));
+            glCheckError();
+#endif
+            NITROGL_PROFILE_END(draw);
+        }
+
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+
+#include "../ogl/shader_program.h"
+#include "../ogl/vao.h"
+#include "../ogl/vbo.h"
+#include "../_internal/main_shader_program.h"
+#include "../samplers/sampler.h"
+#include "../math.h"
+#include "../ogl/profiler.h"
+
+// triangles of round joins and caps of strokes, that are expanded on the GPU
+#ifndef NITROGL_STROKE_ROUND_SEGMENTS
+#define NITROGL_STROKE_ROUND_SEGMENTS 16
+#endif
+
+namespace nitrogl {
+
+    /**
+     * node for strokes, that are expanded on the GPU. Polylines are uploaded padded with their
+     * neighbours, and every segment is an instance, that reads four consecutive points (the
+     * point before, the segment and the point after). The vertex shader expands it into a
+     * quad and a join or a cap, so the width and the transform are only uniforms.
+     * Dashed strokes also upload the arc lengths at the points, and the fragments are covered
+     * by the dash pattern, so the pattern and its offset are only uniforms too.
+     * Requires instanced arrays (NITROGL_SUPPORTS_INSTANCING), otherwise it does nothing.
+     *
+     * Usage: upload_points(points, count), upload_lengths(lengths, count) if dashed, then
+     * render() ranges of polylines in them
+     */
+    class stroke_render_node {
+
+    public:
+        using program_type = main_shader_program;
+        // padded polyline in the points, first point and count of segments
+        struct range_type {
+            GLint first;
+            GLsizei segments;
+        };
+        struct data_type {
+            const range_type * ranges;
+            GLsizei ranges_size;
+            // half width, miter limit, join and cap of the stroke, triangles per fan
+            float half_width, miter_limit;
+            int join, cap, fan;
+            // ends of the dashes and gaps in a period, no dashes if count is 0
+            const float * dashes;
+            int dashes_size;
+            float dash_offset;
+
+            const mat4f & mat_model;
+            const mat4f & mat_view;
+            const mat4f & mat_proj;
+            const mat3f & mat_uvs_sampler;
+            const gl_texture & backdrop_texture;
+            const GLuint window_width;
+            const GLuint window_height;
+            const float opacity;
+            rectf bbox;
+        };
+
+        struct SGVA {
+            SGVA()=default;
+            nitrogl::generic_vertex_attrib_t data[5];
+            static constexpr unsigned size() { return 5; }
+        };
+
+        // triangles of a segment: the quad and the fan at its end
+        static GLsizei vertices_per_segment(int fan) { return 3*(2 + fan); }
+
+        SGVA sgva{};
+        vbo_t _vbo_points{};
+        vbo_t _vbo_lengths{};
+        vao_t _vao{};
+
+    private:
+        void point_attributes(GLint first, bool dashed) {
+#ifdef NITROGL_SUPPORTS_INSTANCING
+            // four views of the same points, one point apart, and the lengths at the start
+            // and the end of the segment, that overlap the ones of the next segment
+            const auto id = _vbo_points.id();
+            const auto at = [first](unsigned k) { return OFFSET((first + k)*sizeof (vec2f)); };
+            sgva = {{
+                { 3, GL_FLOAT, 2, at(0), 0, id},
+                { 4, GL_FLOAT, 2, at(1), 0, id},
+                { 5, GL_FLOAT, 2, at(2), 0, id},
+                { 6, GL_FLOAT, 2, at(3), 0, id},
+                { 7, GL_FLOAT, 2, OFFSET((first + 1)*sizeof (GLfloat)), sizeof (GLfloat),
+                  _vbo_lengths.id()},
+            }};
+            const auto size = dashed ? SGVA::size() : SGVA::size() - 1;
+            program_type::point_generic_vertex_attributes(sgva.data,
+                      program_type::stroke_vertex_attributes().data, size);
+            for (unsigned ix = 0; ix < size; ++ix) {
+                glVertexAttribDivisor(GLuint(sgva.data[ix].index), 1); glCheckError();
+            }
+            // solid strokes do not read the lengths
+            if(!dashed) { glDisableVertexAttribArray(7); glCheckError(); }
+#endif
+        }
+
+    public:
+        stroke_render_node()=default;
+        ~stroke_render_node()=default;
+
+        void init() {}
+
+        // upload the padded points of the polylines
+        void upload_points(const vec2f * points, GLsizeiptr count) const {
+            _vbo_points.uploadData(points, count*GLsizeiptr(sizeof(vec2f)), GL_STREAM_DRAW);
+        }
+
+        // upload the arc lengths at the padded points, for dashed strokes
+        void upload_lengths(const float * lengths, GLsizeiptr count) const {
+            _vbo_lengths.uploadData(lengths, count*GLsizeiptr(sizeof(float)), GL_STREAM_DRAW);
+        }
+
+        void render(const program_type & program, sampler_t & sampler, const data_type & data) {
+#ifdef NITROGL_SUPPORTS_INSTANCING
+            const auto & d = data;
+            NITROGL_PROFILE_BEGIN(uniforms, "stroke_render_node::uniforms");
+            program.use();
+            // vertex uniforms
+            program.updateModelMatrix(d.mat_model);
+            program.updateViewMatrix(d.mat_view);
+            program.updateProjectionMatrix(d.mat_proj);
+            program.updateUVsTransformMatrix(d.mat_uvs_sampler, sampler);
+            program.updateBBox(d.bbox.left, d.bbox.top, d.bbox.right, d.bbox.bottom);
+            program.updateStroke(d.half_width, d.miter_limit, d.join, d.cap, d.fan);
+            program.updateStrokeDashes(d.dashes, d.dashes_size, d.dash_offset,
+                                       d.half_width, d.cap);
+
+            // fragment uniforms
+            program.update_backdrop_texture(d.backdrop_texture);
+            program.update_window_size(d.window_width, d.window_height);
+            program.updateOpacity(d.opacity);
+
+            // sampler uniforms
+            sampler.upload_uniforms(program.id());
+            NITROGL_PROFILE_END(uniforms);
+            NITROGL_PROFILE_BEGIN(draw, "stroke_render_node::draw");
+#ifdef NITROGL_SUPPORTS_VAO
+            _vao.bind();
+#endif
+            for (GLsizei ix = 0; ix < d.ranges_size; ++ix) {
+                const auto & range = d.ranges[ix];
+                if(range.segments<=0) continue;
+                point_attributes(range.first, d.dashes_size!=0);
+                glDrawArraysInstanced(GL_TRIANGLES, 0, vertices_per_segment(d.fan), range.segments);
+                glCheckError();
+            }
+#ifdef NITROGL_SUPPORTS_VAO
+            vao_t::unbind();
+#else
+            // other nodes do not read these locations, the divisors stay
+            program.disableLocations(program_type::stroke_vertex_attributes().data,
+                                     SGVA::size());
+#endif
+            NITROGL_PROFILE_END(draw);
+#endif
+        }
+
+    };
+
+}
\ No newline at end of file
@@ -77,6 +77,18 @@ namespace nitrogl {
 
         }
 
+        bool fold_constant(color_t & result) const override {
+            const auto & info = sub_sampler(0)->resolved()->traversal_info();
+            if(!info.is_constant) return false;
+            const float v = nitrogl::channels::value_of(channel, info.constant);
+            result = { v, v, v, v };
+            return true;
+        }
+
+        bool uv_window(float & u0, float & v0, float & u1, float & v1) override {
+            return sub_sampler(0)->resolved()->uv_window(u0, v0, u1, v1);
+        }
+
         void on_cache_uniforms_locations(GLuint program) override {
         }
 
@@ -34,6 +34,11 @@ namespace nitrogl {
 )";
         }
 
+        bool fold_constant(color_t & result) const override {
+            result = color;
+            return true;
+        }
+
         void on_cache_uniforms_locations(GLuint program) override {
         }
 
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <nitrogl/samplers/sampler.h>
+#include <nitrogl/samplers/gradients/gradient_ramps.h>
 #include <nitrogl/color.h>
 #include <nitrogl/math/vertex2.h>
 #include <nitrogl/traits.h>
@@ -22,14 +23,20 @@ namespace nitrogl {
      * Angular Gradient sampler.
      *
      * Notes:
-     * - Can hold up to 10 colors
+     * - Can hold any amount of colors
+     * - Stops are baked into a shared ramp texture, sampling is a single fetch
      */
     struct angular_gradient : public sampler_t {
-        const char * name() const override { return "line_gradient"; }
+        using stop_t = gradient_ramps::stop_t;
+        const char * name() const override { return "angular_gradient"; }
         const char * uniforms() const override {
             return R"(
 {
-    float inputs[15*6+5];
+    // from radian, to radian
+    vec2 interval;
+    // u offset, u scale, v of row
+    vec3 ramp;
+    sampler2D ramp_texture;
 }
 )";
         }
@@ -37,65 +44,17 @@ namespace nitrogl {
         const char * main() const override {
             return R"(
 (in vec3 uv) {
-    //////////////
-    // main input
-    //////////////
-    // how many slots are occupied
-    int count = int(data.inputs[0]);
-    int window_size = int(data.inputs[1]);
-    int offset = int(data.inputs[2]);
-    int from_rad = int(data.inputs[3]);
-    int to_rad = int(data.inputs[4]);
-    vec2 p = uv.xy - 0.5f;
-
-#define IDX(a) (offset + (a) * (window_size))
 #define PI 3.14159
-
-    //
-    int pos = 0;
+    vec2 p = uv.xy - 0.5;
     float angle = -atan(p.t, -p.s) + PI;
-    float distance_to_closest_stop = 0.0;
-    for (pos=0; pos<count; ++pos) {
-        int idx = IDX(pos);
-        // distance to this angular stop
-        float d = clamp(angle, from_rad, to_rad) - data.inputs[idx+0];
-        if(d<0) break;
-        distance_to_closest_stop=d;
-    }
-
-    pos=(pos-1 + count) % count;
-    int l_idx = IDX(pos);
-    int r_idx = IDX((pos+1)% count);
-    float segment_length= data.inputs[r_idx+1];
-    float factor= distance_to_closest_stop/segment_length;
-    float edge0 = 1.0f;//1.0f-0.05;
-    float edge1 = 1.0f;
-//    factor = 0.0;//clamp((factor - edge0) / (edge1 - edge0), 0.0, 1.0);
-//    factor= smoothstep(1.0-1./10., 1.0,  factor);
-//    factor= mix(0.0, 1.0, factor);
-//    factor= step(0.5, abs(factor));
-//    float factor= 1.0;//step(0.0, 1.0, distance_to_closest_stop/segment_length);
-    vec4 col_l = vec4(data.inputs[l_idx+2], data.inputs[l_idx+3],
-                      data.inputs[l_idx+4], data.inputs[l_idx+5]);
-    vec4 col_r = vec4(data.inputs[r_idx+2], data.inputs[r_idx+3],
-                      data.inputs[r_idx+4], data.inputs[r_idx+5]);
-    vec4 final = mix(col_l, col_r, factor);
-    return final;
+    float from = data.interval.x, to = data.interval.y;
+    float t = (clamp(angle, from, to) - from)/(to - from);
+    // clamp to edge of the ramp texture extends the edge colors
+    return TEXTURE_2D(data.ramp_texture, vec2(data.ramp.x + t*data.ramp.y, data.ramp.z));
 }
 )";
         }
 
-    private:
-        static constexpr int window_size() {
-            return  6;
-        }
-        static constexpr int offset() {
-            // [0]=index, [1]=window_size, [2]=offset
-            return  5;
-        }
-        constexpr int overall_size() const {
-            return  offset() + _index*window_size();
-        }
     public:
 
         static angular_gradient from_rainbow(float from_deg_radian=0.0f,
@@ -122,73 +81,43 @@ namespace nitrogl {
         }
 
         void on_upload_uniforms_request(GLuint program) override {
-            // minus the where float
-            float inputs[5 + 6*15];
-            inputs[0] = float(_index);
-            inputs[1] = float(window_size()); // window size
-            inputs[2] = float(offset()); // window size
-            inputs[3] = float(_interval.x); // from radian
-            inputs[4] = float(_interval.y); // to radian
-            for (int ix = 0; ix < _index; ++ix) {
-                const auto & stop = _stops[ix];
-                int jx = offset() + ix * window_size();
-                inputs[jx + 0] = stop.angle;
-                inputs[jx + 1] = stop.segment_length;
-                inputs[jx + 2] = stop.color.r;
-                inputs[jx + 3] = stop.color.g;
-                inputs[jx + 4] = stop.color.b;
-                inputs[jx + 5] = stop.color.a;
-            }
-            GLint loc_inputs = get_uniform_location(program, "inputs");
-            glUniform1fv(loc_inputs, overall_size(), inputs);
+            auto & ramps = gradient_ramps::shared();
+            const int row = ramps.request(_stops.data(), _stops.size());
+            const auto & tex = ramps.texture();
+            tex.use(tex.slot());
+            glUniform1i(get_uniform_location(program, "ramp_texture"), tex.slot());
+            glUniform2f(get_uniform_location(program, "interval"), _interval.x, _interval.y);
+            glUniform3f(get_uniform_location(program, "ramp"), gradient_ramps::u_offset(),
+                        gradient_ramps::u_scale(), gradient_ramps::v_of(row));
         }
 
-        struct stop_t {
-            float angle=0.0f, where=0.0f;
-            float segment_length=10000.0f;
-            color_t color{};
-        };
-
         void setNewInterval(const vec2f & interval) {
             _interval= interval;
-            const auto how_many = _index;
-            reset();
-            for (int ix = 0; ix < how_many; ++ix)
-                addStop(_stops[ix].where, _stops[ix].color);
         }
 
         void updateStop(int index, float where, color_t color) {
-            if(index>_index) {
+            if(index<0 || index>stops()) {
 #ifndef NITROGL_DISABLE_THROW
                 struct out_of_range{};
                 throw out_of_range{};
 #endif
                 return;
             }
-
-            auto & stop = _stops[index];
-
-            stop.where = where;
-            stop.angle = _interval.x + where * (_interval.y-_interval.x);
-            stop.color = color;
-
-            if(index>0) {
-                stop.segment_length = (stop.angle-_stops[index-1].angle);
-            }
+            if(index==stops()) _stops.push_back(stop_t());
+            _stops[index].where = where;
+            _stops[index].color = color;
         }
 
         void addStop(float where, color_t color) {
-            updateStop(_index, where, color);
-            ++_index;
+            updateStop(stops(), where, color);
         }
-        int stops() const { return _index; }
+        int stops() const { return int(_stops.size()); }
 
-        void reset() { _index=0; }
+        void reset() { _stops.clear(); }
 
     private:
         vec2f _interval;
-        int _index = 0;
-        stop_t _stops[15] {};
+        gradient_ramps::stops_t _stops;
 
     public:
         explicit angular_gradient(float from_deg_radian=0.0f, float to_deg_radian=2.0f*nitrogl::math::pi<float>()) :
@@ -0,0 +1,156 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include <nitrogl/ogl/gl_texture.h>
+#include <nitrogl/color.h>
+#include <nitrogl/traits.h>
+#include <nitrogl/_internal/murmur.h>
+#include <nitrogl/_internal/bits_robin_lru_pool.h>
+
+#ifndef NITROGL_USE_EXTERNAL_MICRO_TESS
+#include "../../micro-tess/include/micro-tess/dynamic_array.h"
+#else
+#include <micro-tess/dynamic_array.h>
+#endif
+
+// the amount of texels in every ramp (row of the atlas)
+#ifndef NITROGL_GRADIENT_RAMP_WIDTH
+#define NITROGL_GRADIENT_RAMP_WIDTH 256
+#endif
+
+namespace nitrogl {
+
+    /**
+     * Gradient Ramps Atlas.
+     * Gradients bake their color stops into a row of a shared RGBA texture, so sampling
+     * a gradient is a single texture fetch with the computed parameter t in [0..1].
+     *
+     * Notes:
+     * - Rows are cached by a hash of the stops, so equal gradients share a row
+     * - Least recently used rows are re-baked when the atlas is full
+     * - All gradients share the same texture (and slot), therefore they also share shaders
+     * - Colors are stored un-multiplied alpha, same as samplers output
+     */
+    class gradient_ramps {
+    public:
+        struct stop_t {
+            float where=0.0f;
+            color_t color{};
+        };
+        // stops of a gradient grow on the heap, the shader cost does not depend on
+        // their amount, because stops are baked into a ramp texture
+        using stops_t = dynamic_array<stop_t, nitrogl::std_rebind_allocator<>>;
+        static constexpr int ramp_width = NITROGL_GRADIENT_RAMP_WIDTH;
+        static constexpr int rows_bits = 8;
+        static constexpr int rows = 1<<rows_bits;
+
+    private:
+        using rows_pool_t = microc::bits_robin_lru_pool<rows_bits, nitrogl::uintptr_type,
+                                                        nitrogl::std_rebind_allocator<>>;
+        rows_pool_t _rows;
+        gl_texture _texture;
+
+        static unsigned char to_byte(float v) {
+            v = v<0.0f ? 0.0f : (v>1.0f ? 1.0f : v);
+            return (unsigned char)(v*255.0f + 0.5f);
+        }
+
+        gradient_ramps() : _rows(1.0f),
+                _texture(gl_texture::empty(ramp_width, rows, GL_RGBA, false, 1,
+                                           GL_LINEAR, GL_LINEAR,
+                                           GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE)) {}
+
+    public:
+        gradient_ramps(const gradient_ramps &)=delete;
+        gradient_ramps & operator=(const gradient_ramps &)=delete;
+
+        // atlas is shared by all gradients, create it lazily when a context is available
+        static gradient_ramps & shared() {
+            static gradient_ramps ramps;
+            return ramps;
+        }
+
+        /**
+         * hash a sequence of stops. Colors are quantized to the ramp precision, so
+         * visually identical gradients map to the same row
+         */
+        static nitrogl::uintptr_type hash_of(const stop_t * stops, unsigned count) {
+            microc::iterative_murmur<nitrogl::uintptr_type> murmur;
+            murmur.begin(count);
+            for (unsigned ix = 0; ix < count; ++ix) {
+                const auto & s = stops[ix];
+                const nitrogl::uintptr_type rgba = (nitrogl::uintptr_type(to_byte(s.color.r))<<24) |
+                        (nitrogl::uintptr_type(to_byte(s.color.g))<<16) |
+                        (nitrogl::uintptr_type(to_byte(s.color.b))<<8) |
+                        nitrogl::uintptr_type(to_byte(s.color.a));
+                murmur.next(nitrogl::uintptr_type(int(s.where*65535.0f)));
+                murmur.next(rgba);
+            }
+            return murmur.end();
+        }
+
+        /**
+         * bake stops into a row of texels, stops are assumed to be sorted by position.
+         * Outside the stops range, the edge colors are extended.
+         */
+        static void bake(const stop_t * stops, unsigned count, unsigned char * texels) {
+            for (int ix = 0; ix < ramp_width; ++ix) {
+                const float t = float(ix)/float(ramp_width-1);
+                color_t c {0.0f, 0.0f, 0.0f, 0.0f};
+                if(count) {
+                    unsigned pos = 0;
+                    for (; pos < count && stops[pos].where <= t; ++pos) {}
+                    if(pos==0) c = stops[0].color;
+                    else if(pos==count) c = stops[count-1].color;
+                    else {
+                        const auto & l = stops[pos-1], & r = stops[pos];
+                        const float len = r.where-l.where;
+                        const float f = len>0.0f ? (t-l.where)/len : 1.0f;
+                        c = { l.color.r + (r.color.r-l.color.r)*f, l.color.g + (r.color.g-l.color.g)*f,
+                              l.color.b + (r.color.b-l.color.b)*f, l.color.a + (r.color.a-l.color.a)*f };
+                    }
+                }
+                texels[ix*4+0] = to_byte(c.r); texels[ix*4+1] = to_byte(c.g);
+                texels[ix*4+2] = to_byte(c.b); texels[ix*4+3] = to_byte(c.a);
+            }
+        }
+
+        /**
+         * get the row of the stops, bake and upload it if it is not in the atlas
+         * @param stops stops array
+         * @param count amount of stops
+         * @return row index
+         */
+        int request(const stop_t * stops, unsigned count) {
+            const auto res = _rows.get_or_put(hash_of(stops, count));
+            if(!res.is_active) {
+                unsigned char texels[ramp_width*4];
+                bake(stops, count, texels);
+                _texture.updateSubImage(0, res.value, ramp_width, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                                        texels, 1);
+            }
+            return res.value;
+        }
+
+        /**
+         * mapping of (t, row) into texture coords of texels centers:
+         * uv = (u_offset + t*u_scale, v_of(row))
+         */
+        static constexpr float u_offset() { return 0.5f/float(ramp_width); }
+        static constexpr float u_scale() { return float(ramp_width-1)/float(ramp_width); }
+        static constexpr float v_of(int row) { return (float(row)+0.5f)/float(rows); }
+
+        const gl_texture & texture() const { return _texture; }
+        int size() const { return _rows.size(); }
+    };
+
+}
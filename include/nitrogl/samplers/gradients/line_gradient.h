@@ -11,11 +11,11 @@
 #pragma once
 
 #include <nitrogl/samplers/sampler.h>
+#include <nitrogl/samplers/gradients/gradient_ramps.h>
 #include <nitrogl/color.h>
 #include <nitrogl/math/vertex2.h>
 #include <nitrogl/traits.h>
-#include <nitrogl/functions/distance.h>
-#include <nitrogl/_internal/string_utils.h>
+#include <nitrogl/math.h>
 
 namespace nitrogl {
 
@@ -23,15 +23,21 @@ namespace nitrogl {
      * A Gradient sampler.
      *
      * Notes:
-     * - Can hold up to 10 colors
+     * - Can hold any amount of colors
+     * - Stops are baked into a shared ramp texture, sampling is a single fetch
      * - You can also change rotation
      */
     struct line_gradient : public sampler_t {
+        using stop_t = gradient_ramps::stop_t;
         const char * name() const override { return "line_gradient"; }
         const char * uniforms() const override {
             return R"(
 {
-    float inputs[10*8+3];
+    // a*x + b*y + c = t
+    vec3 line;
+    // u offset, u scale, v of row
+    vec3 ramp;
+    sampler2D ramp_texture;
 }
 )";
         }
@@ -39,143 +45,55 @@ namespace nitrogl {
         const char * main() const override {
             return R"(
 (in vec3 uv) {
-    //////////////
-    // main input
-    //////////////
-    // how many slots are occupied
-    int count = int(data.inputs[0]);
-    int window_size = int(data.inputs[1]);
-    int offset = int(data.inputs[2]);
-    vec2 p = (uv.xy);
-
-#define IDX(a) (offset + (a) * (window_size))
-
-    //
-    int pos = 0;
-    float distance = 0.0;
-    for (pos=0; pos<count; ++pos) {
-        int idx = IDX(pos);
-        // a*x + b*y + c
-        float d = data.inputs[idx+0]*p.x + data.inputs[idx+1]*p.y + data.inputs[idx+2];
-        if(d<0) break;
-        distance=d;
-    }
-    if(pos==count) {
-        int idx = IDX(count-1);
-        return vec4(data.inputs[idx+4], data.inputs[idx+5], data.inputs[idx+6], data.inputs[idx+7]);
-    } else if(pos==0) {
-        int idx = offset;
-        return vec4(data.inputs[idx+4], data.inputs[idx+5], data.inputs[idx+6], data.inputs[idx+7]);
-    }
-
-    int l_idx = IDX(pos-1);
-    int r_idx = l_idx + window_size;
-    float l_inverse= data.inputs[r_idx+3];
-//    float factor= distance/l_inverse;
-    float factor= distance/l_inverse;
-    vec4 col_l = vec4(data.inputs[l_idx+4], data.inputs[l_idx+5], data.inputs[l_idx+6], data.inputs[l_idx+7]);
-    vec4 col_r = vec4(data.inputs[r_idx+4], data.inputs[r_idx+5], data.inputs[r_idx+6], data.inputs[r_idx+7]);
-    vec4 final = mix(col_l, col_r, factor);
-    return final;
-//    return vec4(p.y,p.y,p.y,1.0);
+    float t = dot(data.line, vec3(uv.xy, 1.0));
+    // clamp to edge of the ramp texture extends the edge colors
+    return TEXTURE_2D(data.ramp_texture, vec2(data.ramp.x + t*data.ramp.y, data.ramp.z));
 }
 )";
         }
 
-    private:
-        constexpr int window_size() const {
-            // minus the where float
-            return  8;
-        }
-        constexpr int offset() const {
-            // [0]=index, [1]=window_size, [2]=offset
-            return  3;
-        }
-        constexpr int overall_size() const {
-            return  offset() + _index*window_size();
-        }
-    public:
-
         void on_cache_uniforms_locations(GLuint program) override {
         }
 
         void on_upload_uniforms_request(GLuint program) override {
-            // minus the where float
-            float inputs[3 + 8*10];
-            inputs[0] = _index;
-            inputs[1] = window_size(); // window size
-            inputs[2] = offset(); // window size
-            for (int ix = 0; ix < _index; ++ix) {
-                const auto & stop = _stops[ix];
-                int jx = offset() + ix * window_size();
-                inputs[jx + 0] = stop.a;
-                inputs[jx + 1] = stop.b;
-                inputs[jx + 2] = stop.c;
-                inputs[jx + 3] = stop.length_inverse;
-                inputs[jx + 4] = stop.color.r;
-                inputs[jx + 5] = stop.color.g;
-                inputs[jx + 6] = stop.color.b;
-                inputs[jx + 7] = stop.color.a;
-            }
-            GLint loc_inputs = get_uniform_location(program, "inputs");
-            glUniform1fv(loc_inputs, overall_size(), inputs);
+            auto & ramps = gradient_ramps::shared();
+            const int row = ramps.request(_stops.data(), _stops.size());
+            const auto & tex = ramps.texture();
+            tex.use(tex.slot());
+            glUniform1i(get_uniform_location(program, "ramp_texture"), tex.slot());
+            glUniform3f(get_uniform_location(program, "line"), _a, _b, _c);
+            glUniform3f(get_uniform_location(program, "ramp"), gradient_ramps::u_offset(),
+                        gradient_ramps::u_scale(), gradient_ramps::v_of(row));
         }
 
     public:
 
-        struct stop_t {
-            float where=0.0f;
-            // inverse length of the segment from this stop and the next stop
-            float length_inverse=0.0f;
-            float a=0.0f, b=0.0f, c=0.0f;
-            color_t color{};
-
-            void updateLine(const vec2f & p, vec2f n) {
-                // normalize the normal
-                n = n/nitrogl::functions::length(n);
-                a=n.x, b=n.y, c= -(n.dot(p));
-            }
-        };
-
         void setNewLine(const vec2f & start, const vec2f & end) {
             _start= start; _end= end;
-            const auto how_many = _index;
-            reset();
-            for (int ix = 0; ix < how_many; ++ix)
-                addStop(_stops[ix].where, _stops[ix].color);
+            // t is the projection of a point on the line, normalized by its length
+            const auto dir = _end-_start;
+            const float l2 = dir.dot(dir);
+            const float l2_inv = l2==0.0f ? 0.0f : 1.0f/l2;
+            _a = dir.x*l2_inv; _b = dir.y*l2_inv; _c = -(_start.dot(dir))*l2_inv;
         }
 
         void updateStop(int index, float where, color_t color) {
-            if(index>_index) {
+            if(index<0 || index>stops()) {
 #ifndef NITROGL_DISABLE_THROW
                 struct out_of_range{};
                 throw out_of_range{};
 #endif
                 return;
             }
-
-            const auto dir = _end-_start;
-            const auto p_w = _start + (_end-_start) * where;
-            auto & stop = _stops[index];
-
-            stop.updateLine(p_w, dir);
-            stop.where = where;
-            stop.color = color;
-
-            if(index>0) {
-                float l = (stop.where-_stops[index-1].where)*nitrogl::functions::length(dir);
-                stop.length_inverse= l;
-                //                stop.a *= l;
-                //                stop.b *= l;
-                //                stop.c *= l;
-            }
+            if(index==stops()) _stops.push_back(stop_t());
+            _stops[index].where = where;
+            _stops[index].color = color;
         }
 
         void addStop(float where, color_t color) {
-            updateStop(_index, where, color);
-            ++_index;
+            updateStop(stops(), where, color);
         }
-        int stops() const { return _index; }
+        int stops() const { return int(_stops.size()); }
         void rotate(float angle_radians, vec2f center = vec2f(0.5f, 0.5f)) {
             auto a = _start - center;
             auto b = _end - center;
@@ -195,12 +113,12 @@ namespace nitrogl {
             setNewLine(a_new, b_new);
         }
 
-        void reset() { _index=0; }
+        void reset() { _stops.clear(); }
 
     private:
         vec2f _start, _end;
-        int _index = 0;
-        stop_t _stops[10] {};
+        float _a=0.0f, _b=0.0f, _c=0.0f;
+        gradient_ramps::stops_t _stops;
 
     public:
         explicit line_gradient(const vec2f & start = vec2f(0.0f, 0.5f),
@@ -0,0 +1,51 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include <nitrogl/samplers/sampler.h>
+#include <nitrogl/traits.h>
+
+namespace nitrogl {
+
+    /**
+     * Tint a sampler with a color of the instance, that is being drawn. This sampler
+     * is valid only inside instanced draws, where the tints are per instance attributes.
+     * Same as tint_sampler otherwise.
+     */
+    struct instance_tint_sampler : public multi_sampler<1> {
+        using base = multi_sampler<1>;
+        const char * name() const override { return "instance_tint_sampler"; }
+
+        const char * main() const override {
+            // fill tint or stroke tint
+            return tint_index==0 ? R"(
+(in vec3 uv) {
+    return sampler_00(uv)*PS_instance_tint_0;
+}
+)" : R"(
+(in vec3 uv) {
+    return sampler_00(uv)*PS_instance_tint_1;
+}
+)";
+        }
+
+        bool uv_window(float & u0, float & v0, float & u1, float & v1) override {
+            return sub_sampler(0)->resolved()->uv_window(u0, v0, u1, v1);
+        }
+
+        // 0 for the fill tint, 1 for the stroke tint of the instance. Tints are per instance
+        // attributes, so the sampler has no uniforms
+        unsigned tint_index;
+
+        explicit instance_tint_sampler(unsigned tint_index, sampler_t * sampler) :
+                base(sampler), tint_index(tint_index) {}
+    };
+}
\ No newline at end of file
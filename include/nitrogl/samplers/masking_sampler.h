@@ -86,7 +86,7 @@ namespace nitrogl {
 (in vec3 uv) {
     vec4 base = sampler_00(uv);
     vec4 mask = sampler_01(uv);
-    base.a *= (mask.b);
+    base.a *= (1.0 - mask.b);
     return base;
 })";
                 case channel_t::alpha_channel_inverted:
@@ -101,6 +101,24 @@ namespace nitrogl {
 
         }
 
+        sampler_t * fold_identity() const override {
+            // masking with an opaque or a constant full mask
+            const auto & mask = sub_sampler(1)->resolved()->traversal_info();
+            if(channel==channel_t::alpha_channel && mask.opaque) return sub_sampler(0);
+            if(mask.is_constant && nitrogl::channels::value_of(channel, mask.constant)==1.0f)
+                return sub_sampler(0);
+            return nullptr;
+        }
+
+        bool fold_constant(color_t & result) const override {
+            const auto & base = sub_sampler(0)->resolved()->traversal_info();
+            const auto & mask = sub_sampler(1)->resolved()->traversal_info();
+            if(!(base.is_constant && mask.is_constant)) return false;
+            result = base.constant;
+            result.a *= nitrogl::channels::value_of(channel, mask.constant);
+            return true;
+        }
+
         void on_cache_uniforms_locations(GLuint program) override {
         }
 
@@ -29,6 +29,25 @@ namespace nitrogl {
             )";
         }
 
+        sampler_t * fold_identity() const override {
+            // mixing a sampler with itself
+            return sub_sampler(0)->resolved()==sub_sampler(1)->resolved() ? sub_sampler(0) : nullptr;
+        }
+
+        bool fold_constant(color_t & result) const override {
+            const auto & a = sub_sampler(0)->resolved()->traversal_info();
+            const auto & b = sub_sampler(1)->resolved()->traversal_info();
+            if(!(a.is_constant && b.is_constant)) return false;
+            result = { (a.constant.r + b.constant.r)/2.0f, (a.constant.g + b.constant.g)/2.0f,
+                       (a.constant.b + b.constant.b)/2.0f, (a.constant.a + b.constant.a)/2.0f };
+            return true;
+        }
+
+        bool is_opaque() const override {
+            return sub_sampler(0)->resolved()->traversal_info().opaque &&
+                   sub_sampler(1)->resolved()->traversal_info().opaque;
+        }
+
 //        color_sampler sampler_1{1., 0.0, 0.0, 1.0};
 //        color_sampler sampler_2{0.0, 1.0, 0.0, 1.0};
 
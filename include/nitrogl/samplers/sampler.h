@@ -14,6 +14,7 @@
 #include "../_internal/string_utils.h"
 #include "../_internal/murmur.h"
 #include "../ogl/debug.h"
+#include "../color.h"
 
 namespace nitrogl {
 
@@ -22,6 +23,11 @@ namespace nitrogl {
         struct traversal_info_t {
             int id;
             bool visited;
+            // results of the fold pass
+            sampler_t * identity; // sampler we pass through, nullptr if none
+            bool is_constant; // output does not depend on uv, it is the constant below
+            bool opaque; // output alpha is always 1
+            color_t constant;
 
             const char * id_str() const {
                 return nitrogl::numbers_99_db::get(id);
@@ -32,10 +38,9 @@ namespace nitrogl {
     protected:
         struct no_more_than_999_samplers_allowed {};
         struct no_more_than_99_samplers_allowed {};
-        struct location_of_uniform_not_found {};
         unsigned int _sub_samplers_count;
 
-        sampler_t() : _sub_samplers_count(0), _traversal_info{-1, false},
+        sampler_t() : _sub_samplers_count(0), _traversal_info{-1, false, nullptr, false, false, {}},
                         intrinsic_width(0.0f), intrinsic_height(0.0f) {
         }
 
@@ -46,6 +51,39 @@ namespace nitrogl {
         traversal_info_t & traversal_info() {
             return _traversal_info;
         }
+        const traversal_info_t & traversal_info() const {
+            return _traversal_info;
+        }
+
+        /**
+         * the sampler that actually gets composited in place of this one, after
+         * identity wrappers were dropped by the fold pass of generate_traversal
+         */
+        sampler_t * resolved() {
+            return _traversal_info.identity ? _traversal_info.identity->resolved() : this;
+        }
+        const sampler_t * resolved() const {
+            return _traversal_info.identity ? _traversal_info.identity->resolved() : this;
+        }
+
+        /**
+         * A constant folded sampler is composited with this code, and is uploaded with
+         * the folded color. Every constant sub-tree therefore shares the same shader code.
+         */
+        static const char * folded_uniforms() {
+            return R"(
+{
+    vec4 color;
+}
+)";
+        }
+        static const char * folded_main() {
+            return R"(
+(in vec3 uv) {
+    return data.color;
+}
+)";
+        }
         GLint get_uniform_location(GLuint program, const char * name) const {
             static char s[50] {0};
             auto i = _traversal_info.id_str();
@@ -59,10 +97,9 @@ namespace nitrogl {
                 *next=c;
             }
             *next='\0'; // add null termination
+            // -1 if the uniform is not active, i.e. the composition ignores the source
+            // (Clear, Destination) and the compiler dropped the sampler. GL ignores it
             const auto loc = glGetUniformLocation(program, s); glCheckError();
-#ifndef NITROGL_DISABLE_THROW
-            if(loc==-1) throw location_of_uniform_not_found();
-#endif
             return loc;
         }
         virtual ~sampler_t()=default;
@@ -80,32 +117,112 @@ namespace nitrogl {
         virtual const char * other_functions() const { return nullptr; }
         virtual const char * main() const = 0;
         void cache_uniforms_locations(GLuint program) {
+            auto * s = resolved();
+            if(s!=this) { s->cache_uniforms_locations(program); return; }
+            if(_traversal_info.is_constant) return;
             const auto ssc = sub_samplers_count();
             for (unsigned ix = 0; ix < ssc; ++ix)
                 sub_sampler(ix)->cache_uniforms_locations(program);
             on_cache_uniforms_locations(program);
         };
         void upload_uniforms(GLuint program) {
+            auto * s = resolved();
+            if(s!=this) { s->upload_uniforms(program); return; }
+            if(_traversal_info.is_constant) {
+                const auto & c = _traversal_info.constant;
+                glUniform4f(get_uniform_location(program, "color"), c.r, c.g, c.b, c.a);
+                return;
+            }
             const auto ssc = sub_samplers_count();
             for (unsigned ix = 0; ix < ssc; ++ix)
                 sub_sampler(ix)->upload_uniforms(program);
             on_upload_uniforms_request(program);
         };
 
+        /**
+         * hash code of the code of this sampler, sub samplers should be hashed with
+         * tree_hash_code(), so folded sub-trees hash the same as their shader code
+         */
         virtual nitrogl::uintptr_type hash_code() const {
             microc::iterative_murmur<nitrogl::uintptr_type> murmur;
             murmur.begin_cast(main());
             const auto ssc = sub_samplers_count();
             for (unsigned int ix = 0; ix < ssc; ++ix)
-                murmur.next(sub_sampler(ix)->hash_code());
+                murmur.next(sub_sampler(ix)->tree_hash_code());
             return murmur.end();
         }
 
+        /**
+         * hash code of the folded tree, rooted at this sampler. Valid after generate_traversal
+         */
+        nitrogl::uintptr_type tree_hash_code() const {
+            const auto * s = resolved();
+            if(s->_traversal_info.is_constant) {
+                microc::iterative_murmur<nitrogl::uintptr_type> murmur;
+                return murmur.begin_cast(folded_main()).end();
+            }
+            return s->hash_code();
+        }
+
+        /**
+         * Fold hooks, consulted bottom-up by generate_traversal before stitching, at which
+         * point the sub samplers were already folded and their traversal_info() is valid.
+         * - fold_identity: return a sub sampler, if this sampler outputs it as is
+         * - fold_constant: return true and write the output, if it does not depend on uv
+         * - is_opaque: return true, if output alpha is always 1
+         */
+        virtual sampler_t * fold_identity() const { return nullptr; }
+        virtual bool fold_constant(color_t &) const { return false; }
+        virtual bool is_opaque() const { return false; }
+
+        /**
+         * window (u0, v0, u1, v1) of uv space this sampler samples, for samplers of an atlas
+         * entry. The render nodes map the draw uvs into it through the uvs transform, it is only
+         * honored for the root sampler (after folding) or through wrappers that forward it.
+         * @return false if the sampler samples the whole uv space
+         */
+        virtual bool uv_window(float &, float &, float &, float &) { return false; }
+
+        /**
+         * change of uvs per one canvas pixel along x and y, reported by the canvas before every
+         * draw where it is constant (affine draws with computed uvs), zeros if unknown. Samplers
+         * can select a mip level with it. Forwarded to the sub samplers by default.
+         */
+        virtual void on_uvs_derivatives(float du_dx, float dv_dx, float du_dy, float dv_dy) {
+            const auto ssc = sub_samplers_count();
+            for (unsigned ix = 0; ix < ssc; ++ix)
+                if(sub_sampler(ix)) sub_sampler(ix)->on_uvs_derivatives(du_dx, dv_dx, du_dy, dv_dy);
+        }
+
         virtual sampler_t * const * sub_samplers() const { return nullptr; }
         virtual sampler_t ** sub_samplers() { return nullptr; }
         virtual void on_cache_uniforms_locations(GLuint program) {};
         virtual void on_upload_uniforms_request(GLuint program) {}
-        virtual unsigned int generate_traversal(unsigned int id) {
+        /**
+         * fold the tree and then number the folded tree bottom-up, so equal folded trees
+         * get equal ids and therefore equal shader code
+         */
+        unsigned int generate_traversal(unsigned int id) {
+            fold();
+            return resolved()->enumerate(id);
+        }
+
+    private:
+        void fold() {
+            const auto ssc = sub_samplers_count();
+            for (unsigned int ix = 0; ix < ssc; ++ix)
+                sub_sampler(ix)->fold();
+            auto & info = _traversal_info;
+            info.identity = fold_identity();
+            info.is_constant = !info.identity && fold_constant(info.constant);
+            info.opaque = info.identity ? info.identity->resolved()->_traversal_info.opaque :
+                    (info.is_constant ? info.constant.a>=1.0f : is_opaque());
+        }
+
+        unsigned int enumerate(unsigned int id) {
+            const auto ssc = _traversal_info.is_constant ? 0 : sub_samplers_count();
+            for (unsigned int ix = 0; ix < ssc; ++ix)
+                id = sub_sampler(ix)->resolved()->enumerate(id);
             _traversal_info.id=id;
             _traversal_info.visited=false;
             if(id > 99) {
@@ -144,12 +261,5 @@ namespace nitrogl {
             return *this;
         }
 
-        unsigned int generate_traversal(unsigned int id) override {
-            const auto ssc = sub_samplers_count();
-            for (unsigned int ix = 0; ix < ssc; ++ix)
-                id = sub_sampler(ix)->generate_traversal(id);
-            return sampler_t::generate_traversal(id);
-        }
-
     };
 }
\ No newline at end of file
@@ -41,16 +41,16 @@ namespace nitrogl {
     /////////////
     // inputs
     /////////////
-    vec2 a = vec2(data.inputs[0], data.inputs[1]);
-    vec2 b = vec2(data.inputs[2], data.inputs[3]);
-    float r = data.inputs[4];
-    float rb = data.inputs[5];
+    vec2 a = vec2(__SHAPE_INPUT(data.inputs, 0), __SHAPE_INPUT(data.inputs, 1));
+    vec2 b = vec2(__SHAPE_INPUT(data.inputs, 2), __SHAPE_INPUT(data.inputs, 3));
+    float r = __SHAPE_INPUT(data.inputs, 4);
+    float rb = __SHAPE_INPUT(data.inputs, 5);
     // stroke width,  divide by 2
-    float sw = data.inputs[6]/2.0;
+    float sw = __SHAPE_INPUT(data.inputs, 6)/2.0;
     // aa fill and stroke, mul by 2 for more beautiful
-    bool is_convex = data.inputs[7]>0;
-    float aa_fill = data.inputs[8]*2.0;
-    float aa_stroke = data.inputs[9]*2.0;
+    bool is_convex = __SHAPE_INPUT(data.inputs, 7)>0;
+    float aa_fill = __SHAPE_INPUT(data.inputs, 8)*2.0;
+    float aa_stroke = __SHAPE_INPUT(data.inputs, 9)*2.0;
     vec2 p = uv.xy - vec2(0.5f);
 
     /////////////
@@ -109,28 +109,43 @@ namespace nitrogl {
         }
 
         void on_upload_uniforms_request(GLuint program) override {
+            // instanced draws pass the inputs per instance
+            if(per_instance) return;
+            float inputs[inputs_count];
+            get_inputs(inputs);
+            GLint loc_inputs = get_uniform_location(program, "inputs");
+            glUniform1fv(loc_inputs, inputs_count, inputs);
+        }
+
+    public:
+        static constexpr unsigned inputs_count = 10;
+
+        /**
+         * write the inputs of the shader, that are uploaded as uniforms or per instance
+         */
+        void get_inputs(float * inputs) const {
             // normalized angle unit vectors
             const auto two_pi = nitrogl::math::pi<float>()*2.0f;
-            from_angle = nitrogl::math::mod(from_angle, two_pi);
-            to_angle = nitrogl::math::mod(to_angle, two_pi);
+            const float from = nitrogl::math::mod(from_angle, two_pi);
+            const float to = nitrogl::math::mod(to_angle, two_pi);
 
-            float ax = nitrogl::math::cos(from_angle);
-            float ay = nitrogl::math::sin(from_angle);
-            float bx = nitrogl::math::cos(to_angle);
-            float by = nitrogl::math::sin(to_angle);
+            float ax = nitrogl::math::cos(from);
+            float ay = nitrogl::math::sin(from);
+            float bx = nitrogl::math::cos(to);
+            float by = nitrogl::math::sin(to);
 
             float is_convex = (ax*by - ay*bx); // b is left-of a
-            float inputs[10] = { ax, ay, bx, by, radius, radius_b, stroke_width,
-                                 is_convex, aa_fill, aa_stroke };
-            GLint loc_inputs = get_uniform_location(program, "inputs");
-            glUniform1fv(loc_inputs, 10, inputs);
+            inputs[0]=ax; inputs[1]=ay; inputs[2]=bx; inputs[3]=by;
+            inputs[4]=radius; inputs[5]=radius_b; inputs[6]=stroke_width;
+            inputs[7]=is_convex; inputs[8]=aa_fill; inputs[9]=aa_stroke;
         }
 
-    public:
         float radius, radius_b;
         float stroke_width;
         float aa_fill, aa_stroke;
         float from_angle, to_angle;
+        // instanced draws pass the inputs per instance, instead of uniforms
+        bool per_instance;
 
         /**
          *
@@ -148,9 +163,11 @@ namespace nitrogl {
                     float from_angle, float to_angle,
                     float radius=0.5f, float radius_b = 0.1f,float stroke_width=0.01f,
                     float aa_fill=0.01f, float aa_stroke=0.01f) :
-                        from_angle(from_angle), to_angle(to_angle),
+                        base(fill, stroke),
                         radius(radius), radius_b(radius_b), stroke_width(stroke_width),
-                             aa_fill(aa_fill), aa_stroke(aa_stroke), base(fill, stroke) {
+                             aa_fill(aa_fill), aa_stroke(aa_stroke),
+                             from_angle(from_angle), to_angle(to_angle),
+                             per_instance(false) {
         }
     };
 }
\ No newline at end of file
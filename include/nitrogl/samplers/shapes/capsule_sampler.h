@@ -39,14 +39,14 @@ namespace nitrogl {
     /////////////
     // inputs
     /////////////
-    vec2 a = vec2(data.inputs[0], data.inputs[1]);
-    vec2 b = vec2(data.inputs[2], data.inputs[3]);
-    float r = data.inputs[4];
+    vec2 a = vec2(__SHAPE_INPUT(data.inputs, 0), __SHAPE_INPUT(data.inputs, 1));
+    vec2 b = vec2(__SHAPE_INPUT(data.inputs, 2), __SHAPE_INPUT(data.inputs, 3));
+    float r = __SHAPE_INPUT(data.inputs, 4);
     // stroke width,  divide by 2
-    float sw = data.inputs[5]/2.0;
+    float sw = __SHAPE_INPUT(data.inputs, 5)/2.0;
     // aa fill and stroke, mul by 2 for more beautiful
-    float aa_fill = data.inputs[6]*2.0;
-    float aa_stroke = data.inputs[7]*2.0;
+    float aa_fill = __SHAPE_INPUT(data.inputs, 6)*2.0;
+    float aa_stroke = __SHAPE_INPUT(data.inputs, 7)*2.0;
     vec2 p = uv.xy;//-0.5f;
 
     /////////////
@@ -82,16 +82,31 @@ namespace nitrogl {
         }
 
         void on_upload_uniforms_request(GLuint program) override {
-            float inputs[8] = { p0.x, p0.y, p1.x, p1.y, radius, stroke_width, aa_fill, aa_stroke };
+            // instanced draws pass the inputs per instance
+            if(per_instance) return;
+            float inputs[inputs_count];
+            get_inputs(inputs);
             GLint loc_inputs = get_uniform_location(program, "inputs");
-            glUniform1fv(loc_inputs, 8, inputs);
+            glUniform1fv(loc_inputs, inputs_count, inputs);
         }
 
     public:
+        static constexpr unsigned inputs_count = 8;
+
+        /**
+         * write the inputs of the shader, that are uploaded as uniforms or per instance
+         */
+        void get_inputs(float * inputs) const {
+            inputs[0]=p0.x; inputs[1]=p0.y; inputs[2]=p1.x; inputs[3]=p1.y;
+            inputs[4]=radius; inputs[5]=stroke_width; inputs[6]=aa_fill; inputs[7]=aa_stroke;
+        }
+
         vec2f p0, p1;
         float radius;
         float stroke_width;
         float aa_fill, aa_stroke;
+        // instanced draws pass the inputs per instance, instead of uniforms
+        bool per_instance;
 
         /**
          *
@@ -109,8 +124,10 @@ namespace nitrogl {
                         const vec2f & p0, const vec2f & p1,
                         float radius=0.5f, float stroke_width=0.01f,
                         float aa_fill=0.01f, float aa_stroke=0.01f) :
+                            base(fill, stroke),
                             p0(p0), p1(p1), radius(radius), stroke_width(stroke_width),
-                             aa_fill(aa_fill), aa_stroke(aa_stroke), base(fill, stroke) {
+                             aa_fill(aa_fill), aa_stroke(aa_stroke),
+                             per_instance(false) {
         }
     };
 }
\ No newline at end of file
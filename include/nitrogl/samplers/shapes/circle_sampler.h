@@ -40,12 +40,12 @@ namespace nitrogl {
     // inputs
     /////////////
     // radius
-    float r = data.inputs[0];
+    float r = __SHAPE_INPUT(data.inputs, 0);
     // stroke width,  divide by 2
-    float sw = data.inputs[1]/2.0;
+    float sw = __SHAPE_INPUT(data.inputs, 1)/2.0;
     // aa fill and stroke, mul by 2 for more beautiful
-    float aa_fill = data.inputs[2]*2.0;
-    float aa_stroke = data.inputs[3]*2.0;
+    float aa_fill = __SHAPE_INPUT(data.inputs, 2)*2.0;
+    float aa_stroke = __SHAPE_INPUT(data.inputs, 3)*2.0;
 
     /////////////
     // SDF function
@@ -79,22 +79,37 @@ namespace nitrogl {
         }
 
         void on_upload_uniforms_request(GLuint program) override {
-            float inputs[4] = { radius, stroke_width, aa_fill, aa_stroke };
+            // instanced draws pass the inputs per instance
+            if(per_instance) return;
+            float inputs[inputs_count];
+            get_inputs(inputs);
             GLint loc_inputs = get_uniform_location(program, "inputs");
-            glUniform1fv(loc_inputs, 4, inputs);
+            glUniform1fv(loc_inputs, inputs_count, inputs);
         }
 
     public:
+        static constexpr unsigned inputs_count = 4;
+
+        /**
+         * write the inputs of the shader, that are uploaded as uniforms or per instance
+         */
+        void get_inputs(float * inputs) const {
+            inputs[0]=radius; inputs[1]=stroke_width; inputs[2]=aa_fill; inputs[3]=aa_stroke;
+        }
+
         float radius;
         float stroke_width;
         float aa_fill, aa_stroke;
+        // instanced draws pass the inputs per instance, instead of uniforms
+        bool per_instance;
 
         explicit circle_sampler(sampler_t * fill, sampler_t * stroke,
                                 float radius=0.5f, float stroke_width=0.01f,
                                 float aa_fill=0.01f, float aa_stroke=0.01f) :
+                        base(fill, stroke),
                         radius(radius), stroke_width(stroke_width), aa_fill(aa_fill),
                         aa_stroke(aa_stroke),
-                        base(fill, stroke) {
+                        per_instance(false) {
         }
     };
 }
\ No newline at end of file
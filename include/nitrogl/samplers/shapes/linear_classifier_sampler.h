@@ -63,6 +63,11 @@ namespace nitrogl {
 )";
         }
 
+        sampler_t * fold_identity() const override {
+            // both sides are the same sampler
+            return sub_sampler(0)->resolved()==sub_sampler(1)->resolved() ? sub_sampler(0) : nullptr;
+        }
+
         void on_cache_uniforms_locations(GLuint program) override {
         }
 
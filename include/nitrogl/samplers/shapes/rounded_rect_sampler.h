@@ -46,13 +46,13 @@ namespace nitrogl {
     /////////////
     // inputs
     /////////////
-    vec2 a = vec2(data.inputs[0], data.inputs[1])/2.0;
-    float r = data.inputs[2]/1.0;
+    vec2 a = vec2(__SHAPE_INPUT(data.inputs, 0), __SHAPE_INPUT(data.inputs, 1))/2.0;
+    float r = __SHAPE_INPUT(data.inputs, 2)/1.0;
     // stroke width,  divide by 2
-    float sw = data.inputs[3]/2.0;
+    float sw = __SHAPE_INPUT(data.inputs, 3)/2.0;
     // aa fill and stroke, mul by 2 for more beautiful
-    float aa_fill = data.inputs[4]*2.0;
-    float aa_stroke = data.inputs[5]*2.0;
+    float aa_fill = __SHAPE_INPUT(data.inputs, 4)*2.0;
+    float aa_stroke = __SHAPE_INPUT(data.inputs, 5)*2.0;
 
     /////////////
     // SDF function
@@ -87,16 +87,31 @@ namespace nitrogl {
         }
 
         void on_upload_uniforms_request(GLuint program) override {
-            float inputs[6] = { w, h, radius, stroke_width, aa_fill, aa_stroke };
+            // instanced draws pass the inputs per instance
+            if(per_instance) return;
+            float inputs[inputs_count];
+            get_inputs(inputs);
             GLint loc_inputs = get_uniform_location(program, "inputs");
-            glUniform1fv(loc_inputs, 6, inputs);
+            glUniform1fv(loc_inputs, inputs_count, inputs);
         }
 
     public:
+        static constexpr unsigned inputs_count = 6;
+
+        /**
+         * write the inputs of the shader, that are uploaded as uniforms or per instance
+         */
+        void get_inputs(float * inputs) const {
+            inputs[0]=w; inputs[1]=h; inputs[2]=radius;
+            inputs[3]=stroke_width; inputs[4]=aa_fill; inputs[5]=aa_stroke;
+        }
+
         float w, h;
         float radius;
         float stroke_width;
         float aa_fill, aa_stroke;
+        // instanced draws pass the inputs per instance, instead of uniforms
+        bool per_instance;
 
         /**
          *
@@ -114,8 +129,10 @@ namespace nitrogl {
                              float w, float h,
                              float radius=0.5f, float stroke_width=0.01f,
                              float aa_fill=0.01f, float aa_stroke=0.01f) :
+                             base(fill, stroke),
                              w(w), h(h), radius(radius), stroke_width(stroke_width),
-                             aa_fill(aa_fill), aa_stroke(aa_stroke), base(fill, stroke) {
+                             aa_fill(aa_fill), aa_stroke(aa_stroke),
+                             per_instance(false) {
         }
     };
 }
\ No newline at end of file
@@ -12,13 +12,29 @@
 
 #include <nitrogl/samplers/sampler.h>
 #include <nitrogl/traits.h>
+#include <nitrogl/math.h>
 #include <nitrogl/ogl/gl_texture.h>
+#include <nitrogl/ogl/texture_atlas.h>
 
 namespace nitrogl {
 
+    /**
+     * Samples a texture or an entry of a texture atlas. Samplers of entries of the same
+     * atlas share the same shader and texture binding, the entry is focused through the
+     * uvs transform.
+     * With canvas_lod, the mip level is computed on the client from the uvs derivatives
+     * the canvas reports for affine draws, and it is sampled explicitly (+lod_bias).
+     */
     struct texture_sampler : public sampler_t {
         const char * name() const override { return "texture_sampler"; }
         const char * uniforms() const override {
+            if(canvas_lod)
+                return R"(
+{
+    sampler2D texture;
+    float lod;
+}
+)";
             return R"(
 {
     sampler2D texture;
@@ -40,6 +56,25 @@ namespace nitrogl {
         }
 
         const char * main() const override {
+            // lod < 0 means the canvas could not compute it, so it is implicit
+            if(canvas_lod) {
+                if(texture.is_premul_alpha())
+                    return R"(
+(in vec3 uv) {
+    vec4 tex = data.lod < 0.0 ? TEXTURE_2D(data.texture, uv.xy) :
+                                TEXTURE_2D_LOD(data.texture, uv.xy, data.lod);
+    tex.rgb/=tex.a;
+    return clamp(tex, 0.0, 1.0);
+}
+)";
+                else
+                    return R"(
+(in vec3 uv) {
+    return data.lod < 0.0 ? TEXTURE_2D(data.texture, uv.xy) :
+                            TEXTURE_2D_LOD(data.texture, uv.xy, data.lod);
+}
+)";
+            }
             if(texture.is_premul_alpha())
                 return R"(
 (in vec3 uv) {
@@ -56,28 +91,84 @@ namespace nitrogl {
 )";
         }
 
+        bool is_opaque() const override {
+            // formats without alpha sample alpha as 1
+            const auto f = texture.internalFormat();
+            return f==GL_RGB || f==GL_RG || f==GL_RED;
+        }
+
+        bool uv_window(float & u0, float & v0, float & u1, float & v1) override {
+            if(!atlas) return false;
+            // an evicted entry samples the transparent texel of the atlas
+            if(!atlas->uv_window(handle, u0, v0, u1, v1))
+                atlas->transparent_uv_window(u0, v0, u1, v1);
+            return true;
+        }
+
         void on_cache_uniforms_locations(GLuint program) override {
         }
 
+        /**
+         * mip level from the uvs derivatives, same as the GL spec computes it:
+         * lod = log2(max(|d(uv)/dx|, |d(uv)/dy|)), in texels units
+         */
+        void on_uvs_derivatives(float du_dx, float dv_dx, float du_dy, float dv_dy) override {
+            _lod = -1.0f;
+            if(!canvas_lod) return;
+            float u0=0.0f, v0=0.0f, u1=1.0f, v1=1.0f;
+            uv_window(u0, v0, u1, v1);
+            const float w = float(texture.width())*(u1-u0), h = float(texture.height())*(v1-v0);
+            const float rho_x = (du_dx*w)*(du_dx*w) + (dv_dx*h)*(dv_dx*h);
+            const float rho_y = (du_dy*w)*(du_dy*w) + (dv_dy*h)*(dv_dy*h);
+            const float rho2 = nitrogl::math::max(rho_x, rho_y);
+            if(rho2<=0.0f) return;
+            _lod = nitrogl::math::max(0.5f*nitrogl::math::log2(rho2) + lod_bias, 0.0f);
+        }
+
         void on_upload_uniforms_request(GLuint program) override {
+            texture.resolveMipMaps();
             texture.use(texture.slot());
             glUniform1i(get_uniform_location(program, "texture"), texture.slot());
+            if(canvas_lod) glUniform1f(get_uniform_location(program, "lod"), _lod);
         }
 
+        // last computed mip level, -1 if unknown
+        float lod() const { return _lod; }
+
         void update_intrinsic(bool on) {
-            intrinsic_width = on ? float(texture.width()) : -1.0f;
-            intrinsic_height = on ? float(texture.height()) : -1.0f;
+            const auto * region = atlas ? atlas->region(handle) : nullptr;
+            intrinsic_width = on ? float(region ? region->width : texture.width()) : -1.0f;
+            intrinsic_height = on ? float(region ? region->height : texture.height()) : -1.0f;
         }
 
+    private:
+        float _lod = -1.0f;
+
+    public:
         gl_texture texture;
+        texture_atlas * atlas = nullptr;
+        texture_atlas::handle_t handle;
+        bool canvas_lod = false;
+        float lod_bias = 0.0f;
         explicit texture_sampler(const gl_texture & texture,
                                  bool intrinsic=false) :
-                texture(texture), sampler_t() {
+                sampler_t(), texture(texture) {
             update_intrinsic(intrinsic);
         }
         explicit texture_sampler(gl_texture && texture,
                                  bool intrinsic=false) :
-                texture(nitrogl::traits::move(texture)), sampler_t() {
+                sampler_t(), texture(nitrogl::traits::move(texture)) {
+            update_intrinsic(intrinsic);
+        }
+        /**
+         * @param atlas the atlas, the sampler does not own it
+         * @param handle entry handle, if it was evicted, transparent is sampled (opaque black
+         *        with atlases of formats without alpha)
+         * @param intrinsic use the entry dimensions as intrinsic dimensions
+         */
+        texture_sampler(texture_atlas & atlas, const texture_atlas::handle_t & handle,
+                        bool intrinsic=false) :
+                sampler_t(), texture(atlas.texture()), atlas(&atlas), handle(handle) {
             update_intrinsic(intrinsic);
         }
     };
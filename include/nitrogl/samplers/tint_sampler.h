@@ -38,6 +38,27 @@ namespace nitrogl {
 )";
         }
 
+        sampler_t * fold_identity() const override {
+            const bool white = color.r==1.0f && color.g==1.0f && color.b==1.0f && color.a==1.0f;
+            return white ? sub_sampler(0) : nullptr;
+        }
+
+        bool fold_constant(color_t & result) const override {
+            const auto & info = sub_sampler(0)->resolved()->traversal_info();
+            if(!info.is_constant) return false;
+            const auto & c = info.constant;
+            result = { c.r*color.r, c.g*color.g, c.b*color.b, c.a*color.a };
+            return true;
+        }
+
+        bool is_opaque() const override {
+            return color.a>=1.0f && sub_sampler(0)->resolved()->traversal_info().opaque;
+        }
+
+        bool uv_window(float & u0, float & v0, float & u1, float & v1) override {
+            return sub_sampler(0)->resolved()->uv_window(u0, v0, u1, v1);
+        }
+
         void on_cache_uniforms_locations(GLuint program) override {
         }
 
@@ -0,0 +1,57 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "color.h"
+#include "math/mat3.h"
+
+namespace nitrogl {
+
+    /**
+     * Instances of the batched shapes draws (canvas::drawRects, drawCircles ...).
+     * Fill and stroke samplers are shared by the batch, and are tinted per instance.
+     * The transform of every instance is about the left-top of its shape, as in the
+     * single shape draws. Omitted trailing members of brace initialization take their
+     * defaults, the transform becomes the identity, but -Wextra warns on them, so pass
+     * mat3f::identity() in code built with it.
+     */
+
+    struct rect_instance {
+        float left, top, right, bottom;
+        color_t tint;
+        mat3f transform;
+    };
+
+    struct circle_instance {
+        float x, y, radius, stroke;
+        color_t fill_tint, stroke_tint;
+        mat3f transform;
+    };
+
+    struct rounded_rect_instance {
+        float left, top, right, bottom, radius, stroke;
+        color_t fill_tint, stroke_tint;
+        mat3f transform;
+    };
+
+    struct arc_instance {
+        float x, y, radius, from_angle, to_angle, inner_radius, stroke;
+        color_t fill_tint, stroke_tint;
+        mat3f transform;
+    };
+
+    struct pie_instance {
+        float x, y, radius, from_angle, to_angle, stroke;
+        color_t fill_tint, stroke_tint;
+        mat3f transform;
+    };
+
+}
\ No newline at end of file
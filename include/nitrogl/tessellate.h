@@ -0,0 +1,67 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include "arena_allocator.h"
+#include "path.h"
+
+namespace nitrogl {
+
+    /**
+     * what tessellate, tessellate_all and hit_test_scene compute for a path. Paths cache their
+     * tessellation, so later canvas::drawPathFill and drawPathStroke with the same settings do
+     * not tessellate again. Edge antialiased canvases ask for fills with boundary, the others
+     * without.
+     */
+    struct tessellate_options {
+        // fill
+        bool fill=true;
+        microtess::fill_rule rule=microtess::fill_rule::non_zero;
+        microtess::tess_quality quality=microtess::tess_quality::better;
+        bool boundary=false;
+        // stroke
+        bool stroke=false;
+        float stroke_width=1.0f;
+        microtess::stroke_cap cap=microtess::stroke_cap::butt;
+        microtess::stroke_line_join line_join=microtess::stroke_line_join::bevel;
+        int miter_limit=4;
+        // stroke dash pattern, no dashes if count is 0
+        const int * dash_array=nullptr;
+        unsigned dash_count=0;
+        int dash_offset=0;
+
+        struct dash_view {
+            const int * data; unsigned count;
+            const int * begin() const { return data; }
+            const int * end() const { return data + count; }
+            unsigned size() const { return count; }
+        };
+        dash_view dashes() const { return { dash_array, dash_count }; }
+    };
+
+    /**
+     * tessellate a path with the temporary memory of an arena
+     */
+    template<class path_type>
+    void tessellate(path_type & path, const tessellate_options & options, memory_arena & arena) {
+        if(options.fill)
+            path.tessellateFillWith(arena_rebind_allocator<>(arena), options.rule,
+                                    options.quality, options.boundary, false);
+        if(options.stroke)
+            path.tessellateStroke(options.stroke_width, options.cap, options.line_join,
+                                  options.miter_limit, options.dashes(), options.dash_offset);
+    }
+
+    template<class path_type>
+    void tessellate(path_type * path, const tessellate_options & options, memory_arena & arena) {
+        tessellate(*path, options, arena);
+    }
+}
\ No newline at end of file
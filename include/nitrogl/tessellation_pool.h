@@ -0,0 +1,186 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "tessellate.h"
+
+namespace nitrogl {
+
+    /**
+     * Pool of worker threads for tessellating many independent paths at once (see
+     * tessellate_all). A run splits [0, count) evenly between the workers, a worker that is
+     * done steals the back half of the range of another worker, so long paths do not keep the
+     * rest waiting. The calling thread is a worker too. Every worker has its own memory arena
+     * for temporary memory, that is reset after every task. Runs are not re-entrant, use a
+     * pool from one thread at a time.
+     */
+    class tessellation_pool {
+    public:
+        using task_t = void (*)(void * context, unsigned index, memory_arena & arena);
+
+    private:
+        struct worker_t {
+            std::thread thread;
+            std::mutex lock;
+            unsigned begin=0, end=0;
+            memory_arena arena;
+        };
+
+        worker_t * _workers;
+        unsigned _size;
+        std::mutex _lock;
+        std::condition_variable _wake, _done;
+        task_t _task;
+        void * _context;
+        unsigned long _generation;
+        unsigned _running;
+        bool _quit;
+
+        bool pop(worker_t & worker, unsigned & index) {
+            std::lock_guard<std::mutex> guard(worker.lock);
+            if(worker.begin==worker.end) return false;
+            index = worker.begin++;
+            return true;
+        }
+
+        bool steal(unsigned self, unsigned & index) {
+            for (unsigned ix = 1; ix < _size; ++ix) {
+                auto & victim = _workers[(self + ix) % _size];
+                unsigned begin, end;
+                {
+                    std::lock_guard<std::mutex> guard(victim.lock);
+                    if(victim.begin==victim.end) continue;
+                    begin = victim.begin + (victim.end - victim.begin)/2;
+                    end = victim.end;
+                    victim.end = begin;
+                }
+                // own range is empty, nobody steals from it meanwhile
+                auto & worker = _workers[self];
+                std::lock_guard<std::mutex> guard(worker.lock);
+                worker.begin = begin + 1; worker.end = end;
+                index = begin;
+                return true;
+            }
+            return false;
+        }
+
+        void drain(unsigned self) {
+            auto & worker = _workers[self];
+            unsigned index;
+            while(pop(worker, index) || steal(self, index)) {
+                _task(_context, index, worker.arena);
+                worker.arena.reset();
+            }
+        }
+
+        void loop(unsigned self) {
+            unsigned long seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> guard(_lock);
+                    _wake.wait(guard, [&]() { return _quit || _generation!=seen; });
+                    if(_quit) return;
+                    seen = _generation;
+                }
+                drain(self);
+                std::lock_guard<std::mutex> guard(_lock);
+                if(--_running==0) _done.notify_all();
+            }
+        }
+
+    public:
+        /**
+         * @param threads count of workers, including the calling thread
+         */
+        explicit tessellation_pool(unsigned threads=std::thread::hardware_concurrency()) :
+                _workers(nullptr), _size(threads ? threads : 1), _task(nullptr),
+                _context(nullptr), _generation(0), _running(0), _quit(false) {
+            _workers = new worker_t[_size];
+            for (unsigned ix = 1; ix < _size; ++ix)
+                _workers[ix].thread = std::thread(&tessellation_pool::loop, this, ix);
+        }
+        tessellation_pool(const tessellation_pool &)=delete;
+        tessellation_pool & operator=(const tessellation_pool &)=delete;
+
+        ~tessellation_pool() {
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                _quit = true;
+            }
+            _wake.notify_all();
+            for (unsigned ix = 1; ix < _size; ++ix) _workers[ix].thread.join();
+            delete [] _workers;
+        }
+
+        unsigned size() const { return _size; }
+
+        /**
+         * run task(context, index, arena) for every index in [0, count), and wait for all of them
+         */
+        void run(unsigned count, task_t task, void * context) {
+            if(count==0) return;
+            for (unsigned ix = 0; ix < _size; ++ix) {
+                std::lock_guard<std::mutex> guard(_workers[ix].lock);
+                _workers[ix].begin = unsigned((unsigned long long)(count) * ix / _size);
+                _workers[ix].end = unsigned((unsigned long long)(count) * (ix + 1) / _size);
+            }
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                _task = task; _context = context;
+                _running = _size - 1;
+                ++_generation;
+            }
+            _wake.notify_all();
+            drain(0);
+            std::unique_lock<std::mutex> guard(_lock);
+            _done.wait(guard, [&]() { return _running==0; });
+        }
+
+        /**
+         * run task(index, arena) for every index in [0, count), and wait for all of them
+         */
+        template<class callable>
+        void run(unsigned count, const callable & task) {
+            struct trampoline {
+                static void call(void * context, unsigned index, memory_arena & arena) {
+                    (*static_cast<const callable *>(context))(index, arena);
+                }
+            };
+            run(count, &trampoline::call, const_cast<void *>(static_cast<const void *>(&task)));
+        }
+
+        // pool of hardware concurrency workers, created on first use
+        static tessellation_pool & shared() {
+            static tessellation_pool pool;
+            return pool;
+        }
+    };
+
+    /**
+     * Tessellate many independent paths on a pool of threads. Fill and stroke of a path are
+     * computed by the same worker. Paths must not be shared, and their allocators must be
+     * thread safe (std_rebind_allocator is).
+     * @param paths array of paths, or of pointers to paths
+     * @param count count of paths
+     * @param options what to tessellate
+     * @param pool the pool
+     */
+    template<class path_type>
+    void tessellate_all(path_type * paths, unsigned count, const tessellate_options & options,
+                        tessellation_pool & pool=tessellation_pool::shared()) {
+        pool.run(count, [&](unsigned index, memory_arena & arena) {
+            tessellate(paths[index], options, arena);
+        });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,256 @@
+/*========================================================================================
+ Copyright (2021), Tomer Shalev (tomer.shalev@gmail.com, https://github.com/HendrixString).
+ All Rights Reserved.
+ License is a custom open source semi-permissive license with the following guidelines:
+ 1. unless otherwise stated, derivative work and usage of this file is permitted and
+    should be credited to the project and the author of this project.
+ 2. Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+========================================================================================*/
+#pragma once
+
+
+#include "canvas.h"
+
+// width and height of the tiles of tiled_canvas
+#ifndef NITROGL_TILE_SIZE
+#define NITROGL_TILE_SIZE 512
+#endif
+
+namespace nitrogl {
+
+    /**
+     * Tiled rendering of a canvas, that is larger than what the GPU can hold (huge exports, memory
+     * limited GPUs). Draw commands are recorded, binned by their bounds into fixed size tiles, and
+     * replayed per tile into a tile sized canvas (frame buffer and backdrop). Every tile is
+     * streamed into a texture, into a pixels buffer or to your callback, so the GPU memory is
+     * bounded by the tile size and not by the size of the canvas.
+     *
+     * Notes:
+     * - a command is a callable void(canvas &), that draws in canvas coordinates. It is copied,
+     *   and whatever it refers to (samplers, paths, textures) has to live until render()
+     * - commands are binned by the bounds of their draws, that are captured when they are
+     *   recorded, so a command has to draw the same thing whenever it is called
+     * - a command is replayed for every tile it touches, its CPU work (tessellation) repeats
+     * - every command starts with the default composition and draw mode, so set the canvas
+     *   state a command depends on inside of it
+     *
+     * @tparam allocator_type allocator for the commands and the bins
+     */
+    template<class allocator_type=nitrogl::std_rebind_allocator<>>
+    class tiled_canvas {
+        struct command_t {
+            void * object;
+            void (*invoke)(void *, canvas &);
+            void (*destroy)(void *, const allocator_type &);
+            rect_i bounds;
+        };
+        using commands_allocator = typename allocator_type::template rebind<command_t>::other;
+        using indices_allocator = typename allocator_type::template rebind<unsigned>::other;
+        using bytes_allocator = typename allocator_type::template rebind<unsigned char>::other;
+        using commands_t = dynamic_array<command_t, commands_allocator>;
+        using indices_t = dynamic_array<unsigned, indices_allocator>;
+        using bytes_t = dynamic_array<unsigned char, bytes_allocator>;
+
+        template<class command_type>
+        static void invoke(void * object, canvas & c) {
+            (*reinterpret_cast<command_type *>(object))(c);
+        }
+
+        template<class command_type>
+        static void destroy(void * object, const allocator_type & allocator) {
+            using rebind_allocator = typename allocator_type::template rebind<command_type>::other;
+            rebind_allocator alloc(allocator);
+            auto * command = reinterpret_cast<command_type *>(object);
+            command->~command_type();
+            alloc.deallocate(command, 1);
+        }
+
+        allocator_type _allocator;
+        unsigned _width, _height, _tile_size;
+        gl_texture _tile;
+        fbo_t _fbo_tile;
+        canvas _canvas;
+        commands_t _commands;
+        color_t _clear_color;
+
+        void reset_state() {
+            _canvas.update_composition(blend_modes::Normal(), porter_duff::SourceOver());
+            _canvas.updateDrawMode(draw_mode::fill);
+        }
+
+    public:
+        /**
+         * @param width width of the canvas
+         * @param height height of the canvas
+         * @param tile_size width and height of the tiles
+         * @param is_pre_mul_alpha is the canvas pre-multiplied alpha
+         * @param allocator allocator for the commands and the bins
+         */
+        tiled_canvas(unsigned width, unsigned height,
+                     unsigned tile_size=NITROGL_TILE_SIZE,
+                     bool is_pre_mul_alpha=true,
+                     const allocator_type & allocator=allocator_type()) :
+                _allocator(allocator), _width(width), _height(height), _tile_size(tile_size),
+                _tile(gl_texture::empty(tile_size, tile_size, GL_RGBA, is_pre_mul_alpha)),
+                _fbo_tile(), _canvas(_tile), _commands(commands_allocator(allocator)),
+                _clear_color{0.0f, 0.0f, 0.0f, 0.0f} {
+            _fbo_tile.attachTexture(_tile);
+            // the clip rect is in canvas coordinates
+            _canvas.updateClipRect(0, 0, int(width), int(height));
+        }
+        tiled_canvas(const tiled_canvas &)=delete;
+        tiled_canvas & operator=(const tiled_canvas &)=delete;
+        ~tiled_canvas() { clear(_clear_color); }
+
+        unsigned width() const { return _width; }
+        unsigned height() const { return _height; }
+        unsigned tileSize() const { return _tile_size; }
+        unsigned commandsCount() const { return unsigned(_commands.size()); }
+
+        /**
+         * The canvas that renders the tiles, for its settings (hardware blending, multisampling).
+         * Draw through record() and not on it.
+         */
+        canvas & tileCanvas() { return _canvas; }
+
+        /**
+         * Drop the recorded commands, and clear the canvas with a color
+         */
+        void clear(const color_t & color) {
+            for (unsigned ix = 0; ix < _commands.size(); ++ix)
+                _commands[ix].destroy(_commands[ix].object, _allocator);
+            _commands.clear();
+            _clear_color = color;
+        }
+
+        /**
+         * Record a draw command, it is binned by the bounds of its draws
+         * @param command callable void(canvas &), that draws in canvas coordinates
+         */
+        template<class command_type>
+        void record(const command_type & command) {
+            using rebind_allocator = typename allocator_type::template rebind<command_type>::other;
+            rebind_allocator alloc(_allocator);
+            auto * object = alloc.allocate(1);
+            alloc.construct(object, command);
+            // capture the bounds of the command, nothing is drawn
+            reset_state();
+            _canvas.beginBoundsCapture();
+            command(_canvas);
+            const auto bounds = _canvas.endBoundsCapture();
+            _commands.push_back({ object, &invoke<command_type>, &destroy<command_type>, bounds });
+        }
+
+        /**
+         * Render the recorded commands, tile by tile. Tiles are cleared with the clear color,
+         * and the commands, that touch a tile, are replayed in the order of their recording.
+         * @param on_tile callback (const rect_i & region, const gl_texture & tile) -> void, where
+         *        region is the rectangle of the canvas, that the tile covers. The region is at the
+         *        top-left of the tile and is smaller than it at the right and bottom edges
+         */
+        template<class on_tile_callback>
+        void render(const on_tile_callback & on_tile) {
+            NITROGL_PROFILE_SCOPE("tiled_canvas::render");
+            if(_width==0 || _height==0 || _tile_size==0) return;
+            const unsigned ts = _tile_size;
+            const unsigned columns = (_width + ts - 1) / ts, rows = (_height + ts - 1) / ts;
+            const unsigned tiles = columns*rows;
+            // bin the commands by their bounds, counting sort into a flat array, so the commands
+            // of a tile keep their order
+            const rect_i canvas_rect(0, 0, int(_width), int(_height));
+            const auto tiles_range = [&](const rect_i & bounds, rect_i & range) {
+                const auto b = bounds.intersect(canvas_rect);
+                if(b.empty()) return false;
+                range = rect_i(b.left/int(ts), b.top/int(ts),
+                               (b.right - 1)/int(ts) + 1, (b.bottom - 1)/int(ts) + 1);
+                return true;
+            };
+            indices_t offsets(tiles + 1, 0u, indices_allocator(_allocator));
+            indices_t bins{indices_allocator(_allocator)};
+            {
+                NITROGL_PROFILE_SCOPE("tiled_canvas::binning");
+                rect_i r;
+                // count the commands of every tile, offsets[tile+1]
+                for (unsigned ix = 0; ix < _commands.size(); ++ix) {
+                    if(!tiles_range(_commands[ix].bounds, r)) continue;
+                    for (int ty = r.top; ty < r.bottom; ++ty)
+                        for (int tx = r.left; tx < r.right; ++tx)
+                            ++offsets[ty*columns + tx + 1];
+                }
+                for (unsigned ix = 1; ix <= tiles; ++ix) offsets[ix] += offsets[ix - 1];
+                // fill, offsets[tile] is the cursor and ends up at the start of the next tile
+                bins.resize(offsets[tiles]);
+                for (unsigned ix = 0; ix < _commands.size(); ++ix) {
+                    if(!tiles_range(_commands[ix].bounds, r)) continue;
+                    for (int ty = r.top; ty < r.bottom; ++ty)
+                        for (int tx = r.left; tx < r.right; ++tx)
+                            bins[offsets[ty*columns + tx]++] = ix;
+                }
+                for (unsigned ix = tiles; ix > 0; --ix) offsets[ix] = offsets[ix - 1];
+                offsets[0] = 0;
+            }
+            for (unsigned tile = 0; tile < tiles; ++tile) {
+                NITROGL_PROFILE_SCOPE("tiled_canvas::tile");
+                const int left = int((tile % columns) * ts), top = int((tile / columns) * ts);
+                const rect_i region(left, top, functions::min(left + int(ts), int(_width)),
+                                    functions::min(top + int(ts), int(_height)));
+                _canvas.updateCanvasWindow(left, top, int(ts), int(ts));
+                _canvas.clear(_clear_color);
+                for (unsigned ix = offsets[tile]; ix < offsets[tile + 1]; ++ix) {
+                    const auto & command = _commands[bins[ix]];
+                    reset_state();
+                    command.invoke(command.object, _canvas);
+                }
+                _canvas.flush();
+                on_tile(region, _tile);
+            }
+        }
+
+        /**
+         * Render the recorded commands into a texture, tile by tile
+         * @param target texture of at least the canvas size, with the alpha state of the canvas
+         */
+        void renderToTexture(const gl_texture & target) {
+            const int ts = int(_tile_size);
+            render([&](const rect_i & region, const gl_texture &) {
+                // invert to opengl coordinates (0,0) is bottom-left
+                _fbo_tile.bind();
+                target.use(0);
+                glCopyTexSubImage2D(GL_TEXTURE_2D, 0,
+                                    region.left, int(target.height()) - region.bottom,
+                                    0, ts - region.height(), region.width(), region.height());
+                glCheckError();
+            });
+        }
+
+        /**
+         * Render the recorded commands into pixels, tile by tile. Streams the tiles to the
+         * CPU, so the canvas can be larger than any texture.
+         * @param on_pixels callback (const rect_i & region, const unsigned char * pixels) -> void,
+         *        pixels of the region are RGBA8 rows from top to bottom, without padding, with
+         *        the alpha state of the canvas
+         */
+        template<class on_pixels_callback>
+        void renderToPixels(const on_pixels_callback & on_pixels) {
+            const int ts = int(_tile_size);
+            bytes_t pixels{bytes_allocator(_allocator)};
+            pixels.resize(_tile_size*_tile_size*4);
+            render([&](const rect_i & region, const gl_texture &) {
+                const int w = region.width(), h = region.height(), stride = w*4;
+                _fbo_tile.bind();
+                glPixelStorei(GL_PACK_ALIGNMENT, 4);
+                glReadPixels(0, ts - h, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+                glCheckError();
+                // opengl rows are bottom to top
+                auto * p = pixels.data();
+                for (int top = 0, bottom = h - 1; top < bottom; ++top, --bottom)
+                    for (int ix = 0; ix < stride; ++ix)
+                        functions::swap(p[top*stride + ix], p[bottom*stride + ix]);
+                on_pixels(region, static_cast<const unsigned char *>(p));
+            });
+        }
+    };
+
+}
\ No newline at end of file